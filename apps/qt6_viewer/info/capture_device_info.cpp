@@ -18,6 +18,12 @@ static QString pixFmtToString(gcap_pixfmt_t f)
         return "R210";
     case GCAP_FMT_Y210:
         return "Y210";
+    case GCAP_FMT_RGBA64:
+        return "RGBA64";
+    case GCAP_FMT_X2R10G10B10:
+        return "X2R10G10B10";
+    case GCAP_FMT_Y8:
+        return "Y8";
     default:
         return "Unknown";
     }
@@ -37,7 +43,11 @@ static QString sampleFamilyToString(gcap_pixfmt_t f)
         return "YUV420 10-bit";
     case GCAP_FMT_ARGB:
     case GCAP_FMT_R210:
+    case GCAP_FMT_RGBA64:
+    case GCAP_FMT_X2R10G10B10:
         return "RGB";
+    case GCAP_FMT_Y8:
+        return "Luma";
     default:
         return "Unknown";
     }
@@ -35,35 +35,6 @@ static MainWindow *g_mainWindow = nullptr;
 
 namespace
 {
-    static inline uint8_t clampByteLocal(int v)
-    {
-        if (v < 0)
-            return 0;
-        if (v > 255)
-            return 255;
-        return static_cast<uint8_t>(v);
-    }
-
-    static inline uint16_t normalizeY210WordLocal(uint16_t v)
-    {
-        // Y210 stores each 10-bit component left-aligned in a 16-bit WORD.
-        // Bits [15:6] are valid, bits [5:0] are padding.
-        return static_cast<uint16_t>((v >> 6) & 0x03FFu);
-    }
-
-    static inline void yuvToRgbLocal(int y, int u, int v, uint8_t &b, uint8_t &g, uint8_t &r)
-    {
-        const int c = y - 16;
-        const int d = u - 128;
-        const int e = v - 128;
-        const int rr = (298 * c + 409 * e + 128) >> 8;
-        const int gg = (298 * c - 100 * d - 208 * e + 128) >> 8;
-        const int bb = (298 * c + 516 * d + 128) >> 8;
-        r = clampByteLocal(rr);
-        g = clampByteLocal(gg);
-        b = clampByteLocal(bb);
-    }
-
     static const char *packetFmtName(int fmt)
     {
         switch (fmt)
@@ -172,6 +143,28 @@ namespace
     }
 
 
+    // Pool-backed SDK frames are retained instead of copied; the lease is released
+    // together with the last QImage that shares the pixels.
+    static QImage leasedFrameImage(const gcap_frame_t *f)
+    {
+        const gcap_frame_t *held = gcap_frame_retain(f);
+        if (!held)
+            return {};
+        return QImage(reinterpret_cast<const uchar *>(held->data[0]), held->width, held->height, held->stride[0], QImage::Format_ARGB32,
+                      [](void *p) { gcap_frame_release(static_cast<const gcap_frame_t *>(p)); },
+                      const_cast<gcap_frame_t *>(held));
+    }
+
+    static QImage leasedPacketImage(const gcap_frame_packet_t *pkt)
+    {
+        const gcap_frame_packet_t *held = gcap_frame_packet_retain(pkt);
+        if (!held)
+            return {};
+        return QImage(reinterpret_cast<const uchar *>(held->data[0]), held->width, held->height, held->stride[0], QImage::Format_ARGB32,
+                      [](void *p) { gcap_frame_packet_release(static_cast<const gcap_frame_packet_t *>(p)); },
+                      const_cast<gcap_frame_packet_t *>(held));
+    }
+
     static QImage framePacketToQImage(const gcap_frame_packet_t &pkt)
     {
         if (pkt.width <= 0 || pkt.height <= 0 || pkt.plane_count <= 0 || !pkt.data[0])
@@ -179,94 +172,32 @@ namespace
 
         if (pkt.format == GCAP_FMT_ARGB)
         {
+            QImage leased = leasedPacketImage(&pkt);
+            if (!leased.isNull())
+                return leased;
             QImage img(reinterpret_cast<const uchar *>(pkt.data[0]), pkt.width, pkt.height, pkt.stride[0], QImage::Format_ARGB32);
             return img.copy();
         }
 
-        QImage img(pkt.width, pkt.height, QImage::Format_ARGB32);
-        if (img.isNull())
-            return {};
-
-        if (pkt.format == GCAP_FMT_NV12 && pkt.plane_count >= 2 && pkt.data[1])
+        // 10-bit CPU outputs map onto Qt formats directly (RGB30 is xx:R10:G10:B10 like X2R10G10B10).
+        if (pkt.format == GCAP_FMT_RGBA64)
         {
-            const uint8_t *yPlane = reinterpret_cast<const uint8_t *>(pkt.data[0]);
-            const uint8_t *uvPlane = reinterpret_cast<const uint8_t *>(pkt.data[1]);
-            const int yStride = pkt.stride[0] > 0 ? pkt.stride[0] : pkt.width;
-            const int uvStride = pkt.stride[1] > 0 ? pkt.stride[1] : pkt.width;
-            for (int y = 0; y < pkt.height; ++y)
-            {
-                const uint8_t *yRow = yPlane + static_cast<size_t>(y) * yStride;
-                const uint8_t *uvRow = uvPlane + static_cast<size_t>(y / 2) * uvStride;
-                QRgb *dst = reinterpret_cast<QRgb *>(img.scanLine(y));
-                for (int x = 0; x < pkt.width; ++x)
-                {
-                    const int Y = yRow[x];
-                    const int U = uvRow[(x & ~1) + 0];
-                    const int V = uvRow[(x & ~1) + 1];
-                    uint8_t b = 0, g = 0, r = 0;
-                    yuvToRgbLocal(Y, U, V, b, g, r);
-                    dst[x] = qRgba(r, g, b, 255);
-                }
-            }
-            return img;
-        }
-
-        if (pkt.format == GCAP_FMT_YUY2)
-        {
-            const uint8_t *src = reinterpret_cast<const uint8_t *>(pkt.data[0]);
-            const int srcStride = pkt.stride[0] > 0 ? pkt.stride[0] : (pkt.width * 2);
-            for (int y = 0; y < pkt.height; ++y)
-            {
-                const uint8_t *srcRow = src + static_cast<size_t>(y) * srcStride;
-                QRgb *dst = reinterpret_cast<QRgb *>(img.scanLine(y));
-                for (int x = 0; x < pkt.width; x += 2)
-                {
-                    const uint8_t y0 = srcRow[x * 2 + 0];
-                    const uint8_t u = srcRow[x * 2 + 1];
-                    const uint8_t y1 = srcRow[x * 2 + 2];
-                    const uint8_t v = srcRow[x * 2 + 3];
-                    uint8_t b = 0, g = 0, r = 0;
-                    yuvToRgbLocal(y0, u, v, b, g, r);
-                    dst[x] = qRgba(r, g, b, 255);
-                    if (x + 1 < pkt.width)
-                    {
-                        yuvToRgbLocal(y1, u, v, b, g, r);
-                        dst[x + 1] = qRgba(r, g, b, 255);
-                    }
-                }
-            }
-            return img;
+            QImage img(reinterpret_cast<const uchar *>(pkt.data[0]), pkt.width, pkt.height, pkt.stride[0], QImage::Format_RGBA64);
+            return img.convertToFormat(QImage::Format_ARGB32);
         }
-
-        if (pkt.format == GCAP_FMT_Y210)
+        if (pkt.format == GCAP_FMT_X2R10G10B10)
         {
-            const uint16_t *src = reinterpret_cast<const uint16_t *>(pkt.data[0]);
-            const int srcStride = pkt.stride[0] > 0 ? pkt.stride[0] : (pkt.width * 4);
-            for (int y = 0; y < pkt.height; ++y)
-            {
-                const uint16_t *srcRow = reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(src) + static_cast<size_t>(y) * static_cast<size_t>(srcStride));
-                QRgb *dst = reinterpret_cast<QRgb *>(img.scanLine(y));
-                for (int x = 0; x < pkt.width; x += 2)
-                {
-                    const int base = x * 2;
-                    const int Y0 = (int(normalizeY210WordLocal(srcRow[base + 0])) * 255 + 511) / 1023;
-                    const int U = (int(normalizeY210WordLocal(srcRow[base + 1])) * 255 + 511) / 1023;
-                    const int Y1 = (x + 1 < pkt.width) ? ((int(normalizeY210WordLocal(srcRow[base + 2])) * 255 + 511) / 1023) : Y0;
-                    const int V = (x + 1 < pkt.width) ? ((int(normalizeY210WordLocal(srcRow[base + 3])) * 255 + 511) / 1023) : U;
-                    uint8_t b = 0, g = 0, r = 0;
-                    yuvToRgbLocal(Y0, U, V, b, g, r);
-                    dst[x] = qRgba(r, g, b, 255);
-                    if (x + 1 < pkt.width)
-                    {
-                        yuvToRgbLocal(Y1, U, V, b, g, r);
-                        dst[x + 1] = qRgba(r, g, b, 255);
-                    }
-                }
-            }
-            return img;
+            QImage img(reinterpret_cast<const uchar *>(pkt.data[0]), pkt.width, pkt.height, pkt.stride[0], QImage::Format_RGB30);
+            return img.convertToFormat(QImage::Format_ARGB32);
         }
 
-        return {};
+        // YUV and R210: the SDK kernels, shared with any other consumer of this frame.
+        QImage img(pkt.width, pkt.height, QImage::Format_ARGB32);
+        if (img.isNull())
+            return {};
+        if (gcap_packet_convert(&pkt, GCAP_FMT_ARGB, img.bits(), static_cast<int>(img.bytesPerLine())) != GCAP_OK)
+            return {};
+        return img;
     }
 }
 
@@ -315,9 +246,10 @@ void MainWindow::s_vcb(const gcap_frame_t *f, void *u)
         return;
 
     // 背景 callback thread 不要直接碰 MainWindow 狀態；
-    // 先把 frame 拷成安全的 QImage，再排回 UI thread。
-    QImage img((const uchar *)f->data[0], f->width, f->height, f->stride[0], QImage::Format_ARGB32);
-    const QImage safeImg = img.copy();
+    // 先把 frame 變成安全的 QImage（能 retain 就零拷貝，否則拷一份），再排回 UI thread。
+    QImage safeImg = leasedFrameImage(f);
+    if (safeImg.isNull())
+        safeImg = QImage((const uchar *)f->data[0], f->width, f->height, f->stride[0], QImage::Format_ARGB32).copy();
     const uint64_t ptsNs = f->pts_ns;
     const int width = f->width;
     const int height = f->height;
@@ -347,7 +279,7 @@ void MainWindow::s_pcb(const gcap_frame_packet_t *pkt, void *u)
         self,
         [self, pktCopy, img]()
         {
-            self->updateFrameSourceState(pktCopy.pts_ns, pktCopy.width, pktCopy.height, self->lastPacketCallbackPtsNs_);
+            self->updateFrameSourceState(pktCopy.pts_smoothed_ns ? pktCopy.pts_smoothed_ns : pktCopy.pts_ns, pktCopy.width, pktCopy.height, self->lastPacketCallbackPtsNs_);
             self->logFramePacketIfNeeded(pktCopy);
             if (self->usePacketCallback_ && !img.isNull())
                 self->dispatchFrameImage(img);
@@ -434,13 +366,16 @@ void MainWindow::updateRuntimeStatusUi()
     QString probeFmt = QString::fromUtf8(packetFmtName(rt.signal_probe.pixfmt));
     const double probeFps = (rt.signal_probe.fps_den > 0) ? (double(rt.signal_probe.fps_num) / double(rt.signal_probe.fps_den)) : 0.0;
 
-    const QString sb = QStringLiteral("Backend: %1 | Source: %2 | %3 | %4 | AppInternal %5 | Runtime %6fps")
+    const QString sb = QStringLiteral("Backend: %1 | Source: %2 | %3 | %4 | AppInternal %5 | Runtime %6fps | Drop %7 Dup %8 | Jitter p95 %9us")
                            .arg(backend)
                            .arg(source)
                            .arg(statusBlock("InputProbe", rt.signal_probe, probeFps, probeFmt))
                            .arg(statusBlock("BackendFmt", rt.negotiated, negotiatedFps, negotiatedFmt))
                            .arg(renderFmt.isEmpty() ? QStringLiteral("--") : renderFmt)
-                           .arg(runtimeFps > 0.0 ? QString::number(runtimeFps, 'f', 2) : QStringLiteral("--"));
+                           .arg(runtimeFps > 0.0 ? QString::number(runtimeFps, 'f', 2) : QStringLiteral("--"))
+                           .arg(rt.frames_dropped)
+                           .arg(rt.frames_duplicated)
+                           .arg(QString::number(rt.jitter_p95_us, 'f', 0));
     if (lastRuntimeStatusText_ != sb)
     {
         ui->statusbar->showMessage(sb);
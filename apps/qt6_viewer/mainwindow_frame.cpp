@@ -112,7 +112,8 @@ void MainWindow::updateFrameSourceState(uint64_t ptsNs, int width, int height, u
 
 void MainWindow::dispatchFrameImage(const QImage &img)
 {
-    sigFrame(img.copy());
+    // Callers already hand over images that own (or lease) their pixels.
+    sigFrame(img);
 }
 
 void MainWindow::refreshFrameDependentUi(const QImage &img)
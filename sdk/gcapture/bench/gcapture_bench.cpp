@@ -0,0 +1,1084 @@
+// gcapture_bench.cpp
+// Converter micro-benchmark. Runs every converter x resolution x ProcAmp on/off
+// x thread count on each kernel table this CPU supports, and reports MPix/s,
+// ns/frame and bytes/cycle. Every output is hashed and checked against the
+// golden table in golden_checksums.h, so a faster kernel that changes a single
+// pixel shows up as a failure rather than a win.
+//
+// Only the platform-neutral converter sources are linked: no Qt, Media
+// Foundation or D3D, so it builds and runs on Linux as well as Windows.
+//
+// --shm-loopback instead measures the shared-memory frame ring: reader
+// processes forked from the bench wait on the ring and report how long each
+// frame took from publish to acquire (POSIX only).
+//
+// --trace-overhead measures what a GCAP_TRACE_SCOPE span costs, tracing off and
+// on, from one thread and from several at once.
+//
+// --stats-overhead measures the gcap_get_stats() bookkeeping a capture thread does
+// per frame, with and without a monitor thread taking snapshots, and what a
+// snapshot costs.
+#include "frame_converter.h"
+#include "frame_converter_simd.h"
+#include "convert_pool.h"
+#include "shm_ring.h"
+#include "gcap_shm.h"
+#include "trace.h"
+#include "capture_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GCAP_BENCH_FORK 1
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GCAP_BENCH_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace
+{
+    struct GoldenChecksum
+    {
+        const char *key;
+        uint64_t checksum;
+    };
+
+#include "golden_checksums.h"
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Resolution
+    {
+        const char *name;
+        int width;
+        int height;
+    };
+
+    const Resolution kResolutions[] = {
+        {"720p", 1280, 720},
+        {"1080p", 1920, 1080},
+        {"4K", 3840, 2160},
+        {"8K", 7680, 4320},
+    };
+
+    enum class Source
+    {
+        Nv12,
+        Yuy2,
+        Y210,
+        P010,
+        V210,
+        R210
+    };
+
+    enum class Op
+    {
+        Convert,     // convert_frame()
+        Scaled,      // convert_frame_scaled() to width / scale_div
+        V210ToP010,  // repack, no matrix
+        R210ToArgb,  // RGB input, ProcAmp does not apply
+        R210ToRgba64
+    };
+
+    struct Case
+    {
+        const char *name;
+        Source source;
+        Op op;
+        gcap::FrameOutput output;
+        int scale_div;              // Op::Scaled only
+        gcap_scale_filter_t filter; // Op::Scaled only
+    };
+
+    const Case kCases[] = {
+        {"nv12>bgra", Source::Nv12, Op::Convert, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"yuy2>bgra", Source::Yuy2, Op::Convert, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"y210>bgra", Source::Y210, Op::Convert, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"y210>rgba64", Source::Y210, Op::Convert, gcap::FrameOutput::Rgba64, 0, GCAP_SCALE_AUTO},
+        {"p010>bgra", Source::P010, Op::Convert, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"p010>bgra-dither", Source::P010, Op::Convert, gcap::FrameOutput::Bgra8Dither, 0, GCAP_SCALE_AUTO},
+        {"p010>rgba64", Source::P010, Op::Convert, gcap::FrameOutput::Rgba64, 0, GCAP_SCALE_AUTO},
+        {"p010>x2rgb10", Source::P010, Op::Convert, gcap::FrameOutput::X2R10G10B10, 0, GCAP_SCALE_AUTO},
+        {"v210>bgra", Source::V210, Op::Convert, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"v210>rgba64", Source::V210, Op::Convert, gcap::FrameOutput::Rgba64, 0, GCAP_SCALE_AUTO},
+        {"v210>p010", Source::V210, Op::V210ToP010, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"r210>bgra", Source::R210, Op::R210ToArgb, gcap::FrameOutput::Bgra8, 0, GCAP_SCALE_AUTO},
+        {"r210>rgba64", Source::R210, Op::R210ToRgba64, gcap::FrameOutput::Rgba64, 0, GCAP_SCALE_AUTO},
+        {"nv12>bgra/2-box", Source::Nv12, Op::Scaled, gcap::FrameOutput::Bgra8, 2, GCAP_SCALE_BOX},
+        {"nv12>bgra/3-bilinear", Source::Nv12, Op::Scaled, gcap::FrameOutput::Bgra8, 3, GCAP_SCALE_BILINEAR},
+        {"p010>bgra/2-box", Source::P010, Op::Scaled, gcap::FrameOutput::Bgra8, 2, GCAP_SCALE_BOX},
+        {"y210>bgra/4-box", Source::Y210, Op::Scaled, gcap::FrameOutput::Bgra8, 4, GCAP_SCALE_BOX},
+    };
+
+    struct KernelChoice
+    {
+        gcap::simd::Isa isa;
+        const char *name;
+    };
+
+    const KernelChoice kKernels[] = {
+        {gcap::simd::Isa::Scalar, "scalar"},
+        {gcap::simd::Isa::Sse41, "sse41"},
+        {gcap::simd::Isa::Avx2, "avx2"},
+        {gcap::simd::Isa::Neon, "neon"},
+    };
+
+    bool procamp_applies(const Case &c)
+    {
+        return c.op == Op::Convert || c.op == Op::Scaled;
+    }
+
+    gcap::YuvLayout source_layout(Source s)
+    {
+        switch (s)
+        {
+        case Source::Yuy2:
+            return gcap::YuvLayout::Yuy2;
+        case Source::Y210:
+            return gcap::YuvLayout::Y210;
+        case Source::P010:
+            return gcap::YuvLayout::P010;
+        case Source::V210:
+            return gcap::YuvLayout::V210;
+        default:
+            return gcap::YuvLayout::Nv12;
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Deterministic source frames
+    // ------------------------------------------------------------
+    struct SourceFrame
+    {
+        std::vector<uint8_t> data;
+        int stride0 = 0;
+        int stride1 = 0;
+        size_t plane1_offset = 0;
+        size_t bytes = 0; // bytes a conversion reads
+
+        const uint8_t *plane0() const { return data.data(); }
+        const uint8_t *plane1() const { return plane1_offset ? data.data() + plane1_offset : nullptr; }
+    };
+
+    // splitmix64: identical sequence on every platform, so checksums are portable.
+    struct Rng
+    {
+        uint64_t state;
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+    };
+
+    void fill_bytes(uint8_t *p, size_t n, Rng &rng)
+    {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            const uint64_t v = rng.next();
+            std::memcpy(p + i, &v, 8);
+        }
+        for (; i < n; ++i)
+            p[i] = (uint8_t)rng.next();
+    }
+
+    // MSB-aligned 10-bit words (P010 / Y210).
+    void fill_msb10(uint8_t *p, size_t words, Rng &rng)
+    {
+        uint16_t *w = reinterpret_cast<uint16_t *>(p);
+        for (size_t i = 0; i < words; i += 4)
+        {
+            const uint64_t v = rng.next();
+            for (size_t k = 0; k < 4 && i + k < words; ++k)
+                w[i + k] = (uint16_t)(((v >> (16 * k)) & 0x3FF) << 6);
+        }
+    }
+
+    SourceFrame make_source(Source s, int width, int height)
+    {
+        Rng rng{0x6763617074757265ull ^ ((uint64_t)s << 48) ^ ((uint64_t)width << 20) ^ (uint64_t)height};
+        SourceFrame f;
+        switch (s)
+        {
+        case Source::Nv12:
+        {
+            f.stride0 = f.stride1 = width;
+            const size_t y = (size_t)f.stride0 * (size_t)height;
+            const size_t uv = (size_t)f.stride1 * (size_t)((height + 1) / 2);
+            f.data.resize(y + uv);
+            f.plane1_offset = y;
+            fill_bytes(f.data.data(), f.data.size(), rng);
+            break;
+        }
+        case Source::Yuy2:
+            f.stride0 = width * 2;
+            f.data.resize((size_t)f.stride0 * (size_t)height);
+            fill_bytes(f.data.data(), f.data.size(), rng);
+            break;
+        case Source::P010:
+        {
+            f.stride0 = f.stride1 = width * 2;
+            const size_t y = (size_t)f.stride0 * (size_t)height;
+            const size_t uv = (size_t)f.stride1 * (size_t)((height + 1) / 2);
+            f.data.resize(y + uv);
+            f.plane1_offset = y;
+            fill_msb10(f.data.data(), f.data.size() / 2, rng);
+            break;
+        }
+        case Source::Y210:
+            f.stride0 = width * 4;
+            f.data.resize((size_t)f.stride0 * (size_t)height);
+            fill_msb10(f.data.data(), f.data.size() / 2, rng);
+            break;
+        case Source::V210:
+        {
+            f.stride0 = gcap::v210_row_bytes(width);
+            f.data.resize((size_t)f.stride0 * (size_t)height);
+            uint32_t *w = reinterpret_cast<uint32_t *>(f.data.data());
+            for (size_t i = 0; i < f.data.size() / 4; ++i)
+                w[i] = (uint32_t)rng.next() & 0x3FFFFFFFu;
+            break;
+        }
+        case Source::R210:
+        {
+            f.stride0 = gcap::r210_row_bytes(width);
+            f.data.resize((size_t)f.stride0 * (size_t)height);
+            uint8_t *p = f.data.data();
+            for (size_t i = 0; i < f.data.size(); i += 4)
+            {
+                const uint32_t v = (uint32_t)rng.next() & 0x3FFFFFFFu; // big-endian, 2 pad bits
+                p[i] = (uint8_t)(v >> 24);
+                p[i + 1] = (uint8_t)(v >> 16);
+                p[i + 2] = (uint8_t)(v >> 8);
+                p[i + 3] = (uint8_t)v;
+            }
+            break;
+        }
+        }
+        f.bytes = f.data.size();
+        return f;
+    }
+
+    // ------------------------------------------------------------
+    // One benchmark instance
+    // ------------------------------------------------------------
+    struct Target
+    {
+        std::vector<uint8_t> data;
+        int width = 0;
+        int height = 0;
+        int stride = 0;       // plane 0
+        int row_bytes = 0;    // bytes of plane 0 that carry pixels
+        int uv_offset = 0;    // v210>p010 only: byte offset of the UV plane
+        int uv_rows = 0;
+        size_t bytes = 0;     // bytes a conversion writes
+    };
+
+    Target make_target(const Case &c, int width, int height)
+    {
+        Target t;
+        t.width = width;
+        t.height = height;
+        if (c.op == Op::Scaled)
+        {
+            t.width = std::max(1, width / c.scale_div);
+            t.height = std::max(1, height / c.scale_div);
+        }
+        if (c.op == Op::V210ToP010)
+        {
+            t.stride = width * 2;
+            t.row_bytes = t.stride;
+            t.uv_rows = (height + 1) / 2;
+            t.uv_offset = t.stride * height;
+            t.data.assign((size_t)t.stride * (size_t)(height + t.uv_rows), 0);
+            t.bytes = t.data.size();
+            return t;
+        }
+        t.row_bytes = t.width * gcap::frame_output_bytes_per_pixel(c.output);
+        t.stride = (t.row_bytes + 63) & ~63;
+        t.data.assign((size_t)t.stride * (size_t)t.height, 0);
+        t.bytes = (size_t)t.row_bytes * (size_t)t.height;
+        return t;
+    }
+
+    struct Prepared
+    {
+        gcap::FrameConverter cv;
+        gcap::ScalePlan plan;
+    };
+
+    gcap::ProcAmpParams procamp_params(bool on)
+    {
+        gcap::ProcAmpParams p;
+        if (on)
+        {
+            p.brightness = 140;
+            p.contrast = 150;
+            p.hue = 120;
+            p.saturation = 170;
+            p.sharpness = 200; // exercises the sharpen pass on 8-bit outputs
+        }
+        return p;
+    }
+
+    Prepared prepare(const Case &c, int width, int height, bool procamp)
+    {
+        Prepared p;
+        const gcap::YuvLayout layout = source_layout(c.source);
+        p.cv = gcap::make_frame_converter(layout, GCAP_CSP_BT709, GCAP_RANGE_LIMITED, procamp_params(procamp), c.output);
+        if (c.op == Op::Scaled)
+            p.plan = gcap::make_scale_plan(layout, width, height, std::max(1, width / c.scale_div),
+                                           std::max(1, height / c.scale_div), c.filter);
+        return p;
+    }
+
+    void run_once(const Case &c, const Prepared &p, const SourceFrame &src, int width, int height, Target &dst)
+    {
+        uint8_t *out = dst.data.data();
+        switch (c.op)
+        {
+        case Op::Convert:
+            gcap::convert_frame(p.cv, src.plane0(), src.plane1(), src.stride0, src.stride1, width, height, out, dst.stride);
+            break;
+        case Op::Scaled:
+            gcap::convert_frame_scaled(p.cv, p.plan, src.plane0(), src.plane1(), src.stride0, src.stride1, out, dst.stride);
+            break;
+        case Op::V210ToP010:
+            gcap::v210_to_p010(src.plane0(), width, height, src.stride0, out, dst.stride, out + dst.uv_offset, dst.stride);
+            break;
+        case Op::R210ToArgb:
+            gcap::r210_to_argb(src.plane0(), width, height, src.stride0, out, dst.stride);
+            break;
+        case Op::R210ToRgba64:
+            gcap::r210_to_rgba64(src.plane0(), width, height, src.stride0, out, dst.stride);
+            break;
+        }
+    }
+
+    // FNV-1a over 64-bit words of the pixel bytes only (stride padding is skipped).
+    uint64_t checksum(const Target &t)
+    {
+        uint64_t h = 0xCBF29CE484222325ull;
+        auto mix_rows = [&](const uint8_t *base, int rows)
+        {
+            for (int y = 0; y < rows; ++y)
+            {
+                const uint8_t *row = base + (size_t)y * (size_t)t.stride;
+                int x = 0;
+                for (; x + 8 <= t.row_bytes; x += 8)
+                {
+                    uint64_t v;
+                    std::memcpy(&v, row + x, 8);
+                    h = (h ^ v) * 0x100000001B3ull;
+                }
+                for (; x < t.row_bytes; ++x)
+                    h = (h ^ row[x]) * 0x100000001B3ull;
+            }
+        };
+        mix_rows(t.data.data(), t.height);
+        if (t.uv_rows)
+            mix_rows(t.data.data() + t.uv_offset, t.uv_rows);
+        return h;
+    }
+
+    // ------------------------------------------------------------
+    // Timing
+    // ------------------------------------------------------------
+    uint64_t read_tsc()
+    {
+#ifdef GCAP_BENCH_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // TSC ticks per nanosecond. The TSC runs at a fixed nominal rate, so
+    // bytes/cycle is relative to that rate rather than the boosted core clock.
+    double calibrate_ghz()
+    {
+#ifdef GCAP_BENCH_TSC
+        const auto t0 = Clock::now();
+        const uint64_t c0 = read_tsc();
+        while (Clock::now() - t0 < std::chrono::milliseconds(100))
+        {
+        }
+        const uint64_t c1 = read_tsc();
+        const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+        return ns > 0 ? (double)(c1 - c0) / ns : 0.0;
+#else
+        return 0.0;
+#endif
+    }
+
+    struct Options
+    {
+        std::vector<int> resolutions = {0, 1, 2, 3};
+        std::vector<int> threads;
+        std::vector<int> kernels = {0, 1, 2, 3};
+        std::string filter;
+        std::string json_path;
+        double min_time = 0.25; // seconds per measurement
+        int min_iters = 3;
+        int max_iters = 500;
+        double ghz = 0.0; // 0 = calibrate from the TSC
+        bool procamp_off = true;
+        bool procamp_on = true;
+        bool emit_golden = false;
+        bool shm_loopback = false;
+        int shm_readers = 2;
+        int shm_frames = 600;
+        bool trace_overhead = false;
+        bool stats_overhead = false;
+    };
+
+    struct Result
+    {
+        const Case *c;
+        const Resolution *res;
+        bool procamp;
+        int threads;
+        const char *kernel;
+        int iterations;
+        double ns_per_frame;
+        double mpix_per_s;
+        double bytes_per_cycle;
+        uint64_t checksum;
+        const char *golden; // "ok", "mismatch" or "missing"
+    };
+
+    double median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        const size_t n = v.size();
+        return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+    }
+
+    std::string golden_key(const Case &c, const Resolution &r, bool procamp)
+    {
+        return std::string(c.name) + "@" + r.name + (procamp ? "+procamp" : "");
+    }
+
+    const GoldenChecksum *find_golden(const std::string &key)
+    {
+        for (const GoldenChecksum &g : kGoldenChecksums)
+            if (key == g.key)
+                return &g;
+        return nullptr;
+    }
+
+    std::vector<int> parse_int_list(const char *s)
+    {
+        std::vector<int> v;
+        while (*s)
+        {
+            char *end = nullptr;
+            const long n = std::strtol(s, &end, 10);
+            if (end == s)
+                break;
+            v.push_back((int)n);
+            s = *end == ',' ? end + 1 : end;
+        }
+        return v;
+    }
+
+    template <typename T, size_t N>
+    std::vector<int> parse_name_list(const char *s, const T (&table)[N])
+    {
+        std::vector<int> v;
+        std::string list(s);
+        size_t pos = 0;
+        while (pos <= list.size())
+        {
+            const size_t comma = std::min(list.find(',', pos), list.size());
+            const std::string item = list.substr(pos, comma - pos);
+            for (size_t i = 0; i < N; ++i)
+                if (item == table[i].name)
+                    v.push_back((int)i);
+            pos = comma + 1;
+        }
+        return v;
+    }
+
+    void usage()
+    {
+        std::printf(
+            "usage: gcapture_bench [options]\n"
+            "  --filter TEXT       only converters whose name contains TEXT\n"
+            "  --res LIST          resolutions, e.g. 720p,1080p,4K,8K (default: all)\n"
+            "  --threads LIST      convert thread counts, e.g. 1,4 (default: 1 and auto)\n"
+            "  --kernels LIST      scalar,sse41,avx2,neon (default: all this CPU supports)\n"
+            "  --procamp on|off    only one ProcAmp setting (default: both)\n"
+            "  --min-time SEC      minimum measured time per result (default 0.25)\n"
+            "  --min-iters N       minimum frames per result (default 3)\n"
+            "  --ghz F             cycle rate for bytes/cycle (default: calibrated TSC)\n"
+            "  --quick             720p and 1080p only, shorter runs\n"
+            "  --json PATH         write results as JSON (\"-\" for stdout)\n"
+            "  --emit-golden       print golden_checksums.h for the cases run and exit\n"
+            "  --shm-loopback      shared-memory ring hand-off latency instead of converters\n"
+            "  --shm-readers N     reader processes for --shm-loopback (default 2)\n"
+            "  --shm-frames N      1080p NV12 frames published at 250 fps (default 600)\n"
+            "  --trace-overhead    cost of one trace span, tracing off and on, instead of converters\n"
+            "  --stats-overhead    per-frame stats bookkeeping and snapshot cost instead of converters\n"
+            "Exit status is 1 if any checksum mismatches its golden value or another kernel.\n");
+    }
+
+    bool parse_args(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string a = argv[i];
+            const char *next = i + 1 < argc ? argv[i + 1] : nullptr;
+            auto need = [&]()
+            {
+                if (!next)
+                {
+                    std::fprintf(stderr, "gcapture_bench: %s needs a value\n", a.c_str());
+                    return false;
+                }
+                ++i;
+                return true;
+            };
+            if (a == "--filter")
+            {
+                if (!need())
+                    return false;
+                o.filter = next;
+            }
+            else if (a == "--res")
+            {
+                if (!need())
+                    return false;
+                o.resolutions = parse_name_list(next, kResolutions);
+            }
+            else if (a == "--threads")
+            {
+                if (!need())
+                    return false;
+                o.threads = parse_int_list(next);
+            }
+            else if (a == "--kernels")
+            {
+                if (!need())
+                    return false;
+                o.kernels = parse_name_list(next, kKernels);
+            }
+            else if (a == "--procamp")
+            {
+                if (!need())
+                    return false;
+                o.procamp_off = std::strcmp(next, "off") == 0;
+                o.procamp_on = std::strcmp(next, "on") == 0;
+            }
+            else if (a == "--min-time")
+            {
+                if (!need())
+                    return false;
+                o.min_time = std::atof(next);
+            }
+            else if (a == "--min-iters")
+            {
+                if (!need())
+                    return false;
+                o.min_iters = std::max(1, std::atoi(next));
+            }
+            else if (a == "--ghz")
+            {
+                if (!need())
+                    return false;
+                o.ghz = std::atof(next);
+            }
+            else if (a == "--quick")
+            {
+                o.resolutions = {0, 1};
+                o.min_time = 0.05;
+            }
+            else if (a == "--json")
+            {
+                if (!need())
+                    return false;
+                o.json_path = next;
+            }
+            else if (a == "--emit-golden")
+                o.emit_golden = true;
+            else if (a == "--shm-loopback")
+                o.shm_loopback = true;
+            else if (a == "--trace-overhead")
+                o.trace_overhead = true;
+            else if (a == "--stats-overhead")
+                o.stats_overhead = true;
+            else if (a == "--shm-readers")
+            {
+                if (!need())
+                    return false;
+                o.shm_readers = std::clamp(std::atoi(next), 1, 16);
+            }
+            else if (a == "--shm-frames")
+            {
+                if (!need())
+                    return false;
+                o.shm_frames = std::max(1, std::atoi(next));
+            }
+            else
+            {
+                usage();
+                return false;
+            }
+        }
+        if (o.threads.empty())
+        {
+            const int hw = (int)std::max(1u, std::thread::hardware_concurrency());
+            o.threads = {1};
+            if (hw > 1)
+                o.threads.push_back(0);
+        }
+        return true;
+    }
+
+    void write_json(std::FILE *f, const Options &o, const std::vector<Result> &results)
+    {
+        std::fprintf(f, "{\n  \"tool\": \"gcapture_bench\",\n");
+        std::fprintf(f, "  \"best_kernels\": \"%s\",\n", gcap::simd::kernels_for(gcap::simd::Isa::Avx2)    ? "AVX2"
+                                                           : gcap::simd::kernels_for(gcap::simd::Isa::Neon)  ? "NEON"
+                                                           : gcap::simd::kernels_for(gcap::simd::Isa::Sse41) ? "SSE4.1"
+                                                                                                             : "Scalar");
+        std::fprintf(f, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+        std::fprintf(f, "  \"cycle_ghz\": %.4f,\n", o.ghz);
+        std::fprintf(f, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            std::fprintf(f,
+                         "    {\"converter\": \"%s\", \"resolution\": \"%s\", \"width\": %d, \"height\": %d, "
+                         "\"procamp\": %s, \"threads\": %d, \"kernel\": \"%s\", \"iterations\": %d, "
+                         "\"ns_per_frame\": %.0f, \"mpix_per_s\": %.2f, \"bytes_per_cycle\": ",
+                         r.c->name, r.res->name, r.res->width, r.res->height, r.procamp ? "true" : "false",
+                         r.threads, r.kernel, r.iterations, r.ns_per_frame, r.mpix_per_s);
+            if (r.bytes_per_cycle > 0)
+                std::fprintf(f, "%.3f", r.bytes_per_cycle);
+            else
+                std::fprintf(f, "null");
+            std::fprintf(f, ", \"checksum\": \"%016llx\", \"golden\": \"%s\"}%s\n",
+                         (unsigned long long)r.checksum, r.golden, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(f, "  ]\n}\n");
+    }
+
+#ifdef GCAP_BENCH_FORK
+    struct ShmReaderReport
+    {
+        int frames;
+        int corrupt;
+        double p50_us, p99_us, max_us;
+    };
+
+    // Reader process: every frame it sees, latency from publish to acquire, and a
+    // check that the payload still carries the frame_id stamped on both planes.
+    ShmReaderReport shm_reader(const char *name)
+    {
+        ShmReaderReport rep{};
+        gcap_shm_reader r = nullptr;
+        for (int i = 0; i < 2000 && gcap_shm_open(name, &r) != GCAP_OK; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!r)
+            return rep;
+        std::vector<double> lat;
+        uint64_t last = 0;
+        while (gcap_shm_wait(r, last, 2000) > 0)
+        {
+            gcap_shm_frame_t f;
+            if (gcap_shm_acquire_latest(r, &f) != GCAP_OK)
+                continue;
+            lat.push_back((double)(gcap::shm::now_ns() - f.publish_ns) / 1e3);
+            const uint8_t id = (uint8_t)f.frame_id;
+            const uint8_t *uv = (const uint8_t *)f.data[1];
+            if (((const uint8_t *)f.data[0])[0] != id || uv[(size_t)f.stride[1] * (f.height / 2) - 1] != id)
+                ++rep.corrupt;
+            last = f.seq;
+            gcap_shm_release(r, &f);
+        }
+        gcap_shm_close(r);
+        rep.frames = (int)lat.size();
+        if (!lat.empty())
+        {
+            std::sort(lat.begin(), lat.end());
+            rep.p50_us = lat[lat.size() / 2];
+            rep.p99_us = lat[std::min(lat.size() - 1, lat.size() * 99 / 100)];
+            rep.max_us = lat.back();
+        }
+        return rep;
+    }
+
+    int run_shm_loopback(const Options &o)
+    {
+        const int w = 1920, h = 1080;
+        char name[64];
+        std::snprintf(name, sizeof(name), "gcapture_bench.%d", (int)getpid());
+
+        std::vector<pid_t> pids;
+        std::vector<int> pipes;
+        for (int i = 0; i < o.shm_readers; ++i)
+        {
+            int fd[2];
+            if (pipe(fd) != 0)
+                return 2;
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fd[0]);
+                const ShmReaderReport rep = shm_reader(name);
+                const ssize_t n = write(fd[1], &rep, sizeof(rep));
+                _exit(n == (ssize_t)sizeof(rep) ? 0 : 1);
+            }
+            close(fd[1]);
+            pids.push_back(pid);
+            pipes.push_back(fd[0]);
+        }
+
+        std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * h / 2);
+        gcap_frame_packet_t p{};
+        p.width = w;
+        p.height = h;
+        p.format = GCAP_FMT_NV12;
+        p.plane_count = 2;
+        p.data[0] = y.data();
+        p.data[1] = uv.data();
+        p.stride[0] = p.stride[1] = w;
+
+        std::vector<double> publish_us;
+        int dropped = 0;
+        {
+            gcap::ShmPublisher pub(name, 4, 0);
+            const auto period = std::chrono::microseconds(4000);
+            auto due = Clock::now();
+            for (int i = 0; i < o.shm_frames; ++i)
+            {
+                p.frame_id = (uint64_t)i + 1;
+                y[0] = uv.back() = (uint8_t)p.frame_id;
+                p.pts_ns = gcap::shm::now_ns();
+                const auto t0 = Clock::now();
+                if (!pub.publish(p))
+                    ++dropped;
+                publish_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+                due += period;
+                std::this_thread::sleep_until(due);
+            }
+            // Let the readers take the last frame before the ring says it closed.
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        std::printf("shm-loopback 1080p NV12, %d frames at 250 fps, %d reader process(es)\n", o.shm_frames, o.shm_readers);
+        std::printf("  publish (copy into ring): median %.1f us, dropped %d\n", median(publish_us), dropped);
+        int failures = 0;
+        for (size_t i = 0; i < pids.size(); ++i)
+        {
+            ShmReaderReport rep{};
+            const bool got = read(pipes[i], &rep, sizeof(rep)) == (ssize_t)sizeof(rep);
+            close(pipes[i]);
+            int status = 0;
+            waitpid(pids[i], &status, 0);
+            if (!got || rep.frames == 0 || rep.corrupt)
+                ++failures;
+            std::printf("  reader %zu: %d frames, publish->acquire p50 %.1f us, p99 %.1f us, max %.1f us%s\n",
+                        i, rep.frames, rep.p50_us, rep.p99_us, rep.max_us,
+                        rep.corrupt ? ", CORRUPT FRAMES" : "");
+        }
+        return failures ? 1 : 0;
+    }
+#endif
+
+    // ns per span over `spans` back-to-back scopes on each of `threads` threads.
+    double trace_span_ns(int threads, int spans)
+    {
+        std::vector<double> perThread((size_t)threads, 0.0);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t)
+            pool.emplace_back([&, t]
+                              {
+                                  const auto t0 = Clock::now();
+                                  for (int i = 0; i < spans; ++i)
+                                  {
+                                      GCAP_TRACE_SCOPE(Convert, (uint64_t)i);
+                                  }
+                                  const auto t1 = Clock::now();
+                                  perThread[(size_t)t] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() / spans; });
+        for (auto &th : pool)
+            th.join();
+        return median(perThread);
+    }
+
+    int run_trace_overhead()
+    {
+        const int spans = 2000000;
+        const int hw = (int)std::max(1u, std::thread::hardware_concurrency());
+        const int many = std::min(hw, 4);
+        // A span is two events (begin and end timestamps); the budget is 50 ns per event.
+        auto report = [](const char *label, double ns)
+        { std::printf("  %-16s %6.1f ns/span %6.1f ns/event\n", label, ns, ns / 2); };
+        std::printf("trace span cost, %d spans per thread\n", spans);
+        report("off, 1 thread", trace_span_ns(1, spans));
+        if (gcap::trace::start(0) != GCAP_OK)
+        {
+            std::fprintf(stderr, "gcapture_bench: tracing is compiled out\n");
+            return 2;
+        }
+        // The first pass allocates the rings; the measured ones wrap them.
+        trace_span_ns(many, 1000);
+        report("on, 1 thread", trace_span_ns(1, spans));
+        if (many > 1)
+        {
+            const std::string label = "on, " + std::to_string(many) + " threads";
+            report(label.c_str(), trace_span_ns(many, spans));
+        }
+        gcap::trace::stop(nullptr);
+        return 0;
+    }
+
+    // ns per frame of what a capture thread records for gcap_get_stats(), while another
+    // thread snapshots every `pollUs` (0 = nobody reads). Returns the mean snapshot time too.
+    double stats_frame_ns(int frames, int pollUs, double *snapshotUs)
+    {
+        gcap::CaptureStats stats;
+        std::atomic<bool> done{false};
+        std::vector<double> snaps;
+        std::thread reader;
+        if (pollUs > 0)
+            reader = std::thread([&]
+                                 {
+                                     gcap_stats_t st;
+                                     while (!done.load(std::memory_order_relaxed))
+                                     {
+                                         const auto t0 = Clock::now();
+                                         stats.snapshot(st);
+                                         snaps.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / 1000.0);
+                                         std::this_thread::sleep_for(std::chrono::microseconds(pollUs));
+                                     } });
+        gcap::StatsShard &s = stats.shard(gcap::CaptureStats::Thread::Capture);
+        const auto t0 = Clock::now();
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t0.time_since_epoch()).count();
+        for (int i = 0; i < frames; ++i)
+        {
+            // A 60 fps frame: arrival, conversion, one callback, one copy.
+            ns += 16666667 + (uint64_t)(i % 97) * 1000;
+            s.arrived(ns);
+            s.record(gcap::StatHist::Convert, 800000 + (uint64_t)(i % 13) * 10000);
+            s.record(gcap::StatHist::Callback, 50000 + (uint64_t)(i % 7) * 1000);
+            s.delivered((uint64_t)i);
+            s.copied(3110400);
+            // Publication follows the real clock, as on a capture thread.
+            s.endFrame((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+        }
+        const double perFrame = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / frames;
+        done = true;
+        if (reader.joinable())
+            reader.join();
+        if (snapshotUs)
+            *snapshotUs = snaps.empty() ? 0.0 : median(snaps);
+        return perFrame;
+    }
+
+    int run_stats_overhead()
+    {
+        const int frames = 2000000;
+        std::printf("stats bookkeeping per frame, %d frames\n", frames);
+        double snapUs = 0.0;
+        std::printf("  %-18s %6.1f ns/frame\n", "no reader", stats_frame_ns(frames, 0, nullptr));
+        const double at10Hz = stats_frame_ns(frames, 100000, &snapUs);
+        std::printf("  %-18s %6.1f ns/frame, snapshot median %.1f us\n", "reader at 10 Hz", at10Hz, snapUs);
+        const double at1kHz = stats_frame_ns(frames, 1000, &snapUs);
+        std::printf("  %-18s %6.1f ns/frame, snapshot median %.1f us\n", "reader at 1 kHz", at1kHz, snapUs);
+
+        gcap::StatsShard shard;
+        const int pubs = 20000;
+        const auto t0 = Clock::now();
+        for (int i = 0; i < pubs; ++i)
+            shard.publish((uint64_t)i);
+        std::printf("  %-18s %6.1f ns (every 25 ms per thread)\n", "publish",
+                    (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / pubs);
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if (!parse_args(argc, argv, o))
+        return 2;
+    if (o.trace_overhead)
+        return run_trace_overhead();
+    if (o.stats_overhead)
+        return run_stats_overhead();
+    if (o.shm_loopback)
+    {
+#ifdef GCAP_BENCH_FORK
+        return run_shm_loopback(o);
+#else
+        std::fprintf(stderr, "gcapture_bench: --shm-loopback needs fork() (POSIX)\n");
+        return 2;
+#endif
+    }
+    if (o.ghz <= 0)
+        o.ghz = calibrate_ghz();
+
+    std::vector<const KernelChoice *> kernels;
+    for (int k : o.kernels)
+        if (gcap::simd::kernels_for(kKernels[k].isa))
+            kernels.push_back(&kKernels[k]);
+    if (kernels.empty())
+    {
+        std::fprintf(stderr, "gcapture_bench: none of the requested kernels is available on this CPU\n");
+        return 2;
+    }
+
+    gcap::convert_pool_acquire();
+
+    std::FILE *log = o.json_path == "-" || o.emit_golden ? stderr : stdout;
+    std::fprintf(log, "%-22s %-6s %-8s %3s %-7s %10s %12s %8s  %s\n",
+                 "converter", "res", "procamp", "thr", "kernel", "MPix/s", "ns/frame", "B/cycle", "checksum");
+
+    std::vector<Result> results;
+    std::vector<std::string> golden_lines;
+    int failures = 0;
+
+    for (const Case &c : kCases)
+    {
+        if (!o.filter.empty() && std::string(c.name).find(o.filter) == std::string::npos)
+            continue;
+        for (int ri : o.resolutions)
+        {
+            const Resolution &res = kResolutions[ri];
+            const SourceFrame src = make_source(c.source, res.width, res.height);
+            Target dst = make_target(c, res.width, res.height);
+            const double pixels = (double)res.width * (double)res.height;
+            const double bytes = (double)src.bytes + (double)dst.bytes;
+
+            for (int pa = 0; pa < 2; ++pa)
+            {
+                const bool procamp = pa == 1;
+                if ((procamp && (!o.procamp_on || !procamp_applies(c))) || (!procamp && !o.procamp_off))
+                    continue;
+                const Prepared prep = prepare(c, res.width, res.height, procamp);
+                const std::string key = golden_key(c, res, procamp);
+                const GoldenChecksum *golden = find_golden(key);
+                bool have_reference = false;
+                uint64_t reference = 0;
+
+                for (int threads : o.threads)
+                {
+                    gcap::set_convert_threads(threads);
+                    for (const KernelChoice *k : kernels)
+                    {
+                        gcap::simd::force_kernels(k->isa);
+
+                        // Warm-up frame doubles as the checksum run.
+                        std::fill(dst.data.begin(), dst.data.end(), (uint8_t)0);
+                        run_once(c, prep, src, res.width, res.height, dst);
+                        const uint64_t sum = checksum(dst);
+
+                        std::vector<double> samples;
+                        const auto start = Clock::now();
+                        while ((int)samples.size() < o.max_iters)
+                        {
+                            const auto t0 = Clock::now();
+                            run_once(c, prep, src, res.width, res.height, dst);
+                            const auto t1 = Clock::now();
+                            samples.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                            if ((int)samples.size() >= o.min_iters &&
+                                std::chrono::duration<double>(t1 - start).count() >= o.min_time)
+                                break;
+                        }
+
+                        Result r{};
+                        r.c = &c;
+                        r.res = &res;
+                        r.procamp = procamp;
+                        r.threads = gcap::convert_threads();
+                        r.kernel = k->name;
+                        r.iterations = (int)samples.size();
+                        r.ns_per_frame = median(samples);
+                        r.mpix_per_s = r.ns_per_frame > 0 ? pixels * 1e3 / r.ns_per_frame : 0.0;
+                        r.bytes_per_cycle = o.ghz > 0 && r.ns_per_frame > 0 ? bytes / (r.ns_per_frame * o.ghz) : 0.0;
+                        r.checksum = sum;
+
+                        // Every kernel and thread count must agree with the first run as well as the table.
+                        const bool agrees = !have_reference || sum == reference;
+                        if (!have_reference)
+                        {
+                            have_reference = true;
+                            reference = sum;
+                        }
+                        if (!agrees || (golden && golden->checksum != sum))
+                            r.golden = "mismatch";
+                        else
+                            r.golden = golden ? "ok" : "missing";
+                        if (!agrees || (golden && golden->checksum != sum))
+                            ++failures;
+
+                        std::fprintf(log, "%-22s %-6s %-8s %3d %-7s %10.1f %12.0f %8.3f  %016llx %s\n",
+                                     c.name, res.name, procamp ? "on" : "off", r.threads, r.kernel,
+                                     r.mpix_per_s, r.ns_per_frame, r.bytes_per_cycle,
+                                     (unsigned long long)sum, r.golden);
+                        std::fflush(log);
+                        results.push_back(r);
+                    }
+                }
+                char line[160];
+                std::snprintf(line, sizeof(line), "    {\"%s\", 0x%016llxull},", key.c_str(), (unsigned long long)reference);
+                golden_lines.push_back(line);
+            }
+        }
+    }
+
+    gcap::set_convert_threads(0);
+    gcap::convert_pool_release();
+
+    if (o.emit_golden)
+    {
+        std::printf("// golden_checksums.h\n"
+                    "// Generated by `gcapture_bench --emit-golden`; included inside gcapture_bench.cpp.\n"
+                    "// Regenerate only when a conversion is meant to change its output.\n"
+                    "const GoldenChecksum kGoldenChecksums[] = {\n");
+        for (const std::string &l : golden_lines)
+            std::printf("%s\n", l.c_str());
+        std::printf("};\n");
+        return 0;
+    }
+
+    if (!o.json_path.empty())
+    {
+        std::FILE *f = o.json_path == "-" ? stdout : std::fopen(o.json_path.c_str(), "w");
+        if (!f)
+        {
+            std::fprintf(stderr, "gcapture_bench: cannot write %s\n", o.json_path.c_str());
+            return 2;
+        }
+        write_json(f, o, results);
+        if (f != stdout)
+            std::fclose(f);
+    }
+
+    if (failures)
+        std::fprintf(stderr, "gcapture_bench: %d checksum mismatch(es)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// golden_checksums.h
+// Generated by `gcapture_bench --emit-golden`; included inside gcapture_bench.cpp.
+// Regenerate only when a conversion is meant to change its output.
+const GoldenChecksum kGoldenChecksums[] = {
+    {"nv12>bgra@720p", 0xd33b1073087150d4ull},
+    {"nv12>bgra@720p+procamp", 0x257f074ea00fd1aaull},
+    {"nv12>bgra@1080p", 0xc2955a4e60b92889ull},
+    {"nv12>bgra@1080p+procamp", 0x54d4baa731a7d8daull},
+    {"nv12>bgra@4K", 0x1a22ddd2636cdaf2ull},
+    {"nv12>bgra@4K+procamp", 0xe9101fce63f4d8a7ull},
+    {"nv12>bgra@8K", 0x090a143a0f0f240eull},
+    {"nv12>bgra@8K+procamp", 0xb3ba697ba53c2c85ull},
+    {"yuy2>bgra@720p", 0xaba3804a6ad77f60ull},
+    {"yuy2>bgra@720p+procamp", 0xe6b39c1cae04ea34ull},
+    {"yuy2>bgra@1080p", 0xc9198bea4e3a6a5aull},
+    {"yuy2>bgra@1080p+procamp", 0xd67e9b9ff5691590ull},
+    {"yuy2>bgra@4K", 0x33106ec643767b18ull},
+    {"yuy2>bgra@4K+procamp", 0xcee2508dbcf409aaull},
+    {"yuy2>bgra@8K", 0x52e88f57ece4ed7bull},
+    {"yuy2>bgra@8K+procamp", 0x548624f9869fb6f1ull},
+    {"y210>bgra@720p", 0xe09c3f626f8fd21dull},
+    {"y210>bgra@720p+procamp", 0x6c2910918a958160ull},
+    {"y210>bgra@1080p", 0xe9c94497d07fb35dull},
+    {"y210>bgra@1080p+procamp", 0x9aed0117136ae215ull},
+    {"y210>bgra@4K", 0xd1200812f8defd26ull},
+    {"y210>bgra@4K+procamp", 0x12b4624c9701895cull},
+    {"y210>bgra@8K", 0x089912f6e846a8ceull},
+    {"y210>bgra@8K+procamp", 0x46eb24008b081b23ull},
+    {"y210>rgba64@720p", 0xa2d0b5c218eb42a0ull},
+    {"y210>rgba64@720p+procamp", 0x49a2bfba00ce90ddull},
+    {"y210>rgba64@1080p", 0xfb0d763bfff8a346ull},
+    {"y210>rgba64@1080p+procamp", 0xf72965e82003002full},
+    {"y210>rgba64@4K", 0xb87f270ac6f6db3bull},
+    {"y210>rgba64@4K+procamp", 0xba80111f39c1b673ull},
+    {"y210>rgba64@8K", 0x5dc590c1d877634aull},
+    {"y210>rgba64@8K+procamp", 0x0957ee06e91ef88full},
+    {"p010>bgra@720p", 0x6bf0f332a4e974e8ull},
+    {"p010>bgra@720p+procamp", 0xd8dc54db36e29f6bull},
+    {"p010>bgra@1080p", 0xf22fb3c911f7b719ull},
+    {"p010>bgra@1080p+procamp", 0x89ce326b690a1fb9ull},
+    {"p010>bgra@4K", 0xcdc40ce3c0d60cfcull},
+    {"p010>bgra@4K+procamp", 0x06dfadc7fefdb44cull},
+    {"p010>bgra@8K", 0x9936c6ce0fc9e366ull},
+    {"p010>bgra@8K+procamp", 0xeae3ffe4591fa5cfull},
+    {"p010>bgra-dither@720p", 0xd169bb0fea446b56ull},
+    {"p010>bgra-dither@720p+procamp", 0x92e6af7313f37b03ull},
+    {"p010>bgra-dither@1080p", 0x2cf03201420d6a63ull},
+    {"p010>bgra-dither@1080p+procamp", 0x55436abe1fff4d5full},
+    {"p010>bgra-dither@4K", 0x51aebdb7926593fbull},
+    {"p010>bgra-dither@4K+procamp", 0x83808b0856506024ull},
+    {"p010>bgra-dither@8K", 0xbb2aa699d5e38b02ull},
+    {"p010>bgra-dither@8K+procamp", 0xe79f34e51b2aa96bull},
+    {"p010>rgba64@720p", 0x9c66729c72acb13aull},
+    {"p010>rgba64@720p+procamp", 0xce11f8b97ac23a5eull},
+    {"p010>rgba64@1080p", 0xcbf8aaabda5ccb13ull},
+    {"p010>rgba64@1080p+procamp", 0xd90990220ed91568ull},
+    {"p010>rgba64@4K", 0x31bdbe6b9ceabe17ull},
+    {"p010>rgba64@4K+procamp", 0x224fb023136358f7ull},
+    {"p010>rgba64@8K", 0x2ee93cbd7c8f582eull},
+    {"p010>rgba64@8K+procamp", 0x0c9a90e6f6dc3fb3ull},
+    {"p010>x2rgb10@720p", 0xc964a57385a981c8ull},
+    {"p010>x2rgb10@720p+procamp", 0xb6ec1909c6e9581eull},
+    {"p010>x2rgb10@1080p", 0x4c08ba5a83a84028ull},
+    {"p010>x2rgb10@1080p+procamp", 0x488ecbd576991a42ull},
+    {"p010>x2rgb10@4K", 0x7177964eba3fac0aull},
+    {"p010>x2rgb10@4K+procamp", 0xcb4f2c0100012a35ull},
+    {"p010>x2rgb10@8K", 0x414367f2a406489cull},
+    {"p010>x2rgb10@8K+procamp", 0x7500aa260c9cd8daull},
+    {"v210>bgra@720p", 0xf8acf159dc242c30ull},
+    {"v210>bgra@720p+procamp", 0xdd9eea7c5e76fdedull},
+    {"v210>bgra@1080p", 0x830086943ed92138ull},
+    {"v210>bgra@1080p+procamp", 0x6ee0dfe0ac596946ull},
+    {"v210>bgra@4K", 0xa59b36cb1abedd97ull},
+    {"v210>bgra@4K+procamp", 0x76dedecce11ec414ull},
+    {"v210>bgra@8K", 0xcbed965d0b520aceull},
+    {"v210>bgra@8K+procamp", 0x74c5376dd8a43eaeull},
+    {"v210>rgba64@720p", 0xf941218f360d354aull},
+    {"v210>rgba64@720p+procamp", 0xfbdd9ce1f84a9cfbull},
+    {"v210>rgba64@1080p", 0xb21fd4d5e3dddabaull},
+    {"v210>rgba64@1080p+procamp", 0xa7b77bc8835ccdccull},
+    {"v210>rgba64@4K", 0xf0d09cfa7f79aa0eull},
+    {"v210>rgba64@4K+procamp", 0xfcc0028592f8e78dull},
+    {"v210>rgba64@8K", 0xa727f34cd22de3a4ull},
+    {"v210>rgba64@8K+procamp", 0xca02b996055d4d85ull},
+    {"v210>p010@720p", 0xc4a6de56daba85e5ull},
+    {"v210>p010@1080p", 0xecfc589df070c2a5ull},
+    {"v210>p010@4K", 0x1d43382cd1778465ull},
+    {"v210>p010@8K", 0x2dc44d72ef149ca5ull},
+    {"r210>bgra@720p", 0x28301b2855de6954ull},
+    {"r210>bgra@1080p", 0x53758e65c1de8315ull},
+    {"r210>bgra@4K", 0xef80dc0b98cbb97aull},
+    {"r210>bgra@8K", 0x3644688c05e32440ull},
+    {"r210>rgba64@720p", 0x349ca3ebdce1a8fbull},
+    {"r210>rgba64@1080p", 0xd3047dd3b9656d96ull},
+    {"r210>rgba64@4K", 0xd83e368440fc61d1ull},
+    {"r210>rgba64@8K", 0xefd893f2af1409a4ull},
+    {"nv12>bgra/2-box@720p", 0x5d2572da63164505ull},
+    {"nv12>bgra/2-box@720p+procamp", 0x483ba41becdff8eaull},
+    {"nv12>bgra/2-box@1080p", 0x5fed72b6b3725afaull},
+    {"nv12>bgra/2-box@1080p+procamp", 0x0efd05b755c3a5edull},
+    {"nv12>bgra/2-box@4K", 0x533da66d72ebf3c5ull},
+    {"nv12>bgra/2-box@4K+procamp", 0x59e60f3eb5e08efdull},
+    {"nv12>bgra/2-box@8K", 0xd1624afa9404e6afull},
+    {"nv12>bgra/2-box@8K+procamp", 0x412ef1c22c5264ffull},
+    {"nv12>bgra/3-bilinear@720p", 0x68ef2ccbdc7d13b8ull},
+    {"nv12>bgra/3-bilinear@720p+procamp", 0x41674811e9e74100ull},
+    {"nv12>bgra/3-bilinear@1080p", 0xf96909023d6353edull},
+    {"nv12>bgra/3-bilinear@1080p+procamp", 0x2cb17a210ee62a41ull},
+    {"nv12>bgra/3-bilinear@4K", 0x661e3d75f0aed8c5ull},
+    {"nv12>bgra/3-bilinear@4K+procamp", 0x160082fd21b2c9ddull},
+    {"nv12>bgra/3-bilinear@8K", 0x998dc602232a5ed3ull},
+    {"nv12>bgra/3-bilinear@8K+procamp", 0x26ee4e6fb581a55full},
+    {"p010>bgra/2-box@720p", 0xb6df806316291591ull},
+    {"p010>bgra/2-box@720p+procamp", 0x1d8459c73f952763ull},
+    {"p010>bgra/2-box@1080p", 0xbdea6b8b53fcaabcull},
+    {"p010>bgra/2-box@1080p+procamp", 0x718c060482bc4d42ull},
+    {"p010>bgra/2-box@4K", 0xc2e02e0ec3af7b48ull},
+    {"p010>bgra/2-box@4K+procamp", 0x86f0f9298dd52bd4ull},
+    {"p010>bgra/2-box@8K", 0x8cb59a4a6a0384d4ull},
+    {"p010>bgra/2-box@8K+procamp", 0x35dce5d849ec8be9ull},
+    {"y210>bgra/4-box@720p", 0x97516c4139304e73ull},
+    {"y210>bgra/4-box@720p+procamp", 0x4f74ac96557b29b8ull},
+    {"y210>bgra/4-box@1080p", 0xde9ccdc0eb84c004ull},
+    {"y210>bgra/4-box@1080p+procamp", 0xd39ef1df98bdb946ull},
+    {"y210>bgra/4-box@4K", 0xe21c3e7d854209c5ull},
+    {"y210>bgra/4-box@4K+procamp", 0x0e1281a7672a8f2bull},
+    {"y210>bgra/4-box@8K", 0x26a988e308ea7d36ull},
+    {"y210>bgra/4-box@8K+procamp", 0x948add9359835a5full},
+};
@@ -0,0 +1,57 @@
+#pragma once
+// Consumer side of the shared-memory frame ring published with gcap_publish_shm().
+// Link gcapture_shm (static, no Qt / Media Foundation); the reading process does
+// not load gcapture itself.
+#include <stdint.h>
+#include "gcapture.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct gcap_shm_reader_t *gcap_shm_reader;
+
+    // A frame in the ring, read in place. Valid until gcap_shm_release(); the publisher
+    // skips slots that are still held, so holding frames for long costs it ring slots.
+    typedef struct
+    {
+        const void *data[3];
+        int stride[3];
+        int plane_count;
+        int width, height;
+        gcap_pixfmt_t format;
+        uint64_t pts_ns;
+        uint64_t pts_smoothed_ns;
+        uint64_t frame_id;
+        uint64_t publish_ns; // publisher's steady clock when the frame became visible
+        uint64_t seq;        // ring sequence, starts at 1
+        int slot;            // SDK-internal
+    } gcap_shm_frame_t;
+
+    typedef struct
+    {
+        int slots;
+        int readers;        // consumers attached now
+        uint64_t published;
+        uint64_t dropped;   // frames the publisher skipped: every slot held by readers
+        uint64_t too_large; // frames bigger than a slot
+    } gcap_shm_info_t;
+
+    // GCAP_ENODEV until the publisher has created the ring (on its first frame);
+    // GCAP_ESTATE when the ring already has its maximum number of readers.
+    gcap_status_t gcap_shm_open(const char *name, gcap_shm_reader *out);
+    // Waits for a frame newer than after_seq: 1 = there is one, 0 = timeout,
+    // -1 = the publisher stopped or its process is gone (reopen to follow a new one; a crash
+    // is noticed within ~250 ms). timeout_ms < 0 waits until one of those.
+    int gcap_shm_wait(gcap_shm_reader r, uint64_t after_seq, int timeout_ms);
+    // Newest frame, held until gcap_shm_release(). GCAP_ESTATE when nothing was published yet.
+    gcap_status_t gcap_shm_acquire_latest(gcap_shm_reader r, gcap_shm_frame_t *out);
+    void gcap_shm_release(gcap_shm_reader r, const gcap_shm_frame_t *frame);
+    gcap_status_t gcap_shm_get_info(gcap_shm_reader r, gcap_shm_info_t *out);
+    // Releases anything still held.
+    void gcap_shm_close(gcap_shm_reader r);
+
+#ifdef __cplusplus
+}
+#endif
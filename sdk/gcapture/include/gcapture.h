@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 #include "gcap_audio.h"
 
@@ -22,7 +23,10 @@ extern "C"
         GCAP_BACKEND_WINMF_CPU = 0,
         GCAP_BACKEND_WINMF_GPU = 1,
         GCAP_BACKEND_DSHOW = 2,
-        GCAP_BACKEND_AUTO = 3
+        GCAP_BACKEND_AUTO = 3,
+        GCAP_BACKEND_SYNTHETIC = 4, // generated test patterns, any platform (gcap_set_synthetic_opts)
+        GCAP_BACKEND_REPLAY = 5,    // memory-mapped recordings, any platform (gcap_set_replay_opts)
+        GCAP_BACKEND_V4L2 = 6       // Video4Linux2 capture devices (Linux; the default backend there)
     } gcap_backend_t;
 
     enum gcap_profile_mode_t
@@ -49,7 +53,13 @@ extern "C"
         GCAP_FMT_P010,
         GCAP_FMT_Y210,
         GCAP_FMT_V210,
-        GCAP_FMT_R210
+        GCAP_FMT_R210,
+        GCAP_FMT_RGBA64,     // CPU output: R, G, B, A as 16-bit UNORM words
+        GCAP_FMT_X2R10G10B10, // CPU output: dword per pixel, B bits 0-9, G 10-19, R 20-29
+        GCAP_FMT_Y8,          // subscriber output: 8-bit luma plane only
+        GCAP_FMT_I420,        // replay (Y4M): 8-bit Y, U, V planes, 4:2:0
+        GCAP_FMT_I010,        // replay (Y4M): as I420 with 16-bit words holding 10-bit values
+        GCAP_FMT_RG10         // replay (RG10 dump): R, G, B as 16-bit words holding 10-bit values
     } gcap_pixfmt_t;
 
     typedef struct
@@ -136,8 +146,66 @@ extern "C"
         char input_signal_desc[64];       // e.g. RGB444 / BT.709 / 8-bit (may be inferred)
         char input_signal_note[32];       // e.g. Inferred / Driver / Unknown
         char negotiated_desc[32];         // e.g. RGB24 / NV12 / YUY2 / ARGB32
+        int lease_slots;                  // frame pool slots allocated (gcap_frame_retain)
+        int lease_outstanding;            // frames currently retained by the application
+        uint64_t lease_exhausted;         // frames that found every slot retained (handled per gcap_lease_policy_t)
+        uint64_t arena_bytes;             // frame arena reserved by gcap_set_buffers (0 = none)
+        uint64_t arena_used_bytes;        // arena blocks currently holding frames
+        int arena_huge_pages;             // 1 when the arena is backed by large / transparent huge pages
+        uint64_t arena_misses;            // slot buffers that did not fit the arena and came from the heap
+        uint64_t frames_dropped;          // cadence gaps in device (or arrival) timestamps
+        uint64_t frames_duplicated;       // repeated or early device timestamps
+        double clock_drift_ppm;           // device clock rate vs host clock (0 without device timestamps)
+        double clock_offset_ms;           // host - device clock at the latest frame
+        double jitter_p50_us;             // |arrival - recovered frame time|, last ~2 s of frames
+        double jitter_p95_us;
+        double jitter_p99_us;
+        int delivery_policy;              // gcap_delivery_policy_t in effect
+        int delivery_depth;               // frames waiting for the delivery thread
+        int delivery_depth_hwm;           // most frames queued at once since gcap_start
+        uint64_t delivery_delivered;      // callbacks run by the delivery thread
+        uint64_t delivery_dropped_oldest; // DROP_OLDEST: queued frames evicted
+        uint64_t delivery_dropped_newest; // DROP_NEWEST: new frames discarded
+        uint64_t delivery_replaced;       // LATEST_ONLY: undelivered frames replaced
+        uint64_t delivery_block_timeouts; // BLOCK: frames discarded after block_timeout_ms
+        uint64_t delivery_blocked_ns;     // BLOCK: total time the capture thread waited
+        uint64_t delivery_copy_failed;    // frames that needed a pool slot for queueing and found none
     } gcap_runtime_info_t;
 
+    // Log-linear ("HDR") histogram buckets: values 0..7 get a bucket each, above that every
+    // power of two is split into 8 equal buckets, so a bucket is at most 12.5% wide. Values
+    // of 2^40 and more (about 18 minutes in ns, 1 TiB in bytes) land in the last bucket.
+    // Bucket i >= 8 starts at (8 + i % 8) << (i / 8 - 1).
+#define GCAP_STATS_BUCKETS 304
+
+    typedef struct
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t min; // exact; 0 when count is 0
+        uint64_t max; // exact
+        uint64_t p50; // percentiles: middle of the bucket holding them, within [min, max]
+        uint64_t p90;
+        uint64_t p99;
+        uint64_t p999;
+        uint64_t buckets[GCAP_STATS_BUCKETS];
+    } gcap_histogram_t;
+
+    typedef struct
+    {
+        uint64_t frames_captured;         // frames that arrived from the device
+        uint64_t frames_delivered;        // frames whose video / packet callbacks ran
+        uint64_t frames_dropped;          // cadence gaps in device (or arrival) timestamps
+        uint64_t frames_duplicated;       // repeated or early device timestamps
+        uint64_t frames_dropped_delivery; // discarded by the delivery stage (gcap_set_delivery)
+        uint64_t bytes_copied;            // frame bytes memcpy'd by the SDK (not conversions)
+        gcap_histogram_t frame_interval_ns; // host arrival time between consecutive frames
+        gcap_histogram_t convert_ns;        // CPU colour conversion / resize per frame
+        gcap_histogram_t callback_ns;       // one video / packet callback (with the subscribers after it)
+        gcap_histogram_t queue_wait_ns;     // delivery queue: push to callback start
+        gcap_histogram_t copy_bytes;        // bytes copied per delivered frame
+    } gcap_stats_t;
+
     typedef enum
     {
         GCAP_DEINT_AUTO = 0,
@@ -146,11 +214,23 @@ extern "C"
         GCAP_DEINT_BOB
     } gcap_deinterlace_t;
 
+    // What the CPU path delivers for 10-bit sources (P010 / Y210). 8-bit sources always give ARGB.
+    typedef enum
+    {
+        GCAP_CPU_OUT_ARGB = 0,        // 8-bit BGRA (default)
+        GCAP_CPU_OUT_ARGB_DITHER = 1, // 8-bit BGRA from the 10-bit matrix with an ordered dither (no banding)
+        GCAP_CPU_OUT_RGBA64 = 2,      // GCAP_FMT_RGBA64 frames, full 10-bit precision
+        GCAP_CPU_OUT_X2R10G10B10 = 3  // GCAP_FMT_X2R10G10B10 frames, full 10-bit precision
+    } gcap_cpu_output_t;
+
     typedef struct
     {
         gcap_pixfmt_t preferred_pixfmt; // Auto=GCAP_FMT_*?（你可用 NV12/YUY2/P010）
         gcap_deinterlace_t deinterlace;
         gcap_range_t force_range; // unknown=auto
+        int worker_threads;       // CPU conversion threads incl. caller: 0=auto, 1=single-threaded. Process-wide:
+                                  // one pool serves every handle, the last accepted gcap_set_processing sets it
+        gcap_cpu_output_t cpu_output; // CPU path output for 10-bit sources; sharpness applies to GCAP_CPU_OUT_ARGB only
     } gcap_processing_opts_t;
 
     // ----------------------------
@@ -183,6 +263,7 @@ extern "C"
         gcap_pixfmt_t format;
         uint64_t pts_ns;
         uint64_t frame_id;
+        const void *lease; // SDK-internal; non-null when gcap_frame_retain() can keep this frame
     } gcap_frame_t;
 
     typedef enum
@@ -191,7 +272,10 @@ extern "C"
         GCAP_SOURCE_WINMF_GPU = 1,
         GCAP_SOURCE_WINMF_CPU = 2,
         GCAP_SOURCE_DSHOW_RAWSINK = 3,
-        GCAP_SOURCE_DSHOW_RENDERER = 4
+        GCAP_SOURCE_DSHOW_RENDERER = 4,
+        GCAP_SOURCE_SYNTHETIC = 5,
+        GCAP_SOURCE_REPLAY = 6,
+        GCAP_SOURCE_V4L2_MMAP = 7 // packet points into a driver buffer, requeued once the callbacks return
     } gcap_frame_source_kind_t;
 
     typedef struct
@@ -206,8 +290,53 @@ extern "C"
         int backend;
         int source_kind;
         int gpu_backed;
+        const void *lease; // SDK-internal; non-null when gcap_frame_packet_retain() can keep this packet
+        // Frame time on the host steady clock, recovered from device timestamps (or the
+        // arrival cadence): free of capture-thread jitter, follows device clock drift. 0 = unknown.
+        uint64_t pts_smoothed_ns;
     } gcap_frame_packet_t;
 
+    // What a provider does with a new frame when every pool slot is still retained
+    // by the application and the pool is at max_slots.
+    typedef enum
+    {
+        GCAP_LEASE_POLICY_UNLEASED = 0, // deliver from provider scratch memory; retain returns nullptr for that frame
+        GCAP_LEASE_POLICY_SKIP          // skip the callbacks for that frame (preview / recording continue)
+    } gcap_lease_policy_t;
+
+    typedef struct
+    {
+        int slots;     // frame slots per handle (0 = 4)
+        int max_slots; // the pool grows up to this many while frames are retained (0 = 2 * slots)
+        gcap_lease_policy_t policy;
+    } gcap_lease_opts_t;
+
+    // Where frame callbacks run. SYNC calls them on the capture thread; the others
+    // queue the frame (retained, or copied into a pool slot) for a delivery thread.
+    typedef enum
+    {
+        GCAP_DELIVERY_SYNC = 0,    // callbacks on the capture thread (default)
+        GCAP_DELIVERY_BLOCK,       // full queue: the capture thread waits for space
+        GCAP_DELIVERY_DROP_OLDEST, // full queue: the oldest queued frame is discarded
+        GCAP_DELIVERY_DROP_NEWEST, // full queue: the new frame is discarded
+        GCAP_DELIVERY_LATEST_ONLY  // one-frame mailbox: a new frame replaces an undelivered one
+    } gcap_delivery_policy_t;
+
+    typedef struct
+    {
+        gcap_delivery_policy_t policy;
+        int depth;            // queued frames (0 = 4, max 64; LATEST_ONLY is always 1)
+        int block_timeout_ms; // BLOCK: longest wait before the frame is discarded (0 = until gcap_stop)
+    } gcap_delivery_opts_t;
+
+    typedef struct
+    {
+        int count;         // frame buffers preallocated per handle (0 = no arena)
+        size_t bytes_hint; // bytes per buffer (0 = sized at gcap_start from the profile, 4 bytes per pixel)
+        int huge_pages;    // 0/1: back the arena with large pages (Windows, needs "Lock pages in memory") or THP
+        int prefault;      // 0/1: touch every page at gcap_start so the first frames take no page faults
+    } gcap_buffer_opts_t;
+
     typedef struct
     {
         void *hwnd;         // native HWND
@@ -216,10 +345,125 @@ extern "C"
         int swapchain_10bit;
     } gcap_preview_desc_t;
 
+    typedef enum
+    {
+        GCAP_SCALE_AUTO = 0, // box for exact 2x / 4x reductions, bilinear otherwise
+        GCAP_SCALE_BOX,      // 2x / 4x box average (falls back to bilinear for other ratios)
+        GCAP_SCALE_BILINEAR
+    } gcap_scale_filter_t;
+
+    // Size of the frames handed to the video callback. The CPU paths convert
+    // and resize in one pass, so a small preview never costs a full-size BGRA frame.
+    typedef struct
+    {
+        int width;  // 0 = follow the source aspect ratio from height (both 0 = source size)
+        int height; // 0 = follow the source aspect ratio from width
+        gcap_scale_filter_t filter;
+    } gcap_video_output_t;
+
     typedef void (*gcap_on_video_cb)(const gcap_frame_t *frame, void *user);
     typedef void (*gcap_on_frame_packet_cb)(const gcap_frame_packet_t *pkt, void *user);
     typedef void (*gcap_on_error_cb)(gcap_status_t code, const char *msg, void *user);
 
+    // One consumer of gcap_subscribe(). Frames arrive as packets in `format` at the
+    // requested size and rate; packets are pool-backed, so gcap_frame_packet_retain() works.
+    typedef struct
+    {
+        gcap_pixfmt_t format;       // GCAP_FMT_ARGB, GCAP_FMT_NV12, GCAP_FMT_Y8, or the source format (source size only)
+        int width, height;          // as gcap_video_output_t: 0 follows the source aspect ratio, both 0 = source size
+        gcap_scale_filter_t filter;
+        int fps_num, fps_den;       // target rate, frames picked by pts on that cadence (0 = every frame)
+        gcap_on_frame_packet_cb cb;
+        void *user;
+    } gcap_subscriber_desc_t;
+
+    // Frames published into a named shared-memory ring for other processes, which read
+    // them in place through gcap_shm.h. Format, size and rate are as for a subscriber.
+    typedef struct
+    {
+        const char *name;  // [A-Za-z0-9._-], up to 64 characters
+        int slots;         // frames in the ring (0 = 4, 2..64)
+        size_t slot_bytes; // bytes per frame (0 = sized from the first frame; larger frames are dropped)
+        gcap_pixfmt_t format;
+        int width, height;
+        gcap_scale_filter_t filter;
+        int fps_num, fps_den;
+    } gcap_shm_publisher_desc_t;
+
+    // Frame pacing of GCAP_BACKEND_SYNTHETIC.
+    typedef enum
+    {
+        GCAP_SYNTHETIC_PACE_CLOCK = 0, // frame n is due at start + n / fps on the steady clock; late slots are skipped (counted as drops)
+        GCAP_SYNTHETIC_PACE_FREE_RUN   // the next frame as soon as the previous one's callbacks return
+    } gcap_synthetic_pacing_t;
+
+    // The synthetic test source. It generates NV12 / YUY2 / P010 / Y210 / V210 at up to
+    // 7680x4320 and 120 fps, as picked by the profile (default 1920x1080, 60 fps, NV12):
+    // 75% colour bars over a luma ramp, scrolling left. Frame n depends only on n, the
+    // profile and the device index; the low 32 bits of n are stamped into its top-left
+    // corner (32 cells of 12x8 pixels, most significant bit first, white = 1). Packets
+    // carry the source format, the video callback gets the CPU conversion, and recording
+    // appends the raw source frames to a file.
+    typedef struct
+    {
+        int device_count; // virtual devices listed by gcap_enumerate (0 = 1, max 16)
+        gcap_synthetic_pacing_t pacing;
+        int zero_copy;    // 0/1: packets point into the pre-rendered pattern (no copy, no stamp, not retainable)
+    } gcap_synthetic_opts_t;
+
+    // Frame pacing of GCAP_BACKEND_REPLAY.
+    typedef enum
+    {
+        GCAP_REPLAY_PACE_PTS = 0,  // real time: frame n at its pts (the Y4M frame rate; the profile's rate for raw / RG10)
+        GCAP_REPLAY_PACE_FIXED,    // real time at fps_num / fps_den
+        GCAP_REPLAY_PACE_FREE_RUN  // the next frame as soon as the previous one's callbacks return
+    } gcap_replay_pacing_t;
+
+    // The replay source memory-maps one recording, listed by gcap_enumerate as the only
+    // device, and delivers packets pointing into the mapping (valid inside the callback,
+    // not retainable):
+    //  - raw: packed frames as GCAP_BACKEND_SYNTHETIC records them; a GCAP_PROFILE_CUSTOM
+    //    profile gives the size and format (NV12 / YUY2 / P010 / Y210 / V210) and the rate;
+    //  - Y4M: 4:2:0, 8-bit (GCAP_FMT_I420) or C420p10 (GCAP_FMT_I010);
+    //  - RG10: a gcap_export_preview_scene_rgb10 dump, one frame (GCAP_FMT_RG10).
+    // The video callback gets the CPU conversion. A frame that is due late is delivered
+    // late rather than skipped and the timeline restarts from it, so every frame of the
+    // file reaches the callbacks, in order.
+    typedef struct
+    {
+        const char *path_utf8;
+        gcap_replay_pacing_t pacing;
+        int fps_num, fps_den; // GCAP_REPLAY_PACE_FIXED
+        int loop;             // 0/1: restart at the end of the file; otherwise the stream ends (logged through the error callback)
+    } gcap_replay_opts_t;
+
+    // Opt-in measurement behind GCAP_BACKEND_AUTO. The first gcap_open of a device and
+    // profile streams each candidate backend (and, without a GCAP_PROFILE_CUSTOM profile,
+    // each pixel format the backend lets gcap_set_processing pick) for warmup_ms +
+    // measure_ms, then opens the one that reaches the full frame rate with the least
+    // process CPU time per frame; frame-interval jitter, then time to the first frame,
+    // break ties. The figures go to the error callback as GCAP_OK messages. The choice is
+    // remembered per symbolic link and profile, so later opens skip the measurement.
+    typedef struct
+    {
+        int enable;                  // 0/1
+        int warmup_ms;               // per candidate, after its first frame (0 = 300)
+        int measure_ms;              // per candidate (0 = 1000)
+        const char *cache_path_utf8; // choices file, read now and rewritten after each calibration (nullptr = this process only)
+    } gcap_auto_calibration_t;
+
+    // gcap_enumerate, gcap_enum_video_caps and gcap_enum_supported_pixel_formats answer from a
+    // process-wide cache (on by default): device lists per backend, capabilities per device
+    // (symbolic link and name). A capture device arriving or leaving drops the lists and this
+    // run's capabilities; gcap_refresh_devices drops everything. Without arrival/removal
+    // notifications (Windows before 8) the lists are read on every call.
+    typedef struct
+    {
+        int enable;                  // 0/1
+        const char *cache_path_utf8; // capabilities file, read now and rewritten as devices are queried; its
+                                     // entries are kept until gcap_refresh_devices (nullptr = this process only)
+    } gcap_device_cache_opts_t;
+
     typedef struct gcap_handle_t *gcap_handle;
 
     gcap_status_t gcap_enumerate(gcap_device_info_t *out, int max, int *count);
@@ -228,8 +472,58 @@ extern "C"
     GCAP_API gcap_status_t gcap_open2(gcap_handle h, int device_index);
     gcap_status_t gcap_set_profile(gcap_handle h, const gcap_profile_t *prof);
     gcap_status_t gcap_set_buffers(gcap_handle h, int count, size_t bytes_hint);
+    // Frame buffers carved from one preallocated arena; CPU frames use 64-byte aligned rows.
+    // gcap_set_buffers(h, count, hint) is this with huge_pages = 0, prefault = 1.
+    GCAP_API gcap_status_t gcap_set_buffers_ex(gcap_handle h, const gcap_buffer_opts_t *opts);
     gcap_status_t gcap_set_callbacks(gcap_handle h, gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user);
+    // Same as gcap_set_callbacks(), with the video callback's output size (nullptr = source size).
+    // Honoured by the CPU conversion paths (WinMF CPU, DShow ARGB bridge) for NV12/YUY2/P010/Y210.
+    GCAP_API gcap_status_t gcap_set_callbacks_ex(gcap_handle h, gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user,
+                                                 const gcap_video_output_t *out);
     GCAP_API gcap_status_t gcap_set_frame_packet_callback(gcap_handle h, gcap_on_frame_packet_cb cb, void *user);
+
+    // Zero-copy frame leases. Inside a video / packet callback, retain keeps the frame's
+    // pixels (and the returned descriptor) valid on any thread until the matching release.
+    // Returns nullptr for frames that are not pool-backed (GPU readback, pass-through ARGB,
+    // or a frame delivered under GCAP_LEASE_POLICY_UNLEASED); copy those before returning.
+    // A retained descriptor may be retained again; each retain needs one release.
+    GCAP_API const gcap_frame_t *gcap_frame_retain(const gcap_frame_t *frame);
+    GCAP_API void gcap_frame_release(const gcap_frame_t *frame);
+    GCAP_API const gcap_frame_packet_t *gcap_frame_packet_retain(const gcap_frame_packet_t *pkt);
+    GCAP_API void gcap_frame_packet_release(const gcap_frame_packet_t *pkt);
+    // Converts a CPU packet to GCAP_FMT_ARGB (from any CPU format), or to GCAP_FMT_RGBA64 /
+    // GCAP_FMT_X2R10G10B10 (from the 10-bit formats) with the SDK kernels; dst holds height
+    // rows of dst_stride bytes. The result is cached per frame and format, so other
+    // consumers converting the same frame get a copy. Callable from any thread while the
+    // packet is valid (inside the callback, or retained). GCAP_ENOTSUP for other formats.
+    GCAP_API gcap_status_t gcap_packet_convert(const gcap_frame_packet_t *pkt, gcap_pixfmt_t dst_format, void *dst,
+                                               int dst_stride);
+    // Pool size and exhaustion policy for frames delivered to this handle (nullptr = defaults).
+    GCAP_API gcap_status_t gcap_set_lease_policy(gcap_handle h, const gcap_lease_opts_t *opts);
+    // Callback delivery stage (nullptr = GCAP_DELIVERY_SYNC). Only while stopped (GCAP_ESTATE
+    // otherwise). Queued frames hold pool slots, so the pool grows by depth + 1 slots.
+    GCAP_API gcap_status_t gcap_set_delivery(gcap_handle h, const gcap_delivery_opts_t *opts);
+    // Extra frame consumers next to the packet callback, e.g. a BGRA preview at 30 fps, an NV12
+    // recorder at full rate and a small Y8 analyser at 5 fps. Subscribers that ask for the same
+    // format and size share one conversion per frame. They run where packet callbacks run
+    // (the capture thread, or the delivery thread with gcap_set_delivery). Any time, any thread.
+    GCAP_API gcap_status_t gcap_subscribe(gcap_handle h, const gcap_subscriber_desc_t *desc, int *out_id);
+    // Once it returns the subscriber's callback is not running and is not called again
+    // (when called from that callback, after the callback returns).
+    GCAP_API gcap_status_t gcap_unsubscribe(gcap_handle h, int id);
+    // Publishes frames into a shared-memory ring (a subscriber that copies each frame once
+    // into the ring). The ring is created on the first frame; a ring of the same name left
+    // by a publisher that died is replaced. gcap_unpublish_shm() tells readers it stopped.
+    GCAP_API gcap_status_t gcap_publish_shm(gcap_handle h, const gcap_shm_publisher_desc_t *desc, int *out_id);
+    GCAP_API gcap_status_t gcap_unpublish_shm(gcap_handle h, int id);
+
+    // Hot-path tracing, process-wide. While started, capture stages (ReadSample / Receive,
+    // raw copy, conversion, ProcAmp, callbacks, recorder writes, present) are recorded with
+    // their frame_id into per-thread rings of events_per_thread spans (0 = 65536; the oldest
+    // are overwritten). Stop writes them as Chrome / Perfetto trace JSON (chrome://tracing,
+    // ui.perfetto.dev); a null path discards them. GCAP_ENOTSUP when built with GCAP_TRACE=0.
+    GCAP_API gcap_status_t gcap_trace_start(int events_per_thread);
+    GCAP_API gcap_status_t gcap_trace_stop(const char *json_path_utf8);
     gcap_status_t gcap_start(gcap_handle h);
     gcap_status_t gcap_start_recording(gcap_handle h, const char *path_utf8);
     gcap_status_t gcap_stop_recording(gcap_handle h);
@@ -241,12 +535,26 @@ extern "C"
     GCAP_API gcap_status_t gcap_set_recording_audio_device(gcap_handle h, const char *device_id_utf8);
     gcap_status_t gcap_close(gcap_handle h);
     GCAP_API void gcap_set_backend(int backend);
+    // Process-wide options of GCAP_BACKEND_SYNTHETIC (nullptr = defaults); used from the next gcap_start.
+    GCAP_API gcap_status_t gcap_set_synthetic_opts(const gcap_synthetic_opts_t *opts);
+    // Process-wide options of GCAP_BACKEND_REPLAY, path copied (nullptr = no file); used from the next gcap_open.
+    GCAP_API gcap_status_t gcap_set_replay_opts(const gcap_replay_opts_t *opts);
+    // Process-wide (nullptr = off); replaces the remembered choices with the file's.
+    GCAP_API gcap_status_t gcap_set_auto_calibration(const gcap_auto_calibration_t *opts);
+    // Process-wide (nullptr = on, no file); drops what is cached.
+    GCAP_API gcap_status_t gcap_set_device_cache(const gcap_device_cache_opts_t *opts);
+    // Forgets every cached device list and capability (the file's too); the next queries ask the devices.
+    GCAP_API void gcap_refresh_devices(void);
+    // Stops the SDK's process-wide background work (watching for device arrival and removal).
+    // Call after the last gcap_close and before unloading the library, not from DllMain or a
+    // static destructor; later calls start what they need again.
+    GCAP_API void gcap_shutdown(void);
     // 選擇要用哪一張 D3D11 Adapter 來做 NV12→RGBA / DXGI 管線
     // adapter_index = -1 表示使用系統預設（原本的 nullptr / default adapter）
     GCAP_API void gcap_set_d3d_adapter(int adapter_index);
 
     // 查詢目前 handle 實際使用中的 backend。
-    // 非 Auto 模式下通常等於 gcap_set_backend() 指定值；Auto 模式下則可能回傳 WinMF GPU / WinMF CPU / DShow。
+    // 非 Auto 模式下通常等於 gcap_set_backend() 指定值；Auto 模式下則可能回傳 WinMF GPU / WinMF CPU / DShow（Linux：V4L2）。
     GCAP_API int gcap_get_active_backend(gcap_handle h);
     GCAP_API gcap_status_t gcap_export_preview_scene_rgb10(gcap_handle h, const char *base_path_utf8,
                                                            int export_raw, int export_tiff, int export_stats);
@@ -255,6 +563,10 @@ extern "C"
     gcap_status_t gcap_get_device_props(gcap_handle h, gcap_device_props_t *out);
     gcap_status_t gcap_get_signal_status(gcap_handle h, gcap_signal_status_t *out);
     GCAP_API gcap_status_t gcap_get_runtime_info(gcap_handle h, gcap_runtime_info_t *out);
+    // Counters and histograms since gcap_start. Each capture / delivery thread keeps its own
+    // and publishes a copy every 25 ms (and at gcap_stop), so this reads none of the
+    // capture thread's data and is cheap to poll; the latest ~25 ms may be missing.
+    GCAP_API gcap_status_t gcap_get_stats(gcap_handle h, gcap_stats_t *out);
     gcap_status_t gcap_set_processing(gcap_handle h, const gcap_processing_opts_t *opts);
 
     // Apply ProcAmp on CPU conversion path (NV12/YUY2->ARGB).
@@ -270,11 +582,13 @@ extern "C"
 
     const char *gcap_strerror(gcap_status_t);
     GCAP_API gcap_status_t gcap_set_preview(gcap_handle h, const gcap_preview_desc_t *desc);
-    // Enumerate DirectShow video format capabilities for a device index.
+    // Enumerate DirectShow (Linux: V4L2) video format capabilities for a device index.
     // Returns actual written count. Pass nullptr or max_caps<=0 to query supported count only.
     GCAP_API int gcap_enum_video_caps(int device_index, gcap_video_cap_t *out_caps, int max_caps);
     // Enumerate unique pixel formats supported by a device for the requested backend.
-    // backend: GCAP_BACKEND_WINMF_CPU / GCAP_BACKEND_WINMF_GPU / GCAP_BACKEND_DSHOW
+    // backend: GCAP_BACKEND_WINMF_CPU / GCAP_BACKEND_WINMF_GPU / GCAP_BACKEND_DSHOW / GCAP_BACKEND_SYNTHETIC /
+    // GCAP_BACKEND_REPLAY (the format of the gcap_set_replay_opts file; the five YUV formats for raw files) /
+    // GCAP_BACKEND_V4L2 (Linux)
     // Returns actual written count. Pass nullptr or max_formats<=0 to query supported count only.
     GCAP_API int gcap_enum_supported_pixel_formats(int backend, int device_index, gcap_pixfmt_t *out_formats, int max_formats);
     // Enumerate available DirectShow property pages (filter + capture pin) for a device index.
@@ -0,0 +1,326 @@
+// backend_calibration.cpp
+#include "backend_calibration.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+    constexpr double kFullRate = 0.97;   // of the target: frames lost to start-up jitter are not a failure
+    constexpr double kCpuTie = 1.10;     // within 10% of the cheapest counts as a tie
+    constexpr int kMaxWarmupMs = 10000;
+    constexpr int kMaxMeasureMs = 60000;
+    constexpr const char *kFileHeader = "# gcapture auto calibration v1";
+
+    uint64_t steady_now_ns()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // CPU time of every thread in the process: the provider's threads, the conversion
+    // pool, and whatever the application runs alongside.
+    uint64_t process_cpu_ns()
+    {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+            return 0;
+        ULARGE_INTEGER k{}, u{};
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        return (k.QuadPart + u.QuadPart) * 100;
+#else
+        timespec ts{};
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+            return 0;
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+    }
+
+    // Frame arrivals of the candidate being measured.
+    struct Probe
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        uint64_t firstNs = 0;
+        bool measuring = false;
+        std::vector<uint64_t> arrivals;
+
+        void frame()
+        {
+            const uint64_t now = steady_now_ns();
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!firstNs)
+            {
+                firstNs = now;
+                cv.notify_all();
+            }
+            if (measuring)
+                arrivals.push_back(now);
+        }
+    };
+
+    void probe_video(const gcap_frame_t *, void *user)
+    {
+        static_cast<Probe *>(user)->frame();
+    }
+
+    void probe_packet(const gcap_frame_packet_t *, void *user)
+    {
+        static_cast<Probe *>(user)->frame();
+    }
+
+    std::FILE *open_utf8(const char *path, const char *mode)
+    {
+#ifdef _WIN32
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        if (n <= 0)
+            return nullptr;
+        std::wstring w((size_t)n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, &w[0], n);
+        std::wstring m(mode, mode + std::strlen(mode));
+        return _wfopen(w.c_str(), m.c_str());
+#else
+        return std::fopen(path, mode);
+#endif
+    }
+
+    std::mutex g_mtx;
+    bool g_enabled = false;
+    gcap::CalibrationSettings g_settings;
+    std::string g_path;
+    std::map<std::string, gcap::CalibrationChoice> g_choices;
+
+    // One line per choice: "<backend> <format>\t<key>".
+    void load_locked()
+    {
+        std::FILE *fp = open_utf8(g_path.c_str(), "rb");
+        if (!fp)
+            return;
+        char line[1024];
+        while (std::fgets(line, sizeof(line), fp))
+        {
+            line[std::strcspn(line, "\r\n")] = '\0';
+            const char *tab = std::strchr(line, '\t');
+            int backend, format;
+            if (line[0] == '#' || !tab || tab[1] == '\0' || std::sscanf(line, "%d %d", &backend, &format) != 2)
+                continue;
+            gcap::CalibrationChoice c;
+            c.backend = backend;
+            c.format = (gcap_pixfmt_t)format;
+            g_choices[tab + 1] = c;
+        }
+        std::fclose(fp);
+    }
+
+    void save_locked()
+    {
+        if (g_path.empty())
+            return;
+        std::FILE *fp = open_utf8(g_path.c_str(), "wb");
+        if (!fp)
+            return;
+        std::fprintf(fp, "%s\n", kFileHeader);
+        for (const auto &e : g_choices)
+            std::fprintf(fp, "%d %d\t%s\n", e.second.backend, (int)e.second.format, e.first.c_str());
+        std::fclose(fp);
+    }
+}
+
+gcap::CalibrationResult gcap::measure_candidate(const ProviderFactory &make, const CalibrationCandidate &c,
+                                                int deviceIndex, const gcap_profile_t *profile, bool packets,
+                                                const CalibrationSettings &s)
+{
+    CalibrationResult r;
+    r.candidate = c;
+    std::unique_ptr<ICaptureProvider> p = make ? make(c.backend) : nullptr;
+    if (!p)
+        return r;
+
+    Probe probe;
+    gcap_processing_opts_t po{};
+    po.preferred_pixfmt = c.format;
+    p->setCallbacks(packets ? nullptr : probe_video, nullptr, &probe);
+    p->setFramePacketCallback(packets ? probe_packet : nullptr, &probe);
+    // NV12 leaves the backend's default; another format the backend cannot be asked
+    // for is not a candidate.
+    const bool pickFormat = c.format != GCAP_FMT_NV12;
+    if ((profile && !p->setProfile(*profile)) || (pickFormat && !p->setProcessing(po)) || !p->open(deviceIndex))
+        return r;
+    if ((profile && !p->setProfile(*profile)) || (pickFormat && !p->setProcessing(po)))
+    {
+        p->close();
+        return r;
+    }
+
+    const uint64_t t0 = steady_now_ns();
+    if (!p->start())
+    {
+        p->close();
+        return r;
+    }
+    // A device that does not offer the format streams another one instead.
+    gcap_signal_status_t st{};
+    if (pickFormat && (!profile || profile->mode != GCAP_PROFILE_CUSTOM) && p->getSignalStatus(st) &&
+        st.pixfmt != c.format)
+    {
+        p->stop();
+        p->close();
+        return r;
+    }
+    r.started = true;
+
+    bool gotFrame;
+    {
+        std::unique_lock<std::mutex> lk(probe.mtx);
+        gotFrame = probe.cv.wait_for(lk, std::chrono::milliseconds(s.firstFrameTimeoutMs), [&]
+                                     { return probe.firstNs != 0; });
+        if (gotFrame)
+            r.firstFrameMs = (double)(probe.firstNs - t0) / 1e6;
+    }
+    uint64_t cpuNs = 0;
+    if (gotFrame)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(s.warmupMs));
+        {
+            std::lock_guard<std::mutex> lk(probe.mtx);
+            probe.measuring = true;
+        }
+        const uint64_t cpu0 = process_cpu_ns();
+        std::this_thread::sleep_for(std::chrono::milliseconds(s.measureMs));
+        cpuNs = process_cpu_ns() - cpu0;
+        std::lock_guard<std::mutex> lk(probe.mtx);
+        probe.measuring = false;
+    }
+    p->stop();
+    p->close();
+
+    const std::vector<uint64_t> &a = probe.arrivals;
+    r.frames = a.size();
+    if (a.size() >= 2)
+    {
+        const double n = (double)(a.size() - 1);
+        const double span = (double)(a.back() - a.front());
+        r.fps = span > 0 ? n * 1e9 / span : 0.0;
+        const double mean = span / n;
+        double var = 0.0;
+        for (size_t i = 1; i < a.size(); ++i)
+        {
+            const double d = (double)(a[i] - a[i - 1]) - mean;
+            var += d * d;
+        }
+        r.jitterMs = std::sqrt(var / n) / 1e6;
+    }
+    if (r.frames > 0)
+        r.cpuUsPerFrame = (double)cpuNs / 1e3 / (double)r.frames;
+    return r;
+}
+
+int gcap::pick_best(const std::vector<CalibrationResult> &results, double targetFps)
+{
+    double best = 0.0;
+    for (const CalibrationResult &r : results)
+        best = std::max(best, r.frames >= 2 ? r.fps : 0.0);
+    if (best <= 0.0)
+        return -1;
+    const double need = (targetFps > 0.0 ? std::min(targetFps, best) : best) * kFullRate;
+
+    double cheapest = -1.0;
+    for (const CalibrationResult &r : results)
+        if (r.frames >= 2 && r.fps >= need && (cheapest < 0.0 || r.cpuUsPerFrame < cheapest))
+            cheapest = r.cpuUsPerFrame;
+
+    int pick = -1;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const CalibrationResult &r = results[i];
+        if (r.frames < 2 || r.fps < need || r.cpuUsPerFrame > cheapest * kCpuTie)
+            continue;
+        if (pick < 0)
+        {
+            pick = (int)i;
+            continue;
+        }
+        const CalibrationResult &p = results[(size_t)pick];
+        if (r.jitterMs < p.jitterMs || (r.jitterMs == p.jitterMs && r.firstFrameMs < p.firstFrameMs))
+            pick = (int)i;
+    }
+    return pick;
+}
+
+void gcap::set_calibration_options(const gcap_auto_calibration_t *opts)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    g_enabled = opts && opts->enable;
+    g_settings = CalibrationSettings{};
+    if (opts && opts->warmup_ms > 0)
+        g_settings.warmupMs = std::min(opts->warmup_ms, kMaxWarmupMs);
+    if (opts && opts->measure_ms > 0)
+        g_settings.measureMs = std::min(opts->measure_ms, kMaxMeasureMs);
+    g_path = opts && opts->cache_path_utf8 ? opts->cache_path_utf8 : "";
+    g_choices.clear();
+    if (!g_path.empty())
+        load_locked();
+}
+
+bool gcap::calibration_enabled(CalibrationSettings *settings)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    if (settings)
+        *settings = g_settings;
+    return g_enabled;
+}
+
+std::string gcap::calibration_key(const char *symbolicLink, const gcap_profile_t *profile)
+{
+    char buf[96];
+    if (!profile || profile->mode != GCAP_PROFILE_CUSTOM)
+        std::snprintf(buf, sizeof(buf), "|default");
+    else
+        std::snprintf(buf, sizeof(buf), "|%dx%d@%d/%d/fmt%d", profile->width, profile->height, profile->fps_num,
+                      profile->fps_den, (int)profile->format);
+    return std::string(symbolicLink ? symbolicLink : "") + buf;
+}
+
+bool gcap::calibration_lookup(const std::string &key, CalibrationChoice &out)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    const auto it = g_choices.find(key);
+    if (it == g_choices.end())
+        return false;
+    out = it->second;
+    return true;
+}
+
+void gcap::calibration_store(const std::string &key, const CalibrationChoice &choice)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    g_choices[key] = choice;
+    save_locked();
+}
+
+void gcap::calibration_forget(const std::string &key)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    if (g_choices.erase(key))
+        save_locked();
+}
@@ -0,0 +1,68 @@
+// backend_calibration.h
+// Measured backend selection for GCAP_BACKEND_AUTO (gcap_set_auto_calibration):
+// streams each candidate briefly, scores it, and remembers the winner per device
+// and profile. Portable; providers come from a factory, so fakes can stand in.
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gcapture.h"
+#include "capture_manager.h"
+
+namespace gcap
+{
+    struct CalibrationSettings
+    {
+        int warmupMs = 300;             // after the first frame, before measuring
+        int measureMs = 1000;
+        int firstFrameTimeoutMs = 3000; // a candidate without a frame by then scores nothing
+    };
+
+    // One backend, with the pixel format asked for through setProcessing(preferred_pixfmt)
+    // (NV12 = the backend's default).
+    struct CalibrationCandidate
+    {
+        int backend = 0;
+        gcap_pixfmt_t format = GCAP_FMT_NV12;
+    };
+
+    struct CalibrationResult
+    {
+        CalibrationCandidate candidate;
+        bool started = false;
+        uint64_t frames = 0;         // in the measuring window
+        double fps = 0.0;
+        double jitterMs = 0.0;       // standard deviation of the frame interval
+        double cpuUsPerFrame = 0.0;  // process CPU time / frames
+        double firstFrameMs = -1.0;  // start() to the first frame (-1 = none)
+    };
+
+    using ProviderFactory = std::function<std::unique_ptr<ICaptureProvider>(int backend)>;
+
+    // Opens, streams and closes one candidate on a provider of its own. Frames go to
+    // counting callbacks of the kind the application uses (packets or converted video),
+    // so the conversion the application will pay for is part of the CPU time.
+    CalibrationResult measure_candidate(const ProviderFactory &make, const CalibrationCandidate &c, int deviceIndex,
+                                        const gcap_profile_t *profile, bool packets, const CalibrationSettings &s);
+
+    // Index of the best result, -1 when none delivered frames. Candidates that reach
+    // the target rate (targetFps <= 0: the best measured rate) compete on CPU per frame;
+    // within 10% of the cheapest, lower jitter wins, then a faster first frame, then
+    // the earlier candidate.
+    int pick_best(const std::vector<CalibrationResult> &results, double targetFps);
+
+    // Process-wide options and remembered choices (gcap_set_auto_calibration).
+    struct CalibrationChoice
+    {
+        int backend = 0;
+        gcap_pixfmt_t format = GCAP_FMT_NV12;
+    };
+    void set_calibration_options(const gcap_auto_calibration_t *opts);
+    bool calibration_enabled(CalibrationSettings *settings = nullptr);
+    std::string calibration_key(const char *symbolicLink, const gcap_profile_t *profile);
+    bool calibration_lookup(const std::string &key, CalibrationChoice &out);
+    void calibration_store(const std::string &key, const CalibrationChoice &choice);
+    void calibration_forget(const std::string &key); // the remembered backend no longer opens
+}
@@ -1,5 +1,9 @@
 // src/core/c_api.cpp
 #include "capture_manager.h"
+#include "device_cache.h"
+#include "frame_pool.h"
+#include "packet_convert.h"
+#include "trace.h"
 #ifndef GCAPTURE_BUILD
 #error not exporting
 #endif
@@ -8,10 +12,15 @@
 #include <vector>
 #include "../audio/audio_manager.h"
 #include "gcap_audio.h"
-#include "../providers/dshow_signal_probe.h"
-#include "../providers/winmf_provider.h"
+#include "../providers/replay_provider.h"
+#include "../providers/synthetic_provider.h"
+#ifdef GCAP_LINUX_V4L2
+#include "../providers/v4l2_provider.h"
+#endif
 
 #ifdef _WIN32
+#include "../providers/dshow_signal_probe.h"
+#include "../providers/winmf_provider.h"
 #include <windows.h>
 #include <wrl/client.h>
 #include <mmdeviceapi.h>
@@ -32,6 +41,15 @@ static std::string w2utf8(const wchar_t *ws)
 }
 #endif
 
+// Identity of the device at `index` in `backendInt`'s order ("" = not listed: no caching).
+static std::string device_identity_at(int backendInt, int index)
+{
+    std::vector<gcap_device_info_t> list;
+    if (index < 0 || !CaptureManager::listDevices(backendInt, list) || index >= (int)list.size())
+        return {};
+    return gcap::device_identity(list[(size_t)index]);
+}
+
 extern "C"
 {
     // 簡單的 handle 物件，內含一個 CaptureManager
@@ -62,13 +80,12 @@ extern "C"
         }
     }
 
-    // 只為了列舉裝置，不需要長壽命 handle
+    // 只為了列舉裝置，不需要長壽命 handle（走 device cache）
     gcap_status_t gcap_enumerate(gcap_device_info_t *out, int max, int *count)
     {
         if (!out || max <= 0)
             return GCAP_EINVAL;
-        CaptureManager tmp;
-        return tmp.enumerate(out, max, count);
+        return CaptureManager::enumerateDevices(out, max, count);
     }
 
     gcap_status_t gcap_create(gcap_handle *out)
@@ -113,6 +130,13 @@ extern "C"
         return h->mgr.setBuffers(count, bytes_hint);
     }
 
+    gcap_status_t gcap_set_buffers_ex(gcap_handle h, const gcap_buffer_opts_t *opts)
+    {
+        if (!h || !opts)
+            return GCAP_EINVAL;
+        return h->mgr.setBuffersEx(*opts);
+    }
+
     gcap_status_t gcap_set_callbacks(gcap_handle h,
                                      gcap_on_video_cb vcb,
                                      gcap_on_error_cb ecb,
@@ -123,6 +147,17 @@ extern "C"
         return h->mgr.setCallbacks(vcb, ecb, user);
     }
 
+    gcap_status_t gcap_set_callbacks_ex(gcap_handle h,
+                                        gcap_on_video_cb vcb,
+                                        gcap_on_error_cb ecb,
+                                        void *user,
+                                        const gcap_video_output_t *out)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.setCallbacksEx(vcb, ecb, user, out);
+    }
+
     gcap_status_t gcap_set_frame_packet_callback(gcap_handle h,
                                                  gcap_on_frame_packet_cb cb,
                                                  void *user)
@@ -137,10 +172,99 @@ extern "C"
         return h->mgr.setFramePacketCallback(cb, user);
     }
 
+    const gcap_frame_t *gcap_frame_retain(const gcap_frame_t *frame)
+    {
+        return gcap::FramePool::retain(frame);
+    }
+
+    void gcap_frame_release(const gcap_frame_t *frame)
+    {
+        if (frame)
+            gcap::FramePool::release(frame->lease);
+    }
+
+    const gcap_frame_packet_t *gcap_frame_packet_retain(const gcap_frame_packet_t *pkt)
+    {
+        return gcap::FramePool::retain(pkt);
+    }
+
+    void gcap_frame_packet_release(const gcap_frame_packet_t *pkt)
+    {
+        if (pkt)
+            gcap::FramePool::release(pkt->lease);
+    }
+
+    gcap_status_t gcap_packet_convert(const gcap_frame_packet_t *pkt, gcap_pixfmt_t dst_format, void *dst, int dst_stride)
+    {
+        if (!pkt)
+            return GCAP_EINVAL;
+        return gcap::packet_convert(*pkt, dst_format, (uint8_t *)dst, dst_stride);
+    }
+
+    gcap_status_t gcap_set_lease_policy(gcap_handle h, const gcap_lease_opts_t *opts)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.setLeasePolicy(opts);
+    }
+
+    gcap_status_t gcap_set_delivery(gcap_handle h, const gcap_delivery_opts_t *opts)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.setDelivery(opts);
+    }
+
+    gcap_status_t gcap_subscribe(gcap_handle h, const gcap_subscriber_desc_t *desc, int *out_id)
+    {
+        if (!h || !desc)
+            return GCAP_EINVAL;
+        return h->mgr.subscribe(*desc, out_id);
+    }
+
+    gcap_status_t gcap_unsubscribe(gcap_handle h, int id)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.unsubscribe(id);
+    }
+
+    gcap_status_t gcap_publish_shm(gcap_handle h, const gcap_shm_publisher_desc_t *desc, int *out_id)
+    {
+        if (!h || !desc)
+            return GCAP_EINVAL;
+        return h->mgr.publishShm(*desc, out_id);
+    }
+
+    gcap_status_t gcap_unpublish_shm(gcap_handle h, int id)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.unpublishShm(id);
+    }
+
+    gcap_status_t gcap_trace_start(int events_per_thread)
+    {
+        return gcap::trace::start(events_per_thread);
+    }
+
+    gcap_status_t gcap_trace_stop(const char *json_path_utf8)
+    {
+        return gcap::trace::stop(json_path_utf8);
+    }
+
     int gcap_enum_video_caps(int device_index, gcap_video_cap_t *out_caps, int max_caps)
     {
 #ifdef _WIN32
-        return dshow_enum_video_caps_by_index(device_index, out_caps, max_caps);
+        return gcap::cached_video_caps(device_identity_at(GCAP_BACKEND_DSHOW, device_index),
+                                       [device_index](gcap_video_cap_t *o, int m)
+                                       { return dshow_enum_video_caps_by_index(device_index, o, m); },
+                                       out_caps, max_caps);
+#elif defined(GCAP_LINUX_V4L2)
+        return gcap::cached_video_caps(device_identity_at(GCAP_BACKEND_V4L2, device_index),
+                                       [device_index](gcap_video_cap_t *o, int m)
+                                       { return v4l2_enum_video_caps_by_index(device_index, o, m); },
+                                       out_caps, max_caps);
 #else
         (void)device_index;
         (void)out_caps;
@@ -151,14 +275,25 @@ extern "C"
 
     int gcap_enum_supported_pixel_formats(int backend, int device_index, gcap_pixfmt_t *out_formats, int max_formats)
     {
+        if (backend == GCAP_BACKEND_SYNTHETIC)
+            return synthetic_enum_supported_pixel_formats(out_formats, max_formats);
+        if (backend == GCAP_BACKEND_REPLAY)
+            return replay_enum_supported_pixel_formats(out_formats, max_formats);
+#ifdef GCAP_LINUX_V4L2
+        if (backend == GCAP_BACKEND_V4L2 || backend == GCAP_BACKEND_AUTO)
+            return gcap::cached_pixel_formats(device_identity_at(GCAP_BACKEND_V4L2, device_index), GCAP_BACKEND_V4L2,
+                                              [device_index](gcap_pixfmt_t *o, int m)
+                                              { return v4l2_enum_supported_pixel_formats_by_index(device_index, o, m); },
+                                              out_formats, max_formats);
+#endif
 #ifdef _WIN32
         if (backend == GCAP_BACKEND_DSHOW)
         {
-            const int capCount = dshow_enum_video_caps_by_index(device_index, nullptr, 0);
+            const int capCount = gcap_enum_video_caps(device_index, nullptr, 0);
             if (capCount <= 0)
                 return 0;
             std::vector<gcap_video_cap_t> caps(static_cast<size_t>(capCount));
-            const int written = dshow_enum_video_caps_by_index(device_index, caps.data(), static_cast<int>(caps.size()));
+            const int written = gcap_enum_video_caps(device_index, caps.data(), static_cast<int>(caps.size()));
             std::vector<gcap_pixfmt_t> uniq;
             auto push_unique = [&](gcap_pixfmt_t fmt)
             {
@@ -178,8 +313,12 @@ extern "C"
                 out_formats[i] = uniq[static_cast<size_t>(i)];
             return n;
         }
+        // Both WinMF backends list devices in MFEnumDeviceSources order and share the entry.
         if (backend == GCAP_BACKEND_WINMF_CPU || backend == GCAP_BACKEND_WINMF_GPU || backend == GCAP_BACKEND_AUTO)
-            return winmf_enum_supported_pixel_formats_by_index(device_index, out_formats, max_formats);
+            return gcap::cached_pixel_formats(device_identity_at(GCAP_BACKEND_WINMF_CPU, device_index), GCAP_BACKEND_WINMF_CPU,
+                                              [device_index](gcap_pixfmt_t *o, int m)
+                                              { return winmf_enum_supported_pixel_formats_by_index(device_index, o, m); },
+                                              out_formats, max_formats);
         return 0;
 #else
         (void)backend;
@@ -204,16 +343,27 @@ extern "C"
 
     int gcap_open_vendor_property_page(int device_index)
     {
+#ifdef _WIN32
         return dshow_open_vendor_property_page_by_index(device_index) ? 1 : 0;
+#else
+        (void)device_index;
+        return 0;
+#endif
     }
 
     int gcap_open_named_property_page(int device_index, const char *page_name_utf8, int capture_pin)
     {
         if (!page_name_utf8 || !*page_name_utf8)
             return 0;
+#ifdef _WIN32
         wchar_t wname[256] = {};
         MultiByteToWideChar(CP_UTF8, 0, page_name_utf8, -1, wname, 256);
         return dshow_open_named_property_page_by_index(device_index, wname, capture_pin != 0) ? 1 : 0;
+#else
+        (void)device_index;
+        (void)capture_pin;
+        return 0;
+#endif
     }
 
     gcap_status_t gcap_start(gcap_handle h)
@@ -383,6 +533,13 @@ extern "C"
         return h->mgr.getRuntimeInfo(*out);
     }
 
+    GCAP_API gcap_status_t gcap_get_stats(gcap_handle h, gcap_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getStats(*out);
+    }
+
     gcap_status_t gcap_set_processing(gcap_handle h, const gcap_processing_opts_t *opts)
     {
         if (!h || !opts)
@@ -417,6 +574,36 @@ extern "C"
         CaptureManager::setBackendInt(backend);
     }
 
+    GCAP_API gcap_status_t gcap_set_synthetic_opts(const gcap_synthetic_opts_t *opts)
+    {
+        return CaptureManager::setSyntheticOpts(opts);
+    }
+
+    GCAP_API gcap_status_t gcap_set_replay_opts(const gcap_replay_opts_t *opts)
+    {
+        return CaptureManager::setReplayOpts(opts);
+    }
+
+    GCAP_API gcap_status_t gcap_set_auto_calibration(const gcap_auto_calibration_t *opts)
+    {
+        return CaptureManager::setAutoCalibration(opts);
+    }
+
+    GCAP_API gcap_status_t gcap_set_device_cache(const gcap_device_cache_opts_t *opts)
+    {
+        return CaptureManager::setDeviceCache(opts);
+    }
+
+    GCAP_API void gcap_refresh_devices(void)
+    {
+        gcap::device_cache_refresh();
+    }
+
+    GCAP_API void gcap_shutdown(void)
+    {
+        gcap::device_cache_shutdown();
+    }
+
     GCAP_API void gcap_set_d3d_adapter(int adapter_index)
     {
         CaptureManager::setD3dAdapterInt(adapter_index);
@@ -450,14 +637,23 @@ extern "C"
 
     extern "C" GCAP_API int gcap_get_audio_device_count(void)
     {
+#ifdef _WIN32
         auto list = gcap::audio::enumerate_devices();
         return static_cast<int>(list.size());
+#else
+        return 0;
+#endif
     }
 
     extern "C" GCAP_API int gcap_enum_audio_devices(
         gcap_audio_device_t *out,
         int max_count)
     {
+#ifndef _WIN32
+        (void)out;
+        (void)max_count;
+        return 0;
+#else
         auto list = gcap::audio::enumerate_devices();
         int total = static_cast<int>(list.size());
 
@@ -480,6 +676,7 @@ extern "C"
         }
 
         return n;
+#endif
     }
 
 } // extern "C"
@@ -1,10 +1,22 @@
 #include "capture_manager.h"
+#include "backend_calibration.h"
+#include "capture_stats.h"
+#include "convert_pool.h"
+#include "delivery_queue.h"
+#include "device_cache.h"
+#include "frame_fanout.h"
+#include "frame_pool.h"
+#include "shm_ring.h"
+#include <chrono>
 #include <cstring>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 #include <cstdio>
 
+#include "../providers/replay_provider.h"
+#include "../providers/synthetic_provider.h"
+
 #ifdef GCAP_WIN_MF
 #include "../providers/winmf_provider.h"
 #endif
@@ -13,6 +25,10 @@
 #include "../providers/dshow_provider.h"
 #endif
 
+#ifdef GCAP_LINUX_V4L2
+#include "../providers/v4l2_provider.h"
+#endif
+
 static void cmDebug(const char *msg)
 {
 #ifdef _WIN32
@@ -26,69 +42,138 @@ enum class Backend
     WinMF_CPU,
     WinMF_GPU,
     DShow,
-    Auto
+    Auto,
+    Synthetic,
+    Replay,
+    V4L2
 };
-static Backend g_backend = Backend::WinMF_GPU;
+#ifdef GCAP_LINUX_V4L2
+static constexpr Backend kDefaultBackend = Backend::V4L2;
+// GCAP_BACKEND_AUTO tries these in order.
+static const int kAutoCandidates[] = {GCAP_BACKEND_V4L2};
+#else
+static constexpr Backend kDefaultBackend = Backend::WinMF_GPU;
+static const int kAutoCandidates[] = {GCAP_BACKEND_WINMF_GPU, GCAP_BACKEND_WINMF_CPU, GCAP_BACKEND_DSHOW};
+#endif
+static Backend g_backend = kDefaultBackend;
 
 // 預設 D3D Adapter (-1 = 由系統選擇 default adapter)
 static int g_d3d_adapter_index = -1;
 
-/**
- * @brief Constructor — selects platform-specific provider.
- */
-CaptureManager::CaptureManager()
+// gcap_set_backend's choice as GCAP_BACKEND_*.
+static int currentBackendInt()
 {
     switch (g_backend)
     {
     case Backend::WinMF_CPU:
-        selectedBackendInt_ = GCAP_BACKEND_WINMF_CPU;
-        break;
+        return GCAP_BACKEND_WINMF_CPU;
     case Backend::DShow:
-        selectedBackendInt_ = GCAP_BACKEND_DSHOW;
-        break;
+        return GCAP_BACKEND_DSHOW;
     case Backend::Auto:
-        selectedBackendInt_ = GCAP_BACKEND_AUTO;
-        break;
+        return GCAP_BACKEND_AUTO;
+    case Backend::Synthetic:
+        return GCAP_BACKEND_SYNTHETIC;
+    case Backend::Replay:
+        return GCAP_BACKEND_REPLAY;
+    case Backend::V4L2:
+        return GCAP_BACKEND_V4L2;
     case Backend::WinMF_GPU:
     default:
-        selectedBackendInt_ = GCAP_BACKEND_WINMF_GPU;
-        break;
+        return GCAP_BACKEND_WINMF_GPU;
     }
+}
 
+/**
+ * @brief Constructor — selects platform-specific provider.
+ */
+CaptureManager::CaptureManager()
+{
+    selectedBackendInt_ = currentBackendInt();
     activeBackendInt_ = selectedBackendInt_ == GCAP_BACKEND_AUTO
-                            ? GCAP_BACKEND_WINMF_GPU
+                            ? kAutoCandidates[0]
                             : selectedBackendInt_;
+    gcap::convert_pool_acquire();
+    framePool_ = gcap::FramePool::create();
+    stats_ = std::make_unique<gcap::CaptureStats>();
+    delivery_ = std::make_unique<gcap::DeliveryQueue>(framePool_);
+    delivery_->setStats(&stats_->shard(gcap::CaptureStats::Thread::Capture),
+                        &stats_->shard(gcap::CaptureStats::Thread::Delivery));
+    fanout_ = std::make_unique<gcap::FrameFanout>(framePool_);
     rebuildProviderForBackend(activeBackendInt_);
 }
 
-bool CaptureManager::rebuildProviderForBackend(int backendInt)
+// nullptr when the backend is not built on this platform.
+static std::unique_ptr<ICaptureProvider> makeProvider(int backendInt)
 {
-    provider_.reset();
-
     switch (backendInt)
     {
 #ifdef GCAP_WIN_DSHOW
     case GCAP_BACKEND_DSHOW:
-        provider_ = std::make_unique<DShowProvider>();
-        activeBackendInt_ = GCAP_BACKEND_DSHOW;
-        return true;
+        return std::make_unique<DShowProvider>();
 #endif
 #ifdef GCAP_WIN_MF
     case GCAP_BACKEND_WINMF_CPU:
-        provider_ = std::make_unique<WinMFProvider>(false);
-        activeBackendInt_ = GCAP_BACKEND_WINMF_CPU;
-        return true;
+        return std::make_unique<WinMFProvider>(false);
     case GCAP_BACKEND_WINMF_GPU:
-        provider_ = std::make_unique<WinMFProvider>(true);
-        activeBackendInt_ = GCAP_BACKEND_WINMF_GPU;
-        return true;
+        return std::make_unique<WinMFProvider>(true);
+#endif
+#ifdef GCAP_LINUX_V4L2
+    case GCAP_BACKEND_V4L2:
+        return std::make_unique<V4L2Provider>();
 #endif
+    case GCAP_BACKEND_SYNTHETIC:
+        return std::make_unique<SyntheticProvider>();
+    case GCAP_BACKEND_REPLAY:
+        return std::make_unique<ReplayProvider>();
     default:
-        break;
+        return nullptr;
+    }
+}
+
+static const char *backendName(int backendInt)
+{
+    switch (backendInt)
+    {
+    case GCAP_BACKEND_WINMF_CPU:
+        return "WinMF CPU";
+    case GCAP_BACKEND_WINMF_GPU:
+        return "WinMF GPU";
+    case GCAP_BACKEND_DSHOW:
+        return "DShow";
+    case GCAP_BACKEND_SYNTHETIC:
+        return "Synthetic";
+    case GCAP_BACKEND_REPLAY:
+        return "Replay";
+    case GCAP_BACKEND_V4L2:
+        return "V4L2";
+    default:
+        return "?";
+    }
+}
+
+static const char *formatName(gcap_pixfmt_t fmt)
+{
+    switch (fmt)
+    {
+    case GCAP_FMT_NV12:
+        return "NV12";
+    case GCAP_FMT_YUY2:
+        return "YUY2";
+    case GCAP_FMT_P010:
+        return "P010";
+    case GCAP_FMT_Y210:
+        return "Y210";
+    default:
+        return "?";
     }
+}
 
+bool CaptureManager::rebuildProviderForBackend(int backendInt)
+{
+    provider_.reset();
+    provider_ = makeProvider(backendInt);
     activeBackendInt_ = backendInt;
-    return false;
+    return provider_ != nullptr;
 }
 
 bool CaptureManager::applyCachedStateToProvider()
@@ -96,8 +181,10 @@ bool CaptureManager::applyCachedStateToProvider()
     if (!provider_)
         return false;
 
-    provider_->setCallbacks(vcb_, ecb_, user_);
-    provider_->setFramePacketCallback(pcb_, user_);
+    installCallbacks();
+    provider_->setVideoOutput(videoOutput_);
+    provider_->setFramePool(framePool_);
+    provider_->setStats(stats_.get());
 
     if (hasProfile_ && !provider_->setProfile(cachedProfile_))
         return false;
@@ -108,6 +195,10 @@ bool CaptureManager::applyCachedStateToProvider()
     if (hasPreview_ && !provider_->setPreview(cachedPreview_))
         return false;
 
+    // Accepted once; a backend without format/deinterlace control just keeps its defaults.
+    if (hasProcessing_)
+        provider_->setProcessing(cachedProcessing_);
+
     return true;
 }
 
@@ -134,6 +225,13 @@ bool CaptureManager::openWithBackend(int backendInt, int deviceIndex)
 CaptureManager::~CaptureManager()
 {
     close();
+    provider_.reset();
+    delivery_.reset();
+    fanout_.reset();
+    shmPublishers_.clear();
+    // Frames the application still retains keep the pool alive until released.
+    framePool_->shutdown();
+    gcap::convert_pool_release();
 }
 
 void CaptureManager::setBackendInt(int v)
@@ -152,12 +250,60 @@ void CaptureManager::setBackendInt(int v)
     case GCAP_BACKEND_AUTO:
         g_backend = Backend::Auto;
         break;
+    case GCAP_BACKEND_SYNTHETIC:
+        g_backend = Backend::Synthetic;
+        break;
+    case GCAP_BACKEND_REPLAY:
+        g_backend = Backend::Replay;
+        break;
+    case GCAP_BACKEND_V4L2:
+        g_backend = Backend::V4L2;
+        break;
     default:
-        g_backend = Backend::WinMF_GPU;
+        g_backend = kDefaultBackend;
         break;
     }
 }
 
+gcap_status_t CaptureManager::setSyntheticOpts(const gcap_synthetic_opts_t *opts)
+{
+    gcap_synthetic_opts_t o{};
+    if (opts)
+    {
+        if (opts->device_count < 0 || opts->device_count > 16 || opts->zero_copy < 0 || opts->zero_copy > 1 ||
+            (opts->pacing != GCAP_SYNTHETIC_PACE_CLOCK && opts->pacing != GCAP_SYNTHETIC_PACE_FREE_RUN))
+            return GCAP_EINVAL;
+        o = *opts;
+    }
+    SyntheticProvider::setOptions(o);
+    return GCAP_OK;
+}
+
+gcap_status_t CaptureManager::setReplayOpts(const gcap_replay_opts_t *opts)
+{
+    if (opts)
+    {
+        if (opts->pacing != GCAP_REPLAY_PACE_PTS && opts->pacing != GCAP_REPLAY_PACE_FIXED &&
+            opts->pacing != GCAP_REPLAY_PACE_FREE_RUN)
+            return GCAP_EINVAL;
+        if (opts->pacing == GCAP_REPLAY_PACE_FIXED &&
+            (opts->fps_num <= 0 || opts->fps_den <= 0 || opts->fps_num > 1000000 || opts->fps_den > 1000000))
+            return GCAP_EINVAL;
+        if (opts->loop < 0 || opts->loop > 1)
+            return GCAP_EINVAL;
+    }
+    ReplayProvider::setOptions(opts);
+    return GCAP_OK;
+}
+
+gcap_status_t CaptureManager::setAutoCalibration(const gcap_auto_calibration_t *opts)
+{
+    if (opts && ((opts->enable != 0 && opts->enable != 1) || opts->warmup_ms < 0 || opts->measure_ms < 0))
+        return GCAP_EINVAL;
+    gcap::set_calibration_options(opts);
+    return GCAP_OK;
+}
+
 void CaptureManager::setD3dAdapterInt(int index)
 {
     g_d3d_adapter_index = index;
@@ -179,7 +325,7 @@ gcap_status_t CaptureManager::enumerate(gcap_device_info_t *out, int max, int *c
     if (!provider_)
         return GCAP_ENOTSUP; // Not supported on this platform
     std::vector<gcap_device_info_t> list;
-    if (!provider_->enumerate(list))
+    if (!listDevices(activeBackendInt_, list))
         return GCAP_EIO;
     int n = (int)list.size();
     if (count)
@@ -189,6 +335,50 @@ gcap_status_t CaptureManager::enumerate(gcap_device_info_t *out, int max, int *c
     return GCAP_OK;
 }
 
+/**
+ * @brief gcap_enumerate: the selected backend's list (AUTO: its first candidate's),
+ * without building a CaptureManager.
+ */
+gcap_status_t CaptureManager::enumerateDevices(gcap_device_info_t *out, int max, int *count)
+{
+    int backendInt = currentBackendInt();
+    if (backendInt == GCAP_BACKEND_AUTO)
+        backendInt = kAutoCandidates[0];
+    std::vector<gcap_device_info_t> list;
+    if (!listDevices(backendInt, list))
+        return makeProvider(backendInt) ? GCAP_EIO : GCAP_ENOTSUP;
+    int n = (int)list.size();
+    if (count)
+        *count = n;
+    for (int i = 0; i < n && i < max; ++i)
+        out[i] = list[i];
+    return GCAP_OK;
+}
+
+/**
+ * @brief A backend's device list through the process-wide device cache. Synthetic and
+ * replay lists follow their options and are cheap, so they are always built afresh.
+ */
+bool CaptureManager::listDevices(int backendInt, std::vector<gcap_device_info_t> &list)
+{
+    auto load = [backendInt](std::vector<gcap_device_info_t> &l)
+    {
+        std::unique_ptr<ICaptureProvider> p = makeProvider(backendInt);
+        return p && p->enumerate(l);
+    };
+    if (backendInt == GCAP_BACKEND_SYNTHETIC || backendInt == GCAP_BACKEND_REPLAY)
+        return load(list);
+    return gcap::cached_device_list(backendInt, load, list);
+}
+
+gcap_status_t CaptureManager::setDeviceCache(const gcap_device_cache_opts_t *opts)
+{
+    if (opts && opts->enable != 0 && opts->enable != 1)
+        return GCAP_EINVAL;
+    gcap::set_device_cache_options(opts);
+    return GCAP_OK;
+}
+
 /**
  * @brief Open the selected device.
  */
@@ -196,8 +386,10 @@ gcap_status_t CaptureManager::open(int idx)
 {
     if (selectedBackendInt_ == GCAP_BACKEND_AUTO)
     {
-        const int candidates[] = {GCAP_BACKEND_WINMF_GPU, GCAP_BACKEND_WINMF_CPU, GCAP_BACKEND_DSHOW};
-        for (int backendInt : candidates)
+        gcap::CalibrationSettings settings;
+        if (gcap::calibration_enabled(&settings) && openCalibrated(idx, settings))
+            return GCAP_OK;
+        for (int backendInt : kAutoCandidates)
         {
             if (openWithBackend(backendInt, idx))
                 return GCAP_OK;
@@ -211,6 +403,110 @@ gcap_status_t CaptureManager::open(int idx)
     return GCAP_OK;
 }
 
+bool CaptureManager::openChoice(const gcap::CalibrationChoice &c, int deviceIndex)
+{
+    if (!openWithBackend(c.backend, deviceIndex))
+        return false;
+    // The choice only decides the pixel format; the rest stays as the application set it.
+    if (c.format != GCAP_FMT_NV12 || hasProcessing_)
+    {
+        gcap_processing_opts_t po = cachedProcessing_;
+        po.preferred_pixfmt = c.format;
+        provider_->setProcessing(po);
+    }
+    return true;
+}
+
+/**
+ * @brief GCAP_BACKEND_AUTO with gcap_set_auto_calibration: opens the backend remembered
+ * for this device and profile, or measures every candidate and opens the best.
+ * Returns false to fall back to the first candidate that opens.
+ */
+bool CaptureManager::openCalibrated(int idx, const gcap::CalibrationSettings &settings)
+{
+    // The symbolic link names the device across runs; the first backend that lists it decides.
+    std::string link;
+    for (int backendInt : kAutoCandidates)
+    {
+        std::vector<gcap_device_info_t> list;
+        if (listDevices(backendInt, list) && idx >= 0 && idx < (int)list.size())
+        {
+            link = list[(size_t)idx].symbolic_link;
+            break;
+        }
+    }
+    if (link.empty())
+        return false;
+
+    const gcap_profile_t *profile = hasProfile_ ? &cachedProfile_ : nullptr;
+    const bool custom = profile && profile->mode == GCAP_PROFILE_CUSTOM;
+    const std::string key = gcap::calibration_key(link.c_str(), profile);
+    char msg[256];
+    gcap::CalibrationChoice choice;
+    if (gcap::calibration_lookup(key, choice))
+    {
+        if (openChoice(choice, idx))
+        {
+            std::snprintf(msg, sizeof(msg), "[Auto] %s (remembered)%s%s", backendName(choice.backend),
+                          custom ? "" : ", ", custom ? "" : formatName(choice.format));
+            deliverError(GCAP_OK, msg, this);
+            return true;
+        }
+        gcap::calibration_forget(key);
+    }
+
+    // A custom profile fixes the format; otherwise every format a backend lets
+    // setProcessing() pick is a candidate of its own.
+    static const gcap_pixfmt_t kFormats[] = {GCAP_FMT_NV12, GCAP_FMT_YUY2, GCAP_FMT_P010, GCAP_FMT_Y210};
+    std::vector<gcap::CalibrationCandidate> candidates;
+    for (int backendInt : kAutoCandidates)
+        for (gcap_pixfmt_t fmt : kFormats)
+        {
+            if (custom && fmt != GCAP_FMT_NV12)
+                break;
+            gcap::CalibrationCandidate c;
+            c.backend = backendInt;
+            c.format = fmt;
+            candidates.push_back(c);
+        }
+
+    const bool packets = pcb_ || fanout_->active();
+    std::vector<gcap::CalibrationResult> results;
+    for (const gcap::CalibrationCandidate &c : candidates)
+    {
+        results.push_back(gcap::measure_candidate([](int b)
+                                                  { return makeProvider(b); },
+                                                  c, idx, profile, packets, settings));
+        const gcap::CalibrationResult &r = results.back();
+        if (!r.started)
+            continue;
+        std::snprintf(msg, sizeof(msg),
+                      "[Auto] %s%s%s: %.2f fps, jitter %.3f ms, CPU %.0f us/frame, first frame %.0f ms",
+                      backendName(c.backend), custom ? "" : " ", custom ? "" : formatName(c.format), r.fps, r.jitterMs,
+                      r.cpuUsPerFrame, r.firstFrameMs);
+        deliverError(GCAP_OK, msg, this);
+    }
+
+    const double target = custom && profile->fps_num > 0 && profile->fps_den > 0
+                              ? (double)profile->fps_num / profile->fps_den
+                              : 0.0;
+    const int best = gcap::pick_best(results, target);
+    if (best < 0)
+    {
+        deliverError(GCAP_OK, "[Auto] calibration: no candidate delivered frames", this);
+        return false;
+    }
+    choice.backend = results[(size_t)best].candidate.backend;
+    choice.format = results[(size_t)best].candidate.format;
+    if (!openChoice(choice, idx))
+        return false;
+    gcap::calibration_store(key, choice);
+    std::snprintf(msg, sizeof(msg), "[Auto] picked %s%s%s", backendName(choice.backend), custom ? "" : " ",
+                  custom ? "" : formatName(choice.format));
+    deliverError(GCAP_OK, msg, this);
+    return true;
+}
+
 /**
  * @brief Set the desired capture profile (resolution, FPS, format).
  */
@@ -228,11 +524,50 @@ gcap_status_t CaptureManager::setProfile(const gcap_profile_t &p)
  */
 gcap_status_t CaptureManager::setBuffers(int c, size_t b)
 {
-    cachedBufferCount_ = c;
-    cachedBufferBytesHint_ = b;
+    gcap_buffer_opts_t o{};
+    o.count = c;
+    o.bytes_hint = b;
+    o.prefault = 1;
+    return setBuffersEx(o);
+}
+
+/**
+ * @brief Configure the frame arena behind the pool. The arena is built here when
+ * the size is known, otherwise at start() from the profile.
+ */
+gcap_status_t CaptureManager::setBuffersEx(const gcap_buffer_opts_t &o)
+{
+    if (o.count < 0)
+        return GCAP_EINVAL;
+    cachedBufferCount_ = o.count;
+    cachedBufferBytesHint_ = o.bytes_hint;
+    bufferOpts_ = o;
+    arenaBlockBytes_ = 0;
+    if (o.bytes_hint > 0 || o.count == 0)
+    {
+        if (!framePool_->setBuffers(o.count, o.bytes_hint, o.huge_pages != 0))
+            return GCAP_EINVAL;
+        arenaBlockBytes_ = o.bytes_hint;
+    }
     if (!provider_)
         return GCAP_ENOTSUP;
-    return provider_->setBuffers(c, b) ? GCAP_OK : GCAP_EINVAL;
+    return provider_->setBuffers(o.count, o.bytes_hint) ? GCAP_OK : GCAP_EINVAL;
+}
+
+// bytes_hint 0: one 4-byte-per-pixel frame (BGRA, or 10-bit 4:2:2) with aligned rows.
+void CaptureManager::prepareFrameArena()
+{
+    const gcap_buffer_opts_t &o = bufferOpts_;
+    if (o.count <= 0)
+        return;
+    if (o.bytes_hint == 0 && hasProfile_ && cachedProfile_.width > 0 && cachedProfile_.height > 0)
+    {
+        const size_t bytes = (size_t)gcap::aligned_row_bytes(cachedProfile_.width * 4) * (size_t)cachedProfile_.height;
+        if (bytes != arenaBlockBytes_ && framePool_->setBuffers(o.count, bytes, o.huge_pages != 0))
+            arenaBlockBytes_ = bytes;
+    }
+    if (o.prefault)
+        framePool_->prefault();
 }
 
 /**
@@ -245,11 +580,28 @@ gcap_status_t CaptureManager::setCallbacks(gcap_on_video_cb v, gcap_on_error_cb
     user_ = u;
     if (!provider_)
         return GCAP_ENOTSUP;
-    provider_->setCallbacks(vcb_, ecb_, user_);
-    provider_->setFramePacketCallback(pcb_, user_);
+    installCallbacks();
     return GCAP_OK;
 }
 
+/**
+ * @brief Register callbacks and the size of the frames the video callback receives.
+ */
+gcap_status_t CaptureManager::setCallbacksEx(gcap_on_video_cb v, gcap_on_error_cb e, void *u, const gcap_video_output_t *out)
+{
+    gcap_video_output_t vo{};
+    if (out)
+    {
+        if (out->width < 0 || out->height < 0 || out->filter < GCAP_SCALE_AUTO || out->filter > GCAP_SCALE_BILINEAR)
+            return GCAP_EINVAL;
+        vo = *out;
+    }
+    videoOutput_ = vo;
+    if (provider_)
+        provider_->setVideoOutput(videoOutput_);
+    return setCallbacks(v, e, u);
+}
+
 gcap_status_t CaptureManager::setFramePacketCallback(gcap_on_frame_packet_cb cb, void *u)
 {
     pcb_ = cb;
@@ -261,11 +613,185 @@ gcap_status_t CaptureManager::setFramePacketCallback(gcap_on_frame_packet_cb cb,
     }
     if (!provider_)
         return GCAP_ENOTSUP;
-    provider_->setCallbacks(vcb_, ecb_, user_);
-    provider_->setFramePacketCallback(pcb_, user_);
+    installCallbacks();
+    return GCAP_OK;
+}
+
+/**
+ * @brief Configure the retainable frame pool (nullptr = defaults).
+ */
+gcap_status_t CaptureManager::setLeasePolicy(const gcap_lease_opts_t *opts)
+{
+    gcap_lease_opts_t o{};
+    if (opts)
+    {
+        if (opts->slots < 0 || opts->max_slots < 0 || opts->policy < GCAP_LEASE_POLICY_UNLEASED || opts->policy > GCAP_LEASE_POLICY_SKIP)
+            return GCAP_EINVAL;
+        o = *opts;
+    }
+    framePool_->configure(o);
+    return GCAP_OK;
+}
+
+/**
+ * @brief Choose where frame callbacks run (nullptr = on the capture thread).
+ */
+gcap_status_t CaptureManager::setDelivery(const gcap_delivery_opts_t *opts)
+{
+    gcap_delivery_opts_t o{};
+    if (opts)
+    {
+        if (opts->policy < GCAP_DELIVERY_SYNC || opts->policy > GCAP_DELIVERY_LATEST_ONLY || opts->depth < 0 || opts->block_timeout_ms < 0)
+            return GCAP_EINVAL;
+        o = *opts;
+    }
+    if (streaming_)
+        return GCAP_ESTATE;
+    delivery_->configure(o);
+    framePool_->setQueueSlots(delivery_->enabled() ? delivery_->depth() + 1 : 0);
+    if (provider_)
+        installCallbacks();
+    return GCAP_OK;
+}
+
+/**
+ * @brief Add a gcap_subscribe() consumer; allowed while streaming.
+ */
+gcap_status_t CaptureManager::subscribe(const gcap_subscriber_desc_t &desc, int *outId)
+{
+    if (desc.filter < GCAP_SCALE_AUTO || desc.filter > GCAP_SCALE_BILINEAR)
+        return GCAP_EINVAL;
+    const int id = fanout_->subscribe(desc);
+    if (!id)
+        return GCAP_EINVAL;
+    if (outId)
+        *outId = id;
+    if (provider_)
+        installCallbacks();
+    return GCAP_OK;
+}
+
+/**
+ * @brief Remove a subscriber; its callback is not running once this returns.
+ */
+gcap_status_t CaptureManager::unsubscribe(int id)
+{
+    if (!fanout_->unsubscribe(id))
+        return GCAP_EINVAL;
+    if (provider_)
+        installCallbacks();
+    return GCAP_OK;
+}
+
+/**
+ * @brief Publish frames into a named shared-memory ring (a subscriber that copies into it).
+ */
+gcap_status_t CaptureManager::publishShm(const gcap_shm_publisher_desc_t &desc, int *outId)
+{
+    if (!gcap::shm::valid_name(desc.name) || desc.slots < 0 || desc.slots > gcap::shm::kMaxSlots)
+        return GCAP_EINVAL;
+    auto pub = std::make_unique<gcap::ShmPublisher>(desc.name, desc.slots, desc.slot_bytes);
+    gcap_subscriber_desc_t sd{};
+    sd.format = desc.format;
+    sd.width = desc.width;
+    sd.height = desc.height;
+    sd.filter = desc.filter;
+    sd.fps_num = desc.fps_num;
+    sd.fps_den = desc.fps_den;
+    sd.cb = &gcap::ShmPublisher::onPacket;
+    sd.user = pub.get();
+    int id = 0;
+    const gcap_status_t st = subscribe(sd, &id);
+    if (st != GCAP_OK)
+        return st;
+    shmPublishers_[id] = std::move(pub);
+    if (outId)
+        *outId = id;
     return GCAP_OK;
 }
 
+gcap_status_t CaptureManager::unpublishShm(int id)
+{
+    auto it = shmPublishers_.find(id);
+    if (it == shmPublishers_.end())
+        return GCAP_EINVAL;
+    unsubscribe(id);
+    shmPublishers_.erase(it);
+    return GCAP_OK;
+}
+
+static uint64_t steadyNowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// The provider always calls the manager, which queues the frame for the delivery
+// thread or runs the callbacks itself, timing them for gcap_get_stats().
+void CaptureManager::installCallbacks()
+{
+    const bool packets = pcb_ || fanout_->active();
+    delivery_->setTargets(vcb_, user_, packets ? &CaptureManager::dispatchPacket : nullptr, this);
+    if (!provider_)
+        return;
+    provider_->setCallbacks(vcb_ ? &CaptureManager::deliverVideo : nullptr, ecb_ ? &CaptureManager::deliverError : nullptr, this);
+    provider_->setFramePacketCallback(packets ? &CaptureManager::deliverPacket : nullptr, this);
+}
+
+void CaptureManager::deliverVideo(const gcap_frame_t *f, void *self)
+{
+    CaptureManager *m = static_cast<CaptureManager *>(self);
+    if (m->delivery_->enabled())
+    {
+        m->delivery_->push(f);
+        return;
+    }
+    if (!m->vcb_)
+        return;
+    const uint64_t t0 = steadyNowNs();
+    m->vcb_(f, m->user_);
+    const uint64_t t1 = steadyNowNs();
+    gcap::StatsShard &st = m->stats_->shard(gcap::CaptureStats::Thread::Capture);
+    st.record(gcap::StatHist::Callback, t1 - t0);
+    st.delivered(f->frame_id);
+    st.tick(t1);
+}
+
+void CaptureManager::deliverPacket(const gcap_frame_packet_t *p, void *self)
+{
+    CaptureManager *m = static_cast<CaptureManager *>(self);
+    if (m->delivery_->enabled())
+    {
+        m->delivery_->push(p);
+        return;
+    }
+    const uint64_t t0 = steadyNowNs();
+    dispatchPacket(p, self);
+    const uint64_t t1 = steadyNowNs();
+    gcap::StatsShard &st = m->stats_->shard(gcap::CaptureStats::Thread::Capture);
+    st.record(gcap::StatHist::Callback, t1 - t0);
+    st.delivered(p->frame_id);
+    st.tick(t1);
+}
+
+// Packet callback first, then the subscribers; on the delivery thread when there is one.
+void CaptureManager::dispatchPacket(const gcap_frame_packet_t *p, void *self)
+{
+    CaptureManager *m = static_cast<CaptureManager *>(self);
+    if (m->pcb_)
+        m->pcb_(p, m->user_);
+    m->fanout_->dispatch(p);
+}
+
+// Errors stay on the provider's thread; only the user pointer is swapped back.
+void CaptureManager::deliverError(gcap_status_t code, const char *msg, void *self)
+{
+    CaptureManager *m = static_cast<CaptureManager *>(self);
+    if (m->ecb_)
+        m->ecb_(code, msg, m->user_);
+}
+
 /**
  * @brief Start video capture.
  */
@@ -274,14 +800,17 @@ gcap_status_t CaptureManager::start()
     if (!provider_)
         return GCAP_ENOTSUP;
 
+    prepareFrameArena();
+    stats_->reset();
+    delivery_->start();
+    streaming_ = true;
     if (provider_->start())
         return GCAP_OK;
 
     if (selectedBackendInt_ == GCAP_BACKEND_AUTO && openedDeviceIndex_ >= 0)
     {
         const int current = activeBackendInt_;
-        const int candidates[] = {GCAP_BACKEND_WINMF_GPU, GCAP_BACKEND_WINMF_CPU, GCAP_BACKEND_DSHOW};
-        for (int backendInt : candidates)
+        for (int backendInt : kAutoCandidates)
         {
             if (backendInt == current)
                 continue;
@@ -292,6 +821,8 @@ gcap_status_t CaptureManager::start()
         }
     }
 
+    streaming_ = false;
+    delivery_->stop();
     return GCAP_ESTATE;
 }
 
@@ -303,6 +834,11 @@ gcap_status_t CaptureManager::stop()
     if (!provider_)
         return GCAP_ENOTSUP;
     provider_->stop();
+    // After the provider: nothing pushes any more, and a producer blocked on a
+    // full queue has been released by the delivery thread draining it.
+    delivery_->stop();
+    stats_->flush();
+    streaming_ = false;
     return GCAP_OK;
 }
 
@@ -315,6 +851,8 @@ gcap_status_t CaptureManager::startRecording(const char *pathUtf8)
     if (auto *p = dynamic_cast<WinMFProvider *>(provider_.get()))
         return p->startRecording(pathUtf8);
 #endif
+    if (auto *p = dynamic_cast<SyntheticProvider *>(provider_.get()))
+        return p->startRecording(pathUtf8);
     return GCAP_ENOTSUP;
 }
 
@@ -327,6 +865,8 @@ gcap_status_t CaptureManager::stopRecording()
     if (auto *p = dynamic_cast<WinMFProvider *>(provider_.get()))
         return p->stopRecording();
 #endif
+    if (auto *p = dynamic_cast<SyntheticProvider *>(provider_.get()))
+        return p->stopRecording();
     return GCAP_ENOTSUP;
 }
 
@@ -351,6 +891,9 @@ gcap_status_t CaptureManager::close()
     if (!provider_)
         return GCAP_ENOTSUP;
     provider_->close();
+    delivery_->stop();
+    stats_->flush();
+    streaming_ = false;
     openedDeviceIndex_ = -1;
     return GCAP_OK;
 }
@@ -373,14 +916,57 @@ gcap_status_t CaptureManager::getRuntimeInfo(gcap_runtime_info_t &out)
 {
     if (!provider_)
         return GCAP_ENOTSUP;
-    return provider_->getRuntimeInfo(out) ? GCAP_OK : GCAP_ENOTSUP;
+    if (!provider_->getRuntimeInfo(out))
+        return GCAP_ENOTSUP;
+    const gcap::FramePool::Stats st = framePool_->stats();
+    out.lease_slots = st.slots;
+    out.lease_outstanding = st.leases;
+    out.lease_exhausted = st.exhausted;
+    out.arena_bytes = st.arenaBytes;
+    out.arena_used_bytes = st.arenaUsedBytes;
+    out.arena_huge_pages = st.hugePages ? 1 : 0;
+    out.arena_misses = st.arenaMisses;
+    const gcap::DeliveryQueue::Stats ds = delivery_->stats();
+    out.delivery_policy = (int)delivery_->policy();
+    out.delivery_depth = ds.depth;
+    out.delivery_depth_hwm = ds.highWater;
+    out.delivery_delivered = ds.delivered;
+    out.delivery_dropped_oldest = ds.droppedOldest;
+    out.delivery_dropped_newest = ds.droppedNewest;
+    out.delivery_replaced = ds.replaced;
+    out.delivery_block_timeouts = ds.blockTimeouts;
+    out.delivery_blocked_ns = ds.blockedNs;
+    out.delivery_copy_failed = ds.copyFailed;
+    return GCAP_OK;
+}
+
+// Reads only what the capture / delivery threads published; safe while streaming.
+gcap_status_t CaptureManager::getStats(gcap_stats_t &out)
+{
+    stats_->snapshot(out);
+    return GCAP_OK;
 }
 
 gcap_status_t CaptureManager::setProcessing(const gcap_processing_opts_t &opts)
 {
+    if (opts.worker_threads < 0 || opts.cpu_output < GCAP_CPU_OUT_ARGB || opts.cpu_output > GCAP_CPU_OUT_X2R10G10B10)
+        return GCAP_EINVAL;
+
     if (!provider_)
         return GCAP_ENOTSUP;
-    return provider_->setProcessing(opts) ? GCAP_OK : GCAP_ENOTSUP;
+    // Providers without format/deinterlace control still honour the thread count.
+    const bool onlyThreads = opts.preferred_pixfmt == GCAP_FMT_NV12 && opts.deinterlace == GCAP_DEINT_AUTO &&
+                             opts.force_range == GCAP_RANGE_UNKNOWN && opts.cpu_output == GCAP_CPU_OUT_ARGB;
+    if (!provider_->setProcessing(opts) && !onlyThreads)
+        return GCAP_ENOTSUP;
+
+    // The conversion pool is shared by every handle; it is configured here so
+    // all CPU paths (WinMF CPU, DShow raw) pick it up regardless of provider.
+    // A rejected call leaves it alone.
+    gcap::set_convert_threads(opts.worker_threads);
+    cachedProcessing_ = opts;
+    hasProcessing_ = true;
+    return GCAP_OK;
 }
 
 gcap_status_t CaptureManager::setProcAmp(const gcap_procamp_t &p)
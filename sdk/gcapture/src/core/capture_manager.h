@@ -1,5 +1,6 @@
 #pragma once
 #include <functional>
+#include <map>
 #include <memory>
 #include <vector>
 #include <string>
@@ -7,6 +8,17 @@
 #include <cstring>
 #include "gcapture.h"
 
+namespace gcap
+{
+    class FramePool;
+    class CaptureStats;
+    class DeliveryQueue;
+    class FrameFanout;
+    class ShmPublisher;
+    struct CalibrationSettings;
+    struct CalibrationChoice;
+}
+
 /**
  * @brief Abstract interface for all capture providers.
  *
@@ -73,6 +85,30 @@ struct ICaptureProvider
         (void)pcb;
         (void)user;
     }
+    /**
+     * @brief Size of the frames handed to the video callback ({0, 0} = source size).
+     * Providers that cannot resize keep delivering source-size frames.
+     */
+    virtual void setVideoOutput(const gcap_video_output_t &out)
+    {
+        (void)out;
+    }
+    /**
+     * @brief Slot pool CPU frames should be delivered from, so callbacks can retain them.
+     * Owned by the CaptureManager and valid for the provider's lifetime.
+     */
+    virtual void setFramePool(gcap::FramePool *pool)
+    {
+        (void)pool;
+    }
+    /**
+     * @brief Where to count frames, copies and conversion times (gcap_get_stats).
+     * Owned by the CaptureManager and valid for the provider's lifetime.
+     */
+    virtual void setStats(gcap::CaptureStats *stats)
+    {
+        (void)stats;
+    }
 
     // --- OBS-like properties ---
     virtual bool getDeviceProps(gcap_device_props_t &out)
@@ -137,8 +173,16 @@ public:
     gcap_status_t open(int deviceIndex);
     gcap_status_t setProfile(const gcap_profile_t &p);
     gcap_status_t setBuffers(int count, size_t bytes_hint);
+    gcap_status_t setBuffersEx(const gcap_buffer_opts_t &opts);
     gcap_status_t setCallbacks(gcap_on_video_cb v, gcap_on_error_cb e, void *user);
+    gcap_status_t setCallbacksEx(gcap_on_video_cb v, gcap_on_error_cb e, void *user, const gcap_video_output_t *out);
     gcap_status_t setFramePacketCallback(gcap_on_frame_packet_cb cb, void *user);
+    gcap_status_t setLeasePolicy(const gcap_lease_opts_t *opts);
+    gcap_status_t setDelivery(const gcap_delivery_opts_t *opts);
+    gcap_status_t subscribe(const gcap_subscriber_desc_t &desc, int *outId);
+    gcap_status_t unsubscribe(int id);
+    gcap_status_t publishShm(const gcap_shm_publisher_desc_t &desc, int *outId);
+    gcap_status_t unpublishShm(int id);
     gcap_status_t start();
     gcap_status_t startRecording(const char *pathUtf8);
     gcap_status_t stopRecording();
@@ -148,6 +192,7 @@ public:
     gcap_status_t getDeviceProps(gcap_device_props_t &out);
     gcap_status_t getSignalStatus(gcap_signal_status_t &out);
     gcap_status_t getRuntimeInfo(gcap_runtime_info_t &out);
+    gcap_status_t getStats(gcap_stats_t &out);
     gcap_status_t setProcessing(const gcap_processing_opts_t &opts);
     gcap_status_t setProcAmp(const gcap_procamp_t &p);
     gcap_status_t setPreview(const gcap_preview_desc_t &desc);
@@ -155,18 +200,39 @@ public:
     int getActiveBackendInt() const;
 
     static void setBackendInt(int v);
+    static gcap_status_t setSyntheticOpts(const gcap_synthetic_opts_t *opts);
+    static gcap_status_t setReplayOpts(const gcap_replay_opts_t *opts);
+    static gcap_status_t setAutoCalibration(const gcap_auto_calibration_t *opts);
+    static gcap_status_t setDeviceCache(const gcap_device_cache_opts_t *opts);
+    static gcap_status_t enumerateDevices(gcap_device_info_t *out, int max, int *count);
+    static bool listDevices(int backendInt, std::vector<gcap_device_info_t> &list);
     static void setD3dAdapterInt(int index);
 
 private:
     bool rebuildProviderForBackend(int backendInt);
     bool openWithBackend(int backendInt, int deviceIndex);
+    bool openCalibrated(int deviceIndex, const gcap::CalibrationSettings &settings);
+    bool openChoice(const gcap::CalibrationChoice &c, int deviceIndex);
     bool applyCachedStateToProvider();
+    void prepareFrameArena();
+    void installCallbacks();
+    static void deliverVideo(const gcap_frame_t *f, void *self);
+    static void deliverPacket(const gcap_frame_packet_t *p, void *self);
+    static void dispatchPacket(const gcap_frame_packet_t *p, void *self);
+    static void deliverError(gcap_status_t code, const char *msg, void *self);
 
     std::unique_ptr<ICaptureProvider> provider_; // Active provider instance
     gcap_on_video_cb vcb_ = nullptr;             // Video frame callback
     gcap_on_frame_packet_cb pcb_ = nullptr;      // Frame packet callback
     gcap_on_error_cb ecb_ = nullptr;             // Error callback
     void *user_ = nullptr;                       // User data pointer for callbacks
+    gcap_video_output_t videoOutput_{};          // Video callback frame size (0 = source)
+    gcap::FramePool *framePool_ = nullptr;       // Retainable frame slots (outlives provider_)
+    std::unique_ptr<gcap::CaptureStats> stats_;     // gcap_get_stats() counters (outlives provider_)
+    std::unique_ptr<gcap::DeliveryQueue> delivery_; // Callback delivery thread (gcap_set_delivery)
+    std::unique_ptr<gcap::FrameFanout> fanout_;     // gcap_subscribe() consumers
+    std::map<int, std::unique_ptr<gcap::ShmPublisher>> shmPublishers_; // by subscriber id
+    bool streaming_ = false;
 
     int selectedBackendInt_ = 1;
     int activeBackendInt_ = 1;
@@ -176,6 +242,10 @@ private:
     gcap_profile_t cachedProfile_{};
     int cachedBufferCount_ = 0;
     size_t cachedBufferBytesHint_ = 0;
+    gcap_buffer_opts_t bufferOpts_{};            // gcap_set_buffers_ex() as requested
+    size_t arenaBlockBytes_ = 0;                 // block size of the pool's current arena
     bool hasPreview_ = false;
     gcap_preview_desc_t cachedPreview_{};
+    bool hasProcessing_ = false;
+    gcap_processing_opts_t cachedProcessing_{};  // last accepted gcap_set_processing
 };
@@ -0,0 +1,238 @@
+// capture_stats.cpp
+#include "capture_stats.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    constexpr int kSubBits = 3; // 8 buckets per power of two
+    constexpr int kSub = 1 << kSubBits;
+    constexpr int kMaxMsb = GCAP_STATS_BUCKETS / kSub + 2; // values from 2^40 share the last bucket
+
+    // v > 0
+    int msb(uint64_t v)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long i;
+        _BitScanReverse64(&i, v);
+        return (int)i;
+#elif defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        int n = 0;
+        while (v >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    gcap_histogram_t &hist_of(gcap_stats_t &st, gcap::StatHist h)
+    {
+        switch (h)
+        {
+        case gcap::StatHist::FrameInterval:
+            return st.frame_interval_ns;
+        case gcap::StatHist::Convert:
+            return st.convert_ns;
+        case gcap::StatHist::Callback:
+            return st.callback_ns;
+        case gcap::StatHist::QueueWait:
+            return st.queue_wait_ns;
+        case gcap::StatHist::CopyBytes:
+        default:
+            return st.copy_bytes;
+        }
+    }
+
+    uint64_t &counter_of(gcap_stats_t &st, gcap::StatCounter c)
+    {
+        switch (c)
+        {
+        case gcap::StatCounter::FramesCaptured:
+            return st.frames_captured;
+        case gcap::StatCounter::FramesDelivered:
+            return st.frames_delivered;
+        case gcap::StatCounter::FramesDropped:
+            return st.frames_dropped;
+        case gcap::StatCounter::FramesDuplicated:
+            return st.frames_duplicated;
+        case gcap::StatCounter::FramesDroppedDelivery:
+            return st.frames_dropped_delivery;
+        case gcap::StatCounter::BytesCopied:
+        default:
+            return st.bytes_copied;
+        }
+    }
+
+    // Middle of the bucket holding the q-th value, kept inside [min, max].
+    uint64_t percentile(const gcap_histogram_t &h, double q)
+    {
+        if (h.count == 0)
+            return 0;
+        uint64_t rank = (uint64_t)(q * (double)h.count + 0.999999);
+        rank = std::min(std::max<uint64_t>(rank, 1), h.count);
+        uint64_t seen = 0;
+        for (int i = 0; i < GCAP_STATS_BUCKETS; ++i)
+        {
+            seen += h.buckets[i];
+            if (seen < rank)
+                continue;
+            const uint64_t lo = gcap::stats_bucket_floor(i);
+            const uint64_t hi = i + 1 < GCAP_STATS_BUCKETS ? gcap::stats_bucket_floor(i + 1) : 1ull << kMaxMsb;
+            return std::min(std::max(lo + (hi - lo - 1) / 2, h.min), h.max);
+        }
+        return h.max;
+    }
+}
+
+int gcap::stats_bucket(uint64_t v)
+{
+    if (v < (uint64_t)kSub)
+        return (int)v;
+    const int m = msb(v);
+    if (m >= kMaxMsb)
+        return GCAP_STATS_BUCKETS - 1;
+    return kSub + (m - kSubBits) * kSub + (int)((v >> (m - kSubBits)) & (kSub - 1));
+}
+
+uint64_t gcap::stats_bucket_floor(int bucket)
+{
+    if (bucket < kSub)
+        return (uint64_t)std::max(bucket, 0);
+    return (uint64_t)(kSub + bucket % kSub) << (bucket / kSub - 1);
+}
+
+gcap::StatsShard::StatsShard()
+{
+    reset();
+}
+
+void gcap::StatsShard::record(StatHist h, uint64_t v)
+{
+    uint64_t *w = live_ + histBase(h);
+    w[0] += 1;
+    w[1] += v;
+    w[2] = std::min(w[2], v);
+    w[3] = std::max(w[3], v);
+    w[4 + stats_bucket(v)] += 1;
+}
+
+void gcap::StatsShard::arrived(uint64_t hostNs)
+{
+    add(StatCounter::FramesCaptured);
+    if (lastArrivalNs_ && hostNs > lastArrivalNs_)
+        record(StatHist::FrameInterval, hostNs - lastArrivalNs_);
+    lastArrivalNs_ = hostNs;
+}
+
+void gcap::StatsShard::delivered(uint64_t frameId)
+{
+    // Video and packet callbacks of one frame share its id.
+    if (frameId == lastDeliveredId_)
+        return;
+    lastDeliveredId_ = frameId;
+    add(StatCounter::FramesDelivered);
+}
+
+void gcap::StatsShard::copied(uint64_t bytes)
+{
+    frameBytes_ += bytes;
+    add(StatCounter::BytesCopied, bytes);
+}
+
+void gcap::StatsShard::endFrame(uint64_t nowNs)
+{
+    record(StatHist::CopyBytes, frameBytes_);
+    frameBytes_ = 0;
+    tick(nowNs);
+}
+
+void gcap::StatsShard::publish(uint64_t nowNs)
+{
+    lastPublishNs_ = nowNs;
+    const uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < kWords; ++i)
+        published_[i].store(live_[i], std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+}
+
+void gcap::StatsShard::reset()
+{
+    std::memset(live_, 0, sizeof(live_));
+    for (int h = 0; h < (int)StatHist::Count; ++h)
+        live_[histBase((StatHist)h) + 2] = UINT64_MAX;
+    lastArrivalNs_ = 0;
+    lastDeliveredId_ = UINT64_MAX;
+    frameBytes_ = 0;
+    publish(0);
+}
+
+void gcap::StatsShard::mergeInto(gcap_stats_t &out) const
+{
+    uint64_t w[kWords];
+    for (int attempt = 0;; ++attempt)
+    {
+        const uint32_t s1 = seq_.load(std::memory_order_acquire);
+        if ((s1 & 1) == 0)
+        {
+            for (int i = 0; i < kWords; ++i)
+                w[i] = published_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1)
+                break;
+        }
+        // A publication takes about a microsecond; only a preempted writer needs the yield.
+        if (attempt >= 16)
+            std::this_thread::yield();
+    }
+
+    for (int c = 0; c < (int)StatCounter::Count; ++c)
+        counter_of(out, (StatCounter)c) += w[c];
+    for (int h = 0; h < (int)StatHist::Count; ++h)
+    {
+        const uint64_t *src = w + histBase((StatHist)h);
+        if (src[0] == 0)
+            continue;
+        gcap_histogram_t &dst = hist_of(out, (StatHist)h);
+        dst.min = dst.count ? std::min(dst.min, src[2]) : src[2];
+        dst.max = std::max(dst.max, src[3]);
+        dst.count += src[0];
+        dst.sum += src[1];
+        for (int i = 0; i < GCAP_STATS_BUCKETS; ++i)
+            dst.buckets[i] += src[4 + i];
+    }
+}
+
+void gcap::CaptureStats::reset()
+{
+    for (StatsShard &s : shards_)
+        s.reset();
+}
+
+void gcap::CaptureStats::flush()
+{
+    for (StatsShard &s : shards_)
+        s.publish(0);
+}
+
+void gcap::CaptureStats::snapshot(gcap_stats_t &out) const
+{
+    std::memset(&out, 0, sizeof(out));
+    for (const StatsShard &s : shards_)
+        s.mergeInto(out);
+    for (int h = 0; h < (int)StatHist::Count; ++h)
+    {
+        gcap_histogram_t &hg = hist_of(out, (StatHist)h);
+        hg.p50 = percentile(hg, 0.50);
+        hg.p90 = percentile(hg, 0.90);
+        hg.p99 = percentile(hg, 0.99);
+        hg.p999 = percentile(hg, 0.999);
+    }
+}
@@ -0,0 +1,124 @@
+// capture_stats.h
+// gcap_get_stats(): counters and latency histograms kept by the threads that
+// produce them. Portable; one instance per CaptureManager.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap
+{
+    // Bucket of a value in the gcap_histogram_t layout, and the smallest value in a bucket.
+    int stats_bucket(uint64_t v);
+    uint64_t stats_bucket_floor(int bucket);
+
+    enum class StatHist : uint8_t
+    {
+        FrameInterval, // ns between device arrivals
+        Convert,       // ns of CPU conversion per frame
+        Callback,      // ns in the application callbacks per frame
+        QueueWait,     // ns a frame waited for the delivery thread
+        CopyBytes,     // bytes copied per frame
+        Count
+    };
+
+    enum class StatCounter : uint8_t
+    {
+        FramesCaptured,
+        FramesDelivered,
+        FramesDropped,
+        FramesDuplicated,
+        FramesDroppedDelivery,
+        BytesCopied,
+        Count
+    };
+
+    /**
+     * The statistics one thread writes. Updates are plain stores into memory no
+     * other thread reads, so the hot path has no locked instructions and shares
+     * no cache line with the reader. tick() copies them, at most every 25 ms,
+     * into a second block behind a sequence lock; snapshots only read that one.
+     *
+     * A shard has one writer at a time. reset() and publish() from another
+     * thread are for when the writer is stopped (joined).
+     */
+    class StatsShard
+    {
+    public:
+        StatsShard();
+        StatsShard(const StatsShard &) = delete;
+        StatsShard &operator=(const StatsShard &) = delete;
+
+        void add(StatCounter c, uint64_t n = 1) { live_[(int)c] += n; }
+        void record(StatHist h, uint64_t v);
+
+        // A frame arrived from the device at hostNs (steady clock): counts it and
+        // records the interval since the previous one.
+        void arrived(uint64_t hostNs);
+        // A callback (or queued delivery) for frameId ran; counted once per frame id.
+        void delivered(uint64_t frameId);
+        // Bytes the SDK copied for the frame in progress; endFrame() records their sum.
+        void copied(uint64_t bytes);
+        void endFrame(uint64_t nowNs);
+
+        // Publishes when the last publication is 25 ms old.
+        void tick(uint64_t nowNs)
+        {
+            if (nowNs - lastPublishNs_ >= kPublishNs)
+                publish(nowNs);
+        }
+        void publish(uint64_t nowNs);
+        void reset();
+
+        // Adds the latest publication to a snapshot (counters summed, histograms merged).
+        void mergeInto(gcap_stats_t &out) const;
+
+    private:
+        static constexpr uint64_t kPublishNs = 25000000;
+        // Counters, then per histogram: count, sum, min, max, buckets.
+        static constexpr int kHistWords = 4 + GCAP_STATS_BUCKETS;
+        static constexpr int kWords = (int)StatCounter::Count + (int)StatHist::Count * kHistWords;
+
+        static int histBase(StatHist h) { return (int)StatCounter::Count + (int)h * kHistWords; }
+
+        // Writer only.
+        alignas(64) uint64_t live_[kWords];
+        uint64_t lastArrivalNs_ = 0;
+        uint64_t lastDeliveredId_ = UINT64_MAX;
+        uint64_t frameBytes_ = 0;
+        uint64_t lastPublishNs_ = 0;
+
+        alignas(64) std::atomic<uint32_t> seq_{0};
+        std::atomic<uint64_t> published_[kWords];
+    };
+
+    /**
+     * One shard per thread that produces frame statistics. Providers pick the
+     * shard of the thread they are on: Device for the thread that receives
+     * samples when it is not the one converting and calling back (DirectShow's
+     * streaming thread), Capture for the capture loop / frame pump, including
+     * the application callbacks it runs; the delivery queue writes Delivery.
+     */
+    class CaptureStats
+    {
+    public:
+        enum class Thread
+        {
+            Device,
+            Capture,
+            Delivery,
+            Count
+        };
+
+        StatsShard &shard(Thread t) { return shards_[(int)t]; }
+
+        // Both while no writer runs (before gcap_start / after the threads are joined).
+        void reset();
+        void flush();
+
+        void snapshot(gcap_stats_t &out) const;
+
+    private:
+        StatsShard shards_[(int)Thread::Count];
+    };
+}
@@ -0,0 +1,298 @@
+// clock_recovery.cpp
+#include "clock_recovery.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int kMinFitPoints = 8;
+    constexpr int kPeriodWindow = 31;
+    constexpr double kMaxDriftRate = 0.01;  // fitted rates beyond 1 +/- 1% are timestamp noise
+    constexpr double kResyncGapNs = 1e9;    // a gap this long (plus 10 periods) restarts the fit
+    constexpr int kRateChangeRun = 4;       // this many agreeing unexplained gaps are a new period
+    constexpr int kMaxUnexplained = 8;      // ... and this many of any kind
+    constexpr double kRunTolerance = 0.2;   // gaps within 20% of each other agree
+
+    double percentile(std::vector<double> &v, double p)
+    {
+        if (v.empty())
+            return 0.0;
+        const size_t k = std::min(v.size() - 1, (size_t)(p * (double)(v.size() - 1) + 0.5));
+        std::nth_element(v.begin(), v.begin() + (ptrdiff_t)k, v.end());
+        return v[k];
+    }
+}
+
+gcap::ClockRecovery::ClockRecovery(int window)
+    : window_(std::max(window, kMinFitPoints)),
+      points_((size_t)std::max(window, kMinFitPoints)),
+      periods_(kPeriodWindow),
+      run_(kMaxUnexplained)
+{
+}
+
+void gcap::ClockRecovery::reset(int fpsNum, int fpsDen)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    head_ = count_ = 0;
+    periodHead_ = periodCount_ = 0;
+    runLen_ = 0;
+    pendingDropped_ = pendingDuplicated_ = 0;
+    nominalPeriodNs_ = (fpsNum > 0 && fpsDen > 0) ? 1e9 * (double)fpsDen / (double)fpsNum : 0.0;
+    started_ = false;
+    deviceMode_ = false;
+    rate_ = 1.0;
+    offset_ = 0.0;
+    lastPts_ = 0;
+    stats_ = Stats{};
+}
+
+void gcap::ClockRecovery::restartFit(int64_t deviceNs, uint64_t hostNs)
+{
+    started_ = true;
+    deviceBase_ = deviceNs >= 0 ? deviceNs : 0;
+    hostBase_ = hostNs;
+    frameIndex_ = 0.0;
+    head_ = count_ = 0;
+    // Gaps before a resync can no longer be confirmed.
+    runLen_ = 0;
+    pendingDropped_ = pendingDuplicated_ = 0;
+    rate_ = deviceNs >= 0 ? 1.0 : periodNs();
+    offset_ = 0.0;
+}
+
+double gcap::ClockRecovery::periodNs() const
+{
+    if (periodCount_ < 3)
+        return nominalPeriodNs_ > 0.0 ? nominalPeriodNs_ : (periodCount_ > 0 ? periods_[(size_t)((periodHead_ + kPeriodWindow - 1) % kPeriodWindow)] : 0.0);
+    double tmp[kPeriodWindow];
+    std::copy(periods_.begin(), periods_.begin() + periodCount_, tmp);
+    std::nth_element(tmp, tmp + periodCount_ / 2, tmp + periodCount_);
+    return tmp[periodCount_ / 2];
+}
+
+void gcap::ClockRecovery::pushPeriod(double ns)
+{
+    periods_[(size_t)periodHead_] = ns;
+    periodHead_ = (periodHead_ + 1) % kPeriodWindow;
+    periodCount_ = std::min(periodCount_ + 1, kPeriodWindow);
+}
+
+bool gcap::ClockRecovery::unexplainedGap(double ns)
+{
+    run_[(size_t)runLen_++] = ns;
+    bool agree = runLen_ >= kRateChangeRun;
+    for (int i = runLen_ - kRateChangeRun; agree && i < runLen_ - 1; ++i)
+        agree = std::fabs(run_[(size_t)i] - ns) <= kRunTolerance * ns;
+    if (!agree && runLen_ < kMaxUnexplained)
+        return false;
+
+    // The rate changed, or the nominal one was wrong: measure from the run's gaps.
+    const int n = agree ? kRateChangeRun : runLen_;
+    periodHead_ = periodCount_ = 0;
+    nominalPeriodNs_ = 0.0;
+    for (int i = runLen_ - n; i < runLen_; ++i)
+        pushPeriod(run_[(size_t)i]);
+    runLen_ = 0;
+    pendingDropped_ = pendingDuplicated_ = 0;
+    return true;
+}
+
+void gcap::ClockRecovery::confirmPeriod()
+{
+    stats_.dropped += pendingDropped_;
+    stats_.duplicated += pendingDuplicated_;
+    runLen_ = 0;
+    pendingDropped_ = pendingDuplicated_ = 0;
+}
+
+uint64_t gcap::ClockRecovery::update(int64_t deviceNs, uint64_t hostNs, Gap *gap)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    const uint64_t dropped = stats_.dropped;
+    const uint64_t duplicated = stats_.duplicated;
+    const uint64_t pts = updateLocked(deviceNs, hostNs);
+    if (gap)
+    {
+        gap->dropped = stats_.dropped - dropped;
+        gap->duplicated = stats_.duplicated - duplicated;
+    }
+    return pts;
+}
+
+uint64_t gcap::ClockRecovery::updateLocked(int64_t deviceNs, uint64_t hostNs)
+{
+    ++stats_.frames;
+    const bool device = deviceNs >= 0;
+    stats_.deviceClock = device;
+
+    if (started_ && device != deviceMode_)
+        periodHead_ = periodCount_ = 0; // the period was measured on the other clock
+    if (!started_ || device != deviceMode_)
+    {
+        deviceMode_ = device;
+        restartFit(deviceNs, hostNs);
+    }
+    else if (device)
+    {
+        const int64_t d = deviceNs - lastDevice_;
+        const double p = periodNs();
+        if (d == 0)
+        {
+            // Same device timestamp: the frame was delivered twice.
+            ++stats_.duplicated;
+            lastHost_ = hostNs;
+            return ++lastPts_;
+        }
+        if (d < 0 || (double)d > kResyncGapNs + 10.0 * p)
+        {
+            restartFit(deviceNs, hostNs);
+        }
+        else if (p > 0.0 && ((double)d > 1.5 * p || (double)d < 0.5 * p))
+        {
+            const uint64_t dropped = (double)d > 1.5 * p ? (uint64_t)std::llround((double)d / p) - 1 : 0;
+            if (!unexplainedGap((double)d))
+            {
+                pendingDropped_ += dropped;
+                pendingDuplicated_ += dropped ? 0 : 1;
+            }
+        }
+        else
+        {
+            confirmPeriod();
+            pushPeriod((double)d);
+        }
+    }
+    else
+    {
+        const double d = hostNs >= lastHost_ ? (double)(hostNs - lastHost_) : -1.0;
+        const double p = periodNs();
+        if (d < 0.0 || d > kResyncGapNs + 10.0 * p)
+        {
+            restartFit(deviceNs, hostNs);
+        }
+        else
+        {
+            // Frame index on the fitted cadence; arrival jitter alone does not skip an index.
+            double steps = 1.0;
+            if (count_ >= kMinFitPoints && rate_ > 0.0)
+                steps = std::max(1.0, std::round(((double)(hostNs - hostBase_) - offset_) / rate_ - frameIndex_));
+            else if (p > 0.0 && d > 1.5 * p)
+                steps = std::round(d / p);
+            if (steps <= 1.0)
+            {
+                confirmPeriod();
+                pushPeriod(d);
+                frameIndex_ += 1.0;
+            }
+            else if (unexplainedGap(d))
+            {
+                restartFit(deviceNs, hostNs); // back on the cadence with the new period
+            }
+            else
+            {
+                pendingDropped_ += (uint64_t)(steps - 1.0);
+                frameIndex_ += steps;
+            }
+        }
+    }
+
+    const double x = device ? (double)(deviceNs - deviceBase_) : frameIndex_;
+    const double y = (double)(hostNs - hostBase_);
+    points_[(size_t)head_] = Point{x, y, 0.0};
+    const int cur = head_;
+    head_ = (head_ + 1) % window_;
+    count_ = std::min(count_ + 1, window_);
+
+    if (count_ >= kMinFitPoints)
+    {
+        double mx = 0.0, my = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            mx += points_[(size_t)i].x;
+            my += points_[(size_t)i].y;
+        }
+        mx /= count_;
+        my /= count_;
+        double sxx = 0.0, sxy = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const double dx = points_[(size_t)i].x - mx;
+            sxx += dx * dx;
+            sxy += dx * (points_[(size_t)i].y - my);
+        }
+        if (sxx > 0.0)
+        {
+            rate_ = sxy / sxx;
+            if (device)
+                rate_ = std::clamp(rate_, 1.0 - kMaxDriftRate, 1.0 + kMaxDriftRate);
+        }
+        offset_ = my - rate_ * mx;
+    }
+    else
+    {
+        // Too few frames to fit a rate: keep the nominal one, average the offset.
+        if (!device && rate_ <= 0.0)
+            rate_ = periodNs();
+        double sum = 0.0;
+        for (int i = 0; i < count_; ++i)
+            sum += points_[(size_t)i].y - rate_ * points_[(size_t)i].x;
+        offset_ = sum / count_;
+    }
+
+    const double fit = offset_ + rate_ * x;
+    points_[(size_t)cur].jitter = std::fabs(y - fit);
+
+    uint64_t pts = hostBase_ + (uint64_t)std::max<int64_t>(0, std::llround(fit));
+    if (pts <= lastPts_)
+        pts = lastPts_ + 1;
+    lastPts_ = pts;
+
+    const double p = periodNs();
+    if (device)
+    {
+        stats_.fps = p > 0.0 ? 1e9 / (p * rate_) : 0.0;
+        stats_.driftPpm = (rate_ - 1.0) * 1e6;
+        stats_.offsetMs = ((double)((int64_t)hostBase_ - deviceBase_) + (fit - x)) / 1e6;
+    }
+    else
+    {
+        stats_.fps = rate_ > 0.0 ? 1e9 / rate_ : 0.0;
+        stats_.driftPpm = 0.0;
+        stats_.offsetMs = 0.0;
+    }
+
+    lastDevice_ = deviceNs;
+    lastHost_ = hostNs;
+    return pts;
+}
+
+gcap::ClockRecovery::Stats gcap::ClockRecovery::stats() const
+{
+    std::vector<double> jitter;
+    Stats st;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        st = stats_;
+        jitter.reserve((size_t)count_);
+        for (int i = 0; i < count_; ++i)
+            jitter.push_back(points_[(size_t)i].jitter);
+    }
+    st.jitterP50Us = percentile(jitter, 0.50) / 1e3;
+    st.jitterP95Us = percentile(jitter, 0.95) / 1e3;
+    st.jitterP99Us = percentile(jitter, 0.99) / 1e3;
+    return st;
+}
+
+void gcap::fill_clock_runtime_info(gcap_runtime_info_t &out, const ClockRecovery::Stats &st)
+{
+    if (st.fps > 0.0)
+        out.runtime_fps = st.fps;
+    out.frames_dropped = st.dropped;
+    out.frames_duplicated = st.duplicated;
+    out.clock_drift_ppm = st.driftPpm;
+    out.clock_offset_ms = st.offsetMs;
+    out.jitter_p50_us = st.jitterP50Us;
+    out.jitter_p95_us = st.jitterP95Us;
+    out.jitter_p99_us = st.jitterP99Us;
+}
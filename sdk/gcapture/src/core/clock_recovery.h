@@ -0,0 +1,111 @@
+// clock_recovery.h
+// Recovers a steady frame clock from (device timestamp, host arrival) pairs.
+// Portable; one instance per provider, fed from its capture thread.
+#pragma once
+#include "gcapture.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace gcap
+{
+    /**
+     * Maps device timestamps onto the host steady clock with a linear regression
+     * over the last `window` frames (host = offset + rate * device), so frame
+     * times keep the device's cadence instead of the capture thread's scheduling
+     * jitter, and follow the device clock's drift against the host.
+     *
+     * Without device timestamps (deviceNs < 0) frames are placed on a regular
+     * cadence fitted to the arrival times instead.
+     *
+     * Gaps of more than 1.5 frame periods count as dropped frames; repeated or
+     * early device timestamps count as duplicates. Either is only counted once a
+     * later frame arrives on the old period again: a run of gaps that agree on
+     * another period (or a longer run of any) re-seeds the period instead, so a
+     * rate change or a wrong nominal rate is learned rather than counted. A
+     * timestamp that goes backwards or jumps by more than a second restarts the fit.
+     *
+     * update() and stats() may be called from different threads.
+     */
+    class ClockRecovery
+    {
+    public:
+        struct Stats
+        {
+            uint64_t frames = 0;
+            uint64_t dropped = 0;
+            uint64_t duplicated = 0;
+            double fps = 0.0;         // recovered frame rate on the host clock
+            double driftPpm = 0.0;    // device clock rate vs host; 0 without device timestamps
+            double offsetMs = 0.0;    // host - device time at the latest frame
+            double jitterP50Us = 0.0; // |arrival - recovered frame time| over the window
+            double jitterP95Us = 0.0;
+            double jitterP99Us = 0.0;
+            bool deviceClock = false; // the last frame carried a device timestamp
+        };
+
+        explicit ClockRecovery(int window = 120);
+
+        // Forgets the fit and the counters. fpsNum/fpsDen (optional) seed the frame
+        // period until enough frames have arrived to measure it.
+        void reset(int fpsNum = 0, int fpsDen = 0);
+
+        // What update() counted with one frame, including earlier gaps it confirmed.
+        struct Gap
+        {
+            uint64_t dropped = 0;    // frames missing
+            uint64_t duplicated = 0; // frames delivered twice or early
+        };
+
+        // Adds one frame; returns its recovered time on the host clock (ns). Always
+        // increases, including for duplicates.
+        uint64_t update(int64_t deviceNs, uint64_t hostNs, Gap *gap = nullptr);
+
+        Stats stats() const;
+
+    private:
+        struct Point
+        {
+            double x;      // device ns (or frame index) since the fit began
+            double y;      // host ns since the fit began
+            double jitter; // |y - fit|, ns
+        };
+
+        uint64_t updateLocked(int64_t deviceNs, uint64_t hostNs);
+        void restartFit(int64_t deviceNs, uint64_t hostNs);
+        double periodNs() const; // median recent frame period (device or host clock)
+        void pushPeriod(double ns);
+        bool unexplainedGap(double ns); // true when the run re-seeded the period
+        void confirmPeriod();           // a frame on the period: counts the run as drops/duplicates
+
+        mutable std::mutex mtx_;
+        const int window_;
+        std::vector<Point> points_; // ring, window_ entries
+        int head_ = 0;
+        int count_ = 0;
+        std::vector<double> periods_; // ring of recent per-frame deltas
+        int periodHead_ = 0;
+        int periodCount_ = 0;
+        double nominalPeriodNs_ = 0.0;
+        std::vector<double> run_; // consecutive gaps the period does not explain
+        int runLen_ = 0;
+        uint64_t pendingDropped_ = 0;    // counted by run_, until a frame confirms the period
+        uint64_t pendingDuplicated_ = 0;
+
+        bool started_ = false;
+        bool deviceMode_ = false;
+        int64_t deviceBase_ = 0;
+        uint64_t hostBase_ = 0;
+        int64_t lastDevice_ = 0;
+        uint64_t lastHost_ = 0;
+        double frameIndex_ = 0.0; // host-cadence mode x
+        double rate_ = 1.0;       // fitted slope: host ns per device ns, or per frame
+        double offset_ = 0.0;     // fitted intercept, ns
+        uint64_t lastPts_ = 0;
+
+        Stats stats_;
+    };
+
+    // Copies fps, drop/duplicate counters, drift and jitter into a runtime info.
+    void fill_clock_runtime_info(gcap_runtime_info_t &out, const ClockRecovery::Stats &st);
+}
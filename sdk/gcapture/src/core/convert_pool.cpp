@@ -0,0 +1,240 @@
+// convert_pool.cpp
+#include "convert_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Below this a frame is converted inline; 1080p sits comfortably under it.
+    constexpr int64_t kMinParallelPixels = 2560LL * 1440LL;
+    // Smallest band worth handing to a worker.
+    constexpr int64_t kMinBandPixels = 1LL << 20;
+    constexpr int kMaxThreads = 16;
+
+    int auto_threads()
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        return std::clamp((int)(hw / 2), 1, 8);
+    }
+
+    class ConvertPool
+    {
+    public:
+        void setThreads(int threads)
+        {
+            std::lock_guard<std::mutex> submit(submitMtx_);
+            stopWorkers();
+            requested_ = std::clamp(threads, 0, kMaxThreads);
+        }
+
+        int threads() const
+        {
+            const int r = requested_.load();
+            return r > 0 ? r : auto_threads();
+        }
+
+        void acquire()
+        {
+            std::lock_guard<std::mutex> submit(submitMtx_);
+            ++users_;
+        }
+
+        void release()
+        {
+            std::lock_guard<std::mutex> submit(submitMtx_);
+            if (users_ > 0 && --users_ == 0)
+                stopWorkers();
+        }
+
+        void run(int width, int height, int rowAlign, gcap::RowBandFn fn, void *ctx)
+        {
+            const int64_t pixels = (int64_t)width * (int64_t)height;
+            const int total = threads();
+            int bands = (int)std::min<int64_t>(total, pixels / kMinBandPixels);
+            if (pixels < kMinParallelPixels || bands < 2 || height < 2 * rowAlign)
+            {
+                fn(ctx, 0, height);
+                return;
+            }
+
+            // A second stream converting at the same time just runs inline instead of queueing.
+            std::unique_lock<std::mutex> submit(submitMtx_, std::try_to_lock);
+            if (!submit.owns_lock())
+            {
+                fn(ctx, 0, height);
+                return;
+            }
+
+            ensureWorkers(total - 1);
+            if (workers_.empty())
+            {
+                fn(ctx, 0, height);
+                return;
+            }
+
+            const int align = std::max(rowAlign, 1);
+            const int groups = (height + align - 1) / align;
+            bands = std::min(bands, groups);
+            const int rowsPerBand = ((groups + bands - 1) / bands) * align;
+            bands = (height + rowsPerBand - 1) / rowsPerBand;
+
+            uint32_t gen;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                job_ = Job{fn, ctx, height, rowsPerBand, bands};
+                gen = ++generation_;
+                remaining_.store(bands);
+                ticket_.store((uint64_t)gen << 32);
+            }
+            // Wake only as many workers as there are bands left for them.
+            const int wake = std::min<int>(bands - 1, (int)workers_.size());
+            for (int i = 0; i < wake; ++i)
+                workCv_.notify_one();
+
+            drain(job_, gen);
+
+            std::unique_lock<std::mutex> lk(mtx_);
+            doneCv_.wait(lk, [&]
+                         { return remaining_.load() == 0; });
+        }
+
+    private:
+        struct Job
+        {
+            gcap::RowBandFn fn = nullptr;
+            void *ctx = nullptr;
+            int height = 0;
+            int rowsPerBand = 0;
+            int bands = 0;
+        };
+
+        // Claims bands of generation `gen` until none are left. The ticket packs
+        // (generation << 32 | next band) so a worker that woke late can never
+        // claim a band of a newer frame with a stale job.
+        void drain(const Job &job, uint32_t gen)
+        {
+            uint64_t cur = ticket_.load();
+            for (;;)
+            {
+                if ((uint32_t)(cur >> 32) != gen || (int)(uint32_t)cur >= job.bands)
+                    return;
+                if (!ticket_.compare_exchange_weak(cur, cur + 1))
+                    continue;
+
+                const int band = (int)(uint32_t)cur;
+                const int y0 = band * job.rowsPerBand;
+                const int y1 = std::min(job.height, y0 + job.rowsPerBand);
+                job.fn(job.ctx, y0, y1);
+
+                if (remaining_.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lk(mtx_);
+                    doneCv_.notify_all();
+                }
+                cur = ticket_.load();
+            }
+        }
+
+        void workerLoop()
+        {
+            uint32_t seen = 0;
+            for (;;)
+            {
+                Job job;
+                uint32_t gen;
+                {
+                    // Parked on the condition variable between frames: no spinning.
+                    std::unique_lock<std::mutex> lk(mtx_);
+                    workCv_.wait(lk, [&]
+                                 { return stop_ || generation_ != seen; });
+                    if (stop_)
+                        return;
+                    seen = gen = generation_;
+                    job = job_;
+                }
+                drain(job, gen);
+            }
+        }
+
+        // Callers hold submitMtx_.
+        void ensureWorkers(int count)
+        {
+            if ((int)workers_.size() == count)
+                return;
+            stopWorkers();
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                stop_ = false;
+            }
+            for (int i = 0; i < count; ++i)
+                workers_.emplace_back([this]
+                                      { workerLoop(); });
+        }
+
+        void stopWorkers()
+        {
+            if (workers_.empty())
+                return;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                stop_ = true;
+            }
+            workCv_.notify_all();
+            for (auto &t : workers_)
+                t.join();
+            workers_.clear();
+        }
+
+        std::mutex submitMtx_; // one frame in flight; guards workers_ / users_
+        std::vector<std::thread> workers_;
+        int users_ = 0;
+        std::atomic<int> requested_{0};
+
+        std::mutex mtx_;
+        std::condition_variable workCv_;
+        std::condition_variable doneCv_;
+        Job job_;
+        uint32_t generation_ = 0;
+        bool stop_ = false;
+        std::atomic<uint64_t> ticket_{0};
+        std::atomic<int> remaining_{0};
+    };
+
+    ConvertPool &pool()
+    {
+        static ConvertPool p;
+        return p;
+    }
+}
+
+void gcap::parallel_rows(int width, int height, int rowAlign, RowBandFn fn, void *ctx)
+{
+    if (!fn || width <= 0 || height <= 0)
+        return;
+    pool().run(width, height, rowAlign, fn, ctx);
+}
+
+void gcap::set_convert_threads(int threads)
+{
+    pool().setThreads(threads);
+}
+
+int gcap::convert_threads()
+{
+    return pool().threads();
+}
+
+void gcap::convert_pool_acquire()
+{
+    pool().acquire();
+}
+
+void gcap::convert_pool_release()
+{
+    pool().release();
+}
@@ -0,0 +1,32 @@
+// convert_pool.h
+// Process-wide worker pool for row-band parallel frame conversion.
+// Internal to the SDK; configured through gcap_processing_opts_t::worker_threads.
+#pragma once
+
+namespace gcap
+{
+    // Converts rows [y0, y1) of one frame. Must be safe to call concurrently
+    // for disjoint row ranges.
+    using RowBandFn = void (*)(void *ctx, int y0, int y1);
+
+    /**
+     * Split rows [0, height) into bands of whole `rowAlign` groups (2 for 4:2:0
+     * chroma, 1 for packed 4:2:2) and run them on the pool plus the calling
+     * thread. Returns after every band has finished.
+     *
+     * Frames up to ~1440p, a pool limited to one thread, or a pool already busy
+     * with another stream run inline on the caller, so a single HD stream never
+     * pays wake-up costs.
+     */
+    void parallel_rows(int width, int height, int rowAlign, RowBandFn fn, void *ctx);
+
+    // Total conversion threads (caller included): 0 = auto, 1 = single-threaded.
+    // Takes effect on the next frame; workers are (re)spawned lazily.
+    void set_convert_threads(int threads);
+    int convert_threads();
+
+    // Pool lifetime follows the CaptureManager instances, so workers are joined
+    // from gcap_close() rather than from DLL unload.
+    void convert_pool_acquire();
+    void convert_pool_release();
+}
@@ -0,0 +1,441 @@
+// delivery_queue.cpp
+#include "delivery_queue.h"
+#include "capture_stats.h"
+#include "frame_pool.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    constexpr int kDefaultDepth = 4;
+    constexpr int kMaxDepth = 64;
+    constexpr size_t kPlaneAlign = 64;
+    // Safety net for the sleep/wake handshake; a wake-up normally comes with the frame.
+    constexpr auto kIdleWait = std::chrono::milliseconds(50);
+
+    uint64_t now_ns()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    int plane_rows(gcap_pixfmt_t fmt, int plane, int height)
+    {
+        if (plane > 0 && (fmt == GCAP_FMT_NV12 || fmt == GCAP_FMT_P010 || fmt == GCAP_FMT_I420 || fmt == GCAP_FMT_I010))
+            return (height + 1) / 2;
+        return height;
+    }
+
+    // Pool-backed frames are retained by reference; anything else (GPU readback,
+    // pass-through ARGB, UNLEASED scratch) is copied into a slot first.
+    template <typename T>
+    const T *retain_or_copy(gcap::FramePool *pool, const T *src, gcap::StatsShard *stats)
+    {
+        if (const T *r = gcap::FramePool::retain(src))
+            return r;
+        if (!pool || src->plane_count <= 0 || src->plane_count > 3 || src->height <= 0)
+            return nullptr;
+
+        size_t planeBytes[3] = {};
+        size_t total = 0;
+        for (int i = 0; i < src->plane_count; ++i)
+        {
+            if (!src->data[i] || src->stride[i] <= 0)
+                return nullptr;
+            planeBytes[i] = (size_t)src->stride[i] * (size_t)plane_rows(src->format, i, src->height);
+            total += (planeBytes[i] + kPlaneAlign - 1) / kPlaneAlign * kPlaneAlign;
+        }
+        gcap::FrameLease lease = pool->acquire(total);
+        if (!lease)
+            return nullptr;
+
+        T copy = *src;
+        uint8_t *dst = lease.data();
+        for (int i = 0; i < src->plane_count; ++i)
+        {
+            std::memcpy(dst, src->data[i], planeBytes[i]);
+            copy.data[i] = dst;
+            dst += (planeBytes[i] + kPlaneAlign - 1) / kPlaneAlign * kPlaneAlign;
+            if (stats)
+                stats->copied(planeBytes[i]);
+        }
+        lease.attach(copy);
+        // The retained descriptor lives in the slot; the lease's own reference drops here.
+        return gcap::FramePool::retain(&copy);
+    }
+}
+
+gcap::DeliveryQueue::DeliveryQueue(FramePool *pool)
+    : pool_(pool)
+{
+    configure(gcap_delivery_opts_t{});
+}
+
+gcap::DeliveryQueue::~DeliveryQueue()
+{
+    stop();
+}
+
+void gcap::DeliveryQueue::configure(const gcap_delivery_opts_t &opts)
+{
+    opts_ = opts;
+    capacity_ = opts.policy == GCAP_DELIVERY_LATEST_ONLY ? 1 : std::clamp(opts.depth > 0 ? opts.depth : kDefaultDepth, 1, kMaxDepth);
+    ringSize_ = std::max(capacity_, 2);
+    cells_.reset(new Cell[(size_t)ringSize_]);
+    for (int i = 0; i < ringSize_; ++i)
+        cells_[(size_t)i].seq.store((uint64_t)i, std::memory_order_relaxed);
+    enqueuePos_.store(0, std::memory_order_relaxed);
+    dequeuePos_.store(0, std::memory_order_relaxed);
+}
+
+void gcap::DeliveryQueue::setTargets(gcap_on_video_cb vcb, void *vuser, gcap_on_frame_packet_cb pcb, void *puser)
+{
+    vuser_.store(vuser, std::memory_order_relaxed);
+    puser_.store(puser, std::memory_order_relaxed);
+    vcb_.store(vcb, std::memory_order_release);
+    pcb_.store(pcb, std::memory_order_release);
+}
+
+void gcap::DeliveryQueue::setStats(StatsShard *producer, StatsShard *consumer)
+{
+    producerStats_ = producer;
+    consumerStats_ = consumer;
+}
+
+void gcap::DeliveryQueue::start()
+{
+    if (!enabled() || running_.load())
+        return;
+    highWater_.store(0, std::memory_order_relaxed);
+    running_.store(true);
+    worker_ = std::thread([this]
+                          { run(); });
+}
+
+void gcap::DeliveryQueue::stop()
+{
+    if (!running_.exchange(false))
+        return;
+    {
+        std::lock_guard<std::mutex> lk(waitMtx_);
+        itemCv_.notify_all();
+        spaceCv_.notify_all();
+    }
+    if (worker_.joinable())
+        worker_.join();
+    Item item;
+    while (tryPop(item))
+        release(item);
+}
+
+void gcap::DeliveryQueue::push(const gcap_frame_t *f)
+{
+    if (!f)
+        return;
+    if (!running_.load(std::memory_order_acquire))
+    {
+        if (gcap_on_video_cb cb = vcb_.load(std::memory_order_acquire))
+            cb(f, vuser_.load(std::memory_order_relaxed));
+        return;
+    }
+    Item item;
+    item.frame = retain_or_copy(pool_, f, producerStats_);
+    if (!item.frame)
+    {
+        copyFailed_.fetch_add(1, std::memory_order_relaxed);
+        noteDropped();
+        return;
+    }
+    item.queuedNs = now_ns();
+    enqueue(item);
+}
+
+void gcap::DeliveryQueue::push(const gcap_frame_packet_t *p)
+{
+    if (!p)
+        return;
+    if (!running_.load(std::memory_order_acquire))
+    {
+        if (gcap_on_frame_packet_cb cb = pcb_.load(std::memory_order_acquire))
+            cb(p, puser_.load(std::memory_order_relaxed));
+        return;
+    }
+    Item item;
+    item.packet = retain_or_copy(pool_, p, producerStats_);
+    if (!item.packet)
+    {
+        copyFailed_.fetch_add(1, std::memory_order_relaxed);
+        noteDropped();
+        return;
+    }
+    item.queuedNs = now_ns();
+    enqueue(item);
+}
+
+void gcap::DeliveryQueue::enqueue(const Item &item)
+{
+    switch (opts_.policy)
+    {
+    case GCAP_DELIVERY_BLOCK:
+        if (!tryPush(item))
+        {
+            const uint64_t t0 = now_ns();
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opts_.block_timeout_ms);
+            bool pushed = false;
+            producersWaiting_.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lk(waitMtx_);
+                while (running_.load() && !(pushed = tryPush(item)))
+                {
+                    if (opts_.block_timeout_ms > 0)
+                    {
+                        if (std::chrono::steady_clock::now() >= deadline)
+                            break;
+                        spaceCv_.wait_until(lk, std::min(deadline, std::chrono::steady_clock::now() + kIdleWait));
+                    }
+                    else
+                    {
+                        spaceCv_.wait_for(lk, kIdleWait);
+                    }
+                }
+            }
+            producersWaiting_.fetch_sub(1);
+            blockedNs_.fetch_add(now_ns() - t0, std::memory_order_relaxed);
+            if (!pushed)
+            {
+                if (running_.load())
+                    blockTimeouts_.fetch_add(1, std::memory_order_relaxed);
+                noteDropped();
+                release(item);
+                return;
+            }
+        }
+        break;
+    case GCAP_DELIVERY_DROP_NEWEST:
+        if (!tryPush(item))
+        {
+            droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+            noteDropped();
+            release(item);
+            return;
+        }
+        break;
+    case GCAP_DELIVERY_DROP_OLDEST:
+    case GCAP_DELIVERY_LATEST_ONLY:
+    default:
+        while (!tryPush(item))
+        {
+            Item old;
+            if (tryPop(old))
+            {
+                release(old);
+                (opts_.policy == GCAP_DELIVERY_LATEST_ONLY ? replaced_ : droppedOldest_).fetch_add(1, std::memory_order_relaxed);
+                noteDropped();
+            }
+        }
+        break;
+    }
+
+    noteDepth();
+    // Pairs with the delivery thread publishing consumerWaiting_ before its last look at the queue.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting_.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lk(waitMtx_);
+        itemCv_.notify_one();
+    }
+}
+
+bool gcap::DeliveryQueue::tryPush(const Item &item)
+{
+    uint64_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    // With several producers `pos` can be stale by the time it is checked; "full" is only
+    // reported for a position that is still the current one.
+    auto stillCurrent = [&]
+    {
+        const uint64_t now = enqueuePos_.load(std::memory_order_relaxed);
+        if (now == pos)
+            return true;
+        pos = now;
+        return false;
+    };
+    for (;;)
+    {
+        // The one-frame mailbox runs on a two-cell ring and stops at one queued frame.
+        if (capacity_ < ringSize_)
+        {
+            const uint64_t deq = dequeuePos_.load(std::memory_order_acquire);
+            if (pos < deq)
+            {
+                // Other producers and the consumer moved on since pos was read.
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (pos - deq >= (uint64_t)capacity_)
+            {
+                if (stillCurrent())
+                    return false;
+                continue;
+            }
+        }
+        Cell &c = cells_[(size_t)(pos % (uint64_t)ringSize_)];
+        const uint64_t seq = c.seq.load(std::memory_order_acquire);
+        const int64_t dif = (int64_t)(seq - pos);
+        if (dif == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                c.item = item;
+                c.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (dif < 0)
+        {
+            // The cell still holds the previous lap's item.
+            if (stillCurrent())
+                return false; // full
+        }
+        else
+        {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool gcap::DeliveryQueue::tryPop(Item &item)
+{
+    uint64_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &c = cells_[(size_t)(pos % (uint64_t)ringSize_)];
+        const uint64_t seq = c.seq.load(std::memory_order_acquire);
+        const int64_t dif = (int64_t)(seq - (pos + 1));
+        if (dif == 0)
+        {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                item = c.item;
+                c.seq.store(pos + (uint64_t)ringSize_, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (dif < 0)
+        {
+            return false; // empty
+        }
+        else
+        {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void gcap::DeliveryQueue::noteDepth()
+{
+    // Dequeue first: the enqueue position read afterwards can only be larger.
+    const uint64_t deq = dequeuePos_.load(std::memory_order_relaxed);
+    const uint64_t enq = enqueuePos_.load(std::memory_order_relaxed);
+    const int depth = (int)std::min<uint64_t>(enq - std::min(enq, deq), (uint64_t)capacity_);
+    int hwm = highWater_.load(std::memory_order_relaxed);
+    while (depth > hwm && !highWater_.compare_exchange_weak(hwm, depth, std::memory_order_relaxed))
+    {
+    }
+}
+
+void gcap::DeliveryQueue::noteDropped()
+{
+    if (producerStats_)
+        producerStats_->add(StatCounter::FramesDroppedDelivery);
+}
+
+void gcap::DeliveryQueue::release(const Item &item)
+{
+    if (item.frame)
+        FramePool::release(item.frame->lease);
+    if (item.packet)
+        FramePool::release(item.packet->lease);
+}
+
+void gcap::DeliveryQueue::run()
+{
+    GCAP_TRACE_THREAD_NAME("gcap delivery");
+    for (;;)
+    {
+        Item item;
+        if (!tryPop(item))
+        {
+            if (!running_.load())
+                break;
+            consumerWaiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool got = false;
+            {
+                std::unique_lock<std::mutex> lk(waitMtx_);
+                got = tryPop(item);
+                if (!got && running_.load())
+                    itemCv_.wait_for(lk, kIdleWait);
+            }
+            consumerWaiting_.store(false, std::memory_order_relaxed);
+            if (!got)
+            {
+                // Idle: make what the last frames recorded visible.
+                if (consumerStats_)
+                    consumerStats_->tick(now_ns());
+                continue;
+            }
+        }
+
+        if (producersWaiting_.load() > 0)
+        {
+            std::lock_guard<std::mutex> lk(waitMtx_);
+            spaceCv_.notify_all();
+        }
+
+        const uint64_t t0 = now_ns();
+        const uint64_t frameId = item.frame ? item.frame->frame_id : item.packet->frame_id;
+        if (item.frame)
+        {
+            if (gcap_on_video_cb cb = vcb_.load(std::memory_order_acquire))
+            {
+                GCAP_TRACE_SCOPE(Callback, frameId);
+                cb(item.frame, vuser_.load(std::memory_order_relaxed));
+            }
+        }
+        else if (gcap_on_frame_packet_cb cb = pcb_.load(std::memory_order_acquire))
+        {
+            GCAP_TRACE_SCOPE(Callback, frameId);
+            cb(item.packet, puser_.load(std::memory_order_relaxed));
+        }
+        release(item);
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        if (StatsShard *st = consumerStats_)
+        {
+            const uint64_t t1 = now_ns(); // includes the release, a few atomics
+            st->record(StatHist::QueueWait, t0 > item.queuedNs ? t0 - item.queuedNs : 0);
+            st->record(StatHist::Callback, t1 - t0);
+            st->delivered(frameId);
+            st->tick(t1);
+        }
+    }
+}
+
+gcap::DeliveryQueue::Stats gcap::DeliveryQueue::stats() const
+{
+    Stats st;
+    const uint64_t deq = dequeuePos_.load(std::memory_order_relaxed);
+    const uint64_t enq = enqueuePos_.load(std::memory_order_relaxed);
+    st.depth = (int)std::min<uint64_t>(enq - std::min(enq, deq), (uint64_t)capacity_);
+    st.highWater = highWater_.load(std::memory_order_relaxed);
+    st.delivered = delivered_.load(std::memory_order_relaxed);
+    st.droppedOldest = droppedOldest_.load(std::memory_order_relaxed);
+    st.droppedNewest = droppedNewest_.load(std::memory_order_relaxed);
+    st.replaced = replaced_.load(std::memory_order_relaxed);
+    st.blockTimeouts = blockTimeouts_.load(std::memory_order_relaxed);
+    st.blockedNs = blockedNs_.load(std::memory_order_relaxed);
+    st.copyFailed = copyFailed_.load(std::memory_order_relaxed);
+    return st;
+}
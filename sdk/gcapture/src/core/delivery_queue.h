@@ -0,0 +1,129 @@
+// delivery_queue.h
+// Optional hand-off of frame callbacks from the capture thread to a delivery
+// thread (gcap_set_delivery). Portable; one instance per CaptureManager.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "gcapture.h"
+
+namespace gcap
+{
+    class FramePool;
+    class StatsShard;
+
+    /**
+     * Bounded lock-free queue of retained frames between the provider's capture
+     * thread and the application's callbacks, so a slow consumer no longer
+     * stalls ReadSample / the frame pump.
+     *
+     * push() retains the frame (pool-backed frames by reference, anything else
+     * by a copy into a pool slot) and queues it; the delivery thread calls the
+     * callback with the retained descriptor and releases it afterwards. The
+     * callback may retain it again like a synchronous one.
+     *
+     * When the queue is full the policy decides: BLOCK waits for space (up to
+     * block_timeout_ms), DROP_OLDEST evicts the oldest queued frame, DROP_NEWEST
+     * discards the new one and LATEST_ONLY is a one-frame mailbox whose
+     * undelivered frame is replaced.
+     *
+     * configure() / start() / stop() are called while the provider is stopped;
+     * push() from the capture thread (any number of them).
+     */
+    class DeliveryQueue
+    {
+    public:
+        explicit DeliveryQueue(FramePool *pool);
+        ~DeliveryQueue();
+        DeliveryQueue(const DeliveryQueue &) = delete;
+        DeliveryQueue &operator=(const DeliveryQueue &) = delete;
+
+        void configure(const gcap_delivery_opts_t &opts);
+        bool enabled() const { return opts_.policy != GCAP_DELIVERY_SYNC; }
+        gcap_delivery_policy_t policy() const { return opts_.policy; }
+        int depth() const { return capacity_; }
+        void setTargets(gcap_on_video_cb vcb, void *vuser, gcap_on_frame_packet_cb pcb, void *puser);
+        // Copies and drops are counted on the pushing thread's shard, waits and callbacks on
+        // the delivery thread's. Set while stopped; both outlive the queue.
+        void setStats(StatsShard *producer, StatsShard *consumer);
+
+        // Starts / joins the delivery thread. Frames still queued at stop() are discarded.
+        void start();
+        void stop();
+
+        void push(const gcap_frame_t *f);
+        void push(const gcap_frame_packet_t *p);
+
+        struct Stats
+        {
+            int depth = 0;             // frames queued now
+            int highWater = 0;         // most frames queued at once since start()
+            uint64_t delivered = 0;
+            uint64_t droppedOldest = 0;
+            uint64_t droppedNewest = 0;
+            uint64_t replaced = 0;     // LATEST_ONLY
+            uint64_t blockTimeouts = 0;
+            uint64_t blockedNs = 0;    // time the capture thread spent waiting (BLOCK)
+            uint64_t copyFailed = 0;   // frames that needed a copy and found no free slot
+        };
+        Stats stats() const;
+
+    private:
+        struct Item
+        {
+            const gcap_frame_t *frame = nullptr; // retained; exactly one of the two is set
+            const gcap_frame_packet_t *packet = nullptr;
+            uint64_t queuedNs = 0;
+        };
+        // Bounded MPMC ring (sequence number per cell); the producer also pops to evict.
+        struct Cell
+        {
+            std::atomic<uint64_t> seq{0};
+            Item item;
+        };
+
+        void enqueue(const Item &item);
+        bool tryPush(const Item &item);
+        bool tryPop(Item &item);
+        void noteDepth();
+        void noteDropped();
+        static void release(const Item &item);
+        void run();
+
+        FramePool *pool_;
+        StatsShard *producerStats_ = nullptr;
+        StatsShard *consumerStats_ = nullptr;
+        gcap_delivery_opts_t opts_{};
+        int capacity_ = 0;
+        int ringSize_ = 0; // cells; at least 2, which the sequence scheme needs
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<uint64_t> enqueuePos_{0};
+        alignas(64) std::atomic<uint64_t> dequeuePos_{0};
+
+        std::atomic<gcap_on_video_cb> vcb_{nullptr};
+        std::atomic<gcap_on_frame_packet_cb> pcb_{nullptr};
+        std::atomic<void *> vuser_{nullptr};
+        std::atomic<void *> puser_{nullptr};
+
+        std::thread worker_;
+        std::atomic<bool> running_{false};
+        // Slow path only: the delivery thread sleeping on an empty queue, producers on a full one.
+        std::mutex waitMtx_;
+        std::condition_variable itemCv_;
+        std::condition_variable spaceCv_;
+        std::atomic<bool> consumerWaiting_{false};
+        std::atomic<int> producersWaiting_{0};
+
+        std::atomic<int> highWater_{0};
+        std::atomic<uint64_t> delivered_{0};
+        std::atomic<uint64_t> droppedOldest_{0};
+        std::atomic<uint64_t> droppedNewest_{0};
+        std::atomic<uint64_t> replaced_{0};
+        std::atomic<uint64_t> blockTimeouts_{0};
+        std::atomic<uint64_t> blockedNs_{0};
+        std::atomic<uint64_t> copyFailed_{0};
+    };
+}
@@ -0,0 +1,496 @@
+// device_cache.cpp
+#include "device_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#if _WIN32_WINNT >= 0x0602
+#include <cfgmgr32.h>
+#endif
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr const char *kFileHeader = "# gcapture device cache v1";
+
+    struct ListEntry
+    {
+        uint64_t generation = 0;
+        std::vector<gcap_device_info_t> devices;
+    };
+
+    struct CapsEntry
+    {
+        uint64_t generation = 0;
+        bool persisted = false; // from or written to the file: lives until device_cache_refresh
+        bool hasCaps = false;
+        std::vector<gcap_video_cap_t> caps;
+        std::map<int, std::vector<gcap_pixfmt_t>> formats; // per backend
+    };
+
+    std::mutex g_mtx;
+    bool g_enabled = true;
+    std::string g_path;
+    uint64_t g_generation = 1;
+    std::map<int, ListEntry> g_lists;
+    std::map<std::string, CapsEntry> g_caps;
+    std::atomic<bool> g_watching{false};
+
+    std::FILE *open_utf8(const char *path, const char *mode)
+    {
+#ifdef _WIN32
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        if (n <= 0)
+            return nullptr;
+        std::wstring w((size_t)n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, &w[0], n);
+        std::wstring m(mode, mode + std::strlen(mode));
+        return _wfopen(w.c_str(), m.c_str());
+#else
+        return std::fopen(path, mode);
+#endif
+    }
+
+    bool entry_valid(const CapsEntry &e)
+    {
+        return e.persisted || e.generation == g_generation;
+    }
+
+    // "caps\t<identity>\t<w> <h> <num> <den> <fmt> <bits>;..." and "fmts\t<identity>\t<backend>\t<fmt> ...".
+    void load_locked()
+    {
+        std::FILE *fp = open_utf8(g_path.c_str(), "rb");
+        if (!fp)
+            return;
+        std::string line;
+        char buf[4096];
+        while (std::fgets(buf, sizeof(buf), fp))
+        {
+            line += buf;
+            if (line.empty() || (line.back() != '\n' && !std::feof(fp)))
+                continue;
+            line.erase(line.find_last_not_of("\r\n") + 1);
+            const size_t t1 = line.find('\t');
+            const size_t t2 = t1 == std::string::npos ? t1 : line.find('\t', t1 + 1);
+            if (line[0] == '#' || t2 == std::string::npos)
+            {
+                line.clear();
+                continue;
+            }
+            const std::string kind = line.substr(0, t1);
+            const std::string id = line.substr(t1 + 1, t2 - t1 - 1);
+            const char *p = line.c_str() + t2 + 1;
+            CapsEntry &e = g_caps[id];
+            e.persisted = true;
+            if (kind == "caps")
+            {
+                e.hasCaps = true;
+                e.caps.clear();
+                gcap_video_cap_t c{};
+                int fmt = 0, n = 0;
+                while (std::sscanf(p, "%d %d %d %d %d %d%n", &c.width, &c.height, &c.fps_num, &c.fps_den, &fmt,
+                                   &c.bit_depth, &n) == 6)
+                {
+                    c.pixfmt = (gcap_pixfmt_t)fmt;
+                    e.caps.push_back(c);
+                    p += n;
+                    if (*p == ';')
+                        ++p;
+                }
+            }
+            else if (kind == "fmts")
+            {
+                char *end = nullptr;
+                const int backend = (int)std::strtol(p, &end, 10);
+                std::vector<gcap_pixfmt_t> &v = e.formats[backend];
+                v.clear();
+                p = end;
+                while (*p)
+                {
+                    const long f = std::strtol(p, &end, 10);
+                    if (end == p)
+                        break;
+                    v.push_back((gcap_pixfmt_t)f);
+                    p = end;
+                }
+            }
+            line.clear();
+        }
+        std::fclose(fp);
+    }
+
+    void save_locked()
+    {
+        if (g_path.empty())
+            return;
+        std::FILE *fp = open_utf8(g_path.c_str(), "wb");
+        if (!fp)
+            return;
+        std::fprintf(fp, "%s\n", kFileHeader);
+        for (const auto &e : g_caps)
+        {
+            if (!e.second.persisted)
+                continue;
+            if (e.second.hasCaps)
+            {
+                std::fprintf(fp, "caps\t%s\t", e.first.c_str());
+                for (size_t i = 0; i < e.second.caps.size(); ++i)
+                {
+                    const gcap_video_cap_t &c = e.second.caps[i];
+                    std::fprintf(fp, "%s%d %d %d %d %d %d", i ? ";" : "", c.width, c.height, c.fps_num, c.fps_den,
+                                 (int)c.pixfmt, c.bit_depth);
+                }
+                std::fprintf(fp, "\n");
+            }
+            for (const auto &f : e.second.formats)
+            {
+                std::fprintf(fp, "fmts\t%s\t%d", e.first.c_str(), f.first);
+                for (gcap_pixfmt_t fmt : f.second)
+                    std::fprintf(fp, " %d", (int)fmt);
+                std::fprintf(fp, "\n");
+            }
+        }
+        std::fclose(fp);
+    }
+
+    // Entries made now: persisted when there is a file (and the identity fits on its line).
+    CapsEntry &fresh_entry_locked(const std::string &identity)
+    {
+        CapsEntry &e = g_caps[identity];
+        if (!entry_valid(e))
+            e = CapsEntry{};
+        e.generation = g_generation;
+        e.persisted = !g_path.empty() && identity.find_first_of("\t\r\n") == std::string::npos;
+        return e;
+    }
+
+    // Arrival/removal notifications of capture devices. Started with the first cached list;
+    // without it lists are not cached. Stopped only by gcap_shutdown: from a static
+    // destructor, CM_Unregister_Notification would run under the loader lock.
+    class DeviceWatcher
+    {
+    public:
+        void ensureStarted()
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (tried_)
+                return;
+            tried_ = true;
+            g_watching = start();
+        }
+
+        // Returns whether it was watching; the next cached list starts it again.
+        bool shutdown()
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            const bool was = g_watching;
+            g_watching = false;
+            stop();
+            tried_ = false;
+            return was;
+        }
+
+    private:
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+        static DWORD CALLBACK onNotify(HCMNOTIFICATION, PVOID, CM_NOTIFY_ACTION action, PCM_NOTIFY_EVENT_DATA data,
+                                       DWORD)
+        {
+            // KSCATEGORY_CAPTURE, KSCATEGORY_VIDEO, KSCATEGORY_VIDEO_CAMERA
+            static const GUID kCategories[] = {
+                {0x65E8773D, 0x8F56, 0x11D0, {0xA3, 0xB9, 0x00, 0xA0, 0xC9, 0x22, 0x31, 0x96}},
+                {0x6994AD05, 0x93EF, 0x11D0, {0xA3, 0xCC, 0x00, 0xA0, 0xC9, 0x22, 0x31, 0x96}},
+                {0xE5323777, 0xF976, 0x4F5B, {0x9B, 0x55, 0xB9, 0x46, 0x99, 0xC4, 0x6E, 0x44}},
+            };
+            if ((action != CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL && action != CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL) ||
+                !data || data->FilterType != CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE)
+                return ERROR_SUCCESS;
+            for (const GUID &g : kCategories)
+                if (IsEqualGUID(g, data->u.DeviceInterface.ClassGuid))
+                {
+                    gcap::device_cache_devices_changed();
+                    break;
+                }
+            return ERROR_SUCCESS;
+        }
+
+        bool start()
+        {
+            CM_NOTIFY_FILTER f{};
+            f.cbSize = sizeof(f);
+            f.Flags = CM_NOTIFY_FILTER_FLAG_ALL_INTERFACE_CLASSES;
+            f.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+            return CM_Register_Notification(&f, nullptr, onNotify, &notify_) == CR_SUCCESS;
+        }
+
+        void stop()
+        {
+            if (notify_)
+                CM_Unregister_Notification(notify_);
+            notify_ = nullptr;
+        }
+
+        HCMNOTIFICATION notify_ = nullptr;
+#else
+        bool start() { return false; }
+        void stop() {}
+#endif
+#else
+        // inotify on /dev: video nodes appear and go with the device; udev fixing the
+        // permissions (IN_ATTRIB) can make a node usable after it appeared.
+        bool start()
+        {
+            if (pipe(wake_) != 0)
+                return false;
+            fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+            if (fd_ < 0 || inotify_add_watch(fd_, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO) < 0)
+            {
+                closeFds();
+                return false;
+            }
+            thread_ = std::thread([this]
+                                  { loop(); });
+            return true;
+        }
+
+        void loop()
+        {
+            alignas(inotify_event) char buf[4096];
+            for (;;)
+            {
+                pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+                if (poll(fds, 2, -1) < 0)
+                    continue;
+                if (fds[1].revents)
+                    return;
+                const ssize_t n = read(fd_, buf, sizeof(buf));
+                bool video = false;
+                for (ssize_t off = 0; off < n;)
+                {
+                    const inotify_event *ev = (const inotify_event *)(buf + off);
+                    if (ev->len && std::strncmp(ev->name, "video", 5) == 0)
+                        video = true;
+                    off += (ssize_t)(sizeof(inotify_event) + ev->len);
+                }
+                if (video)
+                    gcap::device_cache_devices_changed();
+            }
+        }
+
+        void stop()
+        {
+            if (thread_.joinable())
+            {
+                const char c = 0;
+                (void)!write(wake_[1], &c, 1);
+                thread_.join();
+            }
+            closeFds();
+        }
+
+        void closeFds()
+        {
+            for (int *fd : {&fd_, &wake_[0], &wake_[1]})
+                if (*fd >= 0)
+                {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+        }
+
+        int fd_ = -1;
+        int wake_[2] = {-1, -1};
+        std::thread thread_;
+#endif
+        std::mutex mtx_;
+        bool tried_ = false;
+    };
+
+    // Never destroyed (see DeviceWatcher); a watch still running at exit ends with the process.
+    DeviceWatcher &watcher()
+    {
+        static DeviceWatcher *w = new DeviceWatcher;
+        return *w;
+    }
+}
+
+bool gcap::cached_device_list(int backend, const DeviceListLoader &load, std::vector<gcap_device_info_t> &out)
+{
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (!g_enabled)
+            return load(out);
+        generation = g_generation;
+    }
+    watcher().ensureStarted();
+    if (g_watching)
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        const auto it = g_lists.find(backend);
+        if (it != g_lists.end() && it->second.generation == g_generation)
+        {
+            out = it->second.devices;
+            return true;
+        }
+    }
+    if (!load(out))
+        return false;
+    std::lock_guard<std::mutex> lk(g_mtx);
+    // A change during the load leaves its result uncached.
+    if (g_watching && g_enabled && generation == g_generation)
+        g_lists[backend] = ListEntry{generation, out};
+    return true;
+}
+
+std::string gcap::device_identity(const gcap_device_info_t &d)
+{
+    const size_t linkLen = strnlen(d.symbolic_link, sizeof(d.symbolic_link));
+    const size_t nameLen = strnlen(d.name, sizeof(d.name));
+    if (!linkLen && !nameLen)
+        return std::string();
+    return std::string(d.symbolic_link, linkLen) + "|" + std::string(d.name, nameLen);
+}
+
+int gcap::cached_video_caps(const std::string &identity, const VideoCapsQuery &query, gcap_video_cap_t *out, int max)
+{
+    if (identity.empty())
+        return query(out, max);
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (!g_enabled)
+            return query(out, max);
+        const auto it = g_caps.find(identity);
+        if (it != g_caps.end() && it->second.hasCaps && entry_valid(it->second))
+        {
+            const std::vector<gcap_video_cap_t> &caps = it->second.caps;
+            if (!out || max <= 0)
+                return (int)caps.size();
+            const int n = std::min(max, (int)caps.size());
+            std::copy(caps.begin(), caps.begin() + n, out);
+            return n;
+        }
+        generation = g_generation;
+    }
+
+    const int count = query(nullptr, 0);
+    if (count <= 0)
+        return 0;
+    std::vector<gcap_video_cap_t> caps((size_t)count);
+    caps.resize((size_t)std::max(0, query(caps.data(), count)));
+    if (caps.empty())
+        return 0;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (g_enabled && generation == g_generation)
+        {
+            CapsEntry &e = fresh_entry_locked(identity);
+            e.hasCaps = true;
+            e.caps = caps;
+            if (e.persisted)
+                save_locked();
+        }
+    }
+    if (!out || max <= 0)
+        return (int)caps.size();
+    const int n = std::min(max, (int)caps.size());
+    std::copy(caps.begin(), caps.begin() + n, out);
+    return n;
+}
+
+int gcap::cached_pixel_formats(const std::string &identity, int backend, const PixelFormatsQuery &query,
+                               gcap_pixfmt_t *out, int max)
+{
+    if (identity.empty())
+        return query(out, max);
+    uint64_t generation;
+    std::vector<gcap_pixfmt_t> formats;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (!g_enabled)
+            return query(out, max);
+        const auto it = g_caps.find(identity);
+        if (it != g_caps.end() && entry_valid(it->second))
+        {
+            const auto f = it->second.formats.find(backend);
+            if (f != it->second.formats.end())
+                formats = f->second;
+        }
+        generation = g_generation;
+    }
+
+    if (formats.empty())
+    {
+        gcap_pixfmt_t buf[32];
+        const int n = query(buf, 32);
+        if (n <= 0)
+            return 0;
+        formats.assign(buf, buf + n);
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (g_enabled && generation == g_generation)
+        {
+            CapsEntry &e = fresh_entry_locked(identity);
+            e.formats[backend] = formats;
+            if (e.persisted)
+                save_locked();
+        }
+    }
+    if (!out || max <= 0)
+        return (int)formats.size();
+    const int n = std::min(max, (int)formats.size());
+    std::copy(formats.begin(), formats.begin() + n, out);
+    return n;
+}
+
+void gcap::set_device_cache_options(const gcap_device_cache_opts_t *opts)
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    g_enabled = !opts || opts->enable;
+    g_path = opts && opts->cache_path_utf8 ? opts->cache_path_utf8 : "";
+    ++g_generation;
+    g_lists.clear();
+    g_caps.clear();
+    if (g_enabled && !g_path.empty())
+        load_locked();
+}
+
+void gcap::device_cache_refresh()
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    ++g_generation;
+    g_lists.clear();
+    g_caps.clear();
+    save_locked();
+}
+
+void gcap::device_cache_devices_changed()
+{
+    std::lock_guard<std::mutex> lk(g_mtx);
+    ++g_generation;
+    g_lists.clear();
+    for (auto it = g_caps.begin(); it != g_caps.end();)
+        it = it->second.persisted ? std::next(it) : g_caps.erase(it);
+}
+
+void gcap::device_cache_shutdown()
+{
+    // Changes from here to the next start go unnoticed: nothing of this run is trusted then.
+    if (watcher().shutdown())
+        device_cache_devices_changed();
+}
@@ -0,0 +1,36 @@
+// device_cache.h
+// Process-wide cache behind gcap_enumerate / gcap_enum_video_caps /
+// gcap_enum_supported_pixel_formats: device lists per backend, capabilities per
+// device identity. Dropped when a capture device arrives or leaves, or on
+// gcap_refresh_devices; capabilities can also be kept in a file across runs.
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gcapture.h"
+
+namespace gcap
+{
+    using DeviceListLoader = std::function<bool(std::vector<gcap_device_info_t> &)>;
+    using VideoCapsQuery = std::function<int(gcap_video_cap_t *, int)>;    // (nullptr, 0) = count
+    using PixelFormatsQuery = std::function<int(gcap_pixfmt_t *, int)>;
+
+    // The list is only kept while arrivals and removals are watched; otherwise every
+    // call loads it. A failed load is not cached.
+    bool cached_device_list(int backend, const DeviceListLoader &load, std::vector<gcap_device_info_t> &out);
+
+    // "<symbolic link>|<name>": a node path alone (/dev/video0) can name another device next run.
+    std::string device_identity(const gcap_device_info_t &d);
+
+    // Same contract as the query; identity "" bypasses the cache. Empty results are not cached
+    // (a device busy elsewhere can report none).
+    int cached_video_caps(const std::string &identity, const VideoCapsQuery &query, gcap_video_cap_t *out, int max);
+    int cached_pixel_formats(const std::string &identity, int backend, const PixelFormatsQuery &query,
+                             gcap_pixfmt_t *out, int max);
+
+    void set_device_cache_options(const gcap_device_cache_opts_t *opts);
+    void device_cache_refresh();        // drops everything, the file's entries too
+    void device_cache_devices_changed(); // an arrival or removal: drops the lists and this run's capabilities
+    void device_cache_shutdown();        // gcap_shutdown: stops watching for arrivals and removals
+}
@@ -0,0 +1,137 @@
+// frame_arena.cpp
+#include "frame_arena.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    constexpr size_t kAlign = 64;
+    constexpr size_t kPage = 4096;
+    constexpr size_t kHugePage = 2u << 20;
+
+    size_t round_up(size_t v, size_t a)
+    {
+        return (v + a - 1) / a * a;
+    }
+
+#ifdef _WIN32
+    // Large pages need SeLockMemoryPrivilege enabled on the process token (the
+    // account must hold "Lock pages in memory"); tried once per process.
+    bool enable_lock_memory_privilege()
+    {
+        static const bool enabled = []
+        {
+            HANDLE token = nullptr;
+            if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+                return false;
+            TOKEN_PRIVILEGES tp{};
+            tp.PrivilegeCount = 1;
+            tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+            const bool ok = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) &&
+                            AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) &&
+                            GetLastError() == ERROR_SUCCESS;
+            CloseHandle(token);
+            return ok;
+        }();
+        return enabled;
+    }
+#endif
+}
+
+gcap::FrameArena::FrameArena(int count, size_t bytesHint, bool hugePages)
+{
+    if (count <= 0 || bytesHint == 0)
+        return;
+
+    block_ = round_up(bytesHint, kAlign);
+    const size_t total = block_ * (size_t)count;
+
+#ifdef _WIN32
+    if (hugePages)
+    {
+        const size_t large = GetLargePageMinimum();
+        if (large && enable_lock_memory_privilege())
+        {
+            const size_t bytes = round_up(total, large);
+            mapping_ = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (mapping_)
+            {
+                mappedBytes_ = bytes;
+                huge_ = true;
+            }
+        }
+    }
+    if (!mapping_)
+    {
+        mappedBytes_ = round_up(total, kPage);
+        mapping_ = VirtualAlloc(nullptr, mappedBytes_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (!mapping_)
+        return;
+    base_ = static_cast<uint8_t *>(mapping_);
+#else
+    // Over-map by one huge page so the arena can start on a 2 MiB boundary,
+    // which transparent huge pages need, and end on one inside the mapping:
+    // madvise() fails (ENOMEM) on a range that runs past it.
+    const size_t align = hugePages ? kHugePage : kPage;
+    mappedBytes_ = hugePages ? round_up(total, kHugePage) + kHugePage : round_up(total, kPage);
+    void *p = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return;
+    mapping_ = p;
+    base_ = reinterpret_cast<uint8_t *>(round_up(reinterpret_cast<uintptr_t>(p), align));
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+        huge_ = madvise(base_, round_up(total, kHugePage), MADV_HUGEPAGE) == 0;
+#endif
+#endif
+
+    count_ = count;
+    reserved_ = total;
+    free_.reserve((size_t)count);
+    for (int i = count - 1; i >= 0; --i)
+        free_.push_back(base_ + (size_t)i * block_);
+}
+
+gcap::FrameArena::~FrameArena()
+{
+    if (!mapping_)
+        return;
+#ifdef _WIN32
+    VirtualFree(mapping_, 0, MEM_RELEASE);
+#else
+    munmap(mapping_, mappedBytes_);
+#endif
+}
+
+uint8_t *gcap::FrameArena::allocate(size_t bytes)
+{
+    if (!base_ || bytes > block_ || free_.empty())
+        return nullptr;
+    uint8_t *p = free_.back();
+    free_.pop_back();
+    return p;
+}
+
+void gcap::FrameArena::release(uint8_t *block)
+{
+    if (block)
+        free_.push_back(block);
+}
+
+void gcap::FrameArena::prefault()
+{
+    // Only free blocks: a leased block may still be read by the application.
+    for (uint8_t *block : free_)
+    {
+        volatile uint8_t *p = block;
+        for (size_t off = 0; off < block_; off += kPage)
+            p[off] = 0;
+        p[block_ - 1] = 0;
+    }
+}
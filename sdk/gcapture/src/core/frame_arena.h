@@ -0,0 +1,58 @@
+// frame_arena.h
+// Preallocated frame memory behind gcap_set_buffers(). Internal to the SDK;
+// owned by the handle's FramePool, which hands its blocks to frame slots.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gcap
+{
+    // Row pitch for CPU-written frames: rows start on a cache line.
+    inline int aligned_row_bytes(int rowBytes)
+    {
+        return (rowBytes + 63) & ~63;
+    }
+
+    /**
+     * `count` equal blocks carved out of one reservation. Blocks are 64-byte
+     * aligned and a multiple of 64 bytes long. With huge pages the reservation
+     * uses large pages (Windows, needs SeLockMemoryPrivilege) or transparent
+     * huge pages (Linux); it silently falls back to normal pages otherwise.
+     *
+     * Not thread-safe: the owning pool serialises access.
+     */
+    class FrameArena
+    {
+    public:
+        FrameArena(int count, size_t bytesHint, bool hugePages);
+        ~FrameArena();
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        bool valid() const { return base_ != nullptr; }
+
+        // Free block if `bytes` fits one, else nullptr.
+        uint8_t *allocate(size_t bytes);
+        void release(uint8_t *block);
+
+        // Writes every page once so the first frames do not take page faults.
+        void prefault();
+
+        size_t blockBytes() const { return block_; }
+        size_t reservedBytes() const { return reserved_; }
+        size_t usedBytes() const { return (size_t)(count_ - (int)free_.size()) * block_; }
+        bool hugePages() const { return huge_; }
+        bool idle() const { return (int)free_.size() == count_; }
+
+    private:
+        uint8_t *base_ = nullptr;
+        void *mapping_ = nullptr; // what the OS returned (base_ may be aligned up from it)
+        size_t mappedBytes_ = 0;
+        size_t reserved_ = 0;
+        size_t block_ = 0;
+        int count_ = 0;
+        bool huge_ = false;
+        std::vector<uint8_t *> free_;
+    };
+}
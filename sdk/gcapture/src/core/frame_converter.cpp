@@ -1,140 +1,1332 @@
 // frame_converter.cpp
 #include "frame_converter.h"
+#include "frame_converter_simd.h"
+#include "convert_pool.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <type_traits>
 #include <vector>
 
-static constexpr float kPi = 3.14159265358979323846f;
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define GCAP_CONVERTER_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static constexpr double kPi = 3.14159265358979323846;
 static inline uint16_t normalize_y210_word(uint16_t v)
 {
-    // Y210 stores each 10-bit component left-aligned in a 16-bit WORD.
-    // Bits [15:6] are valid, bits [5:0] are padding.
-    return static_cast<uint16_t>((v >> 6) & 0x03FFu);
+    // Y210 stores each 10-bit component left-aligned in a 16-bit WORD.
+    // Bits [15:6] are valid, bits [5:0] are padding.
+    return static_cast<uint16_t>((v >> 6) & 0x03FFu);
+}
+
+
+// ------------------------------------------------------------
+// Row kernels + runtime CPU dispatch
+// ------------------------------------------------------------
+namespace
+{
+    using gcap::simd::Isa;
+    using gcap::simd::RowKernels;
+    using gcap::simd::YuvChannelCoeffs;
+    using gcap::simd::YuvMatrix;
+
+    // BT.601 limited range: the fixed-point reference all kernels are bit-exact with.
+    const YuvMatrix kBt601Limited{};
+
+    static inline uint8_t matrix_channel(const YuvChannelCoeffs &k, int C, int D, int E)
+    {
+        const int v = ((k.y * C + k.u * D + k.v * E + k.round) >> 8) + k.bias;
+        return (uint8_t)std::clamp(v, 0, 255);
+    }
+
+    // Scalar twin of the SIMD kernels; finishes whatever prefix they did not cover.
+    static inline void yuv_to_bgra(const YuvMatrix &m, int Y, int U, int V, uint8_t *dst)
+    {
+        const int C = Y - m.y_offset;
+        const int D = U - 128;
+        const int E = V - 128;
+        dst[0] = matrix_channel(m.b, C, D, E);
+        dst[1] = matrix_channel(m.g, C, D, E);
+        dst[2] = matrix_channel(m.r, C, D, E);
+        dst[3] = 255;
+    }
+
+    static void nv12_row_tail(const uint8_t *yRow, const uint8_t *uvRow, uint8_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        for (; x < width; ++x)
+        {
+            const int c = x & ~1;
+            yuv_to_bgra(m, yRow[x], uvRow[c], uvRow[c + 1], dst + (size_t)x * 4);
+        }
+    }
+
+    static void yuy2_row_tail(const uint8_t *src, uint8_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        for (; x < width; ++x)
+        {
+            const uint8_t *pair = src + (size_t)(x & ~1) * 2;
+            yuv_to_bgra(m, pair[(x & 1) * 2], pair[1], pair[3], dst + (size_t)x * 4);
+        }
+    }
+
+    static void y210_row_tail(const uint16_t *src, uint8_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        auto to8 = [](uint16_t w) -> int
+        { return (int)((normalize_y210_word(w) * 255u + 511u) / 1023u); };
+        for (; x < width; ++x)
+        {
+            const uint16_t *pair = src + (size_t)(x & ~1) * 2;
+            yuv_to_bgra(m, to8(pair[(x & 1) * 2]), to8(pair[1]), to8(pair[3]), dst + (size_t)x * 4);
+        }
+    }
+
+    static inline int p010_to8(uint16_t w)
+    {
+        return (int)((normalize_y210_word(w) * 255u + 511u) / 1023u);
+    }
+
+    static void p010_row_tail(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        for (; x < width; ++x)
+        {
+            const int c = x & ~1;
+            yuv_to_bgra(m, p010_to8(yRow[x]), p010_to8(uvRow[c]), p010_to8(uvRow[c + 1]), dst + (size_t)x * 4);
+        }
+    }
+
+    static inline unsigned matrix_channel10(const YuvChannelCoeffs &k, int C, int D, int E)
+    {
+        return (unsigned)std::clamp(((k.y * C + k.u * D + k.v * E + k.round) >> 8) + k.bias, 0, 1023);
+    }
+
+    // 10-bit value -> 16-bit UNORM by bit replication.
+    static inline uint16_t widen10(unsigned v)
+    {
+        return (uint16_t)((v << 6) | (v >> 4));
+    }
+
+    // One P010 pixel through the 10-bit matrix (simd::to_10bit): R, G, B in 0..1023.
+    static inline void p010_rgb10(const YuvMatrix &m, const uint16_t *yRow, const uint16_t *uvRow, int x, unsigned rgb[3])
+    {
+        const int c = x & ~1;
+        const int C = (yRow[x] >> 6) - m.y_offset;
+        const int D = (uvRow[c] >> 6) - 512;
+        const int E = (uvRow[c + 1] >> 6) - 512;
+        rgb[0] = matrix_channel10(m.r, C, D, E);
+        rgb[1] = matrix_channel10(m.g, C, D, E);
+        rgb[2] = matrix_channel10(m.b, C, D, E);
+    }
+
+    static void p010_rgba64_row_tail(const uint16_t *yRow, const uint16_t *uvRow, uint16_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        for (; x < width; ++x)
+        {
+            unsigned rgb[3];
+            p010_rgb10(m, yRow, uvRow, x, rgb);
+            uint16_t *px = dst + (size_t)x * 4;
+            px[0] = widen10(rgb[0]);
+            px[1] = widen10(rgb[1]);
+            px[2] = widen10(rgb[2]);
+            px[3] = 0xFFFF;
+        }
+    }
+
+    static void p010_x2rgb10_row_tail(const uint16_t *yRow, const uint16_t *uvRow, uint32_t *dst, int x, int width, const YuvMatrix &m)
+    {
+        for (; x < width; ++x)
+        {
+            unsigned rgb[3];
+            p010_rgb10(m, yRow, uvRow, x, rgb);
+            dst[x] = (3u << 30) | (rgb[0] << 20) | (rgb[1] << 10) | rgb[2];
+        }
+    }
+
+    // 16-bit UNORM -> 8 bits against an ordered-dither threshold in 0..255.
+    static inline uint8_t dither8(unsigned w, unsigned d)
+    {
+        return (uint8_t)((w - (w >> 8) + d) >> 8);
+    }
+
+    static void p010_dither_row_tail(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int x, int width, const YuvMatrix &m,
+                                     const uint16_t *dither)
+    {
+        for (; x < width; ++x)
+        {
+            unsigned rgb[3];
+            p010_rgb10(m, yRow, uvRow, x, rgb);
+            const unsigned d = dither[x & 7];
+            uint8_t *px = dst + (size_t)x * 4;
+            px[0] = dither8(widen10(rgb[2]), d);
+            px[1] = dither8(widen10(rgb[1]), d);
+            px[2] = dither8(widen10(rgb[0]), d);
+            px[3] = 255;
+        }
+    }
+
+    // Y210 -> P210: even words are Y, odd words the U V pair of each pixel pair.
+    static void y210_split_row_tail(const uint16_t *src, uint16_t *yRow, uint16_t *uvRow, int x, int width)
+    {
+        for (; x < width; ++x)
+        {
+            yRow[x] = src[(size_t)x * 2];
+            uvRow[x] = src[(size_t)x * 2 + 1];
+        }
+        if (width & 1)
+            uvRow[width] = src[(size_t)width * 2 + 1];
+    }
+
+    static inline int ten_to8(unsigned n)
+    {
+        return (int)((n * 255u + 511u) / 1023u);
+    }
+
+    // One V210 group (16 bytes, 6 pixels) -> 10-bit Y[6], Cb[3], Cr[3].
+    static inline void v210_group(const uint8_t *src, uint16_t y[6], uint16_t cb[3], uint16_t cr[3])
+    {
+        uint32_t w[4];
+        std::memcpy(w, src, sizeof(w)); // little-endian dwords (x86 / ARM64 hosts)
+        auto f = [](uint32_t v, int i)
+        { return (uint16_t)((v >> (10 * i)) & 0x3FFu); };
+        cb[0] = f(w[0], 0), y[0] = f(w[0], 1), cr[0] = f(w[0], 2);
+        y[1] = f(w[1], 0), cb[1] = f(w[1], 1), y[2] = f(w[1], 2);
+        cr[1] = f(w[2], 0), y[3] = f(w[2], 1), cb[2] = f(w[2], 2);
+        y[4] = f(w[3], 0), cr[2] = f(w[3], 1), y[5] = f(w[3], 2);
+    }
+
+    // x is a multiple of 6. The UV row holds (width + 1) & ~1 words.
+    static void v210_row_tail(const uint8_t *src, uint16_t *yRow, uint16_t *uvRow, int x, int width)
+    {
+        for (; x < width; x += 6)
+        {
+            uint16_t y[6], cb[3], cr[3];
+            v210_group(src + (size_t)(x / 6) * 16, y, cb, cr);
+            for (int i = 0; i < 6 && x + i < width; ++i)
+            {
+                yRow[x + i] = (uint16_t)(y[i] << 6);
+                if ((i & 1) == 0)
+                {
+                    uvRow[x + i] = (uint16_t)(cb[i / 2] << 6);
+                    uvRow[x + i + 1] = (uint16_t)(cr[i / 2] << 6);
+                }
+            }
+        }
+    }
+
+    // U/V rows hold (width + 1) / 2 values.
+    static void v210_planar_row_tail(const uint8_t *src, uint16_t *yRow, uint16_t *uRow, uint16_t *vRow, int x, int width)
+    {
+        for (; x < width; x += 6)
+        {
+            uint16_t y[6], cb[3], cr[3];
+            v210_group(src + (size_t)(x / 6) * 16, y, cb, cr);
+            for (int i = 0; i < 6 && x + i < width; ++i)
+            {
+                yRow[x + i] = y[i];
+                if ((i & 1) == 0)
+                {
+                    uRow[(x + i) / 2] = cb[i / 2];
+                    vRow[(x + i) / 2] = cr[i / 2];
+                }
+            }
+        }
+    }
+
+    static inline uint32_t load_be32(const uint8_t *p)
+    {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+
+    static void r210_row_tail(const uint8_t *src, uint8_t *dst, int x, int width)
+    {
+        for (; x < width; ++x)
+        {
+            const uint32_t v = load_be32(src + (size_t)x * 4);
+            uint8_t *px = dst + (size_t)x * 4;
+            px[0] = (uint8_t)ten_to8(v & 0x3FFu);
+            px[1] = (uint8_t)ten_to8((v >> 10) & 0x3FFu);
+            px[2] = (uint8_t)ten_to8((v >> 20) & 0x3FFu);
+            px[3] = 255;
+        }
+    }
+
+    static void r210_rgba64_row_tail(const uint8_t *src, uint16_t *dst, int x, int width)
+    {
+        for (; x < width; ++x)
+        {
+            const uint32_t v = load_be32(src + (size_t)x * 4);
+            uint16_t *px = dst + (size_t)x * 4;
+            px[0] = widen10((v >> 20) & 0x3FFu);
+            px[1] = widen10((v >> 10) & 0x3FFu);
+            px[2] = widen10(v & 0x3FFu);
+            px[3] = 0xFFFF;
+        }
+    }
+
+    int nv12_row_none(const uint8_t *, const uint8_t *, uint8_t *, int, const YuvMatrix &) { return 0; }
+    int yuy2_row_none(const uint8_t *, uint8_t *, int, const YuvMatrix &) { return 0; }
+    int y210_row_none(const uint16_t *, uint8_t *, int, const YuvMatrix &) { return 0; }
+    int p010_row_none(const uint16_t *, const uint16_t *, uint8_t *, int, const YuvMatrix &) { return 0; }
+    int p010_rgba64_row_none(const uint16_t *, const uint16_t *, uint16_t *, int, const YuvMatrix &) { return 0; }
+    int p010_x2rgb10_row_none(const uint16_t *, const uint16_t *, uint32_t *, int, const YuvMatrix &) { return 0; }
+    int p010_dither_row_none(const uint16_t *, const uint16_t *, uint8_t *, int, const YuvMatrix &, const uint16_t *) { return 0; }
+    int y210_split_row_none(const uint16_t *, uint16_t *, uint16_t *, int) { return 0; }
+    int v210_row_none(const uint8_t *, uint16_t *, uint16_t *, int) { return 0; }
+    int v210_planar_row_none(const uint8_t *, uint16_t *, uint16_t *, uint16_t *, int) { return 0; }
+    int r210_row_none(const uint8_t *, uint8_t *, int) { return 0; }
+    int r210_rgba64_row_none(const uint8_t *, uint16_t *, int) { return 0; }
+    int hsum3_row_none(const uint8_t *, uint16_t *, int) { return 0; }
+    int unsharp_row_none(const uint8_t *, const uint16_t *, const uint16_t *, const uint16_t *, uint8_t *, int, int) { return 0; }
+    int vacc8_row_none(const uint8_t *, uint16_t *, int, int) { return 0; }
+    int vacc10_row_none(const uint16_t *, uint32_t *, int, int) { return 0; }
+
+    const RowKernels kScalarKernels = {Isa::Scalar, "Scalar", nv12_row_none, yuy2_row_none, y210_row_none,
+                                       p010_row_none, p010_rgba64_row_none, p010_x2rgb10_row_none, p010_dither_row_none,
+                                       y210_split_row_none, v210_row_none, v210_planar_row_none,
+                                       r210_row_none, r210_rgba64_row_none, hsum3_row_none, unsharp_row_none,
+                                       vacc8_row_none, vacc10_row_none};
+
+#ifdef GCAP_CONVERTER_X86
+    static void cpuid(int leaf, int sub, unsigned regs[4])
+    {
+#ifdef _MSC_VER
+        int r[4] = {};
+        __cpuidex(r, leaf, sub);
+        for (int i = 0; i < 4; ++i)
+            regs[i] = (unsigned)r[i];
+#else
+        __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    static uint64_t xgetbv0()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned lo = 0, hi = 0;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return ((uint64_t)hi << 32) | lo;
+#endif
+    }
+
+    static bool cpu_supports(Isa isa)
+    {
+        unsigned r1[4] = {};
+        cpuid(0, 0, r1);
+        const unsigned maxLeaf = r1[0];
+        cpuid(1, 0, r1);
+        const bool ssse3 = (r1[2] & (1u << 9)) != 0;
+        const bool sse41 = (r1[2] & (1u << 19)) != 0;
+        if (isa == Isa::Sse41)
+            return ssse3 && sse41;
+        if (isa != Isa::Avx2 || maxLeaf < 7)
+            return false;
+
+        // AVX2 also needs the OS to save YMM state (OSXSAVE + XCR0 bits 1/2).
+        const bool osxsave = (r1[2] & (1u << 27)) != 0;
+        const bool avx = (r1[2] & (1u << 28)) != 0;
+        if (!osxsave || !avx || (xgetbv0() & 0x6) != 0x6)
+            return false;
+        unsigned r7[4] = {};
+        cpuid(7, 0, r7);
+        return (r7[1] & (1u << 5)) != 0;
+    }
+#else
+    static bool cpu_supports(Isa isa)
+    {
+        // NEON is mandatory on ARM64.
+        return isa == Isa::Neon;
+    }
+#endif
+
+    static const RowKernels *detect_kernels()
+    {
+        for (Isa isa : {Isa::Avx2, Isa::Sse41, Isa::Neon})
+        {
+            if (const RowKernels *k = gcap::simd::kernels_for(isa))
+                return k;
+        }
+        return &kScalarKernels;
+    }
+
+    std::atomic<const RowKernels *> g_kernels{nullptr};
+}
+
+const gcap::simd::RowKernels *gcap::simd::kernels_for(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return &kScalarKernels;
+    case Isa::Sse41:
+        return cpu_supports(isa) ? sse41_kernels() : nullptr;
+    case Isa::Avx2:
+        return cpu_supports(isa) ? avx2_kernels() : nullptr;
+    case Isa::Neon:
+        return cpu_supports(isa) ? neon_kernels() : nullptr;
+    }
+    return nullptr;
+}
+
+const gcap::simd::RowKernels &gcap::simd::active_kernels()
+{
+    const RowKernels *k = g_kernels.load(std::memory_order_acquire);
+    if (!k)
+    {
+        static const RowKernels *const detected = detect_kernels();
+        k = detected;
+        const RowKernels *expected = nullptr;
+        if (!g_kernels.compare_exchange_strong(expected, k, std::memory_order_acq_rel))
+            k = expected;
+    }
+    return *k;
+}
+
+bool gcap::simd::force_kernels(Isa isa)
+{
+    const RowKernels *k = kernels_for(isa);
+    if (!k)
+        return false;
+    g_kernels.store(k, std::memory_order_release);
+    return true;
+}
+
+const char *gcap::converter_kernel_name()
+{
+    return simd::active_kernels().name;
+}
+
+// ------------------------------------------------------------
+// Row pipeline: convert + streaming sharpness
+// ------------------------------------------------------------
+namespace
+{
+    using gcap::YuvLayout;
+
+    struct ConvertJob
+    {
+        const uint8_t *src0; // Y plane or packed plane
+        const uint8_t *src1; // UV plane (NV12 / P010)
+        int stride0;
+        int stride1;
+        int width;
+        int height;
+        uint8_t *dst;
+        int dstStride;
+        const gcap::ProcAmpPlan *plan;
+    };
+
+    // One unpacked V210 row as P210 (Y + interleaved UV, MSB-aligned), per thread.
+    struct P210Row
+    {
+        std::vector<uint16_t> buf;
+        uint16_t *y = nullptr;
+        uint16_t *uv = nullptr;
+
+        void ensure(int w)
+        {
+            const size_t even = (size_t)(w + 1) & ~(size_t)1;
+            if (buf.size() < even * 2)
+                buf.resize(even * 2);
+            y = buf.data();
+            uv = buf.data() + even;
+        }
+    };
+
+    static inline void unpack_v210_row(const RowKernels &k, const uint8_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        v210_row_tail(src, y, uv, k.v210(src, y, uv, width), width);
+    }
+
+    template <YuvLayout L>
+    static inline void convert_row(const ConvertJob &job, const RowKernels &k, int j, uint8_t *out)
+    {
+        const YuvMatrix &m = job.plan->matrix;
+        if constexpr (L == YuvLayout::Nv12)
+        {
+            const uint8_t *yRow = job.src0 + (size_t)j * (size_t)job.stride0;
+            const uint8_t *uvRow = job.src1 + (size_t)(j / 2) * (size_t)job.stride1;
+            nv12_row_tail(yRow, uvRow, out, k.nv12(yRow, uvRow, out, job.width, m), job.width, m);
+        }
+        else if constexpr (L == YuvLayout::Yuy2)
+        {
+            const uint8_t *src = job.src0 + (size_t)j * (size_t)job.stride0;
+            yuy2_row_tail(src, out, k.yuy2(src, out, job.width, m), job.width, m);
+        }
+        else if constexpr (L == YuvLayout::Y210)
+        {
+            const uint16_t *src = reinterpret_cast<const uint16_t *>(job.src0 + (size_t)j * (size_t)job.stride0);
+            y210_row_tail(src, out, k.y210(src, out, job.width, m), job.width, m);
+        }
+        else if constexpr (L == YuvLayout::P010)
+        {
+            const uint16_t *yRow = reinterpret_cast<const uint16_t *>(job.src0 + (size_t)j * (size_t)job.stride0);
+            const uint16_t *uvRow = reinterpret_cast<const uint16_t *>(job.src1 + (size_t)(j / 2) * (size_t)job.stride1);
+            p010_row_tail(yRow, uvRow, out, k.p010(yRow, uvRow, out, job.width, m), job.width, m);
+        }
+        else
+        {
+            // V210: unpack while the row is hot, then the P010 kernels do the matrix
+            // (a P210 row has the same per-row layout as a P010 row).
+            thread_local P210Row row;
+            row.ensure(job.width);
+            unpack_v210_row(k, job.src0 + (size_t)j * (size_t)job.stride0, row.y, row.uv, job.width);
+            p010_row_tail(row.y, row.uv, out, k.p010(row.y, row.uv, out, job.width, m), job.width, m);
+        }
+    }
+
+    // Rolling three-row window for the unsharp mask. Grows with the widest frame
+    // seen on this thread and is reused afterwards, so steady state never allocates.
+    struct SharpenScratch
+    {
+        std::vector<uint8_t> rows;   // 3 converted BGRA rows
+        std::vector<uint16_t> hsums; // 3 rows of horizontal 3-tap sums, 4 lanes per pixel
+        int width = 0;
+
+        void ensure(int w)
+        {
+            if (w <= width)
+                return;
+            rows.resize((size_t)w * 4 * 3);
+            hsums.resize((size_t)w * 4 * 3);
+            width = w;
+        }
+        uint8_t *row(int slot) { return rows.data() + (size_t)slot * (size_t)width * 4; }
+        uint16_t *hsum(int slot) { return hsums.data() + (size_t)slot * (size_t)width * 4; }
+    };
+
+    // Horizontal pass of the separable 3x3 box: left + centre + right, edges replicated.
+    // Works on the interleaved bytes directly (neighbour = +/-4).
+    static void horizontal_sums(const RowKernels &k, const uint8_t *bgra, uint16_t *out, int w)
+    {
+        const int n = w * 4;
+        for (int i = 0; i < 4; ++i)
+        {
+            out[i] = (uint16_t)(2 * bgra[i] + bgra[i + 4]);
+            out[n - 4 + i] = (uint16_t)(bgra[n - 8 + i] + 2 * bgra[n - 4 + i]);
+        }
+        for (int i = 4 + k.hsum3(bgra + 4, out + 4, n - 8); i < n - 4; ++i)
+            out[i] = (uint16_t)(bgra[i - 4] + bgra[i] + bgra[i + 4]);
+    }
+
+    // Vertical pass + unsharp mask: out = orig + (orig - blur) * amount.
+    // amount = (sharpness - 128) / 128 (128 neutral, >128 sharpen, <128 soften);
+    // the >> 7 form matches the old float math for every in-range result.
+    // Alpha goes through the same math: an all-255 neighbourhood maps back to 255.
+    static void sharpen_row(const RowKernels &k, const uint8_t *orig, const uint16_t *up, const uint16_t *mid,
+                            const uint16_t *down, uint8_t *dst, int w, int sharpness)
+    {
+        const int amt = sharpness - 128;
+        const int n = w * 4;
+        for (int i = k.unsharp(orig, up, mid, down, dst, n, amt); i < n; ++i)
+        {
+            // (sum + 4) / 9 for sum <= 9 * 255, as the multiply-shift the SIMD kernels use.
+            const int blur = ((up[i] + mid[i] + down[i] + 4) * 7282) >> 16;
+            const int v = orig[i] + (((orig[i] - blur) * amt) >> 7);
+            dst[i] = (uint8_t)std::clamp(v, 0, 255);
+        }
+    }
+
+    // Converts rows [y0, y1) of the job. With sharpness active, each row is
+    // converted once into the ring (plus one halo row either side of the range),
+    // filtered while still in cache and written to its destination row.
+    template <YuvLayout L, bool Sharpen>
+    static void run_rows(const ConvertJob &job, int y0, int y1)
+    {
+        const RowKernels &k = gcap::simd::active_kernels();
+        if (!Sharpen || job.width <= 2 || job.height <= 2)
+        {
+            for (int j = y0; j < y1; ++j)
+                convert_row<L>(job, k, j, job.dst + (size_t)j * (size_t)job.dstStride);
+            return;
+        }
+
+        thread_local SharpenScratch scratch;
+        scratch.ensure(job.width);
+        const int w = job.width;
+        const int last = job.height - 1;
+        const int sharpness = job.plan->sharpness;
+
+        auto load = [&](int r)
+        {
+            const int slot = r % 3;
+            convert_row<L>(job, k, r, scratch.row(slot));
+            horizontal_sums(k, scratch.row(slot), scratch.hsum(slot), w);
+        };
+
+        if (y0 > 0)
+            load(y0 - 1);
+        load(y0);
+        for (int j = y0; j < y1; ++j)
+        {
+            if (j < last)
+                load(j + 1);
+            const int up = (j > 0 ? j - 1 : j) % 3;
+            const int down = (j < last ? j + 1 : j) % 3;
+            sharpen_row(k, scratch.row(j % 3), scratch.hsum(up), scratch.hsum(j % 3), scratch.hsum(down),
+                        job.dst + (size_t)j * (size_t)job.dstStride, w, sharpness);
+        }
+    }
+
+    template <YuvLayout L, bool Sharpen>
+    static void run_rows_band(void *ctx, int y0, int y1)
+    {
+        run_rows<L, Sharpen>(*static_cast<const ConvertJob *>(ctx), y0, y1);
+    }
+
+    // Whole frame: bands go to the convert pool (chroma-aligned for 4:2:0).
+    template <YuvLayout L, bool Sharpen>
+    static void convert_frame_impl(const gcap::ProcAmpPlan &plan, const uint8_t *src0, const uint8_t *src1,
+                                   int stride0, int stride1, int width, int height, uint8_t *out, int outStride)
+    {
+        const ConvertJob job{src0, src1, stride0, stride1, width, height, out, outStride, &plan};
+        const int rowAlign = (L == YuvLayout::Nv12 || L == YuvLayout::P010) ? 2 : 1;
+        gcap::parallel_rows(width, height, rowAlign, run_rows_band<L, Sharpen>, const_cast<ConvertJob *>(&job));
+    }
+
+    // [layout][sharpen]: every combination is instantiated up front.
+    const gcap::FrameConvertFn kFrameFns[5][2] = {
+        {convert_frame_impl<YuvLayout::Nv12, false>, convert_frame_impl<YuvLayout::Nv12, true>},
+        {convert_frame_impl<YuvLayout::Yuy2, false>, convert_frame_impl<YuvLayout::Yuy2, true>},
+        {convert_frame_impl<YuvLayout::Y210, false>, convert_frame_impl<YuvLayout::Y210, true>},
+        {convert_frame_impl<YuvLayout::P010, false>, convert_frame_impl<YuvLayout::P010, true>},
+        {convert_frame_impl<YuvLayout::V210, false>, convert_frame_impl<YuvLayout::V210, true>},
+    };
+
+    // 8x8 Bayer thresholds for the dithered 8-bit output, scaled to 0..255.
+    const uint16_t kDither8[8][8] = {
+        {2, 130, 34, 162, 10, 138, 42, 170},
+        {194, 66, 226, 98, 202, 74, 234, 106},
+        {50, 178, 18, 146, 58, 186, 26, 154},
+        {242, 114, 210, 82, 250, 122, 218, 90},
+        {14, 142, 46, 174, 6, 134, 38, 166},
+        {206, 78, 238, 110, 198, 70, 230, 102},
+        {62, 190, 30, 158, 54, 182, 22, 150},
+        {254, 126, 222, 94, 246, 118, 214, 86},
+    };
+
+    // 10-bit layouts as a P010 row pair: P010 rows are used in place, Y210 rows
+    // are split and V210 rows unpacked into the per-thread scratch row.
+    template <YuvLayout L>
+    static inline void p010_rows(const ConvertJob &job, const RowKernels &k, int j, P210Row &row,
+                                 const uint16_t *&y, const uint16_t *&uv)
+    {
+        if constexpr (L == YuvLayout::P010)
+        {
+            y = reinterpret_cast<const uint16_t *>(job.src0 + (size_t)j * (size_t)job.stride0);
+            uv = reinterpret_cast<const uint16_t *>(job.src1 + (size_t)(j / 2) * (size_t)job.stride1);
+            return;
+        }
+        else if constexpr (L == YuvLayout::Y210)
+        {
+            const uint16_t *src = reinterpret_cast<const uint16_t *>(job.src0 + (size_t)j * (size_t)job.stride0);
+            y210_split_row_tail(src, row.y, row.uv, k.y210_split(src, row.y, row.uv, job.width), job.width);
+        }
+        else
+        {
+            unpack_v210_row(k, job.src0 + (size_t)j * (size_t)job.stride0, row.y, row.uv, job.width);
+        }
+        y = row.y;
+        uv = row.uv;
+    }
+
+    // 10-bit layouts to RGBA64 / X2R10G10B10 / dithered BGRA through the 10-bit matrix.
+    // Sharpness is an 8-bit display filter and is not applied on these outputs.
+    template <YuvLayout L, gcap::FrameOutput O>
+    static void deep_rows_band(void *ctx, int y0, int y1)
+    {
+        const ConvertJob &job = *static_cast<const ConvertJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        const YuvMatrix m = gcap::simd::to_10bit(job.plan->matrix);
+        const int w = job.width;
+        thread_local P210Row row;
+        if constexpr (L != YuvLayout::P010)
+            row.ensure(w);
+        for (int j = y0; j < y1; ++j)
+        {
+            const uint16_t *y;
+            const uint16_t *uv;
+            p010_rows<L>(job, k, j, row, y, uv);
+            uint8_t *out = job.dst + (size_t)j * (size_t)job.dstStride;
+            if constexpr (O == gcap::FrameOutput::Rgba64)
+            {
+                uint16_t *dst = reinterpret_cast<uint16_t *>(out);
+                p010_rgba64_row_tail(y, uv, dst, k.p010_rgba64(y, uv, dst, w, m), w, m);
+            }
+            else if constexpr (O == gcap::FrameOutput::X2R10G10B10)
+            {
+                uint32_t *dst = reinterpret_cast<uint32_t *>(out);
+                p010_x2rgb10_row_tail(y, uv, dst, k.p010_x2rgb10(y, uv, dst, w, m), w, m);
+            }
+            else
+            {
+                const uint16_t *d = kDither8[j & 7];
+                p010_dither_row_tail(y, uv, out, k.p010_dither(y, uv, out, w, m, d), w, m, d);
+            }
+        }
+    }
+
+    template <YuvLayout L, gcap::FrameOutput O>
+    static void deep_frame_impl(const gcap::ProcAmpPlan &plan, const uint8_t *src0, const uint8_t *src1,
+                                int stride0, int stride1, int width, int height, uint8_t *out, int outStride)
+    {
+        const ConvertJob job{src0, src1, stride0, stride1, width, height, out, outStride, &plan};
+        gcap::parallel_rows(width, height, L == YuvLayout::P010 ? 2 : 1, deep_rows_band<L, O>, const_cast<ConvertJob *>(&job));
+    }
+
+    // [layout - Y210][output - Bgra8Dither] for the 10-bit layouts.
+    const gcap::FrameConvertFn kDeepFns[3][3] = {
+        {deep_frame_impl<YuvLayout::Y210, gcap::FrameOutput::Bgra8Dither>,
+         deep_frame_impl<YuvLayout::Y210, gcap::FrameOutput::Rgba64>,
+         deep_frame_impl<YuvLayout::Y210, gcap::FrameOutput::X2R10G10B10>},
+        {deep_frame_impl<YuvLayout::P010, gcap::FrameOutput::Bgra8Dither>,
+         deep_frame_impl<YuvLayout::P010, gcap::FrameOutput::Rgba64>,
+         deep_frame_impl<YuvLayout::P010, gcap::FrameOutput::X2R10G10B10>},
+        {deep_frame_impl<YuvLayout::V210, gcap::FrameOutput::Bgra8Dither>,
+         deep_frame_impl<YuvLayout::V210, gcap::FrameOutput::Rgba64>,
+         deep_frame_impl<YuvLayout::V210, gcap::FrameOutput::X2R10G10B10>},
+    };
+
+    static gcap::FrameConvertFn frame_fn(YuvLayout layout, const gcap::ProcAmpPlan &plan,
+                                         gcap::FrameOutput output = gcap::FrameOutput::Bgra8)
+    {
+        if (output != gcap::FrameOutput::Bgra8 && gcap::is_10bit_layout(layout))
+            return kDeepFns[(int)layout - (int)YuvLayout::Y210][(int)output - (int)gcap::FrameOutput::Bgra8Dither];
+        return kFrameFns[(int)layout][plan.sharpness != 128 ? 1 : 0];
+    }
+
+    // Matrix-free repacks: V210 unpack and R210 -> RGB.
+    struct RepackJob
+    {
+        const uint8_t *src;
+        int srcStride;
+        int width;
+        int height;
+        uint8_t *dst0;
+        int stride0;
+        uint8_t *dst1;
+        int stride1;
+        uint8_t *dst2;
+        int stride2;
+    };
+
+    template <typename T>
+    static inline T *row_at(uint8_t *base, int stride, int j)
+    {
+        return reinterpret_cast<T *>(base + (size_t)j * (size_t)stride);
+    }
+
+    static void v210_planar_band(void *ctx, int y0, int y1)
+    {
+        const RepackJob &job = *static_cast<const RepackJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        for (int j = y0; j < y1; ++j)
+        {
+            const uint8_t *src = job.src + (size_t)j * (size_t)job.srcStride;
+            uint16_t *y = row_at<uint16_t>(job.dst0, job.stride0, j);
+            uint16_t *u = row_at<uint16_t>(job.dst1, job.stride1, j);
+            uint16_t *v = row_at<uint16_t>(job.dst2, job.stride2, j);
+            v210_planar_row_tail(src, y, u, v, k.v210_planar(src, y, u, v, job.width), job.width);
+        }
+    }
+
+    static void v210_p210_band(void *ctx, int y0, int y1)
+    {
+        const RepackJob &job = *static_cast<const RepackJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        for (int j = y0; j < y1; ++j)
+            unpack_v210_row(k, job.src + (size_t)j * (size_t)job.srcStride, row_at<uint16_t>(job.dst0, job.stride0, j),
+                            row_at<uint16_t>(job.dst1, job.stride1, j), job.width);
+    }
+
+    // 4:2:2 -> 4:2:0: each output chroma row is the rounded mean of a source row pair.
+    static void v210_p010_band(void *ctx, int y0, int y1)
+    {
+        const RepackJob &job = *static_cast<const RepackJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        thread_local P210Row odd;
+        odd.ensure(job.width);
+        const int uvCount = (job.width + 1) & ~1;
+        for (int j = y0; j < y1; j += 2)
+        {
+            uint16_t *uv = row_at<uint16_t>(job.dst1, job.stride1, j / 2);
+            unpack_v210_row(k, job.src + (size_t)j * (size_t)job.srcStride, row_at<uint16_t>(job.dst0, job.stride0, j), uv, job.width);
+            if (j + 1 >= job.height)
+                break;
+            unpack_v210_row(k, job.src + (size_t)(j + 1) * (size_t)job.srcStride, row_at<uint16_t>(job.dst0, job.stride0, j + 1),
+                            odd.uv, job.width);
+            for (int i = 0; i < uvCount; ++i)
+                uv[i] = (uint16_t)(((uv[i] + odd.uv[i] + 64) >> 1) & 0xFFC0); // MSB-aligned mean
+        }
+    }
+
+    static void r210_argb_band(void *ctx, int y0, int y1)
+    {
+        const RepackJob &job = *static_cast<const RepackJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        for (int j = y0; j < y1; ++j)
+        {
+            const uint8_t *src = job.src + (size_t)j * (size_t)job.srcStride;
+            uint8_t *out = row_at<uint8_t>(job.dst0, job.stride0, j);
+            r210_row_tail(src, out, k.r210(src, out, job.width), job.width);
+        }
+    }
+
+    static void r210_rgba64_band(void *ctx, int y0, int y1)
+    {
+        const RepackJob &job = *static_cast<const RepackJob *>(ctx);
+        const RowKernels &k = gcap::simd::active_kernels();
+        for (int j = y0; j < y1; ++j)
+        {
+            const uint8_t *src = job.src + (size_t)j * (size_t)job.srcStride;
+            uint16_t *out = row_at<uint16_t>(job.dst0, job.stride0, j);
+            r210_rgba64_row_tail(src, out, k.r210_rgba64(src, out, job.width), job.width);
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// Fused resample + convert (preview / thumbnail outputs)
+// ------------------------------------------------------------
+namespace
+{
+    using gcap::ScaleAxis;
+    using gcap::ScalePlan;
+
+    // Exact integer shrink: output o averages source samples [o*f, o*f + f).
+    static ScaleAxis box_axis(int n, int m)
+    {
+        ScaleAxis ax;
+        const int f = n / m;
+        ax.taps = f;
+        ax.box = true;
+        ax.start.resize((size_t)m);
+        ax.weight.assign((size_t)m * f, (uint16_t)(256 / f));
+        for (int o = 0; o < m; ++o)
+            ax.start[o] = o * f;
+        return ax;
+    }
+
+    // Triangle filter; its support widens with the shrink factor so large
+    // reductions average every source sample instead of skipping rows.
+    static ScaleAxis tent_axis(int n, int m)
+    {
+        ScaleAxis ax;
+        const double scale = (double)n / (double)m;
+        const double support = std::max(scale, 1.0);
+        ax.taps = std::min((int)std::ceil(support) * 2 + 1, n);
+        ax.start.resize((size_t)m);
+        ax.weight.assign((size_t)m * ax.taps, 0);
+
+        std::vector<double> w((size_t)ax.taps);
+        for (int o = 0; o < m; ++o)
+        {
+            const double centre = ((double)o + 0.5) * scale;
+            const int first = (int)std::floor(centre - support);
+            // Keep the window inside the source; taps past an edge fold onto the edge sample.
+            const int start = std::clamp(first, 0, n - ax.taps);
+            std::fill(w.begin(), w.end(), 0.0);
+            double sum = 0.0;
+            for (int i = first; i <= (int)std::ceil(centre + support); ++i)
+            {
+                const double wi = std::max(0.0, 1.0 - std::fabs((double)i + 0.5 - centre) / support);
+                const int t = std::clamp(i, 0, n - 1) - start;
+                if (wi > 0.0 && t >= 0 && t < ax.taps)
+                {
+                    w[t] += wi;
+                    sum += wi;
+                }
+            }
+
+            ax.start[o] = start;
+            uint16_t *wt = ax.weight.data() + (size_t)o * ax.taps;
+            int total = 0, peak = 0;
+            for (int t = 0; t < ax.taps; ++t)
+            {
+                wt[t] = (uint16_t)std::lround(w[t] / sum * 256.0);
+                total += wt[t];
+                if (wt[t] > wt[peak])
+                    peak = t;
+            }
+            // Rounding residue goes to the centre tap so every output keeps unit gain.
+            wt[peak] = (uint16_t)(wt[peak] + 256 - total);
+        }
+        return ax;
+    }
+
+    static ScaleAxis scale_axis(int n, int m, bool box)
+    {
+        return box && n % m == 0 ? box_axis(n, m) : tent_axis(n, m);
+    }
+
+    static bool box_factor(int n, int m)
+    {
+        return n == m * 2 || n == m * 4;
+    }
+
+    struct ScaleJob
+    {
+        const gcap::FrameConverter *cv;
+        const ScalePlan *sp;
+        const uint8_t *src0;
+        const uint8_t *src1;
+        int stride0;
+        int stride1;
+        uint8_t *dst;
+        int dstStride;
+    };
+
+    // Vertical sums: 8-bit samples fit 16-bit lanes, 10-bit ones need 32.
+    template <typename T>
+    using ScaleAcc = std::conditional_t<sizeof(T) == 1, uint16_t, uint32_t>;
+
+    // Per-thread scratch: vertical sums at source width and one resampled row in
+    // NV12 / P010 form at output width. Grows to the largest plan seen, then reused.
+    template <typename T>
+    struct ScaleScratch
+    {
+        std::vector<ScaleAcc<T>> acc;  // Y plane, or whole packed row (YUY2 / Y210)
+        std::vector<ScaleAcc<T>> cacc; // interleaved UV plane (NV12 / P010)
+        std::vector<T> row;            // resampled Y followed by UV
+
+        void ensure(size_t accN, size_t caccN, size_t rowN)
+        {
+            if (acc.size() < accN)
+                acc.resize(accN);
+            if (cacc.size() < caccN)
+                cacc.resize(caccN);
+            if (row.size() < rowN)
+                row.resize(rowN);
+        }
+    };
+
+    static inline void vacc_row(const RowKernels &k, const uint8_t *src, uint16_t *acc, int n, int w)
+    {
+        for (int i = k.vacc8(src, acc, n, w); i < n; ++i)
+            acc[i] = (uint16_t)(acc[i] + src[i] * w);
+    }
+
+    static inline void vacc_row(const RowKernels &k, const uint16_t *src, uint32_t *acc, int n, int w)
+    {
+        for (int i = k.vacc10(src, acc, n, w); i < n; ++i)
+            acc[i] += (uint32_t)(src[i] >> 6) * (uint32_t)w;
+    }
+
+    // Weighted sum of the source rows feeding output row j. 10-bit words are
+    // reduced to their 10 significant bits first.
+    template <typename T>
+    static void vertical_pass(const RowKernels &k, const uint8_t *plane, int stride, const ScaleAxis &ax, int j,
+                              int elems, ScaleAcc<T> *acc)
+    {
+        const uint16_t *wt = ax.weight.data() + (size_t)j * ax.taps;
+        const uint8_t *row = plane + (size_t)ax.start[j] * (size_t)stride;
+        std::fill(acc, acc + elems, ScaleAcc<T>(0));
+        for (int t = 0; t < ax.taps; ++t, row += stride)
+        {
+            if (wt[t])
+                vacc_row(k, reinterpret_cast<const T *>(row), acc, elems, wt[t]);
+        }
+    }
+
+    // Where one component group sits in the vertical sums: sample i of lane l is
+    // acc[i * Step + l * LaneStride]. Luma is one lane; U and V share taps as two.
+    template <int Step, int Lanes, int LaneStride>
+    struct HGroup
+    {
+        static constexpr int step = Step;
+        static constexpr int lanes = Lanes;
+        static constexpr int lane_stride = LaneStride;
+    };
+    using PlanarLuma = HGroup<1, 1, 0>;
+    using PlanarChroma = HGroup<2, 2, 1>; // UV pairs
+    using PackedLuma = HGroup<2, 1, 0>;   // Y0 U Y1 V
+    using PackedChroma = HGroup<4, 2, 2>;
+
+    // Box axes read consecutive samples with one weight: no tap tables in the loop.
+    template <typename T, typename G, int F>
+    static void horizontal_box(const ScaleAcc<T> *acc, int count, T *out)
+    {
+        constexpr int shift = sizeof(T) == 2 ? 6 : 0;
+        for (int o = 0; o < count; ++o, acc += F * G::step, out += G::lanes)
+        {
+            for (int l = 0; l < G::lanes; ++l)
+            {
+                uint32_t s = 0;
+                for (int t = 0; t < F; ++t)
+                    s += acc[t * G::step + l * G::lane_stride];
+                out[l] = (T)(((s * (256 / F) + 32768) >> 16) << shift);
+            }
+        }
+    }
+
+    template <typename T, typename G>
+    static void horizontal_pass(const ScaleAcc<T> *acc, const ScaleAxis &ax, int count, T *out)
+    {
+        constexpr int shift = sizeof(T) == 2 ? 6 : 0;
+        if (ax.box)
+        {
+            switch (ax.taps)
+            {
+            case 1:
+                return horizontal_box<T, G, 1>(acc, count, out);
+            case 2:
+                return horizontal_box<T, G, 2>(acc, count, out);
+            case 4:
+                return horizontal_box<T, G, 4>(acc, count, out);
+            }
+        }
+        for (int o = 0; o < count; ++o, out += G::lanes)
+        {
+            const ScaleAcc<T> *p = acc + (size_t)ax.start[o] * G::step;
+            const uint16_t *wt = ax.weight.data() + (size_t)o * ax.taps;
+            for (int l = 0; l < G::lanes; ++l)
+            {
+                uint32_t s = 32768;
+                for (int t = 0; t < ax.taps; ++t)
+                    s += (uint32_t)p[t * G::step + l * G::lane_stride] * wt[t];
+                out[l] = (T)((s >> 16) << shift);
+            }
+        }
+    }
+
+    // Resamples rows [y0, y1) into the scratch row, then hands it to the regular
+    // NV12 / P010 row kernels: the matrix only ever runs at output resolution.
+    template <typename T>
+    static void scale_rows_band(void *ctx, int y0, int y1)
+    {
+        const ScaleJob &job = *static_cast<const ScaleJob *>(ctx);
+        const ScalePlan &sp = *job.sp;
+        const gcap::FrameConverter &cv = *job.cv;
+        const RowKernels &k = gcap::simd::active_kernels();
+
+        const bool packed = sp.layout == YuvLayout::Yuy2 || sp.layout == YuvLayout::Y210;
+        const int cw = (sp.src_width + 1) / 2;
+        const int dw = sp.dst_width;
+        const int dcw = (dw + 1) / 2;
+
+        thread_local ScaleScratch<T> s;
+        s.ensure(packed ? (size_t)cw * 4 : (size_t)sp.src_width, packed ? 0 : (size_t)cw * 2, (size_t)dcw * 4);
+        T *yOut = s.row.data();
+        T *uvOut = s.row.data() + (size_t)dcw * 2;
+
+        const YuvMatrix &m8 = cv.plan.matrix;
+        const YuvMatrix m10 = gcap::simd::to_10bit(cv.plan.matrix);
+
+        for (int j = y0; j < y1; ++j)
+        {
+            if (packed)
+            {
+                // Y0 U Y1 V: 4:2:2 chroma shares the luma rows.
+                vertical_pass<T>(k, job.src0, job.stride0, sp.luma_y, j, cw * 4, s.acc.data());
+                horizontal_pass<T, PackedLuma>(s.acc.data(), sp.luma_x, dw, yOut);
+                horizontal_pass<T, PackedChroma>(s.acc.data() + 1, sp.chroma_x, dcw, uvOut);
+            }
+            else
+            {
+                vertical_pass<T>(k, job.src0, job.stride0, sp.luma_y, j, sp.src_width, s.acc.data());
+                vertical_pass<T>(k, job.src1, job.stride1, sp.chroma_y, j, cw * 2, s.cacc.data());
+                horizontal_pass<T, PlanarLuma>(s.acc.data(), sp.luma_x, dw, yOut);
+                horizontal_pass<T, PlanarChroma>(s.cacc.data(), sp.chroma_x, dcw, uvOut);
+            }
+
+            uint8_t *out = job.dst + (size_t)j * (size_t)job.dstStride;
+            if constexpr (sizeof(T) == 1)
+            {
+                nv12_row_tail(yOut, uvOut, out, k.nv12(yOut, uvOut, out, dw, m8), dw, m8);
+            }
+            else
+            {
+                switch (cv.output)
+                {
+                case gcap::FrameOutput::Rgba64:
+                {
+                    uint16_t *dst = reinterpret_cast<uint16_t *>(out);
+                    p010_rgba64_row_tail(yOut, uvOut, dst, k.p010_rgba64(yOut, uvOut, dst, dw, m10), dw, m10);
+                    break;
+                }
+                case gcap::FrameOutput::X2R10G10B10:
+                {
+                    uint32_t *dst = reinterpret_cast<uint32_t *>(out);
+                    p010_x2rgb10_row_tail(yOut, uvOut, dst, k.p010_x2rgb10(yOut, uvOut, dst, dw, m10), dw, m10);
+                    break;
+                }
+                case gcap::FrameOutput::Bgra8Dither:
+                {
+                    const uint16_t *d = kDither8[j & 7];
+                    p010_dither_row_tail(yOut, uvOut, out, k.p010_dither(yOut, uvOut, out, dw, m10, d), dw, m10, d);
+                    break;
+                }
+                default:
+                    p010_row_tail(yOut, uvOut, out, k.p010(yOut, uvOut, out, dw, m8), dw, m8);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// ProcAmp plan
+// ------------------------------------------------------------
+gcap::simd::YuvMatrix gcap::yuv_matrix(gcap_colorspace_t csp, gcap_range_t range)
+{
+    double kr = 0.299, kb = 0.114; // BT.601
+    if (csp == GCAP_CSP_BT709)
+    {
+        kr = 0.2126;
+        kb = 0.0722;
+    }
+    else if (csp == GCAP_CSP_BT2020)
+    {
+        kr = 0.2627;
+        kb = 0.0593;
+    }
+    const double kg = 1.0 - kr - kb;
+
+    // Limited range: Y 16..235, C 16..240. Full range: both span 0..255.
+    const bool full = range == GCAP_RANGE_FULL;
+    const double ys = (full ? 1.0 : 255.0 / 219.0) * 256.0;
+    const double cs = (full ? 1.0 : 255.0 / 224.0) * 256.0;
+    auto q = [](double v)
+    { return (int16_t)std::lround(v); };
+
+    YuvMatrix m;
+    m.y_offset = full ? 0 : 16;
+    m.r = {q(ys), 0, q(2.0 * (1.0 - kr) * cs), 128, 0};
+    m.g = {q(ys), q(-2.0 * kb * (1.0 - kb) / kg * cs), q(-2.0 * kr * (1.0 - kr) / kg * cs), 128, 0};
+    m.b = {q(ys), q(2.0 * (1.0 - kb) * cs), 0, 128, 0};
+    return m;
 }
 
+gcap_colorspace_t gcap::default_colorspace(int height)
+{
+    return height >= 720 ? GCAP_CSP_BT709 : GCAP_CSP_BT601;
+}
 
-static inline void yuv_to_rgb(int Y, int U, int V, uint8_t &R, uint8_t &G, uint8_t &B)
+gcap::ProcAmpPlan gcap::build_procamp_plan(const ProcAmpParams &p)
 {
-    int C = Y - 16;
-    int D = U - 128;
-    int E = V - 128;
-    int r = (298 * C + 409 * E + 128) >> 8;
-    int g = (298 * C - 100 * D - 208 * E + 128) >> 8;
-    int b = (298 * C + 516 * D + 128) >> 8;
-    R = (uint8_t)std::clamp(r, 0, 255);
-    G = (uint8_t)std::clamp(g, 0, 255);
-    B = (uint8_t)std::clamp(b, 0, 255);
+    return build_procamp_plan(p, kBt601Limited);
 }
 
-// Hue: rotate chroma (U/V) around 128.
-static inline void apply_hue_to_uv(uint8_t &U, uint8_t &V, const gcap::ProcAmpParams &p)
+gcap::ProcAmpPlan gcap::build_procamp_plan(const ProcAmpParams &p, const simd::YuvMatrix &base)
 {
-    // Map 0..255 with 128 neutral to angle [-pi, +pi]
-    const float ang = (float(p.hue) - 128.0f) * (kPi / 128.0f);
-    const float cs = std::cos(ang);
-    const float sn = std::sin(ang);
+    ProcAmpPlan plan;
+    plan.matrix = base;
+    plan.sharpness = p.sharpness;
+    plan.color_neutral = (p.hue == 128 && p.brightness == 128 && p.contrast == 128 && p.saturation == 128);
+    if (plan.color_neutral)
+        return plan; // matrix stays the exact colorimetry reference
+
+    const simd::YuvChannelCoeffs *in[3] = {&base.r, &base.g, &base.b};
 
-    const float u = float(U) - 128.0f;
-    const float v = float(V) - 128.0f;
+    // Hue: rotate (D, E) by ang, i.e. D' = D*cs - E*sn, E' = D*sn + E*cs.
+    const double ang = (double(p.hue) - 128.0) * (kPi / 128.0);
+    const double cs = std::cos(ang);
+    const double sn = std::sin(ang);
+    double cu[3], cv[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        cu[i] = in[i]->u * cs + in[i]->v * sn;
+        cv[i] = -in[i]->u * sn + in[i]->v * cs;
+    }
+
+    // Saturation scales each channel's distance from gray = (R + G + B) / 3.
+    // Luma contributes equally to R/G/B, so only the chroma terms change.
+    const double sat = double(p.saturation) / 128.0;
+    const double mu = (cu[0] + cu[1] + cu[2]) / 3.0;
+    const double mv = (cv[0] + cv[1] + cv[2]) / 3.0;
+    for (int i = 0; i < 3; ++i)
+    {
+        cu[i] = mu + (cu[i] - mu) * sat;
+        cv[i] = mv + (cv[i] - mv) * sat;
+    }
 
-    const int u2 = int(u * cs - v * sn + 128.0f + 0.5f);
-    const int v2 = int(u * sn + v * cs + 128.0f + 0.5f);
+    // Contrast pivots around 128 and brightness is an offset of up to +-255;
+    // both are affine, so they scale the matrix and move its rounding term.
+    const double ct = double(p.contrast) / 128.0;
+    const double br = (double(p.brightness) - 128.0) / 128.0 * 255.0;
+    const int offset = (int)std::lround((128.0 - 128.0 * ct + br) * 256.0) + 128;
 
-    U = (uint8_t)std::clamp(u2, 0, 255);
-    V = (uint8_t)std::clamp(v2, 0, 255);
+    simd::YuvChannelCoeffs *out[3] = {&plan.matrix.r, &plan.matrix.g, &plan.matrix.b};
+    for (int i = 0; i < 3; ++i)
+    {
+        out[i]->y = (int16_t)std::lround(in[i]->y * ct);
+        out[i]->u = (int16_t)std::lround(cu[i] * ct);
+        out[i]->v = (int16_t)std::lround(cv[i] * ct);
+        out[i]->round = (int16_t)(offset & 255);
+        out[i]->bias = (int16_t)(offset >> 8); // arithmetic: floor for negative offsets
+    }
+    return plan;
 }
 
-// Brightness/Contrast/Saturation in RGB domain.
-static inline void apply_bcs_rgb(uint8_t &R, uint8_t &G, uint8_t &B, const gcap::ProcAmpParams &p)
+// ------------------------------------------------------------
+// Frame converter (selected once per media type / ProcAmp change)
+// ------------------------------------------------------------
+gcap::FrameConverter gcap::make_frame_converter(YuvLayout layout, gcap_colorspace_t csp, gcap_range_t range,
+                                                const ProcAmpParams &p, FrameOutput output)
 {
-    int r = R, g = G, b = B;
+    FrameConverter cv;
+    cv.layout = layout;
+    cv.output = is_10bit_layout(layout) ? output : FrameOutput::Bgra8;
+    cv.csp = csp == GCAP_CSP_UNKNOWN ? GCAP_CSP_BT601 : csp;
+    cv.range = range == GCAP_RANGE_FULL ? GCAP_RANGE_FULL : GCAP_RANGE_LIMITED;
+    cv.plan = build_procamp_plan(p, yuv_matrix(cv.csp, cv.range));
+    cv.run = frame_fn(layout, cv.plan, cv.output);
+    return cv;
+}
 
-    // Brightness: [-255..+255] roughly
-    const float br = (float(p.brightness) - 128.0f) / 128.0f * 255.0f;
-    // Contrast: [0..~2]
-    const float ct = float(p.contrast) / 128.0f;
+void gcap::convert_frame(const FrameConverter &cv, const uint8_t *src0, const uint8_t *src1,
+                         int stride0, int stride1, int width, int height,
+                         uint8_t *out, int outStride)
+{
+    // A default-constructed converter (no media type yet) still converts as BT.601 limited.
+    const FrameConvertFn fn = cv.run ? cv.run : frame_fn(cv.layout, cv.plan, cv.output);
+    fn(cv.plan, src0, src1, stride0, stride1, width, height, out, outStride);
+}
 
-    r = int((r - 128) * ct + 128 + br);
-    g = int((g - 128) * ct + 128 + br);
-    b = int((b - 128) * ct + 128 + br);
+const char *gcap::yuv_layout_name(YuvLayout layout)
+{
+    switch (layout)
+    {
+    case YuvLayout::Nv12:
+        return "NV12";
+    case YuvLayout::Yuy2:
+        return "YUY2";
+    case YuvLayout::Y210:
+        return "Y210";
+    case YuvLayout::P010:
+        return "P010";
+    case YuvLayout::V210:
+        return "V210";
+    }
+    return "?";
+}
 
-    // Saturation
-    const float sat = float(p.saturation) / 128.0f;
-    const int gray = (r + g + b) / 3;
-    r = int(gray + (r - gray) * sat);
-    g = int(gray + (g - gray) * sat);
-    b = int(gray + (b - gray) * sat);
+bool gcap::is_10bit_layout(YuvLayout layout)
+{
+    return layout == YuvLayout::Y210 || layout == YuvLayout::P010 || layout == YuvLayout::V210;
+}
 
-    R = (uint8_t)std::clamp(r, 0, 255);
-    G = (uint8_t)std::clamp(g, 0, 255);
-    B = (uint8_t)std::clamp(b, 0, 255);
+int gcap::frame_output_bytes_per_pixel(FrameOutput output)
+{
+    return output == FrameOutput::Rgba64 ? 8 : 4;
 }
 
-// Simple 3x3 unsharp mask (ARGB/BGRA buffer).
-// sharpness: 128 neutral; >128 sharpen; <128 soften.
-static void apply_sharpness_bgra(uint8_t *bgra, int w, int h, int stride, int sharpness)
+gcap_pixfmt_t gcap::frame_output_pixfmt(FrameOutput output)
 {
-    if (!bgra || w <= 2 || h <= 2)
-        return;
-    if (sharpness == 128)
-        return;
+    switch (output)
+    {
+    case FrameOutput::Rgba64:
+        return GCAP_FMT_RGBA64;
+    case FrameOutput::X2R10G10B10:
+        return GCAP_FMT_X2R10G10B10;
+    default:
+        return GCAP_FMT_ARGB;
+    }
+}
 
-    // amount in [-1.0..+1.0] approx
-    const float amt = (float(sharpness) - 128.0f) / 128.0f;
+const char *gcap::frame_output_name(FrameOutput output)
+{
+    switch (output)
+    {
+    case FrameOutput::Bgra8:
+        return "BGRA8";
+    case FrameOutput::Bgra8Dither:
+        return "BGRA8 dithered";
+    case FrameOutput::Rgba64:
+        return "RGBA64";
+    case FrameOutput::X2R10G10B10:
+        return "X2R10G10B10";
+    }
+    return "?";
+}
 
-    std::vector<uint8_t> src((size_t)h * (size_t)stride);
-    std::memcpy(src.data(), bgra, (size_t)h * (size_t)stride);
+// ------------------------------------------------------------
+// Fused resample + convert
+// ------------------------------------------------------------
+bool gcap::scale_supported(YuvLayout layout)
+{
+    return layout == YuvLayout::Nv12 || layout == YuvLayout::Yuy2 || layout == YuvLayout::Y210 || layout == YuvLayout::P010;
+}
 
-    auto at = [&](int x, int y, int c) -> int
+bool gcap::video_output_size(const gcap_video_output_t &vo, int srcWidth, int srcHeight, int &width, int &height)
+{
+    width = srcWidth;
+    height = srcHeight;
+    if (srcWidth <= 0 || srcHeight <= 0 || (vo.width <= 0 && vo.height <= 0))
+        return false;
+    if (vo.width > 0 && vo.height > 0)
     {
-        x = std::clamp(x, 0, w - 1);
-        y = std::clamp(y, 0, h - 1);
-        return src[(size_t)y * (size_t)stride + (size_t)x * 4 + (size_t)c];
-    };
-
-    for (int y = 0; y < h; ++y)
+        width = vo.width;
+        height = vo.height;
+    }
+    else if (vo.width > 0)
     {
-        uint8_t *dstRow = bgra + (size_t)y * (size_t)stride;
-        for (int x = 0; x < w; ++x)
-        {
-            // 3x3 box blur
-            int sumB = 0, sumG = 0, sumR = 0;
-            for (int ky = -1; ky <= 1; ++ky)
-            {
-                for (int kx = -1; kx <= 1; ++kx)
-                {
-                    sumB += at(x + kx, y + ky, 0);
-                    sumG += at(x + kx, y + ky, 1);
-                    sumR += at(x + kx, y + ky, 2);
-                }
-            }
-            const int blurB = (sumB + 4) / 9;
-            const int blurG = (sumG + 4) / 9;
-            const int blurR = (sumR + 4) / 9;
+        width = vo.width;
+        height = std::max(1, (int)(((int64_t)vo.width * srcHeight + srcWidth / 2) / srcWidth));
+    }
+    else
+    {
+        height = vo.height;
+        width = std::max(1, (int)(((int64_t)vo.height * srcWidth + srcHeight / 2) / srcHeight));
+    }
+    return width != srcWidth || height != srcHeight;
+}
 
-            const int origB = at(x, y, 0);
-            const int origG = at(x, y, 1);
-            const int origR = at(x, y, 2);
+gcap::ScalePlan gcap::make_scale_plan(YuvLayout layout, int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+                                      gcap_scale_filter_t filter)
+{
+    ScalePlan sp;
+    sp.layout = layout;
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 || !scale_supported(layout))
+        return sp;
 
-            int outB = int(origB + amt * float(origB - blurB));
-            int outG = int(origG + amt * float(origG - blurG));
-            int outR = int(origR + amt * float(origR - blurR));
+    sp.src_width = srcWidth;
+    sp.src_height = srcHeight;
+    sp.dst_width = dstWidth;
+    sp.dst_height = dstHeight;
 
-            dstRow[x * 4 + 0] = (uint8_t)std::clamp(outB, 0, 255);
-            dstRow[x * 4 + 1] = (uint8_t)std::clamp(outG, 0, 255);
-            dstRow[x * 4 + 2] = (uint8_t)std::clamp(outR, 0, 255);
-            dstRow[x * 4 + 3] = 255;
-        }
-    }
+    const bool exact = box_factor(srcWidth, dstWidth) && box_factor(srcHeight, dstHeight);
+    sp.filter = (filter != GCAP_SCALE_BILINEAR && exact) ? GCAP_SCALE_BOX : GCAP_SCALE_BILINEAR;
+    const bool box = sp.filter == GCAP_SCALE_BOX;
+
+    // Chroma is resampled on its own grid: half width always, half height for 4:2:0.
+    // Odd sizes can leave a chroma axis inexact; that axis alone falls back to the tent.
+    const bool subV = layout == YuvLayout::Nv12 || layout == YuvLayout::P010;
+    sp.luma_x = scale_axis(srcWidth, dstWidth, box);
+    sp.luma_y = scale_axis(srcHeight, dstHeight, box);
+    sp.chroma_x = scale_axis((srcWidth + 1) / 2, (dstWidth + 1) / 2, box);
+    if (subV)
+        sp.chroma_y = scale_axis((srcHeight + 1) / 2, dstHeight, box && srcHeight % 2 == 0 && srcHeight / 2 >= dstHeight);
+    return sp;
+}
+
+void gcap::convert_frame_scaled(const FrameConverter &cv, const ScalePlan &sp, const uint8_t *src0, const uint8_t *src1,
+                                int stride0, int stride1, uint8_t *out, int outStride)
+{
+    if (sp.dst_width <= 0 || sp.dst_height <= 0 || !src0 || !out)
+        return;
+    const ScaleJob job{&cv, &sp, src0, src1, stride0, stride1, out, outStride};
+    // Cost follows the source rows read, so the pool sizes bands by source width.
+    const RowBandFn fn = is_10bit_layout(sp.layout) ? scale_rows_band<uint16_t> : scale_rows_band<uint8_t>;
+    parallel_rows(sp.src_width, sp.dst_height, 1, fn, const_cast<ScaleJob *>(&job));
 }
 
+// ------------------------------------------------------------
+// NV12 → ARGB
+// ------------------------------------------------------------
 void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
                         int w, int h, int yStride, int uvStride,
                         uint8_t *out, int outStride)
 {
-    ProcAmpParams p; // neutral
-    nv12_to_argb(y, uv, w, h, yStride, uvStride, out, outStride, p);
+    nv12_to_argb(y, uv, w, h, yStride, uvStride, out, outStride, ProcAmpPlan{});
 }
 
 void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
@@ -142,43 +1334,15 @@ void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
                         uint8_t *out, int outStride,
                         const ProcAmpParams &p)
 {
-    for (int j = 0; j < h; ++j)
-    {
-        const uint8_t *yRow = y + j * yStride;
-        const uint8_t *uvRow = uv + (j / 2) * uvStride;
-        uint8_t *dst = out + j * outStride;
-
-        for (int i = 0; i < w; i += 2)
-        {
-            uint8_t Y1 = yRow[i], Y2 = yRow[i + 1];
-            uint8_t U = uvRow[i], V = uvRow[i + 1];
-
-            if (p.hue != 128)
-                apply_hue_to_uv(U, V, p);
-
-            uint8_t r, g, b;
-
-            yuv_to_rgb(Y1, U, V, r, g, b);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r, g, b, p);
-            dst[0] = b;
-            dst[1] = g;
-            dst[2] = r;
-            dst[3] = 255; // BGRA
-
-            yuv_to_rgb(Y2, U, V, r, g, b);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r, g, b, p);
-            dst[4] = b;
-            dst[5] = g;
-            dst[6] = r;
-            dst[7] = 255;
-            dst += 8;
-        }
-    }
+    nv12_to_argb(y, uv, w, h, yStride, uvStride, out, outStride, build_procamp_plan(p));
+}
 
-    if (p.sharpness != 128)
-        apply_sharpness_bgra(out, w, h, outStride, p.sharpness);
+void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride,
+                        const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::Nv12, plan)(plan, y, uv, yStride, uvStride, w, h, out, outStride);
 }
 
 // ------------------------------------------------------------
@@ -189,8 +1353,7 @@ void gcap::yuy2_to_argb(const uint8_t *yuy2,
                         int strideYUY2,
                         uint8_t *outARGB, int outStride)
 {
-    ProcAmpParams p;
-    yuy2_to_argb(yuy2, width, height, strideYUY2, outARGB, outStride, p);
+    yuy2_to_argb(yuy2, width, height, strideYUY2, outARGB, outStride, ProcAmpPlan{});
 }
 
 void gcap::yuy2_to_argb(const uint8_t *yuy2,
@@ -199,55 +1362,20 @@ void gcap::yuy2_to_argb(const uint8_t *yuy2,
                         uint8_t *outARGB, int outStride,
                         const ProcAmpParams &p)
 {
-    for (int y = 0; y < height; y++)
-    {
-        const uint8_t *src = yuy2 + y * strideYUY2;
-        uint8_t *dst = outARGB + y * outStride;
-
-        for (int x = 0; x < width; x += 2)
-        {
-            int Y0 = src[0];
-            uint8_t U = src[1];
-            int Y1 = src[2];
-            uint8_t V = src[3];
-
-            if (p.hue != 128)
-                apply_hue_to_uv(U, V, p);
-
-            uint8_t r0, g0, b0;
-            uint8_t r1, g1, b1;
-
-            yuv_to_rgb(Y0, U, V, r0, g0, b0);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r0, g0, b0, p);
-
-            yuv_to_rgb(Y1, U, V, r1, g1, b1);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r1, g1, b1, p);
-
-            // pixel 0
-            dst[0] = b0;
-            dst[1] = g0;
-            dst[2] = r0;
-            dst[3] = 255; // BGRA
-
-            // pixel 1
-            dst[4] = b1;
-            dst[5] = g1;
-            dst[6] = r1;
-            dst[7] = 255;
-
-            src += 4;
-            dst += 8;
-        }
-    }
+    yuy2_to_argb(yuy2, width, height, strideYUY2, outARGB, outStride, build_procamp_plan(p));
+}
 
-    if (p.sharpness != 128)
-        apply_sharpness_bgra(outARGB, width, height, outStride, p.sharpness);
+void gcap::yuy2_to_argb(const uint8_t *yuy2,
+                        int width, int height,
+                        int strideYUY2,
+                        uint8_t *outARGB, int outStride,
+                        const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::Yuy2, plan)(plan, yuy2, nullptr, strideYUY2, 0, width, height, outARGB, outStride);
 }
 
 // ------------------------------------------------------------
-// Y210 (YUV422 10-bit packed) → ARGB
+// Y210 (YUV422 10-bit packed) → ARGB / RGBA64
 // layout per 2 pixels: Y0 U Y1 V, each component stored in 16-bit container
 // ------------------------------------------------------------
 void gcap::y210_to_argb(const uint8_t *y210,
@@ -255,8 +1383,7 @@ void gcap::y210_to_argb(const uint8_t *y210,
                         int strideY210,
                         uint8_t *outARGB, int outStride)
 {
-    ProcAmpParams p;
-    y210_to_argb(y210, width, height, strideY210, outARGB, outStride, p);
+    y210_to_argb(y210, width, height, strideY210, outARGB, outStride, ProcAmpPlan{});
 }
 
 void gcap::y210_to_argb(const uint8_t *y210,
@@ -265,53 +1392,147 @@ void gcap::y210_to_argb(const uint8_t *y210,
                         uint8_t *outARGB, int outStride,
                         const ProcAmpParams &p)
 {
-    for (int y = 0; y < height; ++y)
-    {
-        const uint16_t *src = reinterpret_cast<const uint16_t *>(y210 + (size_t)y * (size_t)strideY210);
-        uint8_t *dst = outARGB + (size_t)y * (size_t)outStride;
+    y210_to_argb(y210, width, height, strideY210, outARGB, outStride, build_procamp_plan(p));
+}
 
-        for (int x = 0; x < width; x += 2)
-        {
-            const int base = x * 2;
-            // Y210 WORD layout is Y0 U Y1 V; each component is 10-bit left-aligned.
-            const int Y0 = (int)(normalize_y210_word(src[base + 0]) * 255u + 511u) / 1023;
-            uint8_t U = (uint8_t)((normalize_y210_word(src[base + 1]) * 255u + 511u) / 1023);
-            const int Y1 = (x + 1 < width)
-                               ? (int)((normalize_y210_word(src[base + 2]) * 255u + 511u) / 1023)
-                               : Y0;
-            uint8_t V = (uint8_t)((normalize_y210_word(src[base + 3]) * 255u + 511u) / 1023);
+void gcap::y210_to_argb(const uint8_t *y210,
+                        int width, int height,
+                        int strideY210,
+                        uint8_t *outARGB, int outStride,
+                        const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::Y210, plan)(plan, y210, nullptr, strideY210, 0, width, height, outARGB, outStride);
+}
 
-            if (p.hue != 128)
-                apply_hue_to_uv(U, V, p);
+void gcap::y210_to_rgba64(const uint8_t *y210,
+                          int width, int height,
+                          int strideY210,
+                          uint8_t *out, int outStride,
+                          const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::Y210, plan, FrameOutput::Rgba64)(plan, y210, nullptr, strideY210, 0, width, height, out, outStride);
+}
+
+// ------------------------------------------------------------
+// P010 (YUV420 10-bit, MSB-aligned words) → ARGB / RGBA64
+// Y plane followed by interleaved UV at half height; strides in bytes.
+// ------------------------------------------------------------
+void gcap::p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride)
+{
+    p010_to_argb(y, uv, w, h, yStride, uvStride, out, outStride, ProcAmpPlan{});
+}
 
-            uint8_t r0, g0, b0;
-            uint8_t r1, g1, b1;
+void gcap::p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride,
+                        const ProcAmpParams &p)
+{
+    p010_to_argb(y, uv, w, h, yStride, uvStride, out, outStride, build_procamp_plan(p));
+}
 
-            yuv_to_rgb(Y0, U, V, r0, g0, b0);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r0, g0, b0, p);
+void gcap::p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride,
+                        const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::P010, plan)(plan, y, uv, yStride, uvStride, w, h, out, outStride);
+}
 
-            yuv_to_rgb(Y1, U, V, r1, g1, b1);
-            if (p.brightness != 128 || p.contrast != 128 || p.saturation != 128)
-                apply_bcs_rgb(r1, g1, b1, p);
+void gcap::p010_to_rgba64(const uint8_t *y, const uint8_t *uv,
+                          int w, int h, int yStride, int uvStride,
+                          uint8_t *out, int outStride,
+                          const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::P010, plan, FrameOutput::Rgba64)(plan, y, uv, yStride, uvStride, w, h, out, outStride);
+}
 
-            dst[0] = b0;
-            dst[1] = g0;
-            dst[2] = r0;
-            dst[3] = 255;
+// ------------------------------------------------------------
+// V210 (YUV422 10-bit, 6 pixels per 16 bytes) → planar / P210 / P010 / ARGB / RGBA64
+// ------------------------------------------------------------
+int gcap::v210_row_bytes(int width)
+{
+    return ((width + 47) / 48) * 128;
+}
 
-            if (x + 1 < width)
-            {
-                dst[4] = b1;
-                dst[5] = g1;
-                dst[6] = r1;
-                dst[7] = 255;
-            }
+void gcap::v210_unpack(const uint8_t *v210, int width, int height, int v210Stride,
+                       uint16_t *y, int yStride, uint16_t *u, int uStride, uint16_t *v, int vStride)
+{
+    const RepackJob job{v210, v210Stride, width, height,
+                        reinterpret_cast<uint8_t *>(y), yStride,
+                        reinterpret_cast<uint8_t *>(u), uStride,
+                        reinterpret_cast<uint8_t *>(v), vStride};
+    parallel_rows(width, height, 1, v210_planar_band, const_cast<RepackJob *>(&job));
+}
 
-            dst += 8;
-        }
-    }
+void gcap::v210_to_p210(const uint8_t *v210, int width, int height, int v210Stride,
+                        uint8_t *y, int yStride, uint8_t *uv, int uvStride)
+{
+    const RepackJob job{v210, v210Stride, width, height, y, yStride, uv, uvStride, nullptr, 0};
+    parallel_rows(width, height, 1, v210_p210_band, const_cast<RepackJob *>(&job));
+}
 
-    if (p.sharpness != 128)
-        apply_sharpness_bgra(outARGB, width, height, outStride, p.sharpness);
+void gcap::v210_to_p010(const uint8_t *v210, int width, int height, int v210Stride,
+                        uint8_t *y, int yStride, uint8_t *uv, int uvStride)
+{
+    const RepackJob job{v210, v210Stride, width, height, y, yStride, uv, uvStride, nullptr, 0};
+    parallel_rows(width, height, 2, v210_p010_band, const_cast<RepackJob *>(&job));
+}
+
+void gcap::v210_to_argb(const uint8_t *v210,
+                        int width, int height,
+                        int strideV210,
+                        uint8_t *outARGB, int outStride)
+{
+    v210_to_argb(v210, width, height, strideV210, outARGB, outStride, ProcAmpPlan{});
+}
+
+void gcap::v210_to_argb(const uint8_t *v210,
+                        int width, int height,
+                        int strideV210,
+                        uint8_t *outARGB, int outStride,
+                        const ProcAmpParams &p)
+{
+    v210_to_argb(v210, width, height, strideV210, outARGB, outStride, build_procamp_plan(p));
+}
+
+void gcap::v210_to_argb(const uint8_t *v210,
+                        int width, int height,
+                        int strideV210,
+                        uint8_t *outARGB, int outStride,
+                        const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::V210, plan)(plan, v210, nullptr, strideV210, 0, width, height, outARGB, outStride);
+}
+
+void gcap::v210_to_rgba64(const uint8_t *v210,
+                          int width, int height,
+                          int strideV210,
+                          uint8_t *out, int outStride,
+                          const ProcAmpPlan &plan)
+{
+    frame_fn(YuvLayout::V210, plan, FrameOutput::Rgba64)(plan, v210, nullptr, strideV210, 0, width, height, out, outStride);
+}
+
+// ------------------------------------------------------------
+// R210 (big-endian x2:R10:G10:B10) → ARGB / RGBA64
+// ------------------------------------------------------------
+int gcap::r210_row_bytes(int width)
+{
+    return ((width + 63) / 64) * 256;
+}
+
+void gcap::r210_to_argb(const uint8_t *r210, int width, int height, int strideR210,
+                        uint8_t *outARGB, int outStride)
+{
+    const RepackJob job{r210, strideR210, width, height, outARGB, outStride, nullptr, 0, nullptr, 0};
+    parallel_rows(width, height, 1, r210_argb_band, const_cast<RepackJob *>(&job));
+}
+
+void gcap::r210_to_rgba64(const uint8_t *r210, int width, int height, int strideR210,
+                          uint8_t *out, int outStride)
+{
+    const RepackJob job{r210, strideR210, width, height, out, outStride, nullptr, 0, nullptr, 0};
+    parallel_rows(width, height, 1, r210_rgba64_band, const_cast<RepackJob *>(&job));
 }
@@ -1,6 +1,9 @@
 // frame_converter.h
 #pragma once
 #include <cstdint>
+#include <vector>
+#include "gcapture.h"
+#include "frame_converter_simd.h"
 
 namespace gcap
 {
@@ -17,6 +20,135 @@ namespace gcap
         int sharpness = 128;  // 0..255, 128 neutral
     };
 
+    /**
+     * ProcAmp compiled into the fixed-point YUV→RGB matrix.
+     * Hue rotation, saturation, contrast and brightness are folded into the
+     * coefficients, so converting with a plan costs the same as neutral.
+     * Build it once when the ProcAmp settings change, not per frame.
+     */
+    struct ProcAmpPlan
+    {
+        simd::YuvMatrix matrix; // default: BT.601 limited, neutral
+        int sharpness = 128;
+        bool color_neutral = true;
+    };
+
+    // Fixed-point YUV→RGB matrix for a colour space / range. GCAP_CSP_UNKNOWN
+    // maps to BT.601 and GCAP_RANGE_UNKNOWN to limited range.
+    simd::YuvMatrix yuv_matrix(gcap_colorspace_t csp, gcap_range_t range);
+
+    // Colour space to assume when the source does not signal one:
+    // BT.601 below 720 lines, BT.709 otherwise.
+    gcap_colorspace_t default_colorspace(int height);
+
+    // ProcAmp folded into `base` (BT.601 limited when omitted).
+    ProcAmpPlan build_procamp_plan(const ProcAmpParams &p);
+    ProcAmpPlan build_procamp_plan(const ProcAmpParams &p, const simd::YuvMatrix &base);
+
+    enum class YuvLayout
+    {
+        Nv12,
+        Yuy2,
+        Y210,
+        P010,
+        V210
+    };
+
+    /**
+     * What a FrameConverter writes. The deep outputs run the matrix at 10 bits and
+     * apply to the 10-bit layouts (Y210 / P010 / V210); 8-bit layouts always give Bgra8.
+     * Sharpness is only applied on Bgra8.
+     */
+    enum class FrameOutput
+    {
+        Bgra8,       // BGRA bytes (GCAP_FMT_ARGB)
+        Bgra8Dither, // BGRA bytes with an 8x8 ordered dither from the 10-bit result (GCAP_FMT_ARGB)
+        Rgba64,      // R, G, B, A as 16-bit UNORM words (GCAP_FMT_RGBA64)
+        X2R10G10B10  // one dword per pixel: B bits 0-9, G 10-19, R 20-29, top bits set (GCAP_FMT_X2R10G10B10)
+    };
+
+    using FrameConvertFn = void (*)(const ProcAmpPlan &plan, const uint8_t *src0, const uint8_t *src1,
+                                    int stride0, int stride1, int width, int height,
+                                    uint8_t *out, int outStride);
+
+    /**
+     * Converter resolved once per negotiated media type or ProcAmp change.
+     * Colour space, range and ProcAmp are folded into plan.matrix; layout and
+     * sharpen select a template-specialised frame routine, so the per-row path
+     * carries no format or feature branches.
+     */
+    struct FrameConverter
+    {
+        YuvLayout layout = YuvLayout::Nv12;
+        FrameOutput output = FrameOutput::Bgra8;
+        gcap_colorspace_t csp = GCAP_CSP_BT601;
+        gcap_range_t range = GCAP_RANGE_LIMITED;
+        ProcAmpPlan plan;
+        FrameConvertFn run = nullptr;
+    };
+
+    FrameConverter make_frame_converter(YuvLayout layout, gcap_colorspace_t csp, gcap_range_t range,
+                                        const ProcAmpParams &p, FrameOutput output = FrameOutput::Bgra8);
+
+    // src1 is the interleaved UV plane for NV12 / P010 and ignored for packed layouts (YUY2, Y210, V210).
+    // `out` holds frame_output_bytes_per_pixel(cv.output) bytes per pixel.
+    void convert_frame(const FrameConverter &cv, const uint8_t *src0, const uint8_t *src1,
+                       int stride0, int stride1, int width, int height,
+                       uint8_t *out, int outStride);
+
+    const char *yuv_layout_name(YuvLayout layout);
+
+    /**
+     * Resampling taps for convert_frame_scaled(), built once per (source size,
+     * output size). Output sample o is the weighted sum of source samples
+     * [start[o], start[o] + taps) with 8-bit weights summing to 256; rows and
+     * columns are filtered separately in YUV, so the matrix kernels only ever see
+     * output-size rows.
+     */
+    struct ScaleAxis
+    {
+        int taps = 0;
+        bool box = false;             // start = out * taps, every weight 256 / taps
+        std::vector<int32_t> start;   // [out], window kept inside the source
+        std::vector<uint16_t> weight; // [out * taps + t]
+    };
+
+    struct ScalePlan
+    {
+        YuvLayout layout = YuvLayout::Nv12;
+        int src_width = 0, src_height = 0;
+        int dst_width = 0, dst_height = 0;
+        gcap_scale_filter_t filter = GCAP_SCALE_BILINEAR; // resolved: BOX or BILINEAR
+        ScaleAxis luma_x, luma_y;
+        ScaleAxis chroma_x, chroma_y; // per output chroma pair / chroma row
+    };
+
+    // Layouts convert_frame_scaled() accepts: NV12, YUY2, P010 and Y210.
+    bool scale_supported(YuvLayout layout);
+
+    // Resolves a gcap_video_output_t against the source size: a zero dimension follows
+    // the source aspect ratio from the other one, both zero means the source size.
+    // Returns false when the result is the source size (nothing to resample).
+    bool video_output_size(const gcap_video_output_t &vo, int srcWidth, int srcHeight, int &width, int &height);
+
+    // GCAP_SCALE_BOX / AUTO pick a box filter when both axes shrink by exactly 2 or 4
+    // and bilinear otherwise.
+    ScalePlan make_scale_plan(YuvLayout layout, int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+                              gcap_scale_filter_t filter);
+
+    // Converts and resizes in one pass into sp.dst_width x sp.dst_height (cv.output format;
+    // sharpness is not applied). Source arguments are as for convert_frame().
+    void convert_frame_scaled(const FrameConverter &cv, const ScalePlan &sp, const uint8_t *src0, const uint8_t *src1,
+                              int stride0, int stride1, uint8_t *out, int outStride);
+
+    bool is_10bit_layout(YuvLayout layout);
+    int frame_output_bytes_per_pixel(FrameOutput output);
+    gcap_pixfmt_t frame_output_pixfmt(FrameOutput output);
+    const char *frame_output_name(FrameOutput output);
+
+    // Name of the row-kernel set picked for this CPU ("AVX2", "SSE4.1", "NEON", "Scalar").
+    const char *converter_kernel_name();
+
     // NV12 → ARGB
     void nv12_to_argb(const uint8_t *y, const uint8_t *uv,
                       int width, int height, int yStride, int uvStride,
@@ -28,6 +160,12 @@ namespace gcap
                       uint8_t *outARGB, int outStride,
                       const ProcAmpParams &p);
 
+    // NV12 → ARGB + precompiled ProcAmp plan (preferred in capture loops)
+    void nv12_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpPlan &plan);
+
     // YUY2 → ARGB
     void yuy2_to_argb(const uint8_t *yuy2,
                       int width, int height, int yuy2Stride,
@@ -39,6 +177,12 @@ namespace gcap
                       uint8_t *outARGB, int outStride,
                       const ProcAmpParams &p);
 
+    // YUY2 → ARGB + precompiled ProcAmp plan (preferred in capture loops)
+    void yuy2_to_argb(const uint8_t *yuy2,
+                      int width, int height, int yuy2Stride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpPlan &plan);
+
     // Y210 (YUV422 10-bit packed) → ARGB
     void y210_to_argb(const uint8_t *y210,
                       int width, int height, int y210Stride,
@@ -49,4 +193,90 @@ namespace gcap
                       int width, int height, int y210Stride,
                       uint8_t *outARGB, int outStride,
                       const ProcAmpParams &p);
+
+    // Y210 → ARGB + precompiled ProcAmp plan (preferred in capture loops)
+    void y210_to_argb(const uint8_t *y210,
+                      int width, int height, int y210Stride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpPlan &plan);
+
+    // Y210 → RGBA64, same rules as p010_to_rgba64().
+    void y210_to_rgba64(const uint8_t *y210,
+                        int width, int height, int y210Stride,
+                        uint8_t *outRGBA64, int outStride,
+                        const ProcAmpPlan &plan);
+
+    // P010 (YUV420 10-bit) → ARGB
+    void p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride);
+
+    // P010 → ARGB + ProcAmp
+    void p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpParams &p);
+
+    // P010 → ARGB + precompiled ProcAmp plan (preferred in capture loops)
+    void p010_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpPlan &plan);
+
+    // P010 → RGBA64 (R, G, B, A as 16-bit words) keeping all 10 bits.
+    // Colour space, range and ProcAmp colour terms apply as for ARGB;
+    // sharpness is an 8-bit display filter and is not applied here.
+    void p010_to_rgba64(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStride, int uvStride,
+                        uint8_t *outRGBA64, int outStride,
+                        const ProcAmpPlan &plan);
+
+    // V210 (YUV422 10-bit, 6 pixels per 16-byte group). Rows are padded to whole
+    // 48-pixel blocks; v210_row_bytes() gives the usual stride for a width.
+    int v210_row_bytes(int width);
+
+    // V210 → planar 16-bit Y / U / V with the 10-bit value in the low bits
+    // (U and V rows hold (width + 1) / 2 samples). Strides in bytes.
+    void v210_unpack(const uint8_t *v210, int width, int height, int v210Stride,
+                     uint16_t *y, int yStride, uint16_t *u, int uStride, uint16_t *v, int vStride);
+
+    // V210 → P210 / P010 (MSB-aligned words; UV rows hold (width + 1) & ~1 words).
+    // P010 chroma is the rounded mean of each source row pair.
+    void v210_to_p210(const uint8_t *v210, int width, int height, int v210Stride,
+                      uint8_t *y, int yStride, uint8_t *uv, int uvStride);
+    void v210_to_p010(const uint8_t *v210, int width, int height, int v210Stride,
+                      uint8_t *y, int yStride, uint8_t *uv, int uvStride);
+
+    // V210 → ARGB
+    void v210_to_argb(const uint8_t *v210,
+                      int width, int height, int v210Stride,
+                      uint8_t *outARGB, int outStride);
+
+    // V210 → ARGB + ProcAmp
+    void v210_to_argb(const uint8_t *v210,
+                      int width, int height, int v210Stride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpParams &p);
+
+    // V210 → ARGB + precompiled ProcAmp plan (preferred in capture loops)
+    void v210_to_argb(const uint8_t *v210,
+                      int width, int height, int v210Stride,
+                      uint8_t *outARGB, int outStride,
+                      const ProcAmpPlan &plan);
+
+    // V210 → RGBA64, same rules as p010_to_rgba64().
+    void v210_to_rgba64(const uint8_t *v210,
+                        int width, int height, int v210Stride,
+                        uint8_t *outRGBA64, int outStride,
+                        const ProcAmpPlan &plan);
+
+    // R210 (big-endian dword per pixel: 2 pad bits, R, G, B at 10 bits). Rows are
+    // padded to 64-pixel blocks; r210_row_bytes() gives the usual stride.
+    int r210_row_bytes(int width);
+
+    // R210 → ARGB (BGRA bytes) / RGBA64. RGB input: ProcAmp does not apply.
+    void r210_to_argb(const uint8_t *r210, int width, int height, int r210Stride,
+                      uint8_t *outARGB, int outStride);
+    void r210_to_rgba64(const uint8_t *r210, int width, int height, int r210Stride,
+                        uint8_t *outRGBA64, int outStride);
 }
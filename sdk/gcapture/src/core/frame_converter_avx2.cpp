@@ -0,0 +1,527 @@
+// frame_converter_avx2.cpp
+// AVX2 row kernels: 16 pixels per iteration.
+// Built with -mavx2 on GCC/Clang and /arch:AVX2 on MSVC; only entered after the CPUID check.
+#include "frame_converter_simd.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+
+namespace
+{
+    using gcap::simd::YuvChannelCoeffs;
+    using gcap::simd::YuvMatrix;
+
+    struct ChannelVec
+    {
+        __m256i yu;   // (y, u) pairs for _mm256_madd_epi16
+        __m256i vr;   // (v, round) pairs
+        __m256i bias; // added after >> 8
+    };
+
+    static inline ChannelVec load_channel(const YuvChannelCoeffs &c)
+    {
+        ChannelVec out;
+        out.yu = _mm256_set1_epi32((int)((uint32_t)(uint16_t)c.y | ((uint32_t)(uint16_t)c.u << 16)));
+        out.vr = _mm256_set1_epi32((int)((uint32_t)(uint16_t)c.v | ((uint32_t)(uint16_t)c.round << 16)));
+        out.bias = _mm256_set1_epi16(c.bias);
+        return out;
+    }
+
+    struct MatrixVec
+    {
+        __m256i yoff;
+        ChannelVec r, g, b;
+    };
+
+    static inline MatrixVec load_matrix(const YuvMatrix &m)
+    {
+        MatrixVec out;
+        out.yoff = _mm256_set1_epi16(m.y_offset);
+        out.r = load_channel(m.r);
+        out.g = load_channel(m.g);
+        out.b = load_channel(m.b);
+        return out;
+    }
+
+    // unpacklo/hi work per 128-bit lane, so lo = pixels 0-3 / 8-11 and hi = 4-7 / 12-15;
+    // packs_epi32 puts them back in order.
+    static inline __m256i channel16(__m256i cdLo, __m256i cdHi, __m256i e1Lo, __m256i e1Hi, const ChannelVec &k, __m256i maxv)
+    {
+        __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(cdLo, k.yu), _mm256_madd_epi16(e1Lo, k.vr));
+        __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(cdHi, k.yu), _mm256_madd_epi16(e1Hi, k.vr));
+        lo = _mm256_srai_epi32(lo, 8);
+        hi = _mm256_srai_epi32(hi, 8);
+        __m256i v = _mm256_adds_epi16(_mm256_packs_epi32(lo, hi), k.bias);
+        return _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), maxv);
+    }
+
+    // R, G, B for 16 pixels, clamped to 0..maxv; `center` is the chroma midpoint (128, or 512 for 10-bit).
+    static inline void rgb16(__m256i y, __m256i u, __m256i v, const MatrixVec &k, short center, short maxv,
+                             __m256i &r, __m256i &g, __m256i &b)
+    {
+        const __m256i c = _mm256_sub_epi16(y, k.yoff);
+        const __m256i d = _mm256_sub_epi16(u, _mm256_set1_epi16(center));
+        const __m256i e = _mm256_sub_epi16(v, _mm256_set1_epi16(center));
+        const __m256i one = _mm256_set1_epi16(1);
+        const __m256i mx = _mm256_set1_epi16(maxv);
+
+        const __m256i cdLo = _mm256_unpacklo_epi16(c, d);
+        const __m256i cdHi = _mm256_unpackhi_epi16(c, d);
+        const __m256i e1Lo = _mm256_unpacklo_epi16(e, one);
+        const __m256i e1Hi = _mm256_unpackhi_epi16(e, one);
+
+        r = channel16(cdLo, cdHi, e1Lo, e1Hi, k.r, mx);
+        g = channel16(cdLo, cdHi, e1Lo, e1Hi, k.g, mx);
+        b = channel16(cdLo, cdHi, e1Lo, e1Hi, k.b, mx);
+    }
+
+    // y/u/v: 16 pixels as unsigned 8-bit values in 16-bit lanes (u/v already upsampled).
+    static inline void store_bgra16(__m256i y, __m256i u, __m256i v, const MatrixVec &k, uint8_t *dst)
+    {
+        __m256i r, g, b;
+        rgb16(y, u, v, k, 128, 255, r, g, b);
+
+        const __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+        const __m256i ra = _mm256_or_si256(r, _mm256_set1_epi16((short)0xFF00));
+        const __m256i lo = _mm256_unpacklo_epi16(bg, ra); // pixels 0-3 | 8-11
+        const __m256i hi = _mm256_unpackhi_epi16(bg, ra); // pixels 4-7 | 12-15
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    // 32 bytes of YUY2 (16 pixels) -> Y, U, V in 16-bit lanes.
+    static inline void split_yuy2(__m256i px, __m256i &y, __m256i &u, __m256i &v)
+    {
+        const __m256i shufY = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i shufUV = _mm256_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, 3, 3, 7, 7, 11, 11, 15, 15,
+                                                1, 1, 5, 5, 9, 9, 13, 13, 3, 3, 7, 7, 11, 11, 15, 15);
+        // Gather the per-lane results: qwords (0, 2) hold Y, (0, 2) / (1, 3) hold U / V.
+        const __m256i ys = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(px, shufY), 0x08);
+        const __m256i uvs = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(px, shufUV), 0xD8);
+        y = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(ys));
+        u = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(uvs));
+        v = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(uvs, 1));
+    }
+
+    // Y210 WORD -> 8-bit, bit-exact with (n * 255 + 511) / 1023 for n = word >> 6.
+    static inline __m256i y210_to_8bit(__m256i w)
+    {
+        const __m256i n6 = _mm256_and_si256(w, _mm256_set1_epi16((short)0xFFC0));
+        const __m256i m = _mm256_mulhi_epu16(n6, _mm256_set1_epi16(1021));
+        return _mm256_srli_epi16(_mm256_add_epi16(m, _mm256_set1_epi16(2)), 2);
+    }
+
+    int nv12_row_avx2(const uint8_t *yRow, const uint8_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const __m128i shufU = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, 8, 8, 10, 10, 12, 12, 14, 14);
+        const __m128i shufV = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, 9, 9, 11, 11, 13, 13, 15, 15);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x)));
+            const __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uvRow + x));
+            const __m256i u = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(uv, shufU));
+            const __m256i v = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(uv, shufV));
+            store_bgra16(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int yuy2_row_avx2(const uint8_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i y, u, v;
+            split_yuy2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 2)), y, u, v);
+            store_bgra16(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int y210_row_avx2(const uint16_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const __m256i a = y210_to_8bit(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 2)));
+            const __m256i b = y210_to_8bit(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 2 + 16)));
+            // packus interleaves lanes: qwords are pixels 0-3, 8-11, 4-7, 12-15.
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            __m256i y, u, v;
+            split_yuy2(packed, y, u, v);
+            store_bgra16(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int hsum3_row_avx2(const uint8_t *bgra, uint16_t *out, int count)
+    {
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const __m256i l = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i - 4)));
+            const __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i)));
+            const __m256i r = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i + 4)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_add_epi16(_mm256_add_epi16(l, c), r));
+        }
+        return n;
+    }
+
+    // 16 lanes of the unsharp mask; o holds the original bytes widened to 16 bits.
+    static inline __m256i unsharp16(__m256i o, const uint16_t *up, const uint16_t *mid, const uint16_t *down, __m256i amt)
+    {
+        __m256i sum = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(up)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mid)));
+        sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(down)));
+        const __m256i blur = _mm256_mulhi_epu16(_mm256_add_epi16(sum, _mm256_set1_epi16(4)), _mm256_set1_epi16(7282));
+        const __m256i delta = _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(o, blur), amt), 7);
+        return _mm256_add_epi16(o, delta);
+    }
+
+    int unsharp_row_avx2(const uint8_t *orig, const uint16_t *up, const uint16_t *mid, const uint16_t *down,
+                         uint8_t *dst, int count, int amount)
+    {
+        const __m256i amt = _mm256_set1_epi16((short)amount);
+        const int n = count & ~31;
+        for (int i = 0; i < n; i += 32)
+        {
+            const __m256i lo = unsharp16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(orig + i))),
+                                         up + i, mid + i, down + i, amt);
+            const __m256i hi = unsharp16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(orig + i + 16))),
+                                         up + i + 16, mid + i + 16, down + i + 16, amt);
+            // packus works per lane; 0xD8 restores byte order.
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+        }
+        return n;
+    }
+
+    int vacc8_row_avx2(const uint8_t *src, uint16_t *acc, int count, int weight)
+    {
+        const __m256i w = _mm256_set1_epi16((short)weight);
+        const int n = count & ~31;
+        for (int i = 0; i < n; i += 32)
+        {
+            const __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+            const __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 16)));
+            __m256i *a = reinterpret_cast<__m256i *>(acc + i);
+            // Products stay below 65536, so the low half of the multiply is the whole product.
+            _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), _mm256_mullo_epi16(lo, w)));
+            _mm256_storeu_si256(a + 1, _mm256_add_epi16(_mm256_loadu_si256(a + 1), _mm256_mullo_epi16(hi, w)));
+        }
+        return n;
+    }
+
+    int vacc10_row_avx2(const uint16_t *src, uint32_t *acc, int count, int weight)
+    {
+        const __m256i w = _mm256_set1_epi32(weight); // (weight, 0) word pairs for madd
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const __m256i lo = _mm256_cvtepu16_epi32(_mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), 6));
+            const __m256i hi = _mm256_cvtepu16_epi32(_mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8)), 6));
+            __m256i *a = reinterpret_cast<__m256i *>(acc + i);
+            _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), _mm256_madd_epi16(lo, w)));
+            _mm256_storeu_si256(a + 1, _mm256_add_epi32(_mm256_loadu_si256(a + 1), _mm256_madd_epi16(hi, w)));
+        }
+        return n;
+    }
+
+    // P010 UV words already pair up with pixel pairs inside each 128-bit lane; just duplicate them.
+    static inline void split_p010_uv(__m256i uv, __m256i &u, __m256i &v)
+    {
+        const __m256i dupU = _mm256_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13,
+                                              0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+        const __m256i dupV = _mm256_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15,
+                                              2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+        u = _mm256_shuffle_epi8(uv, dupU);
+        v = _mm256_shuffle_epi8(uv, dupV);
+    }
+
+    int p010_row_avx2(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const __m256i y = y210_to_8bit(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(yRow + x)));
+            __m256i u, v;
+            split_p010_uv(y210_to_8bit(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(uvRow + x))), u, v);
+            store_bgra16(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    // 10-bit -> 16-bit UNORM by bit replication.
+    static inline __m256i widen10(__m256i v)
+    {
+        return _mm256_or_si256(_mm256_slli_epi16(v, 6), _mm256_srli_epi16(v, 4));
+    }
+
+    // 16 pixels of 16-bit R, G, B -> R G B A words, alpha opaque.
+    static inline void store_rgba64(__m256i r, __m256i g, __m256i b, uint16_t *dst)
+    {
+        const __m256i alpha = _mm256_set1_epi16((short)0xFFFF);
+        const __m256i rgLo = _mm256_unpacklo_epi16(r, g);     // pixels 0-3 | 8-11
+        const __m256i rgHi = _mm256_unpackhi_epi16(r, g);     // pixels 4-7 | 12-15
+        const __m256i baLo = _mm256_unpacklo_epi16(b, alpha);
+        const __m256i baHi = _mm256_unpackhi_epi16(b, alpha);
+        const __m256i q0 = _mm256_unpacklo_epi32(rgLo, baLo); // 0-1 | 8-9
+        const __m256i q1 = _mm256_unpackhi_epi32(rgLo, baLo); // 2-3 | 10-11
+        const __m256i q2 = _mm256_unpacklo_epi32(rgHi, baHi); // 4-5 | 12-13
+        const __m256i q3 = _mm256_unpackhi_epi32(rgHi, baHi); // 6-7 | 14-15
+        __m256i *out = reinterpret_cast<__m256i *>(dst);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+    }
+
+    // 16 pixels of a P010 row pair -> 10-bit R, G, B (m in 10-bit units).
+    static inline void p010_rgb10(const uint16_t *yRow, const uint16_t *uvRow, const MatrixVec &k,
+                                  __m256i &r, __m256i &g, __m256i &b)
+    {
+        const __m256i y = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(yRow)), 6);
+        __m256i u, v;
+        split_p010_uv(_mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(uvRow)), 6), u, v);
+        rgb16(y, u, v, k, 512, 1023, r, g, b);
+    }
+
+    int p010_rgba64_row_avx2(const uint16_t *yRow, const uint16_t *uvRow, uint16_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            store_rgba64(widen10(r), widen10(g), widen10(b), dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    // 16 pixels of 10-bit R, G, B -> X2R10G10B10 dwords built as (low, high) word pairs.
+    static inline void store_x2rgb10(__m256i r, __m256i g, __m256i b, uint32_t *dst)
+    {
+        const __m256i lo = _mm256_or_si256(b, _mm256_slli_epi16(g, 10));
+        const __m256i hi = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi16(g, 6), _mm256_slli_epi16(r, 4)),
+                                           _mm256_set1_epi16((short)0xC000));
+        const __m256i a = _mm256_unpacklo_epi16(lo, hi); // pixels 0-3 | 8-11
+        const __m256i c = _mm256_unpackhi_epi16(lo, hi); // pixels 4-7 | 12-15
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(a, c, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 8), _mm256_permute2x128_si256(a, c, 0x31));
+    }
+
+    int p010_x2rgb10_row_avx2(const uint16_t *yRow, const uint16_t *uvRow, uint32_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            store_x2rgb10(r, g, b, dst + x);
+        }
+        return n;
+    }
+
+    // 16-bit UNORM -> 8 bits with threshold d in 0..255; the sum stays below 65536.
+    static inline __m256i dither8(__m256i w, __m256i d)
+    {
+        return _mm256_srli_epi16(_mm256_add_epi16(_mm256_sub_epi16(w, _mm256_srli_epi16(w, 8)), d), 8);
+    }
+
+    int p010_dither_row_avx2(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m,
+                             const uint16_t *dither)
+    {
+        const MatrixVec k = load_matrix(m);
+        // The 8-pixel pattern repeats once per 16 pixels.
+        const __m256i d = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(dither)));
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            r = dither8(widen10(r), d);
+            g = dither8(widen10(g), d);
+            b = dither8(widen10(b), d);
+            const __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+            const __m256i ra = _mm256_or_si256(r, _mm256_set1_epi16((short)0xFF00));
+            const __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+            const __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (size_t)x * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (size_t)x * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        return n;
+    }
+
+    int y210_split_row_avx2(const uint16_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        // Per lane: even words (Y) to the low qword, odd words (U V pairs) to the high one.
+        const __m256i evenOdd = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                                                 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 2)), evenOdd);
+            const __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 2 + 16)), evenOdd);
+            // qwords of a/b: Y0 UV0 Y1 UV1 -> Y0 Y1 | UV0 UV1
+            const __m256i ap = _mm256_permute4x64_epi64(a, 0xD8);
+            const __m256i bp = _mm256_permute4x64_epi64(b, 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + x), _mm256_permute2x128_si256(ap, bp, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(uv + x), _mm256_permute2x128_si256(ap, bp, 0x31));
+        }
+        return n;
+    }
+
+    // Two V210 groups (one per 128-bit lane) -> ab = (a | b << 16) and c per dword,
+    // where a/b/c are the 10-bit fields at bits 0/10/20.
+    static inline void split_v210(__m256i px, __m256i &ab, __m256i &c)
+    {
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        const __m256i a = _mm256_and_si256(px, mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(px, 10), mask);
+        ab = _mm256_or_si256(a, _mm256_slli_epi32(b, 16));
+        c = _mm256_and_si256(_mm256_srli_epi32(px, 20), mask);
+    }
+
+    static inline __m256i gather_words(__m256i ab, __m256i c, __m256i fromAb, __m256i fromC)
+    {
+        return _mm256_or_si256(_mm256_shuffle_epi8(ab, fromAb), _mm256_shuffle_epi8(c, fromC));
+    }
+
+    // Each lane holds 6 valid words; lane 1 is stored right behind lane 0.
+    static inline void store_6_6(uint16_t *dst, __m256i v)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm256_castsi256_si128(v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 6), _mm256_extracti128_si256(v, 1));
+    }
+
+    static inline void store_3_3(uint16_t *dst, __m256i v)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm256_castsi256_si128(v));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 3), _mm256_extracti128_si256(v, 1));
+    }
+
+    // Y = b0 a1 c1 b2 a3 c3, UV = a0 c0 b1 a2 c2 b3, U = a0 b1 c2, V = c0 a2 b3 (see the SSE4.1 kernels).
+    int v210_row_avx2(const uint8_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        const __m256i yAb = _mm256_setr_epi8(2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1,
+                                             2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1);
+        const __m256i yC = _mm256_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1,
+                                            -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1);
+        const __m256i uvAb = _mm256_setr_epi8(0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1,
+                                              0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1);
+        const __m256i uvC = _mm256_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1,
+                                             -1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1);
+        int x = 0;
+        for (; x + 14 <= width; x += 12)
+        {
+            __m256i ab, c;
+            split_v210(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)(x / 6) * 16)), ab, c);
+            store_6_6(y + x, _mm256_slli_epi16(gather_words(ab, c, yAb, yC), 6));
+            store_6_6(uv + x, _mm256_slli_epi16(gather_words(ab, c, uvAb, uvC), 6));
+        }
+        return x;
+    }
+
+    int v210_planar_row_avx2(const uint8_t *src, uint16_t *y, uint16_t *u, uint16_t *v, int width)
+    {
+        const __m256i yAb = _mm256_setr_epi8(2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1,
+                                             2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1);
+        const __m256i yC = _mm256_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1,
+                                            -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1);
+        const __m256i uAb = _mm256_setr_epi8(0, 1, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             0, 1, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i uC = _mm256_setr_epi8(-1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i vAb = _mm256_setr_epi8(-1, -1, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             -1, -1, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i vC = _mm256_setr_epi8(0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        int x = 0;
+        for (; x + 14 <= width; x += 12)
+        {
+            __m256i ab, c;
+            split_v210(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)(x / 6) * 16)), ab, c);
+            store_6_6(y + x, gather_words(ab, c, yAb, yC));
+            store_3_3(u + x / 2, gather_words(ab, c, uAb, uC));
+            store_3_3(v + x / 2, gather_words(ab, c, vAb, vC));
+        }
+        return x;
+    }
+
+    // 16 R210 pixels -> R, G, B as 10-bit values in 16-bit lanes, in pixel order.
+    static inline void split_r210(const uint8_t *src, __m256i &r, __m256i &g, __m256i &b)
+    {
+        const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                               3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        const __m256i lo = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)), bswap);
+        const __m256i hi = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32)), bswap);
+        // packus interleaves lanes (0-3, 8-11, 4-7, 12-15); 0xD8 restores pixel order.
+        auto pack = [&](__m256i l, __m256i h)
+        { return _mm256_permute4x64_epi64(_mm256_packus_epi32(_mm256_and_si256(l, mask), _mm256_and_si256(h, mask)), 0xD8); };
+        r = pack(_mm256_srli_epi32(lo, 20), _mm256_srli_epi32(hi, 20));
+        g = pack(_mm256_srli_epi32(lo, 10), _mm256_srli_epi32(hi, 10));
+        b = pack(lo, hi);
+    }
+
+    int r210_row_avx2(const uint8_t *src, uint8_t *dst, int width)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            r = y210_to_8bit(_mm256_slli_epi16(r, 6));
+            g = y210_to_8bit(_mm256_slli_epi16(g, 6));
+            b = y210_to_8bit(_mm256_slli_epi16(b, 6));
+            const __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+            const __m256i ra = _mm256_or_si256(r, _mm256_set1_epi16((short)0xFF00));
+            const __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+            const __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (size_t)x * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (size_t)x * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        return n;
+    }
+
+    int r210_rgba64_row_avx2(const uint8_t *src, uint16_t *dst, int width)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            __m256i r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            store_rgba64(widen10(r), widen10(g), widen10(b), dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    const gcap::simd::RowKernels kAvx2Kernels = {
+        gcap::simd::Isa::Avx2, "AVX2", nv12_row_avx2, yuy2_row_avx2, y210_row_avx2,
+        p010_row_avx2, p010_rgba64_row_avx2, p010_x2rgb10_row_avx2, p010_dither_row_avx2,
+        y210_split_row_avx2, v210_row_avx2, v210_planar_row_avx2,
+        r210_row_avx2, r210_rgba64_row_avx2, hsum3_row_avx2, unsharp_row_avx2,
+        vacc8_row_avx2, vacc10_row_avx2};
+}
+
+const gcap::simd::RowKernels *gcap::simd::avx2_kernels()
+{
+    return &kAvx2Kernels;
+}
+
+#else
+
+const gcap::simd::RowKernels *gcap::simd::avx2_kernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,404 @@
+// frame_converter_neon.cpp
+// NEON row kernels for ARM64 builds: 16 pixels per iteration.
+#include "frame_converter_simd.h"
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+
+namespace
+{
+    using gcap::simd::YuvChannelCoeffs;
+    using gcap::simd::YuvMatrix;
+
+    static inline int16x8_t channel8(int16x8_t c, int16x8_t d, int16x8_t e, const YuvChannelCoeffs &k)
+    {
+        const int32x4_t round = vdupq_n_s32(k.round);
+        int32x4_t lo = vmlal_n_s16(round, vget_low_s16(c), k.y);
+        int32x4_t hi = vmlal_n_s16(round, vget_high_s16(c), k.y);
+        lo = vmlal_n_s16(lo, vget_low_s16(d), k.u);
+        hi = vmlal_n_s16(hi, vget_high_s16(d), k.u);
+        lo = vmlal_n_s16(lo, vget_low_s16(e), k.v);
+        hi = vmlal_n_s16(hi, vget_high_s16(e), k.v);
+        const int16x8_t v = vcombine_s16(vshrn_n_s32(lo, 8), vshrn_n_s32(hi, 8));
+        return vqaddq_s16(v, vdupq_n_s16(k.bias));
+    }
+
+    // y/u/v: 8 pixels as unsigned 8-bit values (u/v already upsampled).
+    static inline uint8x8x4_t bgra8(uint8x8_t y, uint8x8_t u, uint8x8_t v, const YuvMatrix &m)
+    {
+        const int16x8_t c = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(m.y_offset));
+        const int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+        const int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+
+        uint8x8x4_t out;
+        out.val[0] = vqmovun_s16(channel8(c, d, e, m.b));
+        out.val[1] = vqmovun_s16(channel8(c, d, e, m.g));
+        out.val[2] = vqmovun_s16(channel8(c, d, e, m.r));
+        out.val[3] = vdup_n_u8(255);
+        return out;
+    }
+
+    // Y210 WORD -> 8-bit, bit-exact with (n * 255 + 511) / 1023 for n = word >> 6.
+    static inline uint8x8_t y210_to_8bit(uint16x8_t w)
+    {
+        const uint32x4_t lo = vmull_n_u16(vget_low_u16(vshrq_n_u16(w, 6)), 1021);
+        const uint32x4_t hi = vmull_n_u16(vget_high_u16(vshrq_n_u16(w, 6)), 1021);
+        const uint16x8_t m = vcombine_u16(vshrn_n_u32(lo, 10), vshrn_n_u32(hi, 10));
+        return vmovn_u16(vshrq_n_u16(vaddq_u16(m, vdupq_n_u16(2)), 2));
+    }
+
+    int nv12_row_neon(const uint8_t *yRow, const uint8_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const uint8x16_t y = vld1q_u8(yRow + x);
+            const uint8x8x2_t uv = vld2_u8(uvRow + x);
+            const uint8x8x2_t u = vzip_u8(uv.val[0], uv.val[0]);
+            const uint8x8x2_t v = vzip_u8(uv.val[1], uv.val[1]);
+            vst4_u8(dst + (size_t)x * 4, bgra8(vget_low_u8(y), u.val[0], v.val[0], m));
+            vst4_u8(dst + (size_t)x * 4 + 32, bgra8(vget_high_u8(y), u.val[1], v.val[1], m));
+        }
+        return n;
+    }
+
+    // Even/odd pixels share U/V, so convert them separately and zip the results.
+    static inline void store_pairs(uint8x8_t y0, uint8x8_t y1, uint8x8_t u, uint8x8_t v, const YuvMatrix &m, uint8_t *dst)
+    {
+        const uint8x8x4_t even = bgra8(y0, u, v, m);
+        const uint8x8x4_t odd = bgra8(y1, u, v, m);
+        uint8x8x4_t a, b;
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            const uint8x8x2_t z = vzip_u8(even.val[ch], odd.val[ch]);
+            a.val[ch] = z.val[0];
+            b.val[ch] = z.val[1];
+        }
+        vst4_u8(dst, a);
+        vst4_u8(dst + 32, b);
+    }
+
+    int yuy2_row_neon(const uint8_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const uint8x8x4_t px = vld4_u8(src + (size_t)x * 2); // Y0 U Y1 V
+            store_pairs(px.val[0], px.val[2], px.val[1], px.val[3], m, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int y210_row_neon(const uint16_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const uint16x8x4_t px = vld4q_u16(src + (size_t)x * 2); // Y0 U Y1 V
+            store_pairs(y210_to_8bit(px.val[0]), y210_to_8bit(px.val[2]),
+                        y210_to_8bit(px.val[1]), y210_to_8bit(px.val[3]), m, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int p010_row_neon(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~15;
+        for (int x = 0; x < n; x += 16)
+        {
+            const uint8x8_t y0 = y210_to_8bit(vld1q_u16(yRow + x));
+            const uint8x8_t y1 = y210_to_8bit(vld1q_u16(yRow + x + 8));
+            const uint16x8x2_t uv = vld2q_u16(uvRow + x);
+            const uint8x8x2_t u = vzip_u8(y210_to_8bit(uv.val[0]), y210_to_8bit(uv.val[0]));
+            const uint8x8x2_t v = vzip_u8(y210_to_8bit(uv.val[1]), y210_to_8bit(uv.val[1]));
+            vst4_u8(dst + (size_t)x * 4, bgra8(y0, u.val[0], v.val[0], m));
+            vst4_u8(dst + (size_t)x * 4 + 32, bgra8(y1, u.val[1], v.val[1], m));
+        }
+        return n;
+    }
+
+    // 10-bit -> 16-bit UNORM by bit replication.
+    static inline uint16x8_t widen10(uint16x8_t v)
+    {
+        return vorrq_u16(vshlq_n_u16(v, 6), vshrq_n_u16(v, 4));
+    }
+
+    // One 10-bit channel clamped to 0..1023.
+    static inline uint16x8_t channel10(int16x8_t c, int16x8_t d, int16x8_t e, const YuvChannelCoeffs &k)
+    {
+        const int16x8_t v = vminq_s16(vmaxq_s16(channel8(c, d, e, k), vdupq_n_s16(0)), vdupq_n_s16(1023));
+        return vreinterpretq_u16_s16(v);
+    }
+
+    // 8 pixels of a P010 row pair -> 10-bit R, G, B (m in 10-bit units).
+    static inline void p010_rgb10(const uint16_t *yRow, const uint16_t *uvRow, const YuvMatrix &m,
+                                  uint16x8_t &r, uint16x8_t &g, uint16x8_t &b)
+    {
+        const uint16x4x2_t uv = vld2_u16(uvRow);
+        const uint16x4x2_t u = vzip_u16(uv.val[0], uv.val[0]);
+        const uint16x4x2_t v = vzip_u16(uv.val[1], uv.val[1]);
+        const int16x8_t c = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(yRow), 6)), vdupq_n_s16(m.y_offset));
+        const int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vcombine_u16(u.val[0], u.val[1]), 6)), vdupq_n_s16(512));
+        const int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vcombine_u16(v.val[0], v.val[1]), 6)), vdupq_n_s16(512));
+        r = channel10(c, d, e, m.r);
+        g = channel10(c, d, e, m.g);
+        b = channel10(c, d, e, m.b);
+    }
+
+    int p010_rgba64_row_neon(const uint16_t *yRow, const uint16_t *uvRow, uint16_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            uint16x8_t r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, m, r, g, b);
+            uint16x8x4_t out;
+            out.val[0] = widen10(r);
+            out.val[1] = widen10(g);
+            out.val[2] = widen10(b);
+            out.val[3] = vdupq_n_u16(0xFFFF);
+            vst4q_u16(dst + (size_t)x * 4, out);
+        }
+        return n;
+    }
+
+    int p010_x2rgb10_row_neon(const uint16_t *yRow, const uint16_t *uvRow, uint32_t *dst, int width, const YuvMatrix &m)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            uint16x8_t r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, m, r, g, b);
+            // (low, high) word pairs: B | G << 10 and G >> 6 | R << 4 | padding.
+            uint16x8x2_t out;
+            out.val[0] = vorrq_u16(b, vshlq_n_u16(g, 10));
+            out.val[1] = vorrq_u16(vorrq_u16(vshrq_n_u16(g, 6), vshlq_n_u16(r, 4)), vdupq_n_u16(0xC000));
+            vst2q_u16(reinterpret_cast<uint16_t *>(dst + x), out);
+        }
+        return n;
+    }
+
+    // 16-bit UNORM -> 8 bits with threshold d in 0..255; the sum stays below 65536.
+    static inline uint8x8_t dither8(uint16x8_t w, uint16x8_t d)
+    {
+        return vshrn_n_u16(vaddq_u16(vsubq_u16(w, vshrq_n_u16(w, 8)), d), 8);
+    }
+
+    int p010_dither_row_neon(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m,
+                             const uint16_t *dither)
+    {
+        const uint16x8_t d = vld1q_u16(dither);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            uint16x8_t r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, m, r, g, b);
+            uint8x8x4_t out;
+            out.val[0] = dither8(widen10(b), d);
+            out.val[1] = dither8(widen10(g), d);
+            out.val[2] = dither8(widen10(r), d);
+            out.val[3] = vdup_n_u8(255);
+            vst4_u8(dst + (size_t)x * 4, out);
+        }
+        return n;
+    }
+
+    int y210_split_row_neon(const uint16_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            // Even words are Y, odd words the U V pairs.
+            const uint16x8x2_t px = vld2q_u16(src + (size_t)x * 2);
+            vst1q_u16(y + x, px.val[0]);
+            vst1q_u16(uv + x, px.val[1]);
+        }
+        return n;
+    }
+
+    // One V210 group -> ab = (a | b << 16) and c per dword (10-bit fields at bits 0/10/20).
+    static inline void split_v210(const uint8_t *src, uint8x16_t &ab, uint8x16_t &c)
+    {
+        const uint32x4_t px = vreinterpretq_u32_u8(vld1q_u8(src));
+        const uint32x4_t mask = vdupq_n_u32(0x3FF);
+        const uint32x4_t a = vandq_u32(px, mask);
+        const uint32x4_t b = vandq_u32(vshrq_n_u32(px, 10), mask);
+        ab = vreinterpretq_u8_u32(vorrq_u32(a, vshlq_n_u32(b, 16)));
+        c = vreinterpretq_u8_u32(vandq_u32(vshrq_n_u32(px, 20), mask));
+    }
+
+    // Table lookups with 0xFF = zero; Y = b0 a1 c1 b2 a3 c3, UV = a0 c0 b1 a2 c2 b3,
+    // U = a0 b1 c2, V = c0 a2 b3 (see the SSE4.1 kernels).
+    static inline uint16x8_t gather_words(uint8x16_t ab, uint8x16_t c, const uint8_t (&fromAb)[16], const uint8_t (&fromC)[16])
+    {
+        return vreinterpretq_u16_u8(vorrq_u8(vqtbl1q_u8(ab, vld1q_u8(fromAb)), vqtbl1q_u8(c, vld1q_u8(fromC))));
+    }
+
+    alignas(16) const uint8_t kV210YAb[16] = {2, 3, 4, 5, 0xFF, 0xFF, 10, 11, 12, 13, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210YC[16] = {0xFF, 0xFF, 0xFF, 0xFF, 4, 5, 0xFF, 0xFF, 0xFF, 0xFF, 12, 13, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210UvAb[16] = {0, 1, 0xFF, 0xFF, 6, 7, 8, 9, 0xFF, 0xFF, 14, 15, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210UvC[16] = {0xFF, 0xFF, 0, 1, 0xFF, 0xFF, 0xFF, 0xFF, 8, 9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210UAb[16] = {0, 1, 6, 7, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210UC[16] = {0xFF, 0xFF, 0xFF, 0xFF, 8, 9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210VAb[16] = {0xFF, 0xFF, 8, 9, 14, 15, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    alignas(16) const uint8_t kV210VC[16] = {0, 1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    int v210_row_neon(const uint8_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        // Each store writes 8 words of which 6 are valid; the next group overwrites the rest.
+        int x = 0;
+        for (; x + 8 <= width; x += 6)
+        {
+            uint8x16_t ab, c;
+            split_v210(src + (size_t)(x / 6) * 16, ab, c);
+            vst1q_u16(y + x, vshlq_n_u16(gather_words(ab, c, kV210YAb, kV210YC), 6));
+            vst1q_u16(uv + x, vshlq_n_u16(gather_words(ab, c, kV210UvAb, kV210UvC), 6));
+        }
+        return x;
+    }
+
+    int v210_planar_row_neon(const uint8_t *src, uint16_t *y, uint16_t *u, uint16_t *v, int width)
+    {
+        int x = 0;
+        for (; x + 8 <= width; x += 6)
+        {
+            uint8x16_t ab, c;
+            split_v210(src + (size_t)(x / 6) * 16, ab, c);
+            vst1q_u16(y + x, gather_words(ab, c, kV210YAb, kV210YC));
+            vst1_u16(u + x / 2, vget_low_u16(gather_words(ab, c, kV210UAb, kV210UC)));
+            vst1_u16(v + x / 2, vget_low_u16(gather_words(ab, c, kV210VAb, kV210VC)));
+        }
+        return x;
+    }
+
+    // 8 R210 pixels -> R, G, B as 10-bit values.
+    static inline void split_r210(const uint8_t *src, uint16x8_t &r, uint16x8_t &g, uint16x8_t &b)
+    {
+        const uint32x4_t mask = vdupq_n_u32(0x3FF);
+        const uint32x4_t lo = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src)));
+        const uint32x4_t hi = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src + 16)));
+        r = vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(lo, 20), mask)), vmovn_u32(vandq_u32(vshrq_n_u32(hi, 20), mask)));
+        g = vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(lo, 10), mask)), vmovn_u32(vandq_u32(vshrq_n_u32(hi, 10), mask)));
+        b = vcombine_u16(vmovn_u32(vandq_u32(lo, mask)), vmovn_u32(vandq_u32(hi, mask)));
+    }
+
+    int r210_row_neon(const uint8_t *src, uint8_t *dst, int width)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            uint16x8_t r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            uint8x8x4_t out;
+            out.val[0] = y210_to_8bit(vshlq_n_u16(b, 6));
+            out.val[1] = y210_to_8bit(vshlq_n_u16(g, 6));
+            out.val[2] = y210_to_8bit(vshlq_n_u16(r, 6));
+            out.val[3] = vdup_n_u8(255);
+            vst4_u8(dst + (size_t)x * 4, out);
+        }
+        return n;
+    }
+
+    int r210_rgba64_row_neon(const uint8_t *src, uint16_t *dst, int width)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            uint16x8_t r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            uint16x8x4_t out;
+            out.val[0] = widen10(r);
+            out.val[1] = widen10(g);
+            out.val[2] = widen10(b);
+            out.val[3] = vdupq_n_u16(0xFFFF);
+            vst4q_u16(dst + (size_t)x * 4, out);
+        }
+        return n;
+    }
+
+    int hsum3_row_neon(const uint8_t *bgra, uint16_t *out, int count)
+    {
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const uint8x16_t l = vld1q_u8(bgra + i - 4);
+            const uint8x16_t c = vld1q_u8(bgra + i);
+            const uint8x16_t r = vld1q_u8(bgra + i + 4);
+            vst1q_u16(out + i, vaddw_u8(vaddl_u8(vget_low_u8(l), vget_low_u8(c)), vget_low_u8(r)));
+            vst1q_u16(out + i + 8, vaddw_u8(vaddl_u8(vget_high_u8(l), vget_high_u8(c)), vget_high_u8(r)));
+        }
+        return n;
+    }
+
+    // 8 lanes of the unsharp mask.
+    static inline uint8x8_t unsharp8(uint8x8_t orig, const uint16_t *up, const uint16_t *mid, const uint16_t *down, int16x8_t amt)
+    {
+        const uint16x8_t sum = vaddq_u16(vaddq_u16(vld1q_u16(up), vld1q_u16(mid)), vaddq_u16(vld1q_u16(down), vdupq_n_u16(4)));
+        const uint16x8_t blur = vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(sum), 7282), 16),
+                                             vshrn_n_u32(vmull_n_u16(vget_high_u16(sum), 7282), 16));
+        const int16x8_t o = vreinterpretq_s16_u16(vmovl_u8(orig));
+        const int16x8_t delta = vshrq_n_s16(vmulq_s16(vsubq_s16(o, vreinterpretq_s16_u16(blur)), amt), 7);
+        return vqmovun_s16(vaddq_s16(o, delta));
+    }
+
+    int unsharp_row_neon(const uint8_t *orig, const uint16_t *up, const uint16_t *mid, const uint16_t *down,
+                         uint8_t *dst, int count, int amount)
+    {
+        const int16x8_t amt = vdupq_n_s16((int16_t)amount);
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const uint8x16_t o = vld1q_u8(orig + i);
+            vst1q_u8(dst + i, vcombine_u8(unsharp8(vget_low_u8(o), up + i, mid + i, down + i, amt),
+                                          unsharp8(vget_high_u8(o), up + i + 8, mid + i + 8, down + i + 8, amt)));
+        }
+        return n;
+    }
+
+    int vacc8_row_neon(const uint8_t *src, uint16_t *acc, int count, int weight)
+    {
+        const uint16_t w = (uint16_t)weight;
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const uint8x16_t s = vld1q_u8(src + i);
+            vst1q_u16(acc + i, vmlaq_n_u16(vld1q_u16(acc + i), vmovl_u8(vget_low_u8(s)), w));
+            vst1q_u16(acc + i + 8, vmlaq_n_u16(vld1q_u16(acc + i + 8), vmovl_u8(vget_high_u8(s)), w));
+        }
+        return n;
+    }
+
+    int vacc10_row_neon(const uint16_t *src, uint32_t *acc, int count, int weight)
+    {
+        const uint16_t w = (uint16_t)weight;
+        const int n = count & ~7;
+        for (int i = 0; i < n; i += 8)
+        {
+            const uint16x8_t s = vshrq_n_u16(vld1q_u16(src + i), 6);
+            vst1q_u32(acc + i, vmlal_n_u16(vld1q_u32(acc + i), vget_low_u16(s), w));
+            vst1q_u32(acc + i + 4, vmlal_n_u16(vld1q_u32(acc + i + 4), vget_high_u16(s), w));
+        }
+        return n;
+    }
+
+    const gcap::simd::RowKernels kNeonKernels = {
+        gcap::simd::Isa::Neon, "NEON", nv12_row_neon, yuy2_row_neon, y210_row_neon,
+        p010_row_neon, p010_rgba64_row_neon, p010_x2rgb10_row_neon, p010_dither_row_neon,
+        y210_split_row_neon, v210_row_neon, v210_planar_row_neon,
+        r210_row_neon, r210_rgba64_row_neon, hsum3_row_neon, unsharp_row_neon,
+        vacc8_row_neon, vacc10_row_neon};
+}
+
+const gcap::simd::RowKernels *gcap::simd::neon_kernels()
+{
+    return &kNeonKernels;
+}
+
+#else
+
+const gcap::simd::RowKernels *gcap::simd::neon_kernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,141 @@
+// frame_converter_simd.h
+// Internal row kernels used by frame_converter.cpp. Not part of the public SDK API.
+#pragma once
+#include <cstdint>
+
+namespace gcap::simd
+{
+    /**
+     * Fixed-point YUV -> RGB matrix, 8 fractional bits.
+     *
+     * Each output channel is computed as
+     *   c = clamp(((y * (Y - y_offset) + u * (U - 128) + v * (V - 128) + round) >> 8) + bias, 0, 255)
+     * The default values are the BT.601 limited-range coefficients used by the
+     * scalar yuv_to_rgb() reference, so the SIMD kernels stay bit-exact with it.
+     */
+    struct YuvChannelCoeffs
+    {
+        int16_t y;
+        int16_t u;
+        int16_t v;
+        int16_t round; // added before >> 8 (0..255)
+        int16_t bias;  // added after >> 8
+    };
+
+    struct YuvMatrix
+    {
+        int16_t y_offset = 16;
+        YuvChannelCoeffs r{298, 0, 409, 128, 0};
+        YuvChannelCoeffs g{298, -100, -208, 128, 0};
+        YuvChannelCoeffs b{298, 516, 0, 128, 0};
+    };
+
+    // Row kernels convert a prefix of one row into BGRA (alpha = 255) and return
+    // the number of pixels written. The prefix is always even and a multiple of
+    // the kernel's vector width; the caller finishes the row with scalar code.
+    using Nv12RowFn = int (*)(const uint8_t *y, const uint8_t *uv, uint8_t *dst, int width, const YuvMatrix &m);
+    using Yuy2RowFn = int (*)(const uint8_t *yuy2, uint8_t *dst, int width, const YuvMatrix &m);
+    using Y210RowFn = int (*)(const uint16_t *y210, uint8_t *dst, int width, const YuvMatrix &m);
+    // P010: 10-bit samples in bits [15:6] of each WORD; Y row + interleaved UV row.
+    using P010RowFn = int (*)(const uint16_t *y, const uint16_t *uv, uint8_t *dst, int width, const YuvMatrix &m);
+    // P010 -> RGBA64 (R, G, B, A as 16-bit UNORM) at full 10-bit precision. `m` is in
+    // 10-bit units (see to_10bit()): chroma is centred on 512 and results clamp to 0..1023
+    // before being widened to 16 bits.
+    using P010Rgba64RowFn = int (*)(const uint16_t *y, const uint16_t *uv, uint16_t *dst, int width, const YuvMatrix &m);
+    // P010 -> X2R10G10B10 dwords (B in bits 0-9, G 10-19, R 20-29, padding bits set); `m` as above.
+    using P010X2Rgb10RowFn = int (*)(const uint16_t *y, const uint16_t *uv, uint32_t *dst, int width, const YuvMatrix &m);
+    // P010 -> BGRA at 8 bits through the 10-bit matrix with an ordered dither: each 16-bit
+    // channel w becomes (w - (w >> 8) + d) >> 8 with d = dither[x & 7] in 0..255.
+    // The prefix is a multiple of 8 so the pattern phase stays tied to x.
+    using P010DitherRowFn = int (*)(const uint16_t *y, const uint16_t *uv, uint8_t *dst, int width, const YuvMatrix &m,
+                                    const uint16_t *dither);
+    // Y210 -> P210 row pair (Y + interleaved UV), so the P010 kernels can take Y210 rows.
+    using Y210SplitRowFn = int (*)(const uint16_t *y210, uint16_t *y, uint16_t *uv, int width);
+
+    // V210 unpack: each 16-byte group holds 6 pixels as four little-endian dwords of
+    // three 10-bit fields (Cb0 Y0 Cr0 | Y1 Cb2 Y2 | Cr2 Y3 Cb4 | Y4 Cr4 Y5). Kernels
+    // return a multiple of 6 and never write at or past `width` in any output.
+    // V210Row: to a P210 row pair (Y + interleaved UV, MSB-aligned like P010).
+    using V210RowFn = int (*)(const uint8_t *v210, uint16_t *y, uint16_t *uv, int width);
+    // V210Planar: to 10-bit values in the low bits of Y, U and V rows (U/V at half width).
+    using V210PlanarRowFn = int (*)(const uint8_t *v210, uint16_t *y, uint16_t *u, uint16_t *v, int width);
+    // R210: one big-endian dword per pixel, 2 padding bits then R, G, B at 10 bits each.
+    using R210RowFn = int (*)(const uint8_t *r210, uint8_t *bgra, int width);
+    using R210Rgba64RowFn = int (*)(const uint8_t *r210, uint16_t *rgba, int width);
+
+    // Sharpness helpers over interleaved BGRA bytes; same prefix contract as above.
+    // Hsum3: out[i] = bgra[i - 4] + bgra[i] + bgra[i + 4] for i in [0, count); reads bgra[-4, count + 4).
+    using Hsum3RowFn = int (*)(const uint8_t *bgra, uint16_t *out, int count);
+    // Unsharp: blur = (up + mid + down + 4) / 9, dst = clamp(orig + (((orig - blur) * amount) >> 7), 0, 255)
+    // with amount in [-128, 127].
+    using UnsharpRowFn = int (*)(const uint8_t *orig, const uint16_t *up, const uint16_t *mid, const uint16_t *down,
+                                 uint8_t *dst, int count, int amount);
+
+    // Resampler vertical pass: acc[i] += src[i] * weight for i in [0, count), weight in [0, 256].
+    // Vacc8 sums 8-bit samples into 16-bit lanes (the 256 weight budget keeps them below 65536);
+    // Vacc10 sums the 10 significant bits of MSB-aligned words into 32-bit lanes.
+    using Vacc8RowFn = int (*)(const uint8_t *src, uint16_t *acc, int count, int weight);
+    using Vacc10RowFn = int (*)(const uint16_t *src, uint32_t *acc, int count, int weight);
+
+    enum class Isa
+    {
+        Scalar = 0,
+        Sse41,
+        Avx2,
+        Neon
+    };
+
+    struct RowKernels
+    {
+        Isa isa;
+        const char *name;
+        Nv12RowFn nv12;
+        Yuy2RowFn yuy2;
+        Y210RowFn y210;
+        P010RowFn p010;
+        P010Rgba64RowFn p010_rgba64;
+        P010X2Rgb10RowFn p010_x2rgb10;
+        P010DitherRowFn p010_dither;
+        Y210SplitRowFn y210_split;
+        V210RowFn v210;
+        V210PlanarRowFn v210_planar;
+        R210RowFn r210;
+        R210Rgba64RowFn r210_rgba64;
+        Hsum3RowFn hsum3;
+        UnsharpRowFn unsharp;
+        Vacc8RowFn vacc8;
+        Vacc10RowFn vacc10;
+    };
+
+    // Rescales an 8-bit-output matrix to 10-bit inputs/outputs: y_offset and the
+    // brightness offset are multiplied by 4, coefficients are unchanged. The +128
+    // rounding half stays half an output LSB, so it is not scaled.
+    inline YuvMatrix to_10bit(const YuvMatrix &m)
+    {
+        YuvMatrix out = m;
+        out.y_offset = (int16_t)(m.y_offset * 4);
+        YuvChannelCoeffs *ch[3] = {&out.r, &out.g, &out.b};
+        for (YuvChannelCoeffs *c : ch)
+        {
+            const int offset = (c->round + c->bias * 256 - 128) * 4 + 128;
+            c->round = (int16_t)(offset & 255);
+            c->bias = (int16_t)(offset >> 8);
+        }
+        return out;
+    }
+
+    // Per-ISA kernel tables. Return nullptr when the ISA was not compiled in.
+    const RowKernels *sse41_kernels();
+    const RowKernels *avx2_kernels();
+    const RowKernels *neon_kernels();
+
+    // Kernel table for an ISA, or nullptr if it is unavailable on this CPU/build.
+    const RowKernels *kernels_for(Isa isa);
+
+    // Best kernel table for this CPU, chosen once on first use (CPUID on x86).
+    const RowKernels &active_kernels();
+
+    // Override the automatic choice (benchmarks / diagnostics). Returns false
+    // and keeps the current table if the ISA is unavailable.
+    bool force_kernels(Isa isa);
+}
@@ -0,0 +1,484 @@
+// frame_converter_sse41.cpp
+// SSE4.1 row kernels: 8 pixels per iteration.
+// Built with -msse4.1 on GCC/Clang; MSVC x64 accepts the intrinsics without /arch.
+#include "frame_converter_simd.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <smmintrin.h>
+
+namespace
+{
+    using gcap::simd::YuvChannelCoeffs;
+    using gcap::simd::YuvMatrix;
+
+    struct ChannelVec
+    {
+        __m128i yu;   // (y, u) pairs for _mm_madd_epi16
+        __m128i vr;   // (v, round) pairs
+        __m128i bias; // added after >> 8
+    };
+
+    static inline ChannelVec load_channel(const YuvChannelCoeffs &c)
+    {
+        ChannelVec out;
+        out.yu = _mm_set1_epi32((int)((uint32_t)(uint16_t)c.y | ((uint32_t)(uint16_t)c.u << 16)));
+        out.vr = _mm_set1_epi32((int)((uint32_t)(uint16_t)c.v | ((uint32_t)(uint16_t)c.round << 16)));
+        out.bias = _mm_set1_epi16(c.bias);
+        return out;
+    }
+
+    struct MatrixVec
+    {
+        __m128i yoff;
+        ChannelVec r, g, b;
+    };
+
+    static inline MatrixVec load_matrix(const YuvMatrix &m)
+    {
+        MatrixVec out;
+        out.yoff = _mm_set1_epi16(m.y_offset);
+        out.r = load_channel(m.r);
+        out.g = load_channel(m.g);
+        out.b = load_channel(m.b);
+        return out;
+    }
+
+    // One channel for 8 pixels, clamped to 0..maxv. cd/e1 hold the interleaved (C, D) and (E, 1) pairs.
+    static inline __m128i channel8(__m128i cdLo, __m128i cdHi, __m128i e1Lo, __m128i e1Hi, const ChannelVec &k, __m128i maxv)
+    {
+        __m128i lo = _mm_add_epi32(_mm_madd_epi16(cdLo, k.yu), _mm_madd_epi16(e1Lo, k.vr));
+        __m128i hi = _mm_add_epi32(_mm_madd_epi16(cdHi, k.yu), _mm_madd_epi16(e1Hi, k.vr));
+        lo = _mm_srai_epi32(lo, 8);
+        hi = _mm_srai_epi32(hi, 8);
+        __m128i v = _mm_adds_epi16(_mm_packs_epi32(lo, hi), k.bias);
+        return _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), maxv);
+    }
+
+    // R, G, B for 8 pixels; `center` is the chroma midpoint (128, or 512 for 10-bit).
+    static inline void rgb8(__m128i y, __m128i u, __m128i v, const MatrixVec &k, short center, short maxv,
+                            __m128i &r, __m128i &g, __m128i &b)
+    {
+        const __m128i c = _mm_sub_epi16(y, k.yoff);
+        const __m128i d = _mm_sub_epi16(u, _mm_set1_epi16(center));
+        const __m128i e = _mm_sub_epi16(v, _mm_set1_epi16(center));
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i mx = _mm_set1_epi16(maxv);
+
+        const __m128i cdLo = _mm_unpacklo_epi16(c, d);
+        const __m128i cdHi = _mm_unpackhi_epi16(c, d);
+        const __m128i e1Lo = _mm_unpacklo_epi16(e, one);
+        const __m128i e1Hi = _mm_unpackhi_epi16(e, one);
+
+        r = channel8(cdLo, cdHi, e1Lo, e1Hi, k.r, mx);
+        g = channel8(cdLo, cdHi, e1Lo, e1Hi, k.g, mx);
+        b = channel8(cdLo, cdHi, e1Lo, e1Hi, k.b, mx);
+    }
+
+    // y/u/v: 8 pixels as unsigned 8-bit values in 16-bit lanes (u/v already upsampled).
+    static inline void store_bgra8(__m128i y, __m128i u, __m128i v, const MatrixVec &k, uint8_t *dst)
+    {
+        __m128i r, g, b;
+        rgb8(y, u, v, k, 128, 255, r, g, b);
+
+        const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        const __m128i ra = _mm_or_si128(r, _mm_set1_epi16((short)0xFF00));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+
+    // 16 bytes of YUY2 (8 pixels) -> Y, U, V in 16-bit lanes.
+    static inline void split_yuy2(__m128i px, __m128i &y, __m128i &u, __m128i &v)
+    {
+        const __m128i shufY = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i shufU = _mm_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i shufV = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+        y = _mm_cvtepu8_epi16(_mm_shuffle_epi8(px, shufY));
+        u = _mm_cvtepu8_epi16(_mm_shuffle_epi8(px, shufU));
+        v = _mm_cvtepu8_epi16(_mm_shuffle_epi8(px, shufV));
+    }
+
+    // Y210 WORD -> 8-bit, bit-exact with (n * 255 + 511) / 1023 for n = word >> 6.
+    static inline __m128i y210_to_8bit(__m128i w)
+    {
+        const __m128i n6 = _mm_and_si128(w, _mm_set1_epi16((short)0xFFC0));
+        const __m128i m = _mm_mulhi_epu16(n6, _mm_set1_epi16(1021));
+        return _mm_srli_epi16(_mm_add_epi16(m, _mm_set1_epi16(2)), 2);
+    }
+
+    int nv12_row_sse41(const uint8_t *yRow, const uint8_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const __m128i shufU = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i shufV = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            const __m128i y = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(yRow + x)));
+            const __m128i uv = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(uvRow + x));
+            const __m128i u = _mm_cvtepu8_epi16(_mm_shuffle_epi8(uv, shufU));
+            const __m128i v = _mm_cvtepu8_epi16(_mm_shuffle_epi8(uv, shufV));
+            store_bgra8(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int yuy2_row_sse41(const uint8_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i y, u, v;
+            split_yuy2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 2)), y, u, v);
+            store_bgra8(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int y210_row_sse41(const uint16_t *src, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            const __m128i a = y210_to_8bit(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 2)));
+            const __m128i b = y210_to_8bit(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 2 + 8)));
+            __m128i y, u, v;
+            split_yuy2(_mm_packus_epi16(a, b), y, u, v);
+            store_bgra8(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    int hsum3_row_sse41(const uint8_t *bgra, uint16_t *out, int count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i - 4));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i + 4));
+            const __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(c, zero)),
+                                             _mm_unpacklo_epi8(r, zero));
+            const __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(c, zero)),
+                                             _mm_unpackhi_epi8(r, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), hi);
+        }
+        return n;
+    }
+
+    // 8 lanes of the unsharp mask; o holds the original bytes widened to 16 bits.
+    static inline __m128i unsharp8(__m128i o, const uint16_t *up, const uint16_t *mid, const uint16_t *down, __m128i amt)
+    {
+        __m128i sum = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(up)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(mid)));
+        sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(down)));
+        const __m128i blur = _mm_mulhi_epu16(_mm_add_epi16(sum, _mm_set1_epi16(4)), _mm_set1_epi16(7282));
+        const __m128i delta = _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(o, blur), amt), 7);
+        return _mm_add_epi16(o, delta);
+    }
+
+    int unsharp_row_sse41(const uint8_t *orig, const uint16_t *up, const uint16_t *mid, const uint16_t *down,
+                          uint8_t *dst, int count, int amount)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i amt = _mm_set1_epi16((short)amount);
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i *>(orig + i));
+            const __m128i lo = unsharp8(_mm_unpacklo_epi8(o, zero), up + i, mid + i, down + i, amt);
+            const __m128i hi = unsharp8(_mm_unpackhi_epi8(o, zero), up + i + 8, mid + i + 8, down + i + 8, amt);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        return n;
+    }
+
+    int vacc8_row_sse41(const uint8_t *src, uint16_t *acc, int count, int weight)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w = _mm_set1_epi16((short)weight);
+        const int n = count & ~15;
+        for (int i = 0; i < n; i += 16)
+        {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i *a = reinterpret_cast<__m128i *>(acc + i);
+            // Products stay below 65536, so the low half of the multiply is the whole product.
+            _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), w)));
+            _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), w)));
+        }
+        return n;
+    }
+
+    int vacc10_row_sse41(const uint16_t *src, uint32_t *acc, int count, int weight)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w = _mm_set1_epi32(weight); // (weight, 0) word pairs for madd
+        const int n = count & ~7;
+        for (int i = 0; i < n; i += 8)
+        {
+            const __m128i s = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), 6);
+            __m128i *a = reinterpret_cast<__m128i *>(acc + i);
+            _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_madd_epi16(_mm_unpacklo_epi16(s, zero), w)));
+            _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_madd_epi16(_mm_unpackhi_epi16(s, zero), w)));
+        }
+        return n;
+    }
+
+    // P010 rows: UV words are already paired per pixel pair, so only duplication is needed.
+    static inline void split_p010_uv(__m128i uv, __m128i &u, __m128i &v)
+    {
+        const __m128i dupU = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+        const __m128i dupV = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+        u = _mm_shuffle_epi8(uv, dupU);
+        v = _mm_shuffle_epi8(uv, dupV);
+    }
+
+    int p010_row_sse41(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            const __m128i y = y210_to_8bit(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x)));
+            __m128i u, v;
+            split_p010_uv(y210_to_8bit(_mm_loadu_si128(reinterpret_cast<const __m128i *>(uvRow + x))), u, v);
+            store_bgra8(y, u, v, k, dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    // 10-bit -> 16-bit UNORM by bit replication.
+    static inline __m128i widen10(__m128i v)
+    {
+        return _mm_or_si128(_mm_slli_epi16(v, 6), _mm_srli_epi16(v, 4));
+    }
+
+    // 8 pixels of 16-bit R, G, B -> R G B A words, alpha opaque.
+    static inline void store_rgba64(__m128i r, __m128i g, __m128i b, uint16_t *dst)
+    {
+        const __m128i alpha = _mm_set1_epi16((short)0xFFFF);
+        const __m128i rgLo = _mm_unpacklo_epi16(r, g);
+        const __m128i rgHi = _mm_unpackhi_epi16(r, g);
+        const __m128i baLo = _mm_unpacklo_epi16(b, alpha);
+        const __m128i baHi = _mm_unpackhi_epi16(b, alpha);
+        __m128i *out = reinterpret_cast<__m128i *>(dst);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi32(rgLo, baLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi32(rgLo, baLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi32(rgHi, baHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi32(rgHi, baHi));
+    }
+
+    // 8 pixels of a P010 row pair -> 10-bit R, G, B (m in 10-bit units).
+    static inline void p010_rgb10(const uint16_t *yRow, const uint16_t *uvRow, const MatrixVec &k,
+                                  __m128i &r, __m128i &g, __m128i &b)
+    {
+        const __m128i y = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow)), 6);
+        __m128i u, v;
+        split_p010_uv(_mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(uvRow)), 6), u, v);
+        rgb8(y, u, v, k, 512, 1023, r, g, b);
+    }
+
+    int p010_rgba64_row_sse41(const uint16_t *yRow, const uint16_t *uvRow, uint16_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            store_rgba64(widen10(r), widen10(g), widen10(b), dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    // 8 pixels of 10-bit R, G, B -> X2R10G10B10 dwords built as (low, high) word pairs.
+    static inline void store_x2rgb10(__m128i r, __m128i g, __m128i b, uint32_t *dst)
+    {
+        const __m128i lo = _mm_or_si128(b, _mm_slli_epi16(g, 10));
+        const __m128i hi = _mm_or_si128(_mm_or_si128(_mm_srli_epi16(g, 6), _mm_slli_epi16(r, 4)),
+                                        _mm_set1_epi16((short)0xC000));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4), _mm_unpackhi_epi16(lo, hi));
+    }
+
+    int p010_x2rgb10_row_sse41(const uint16_t *yRow, const uint16_t *uvRow, uint32_t *dst, int width, const YuvMatrix &m)
+    {
+        const MatrixVec k = load_matrix(m);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            store_x2rgb10(r, g, b, dst + x);
+        }
+        return n;
+    }
+
+    // 16-bit UNORM -> 8 bits with threshold d in 0..255; the sum stays below 65536.
+    static inline __m128i dither8(__m128i w, __m128i d)
+    {
+        return _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(w, _mm_srli_epi16(w, 8)), d), 8);
+    }
+
+    int p010_dither_row_sse41(const uint16_t *yRow, const uint16_t *uvRow, uint8_t *dst, int width, const YuvMatrix &m,
+                              const uint16_t *dither)
+    {
+        const MatrixVec k = load_matrix(m);
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dither));
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i r, g, b;
+            p010_rgb10(yRow + x, uvRow + x, k, r, g, b);
+            r = dither8(widen10(r), d);
+            g = dither8(widen10(g), d);
+            b = dither8(widen10(b), d);
+            const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+            const __m128i ra = _mm_or_si128(r, _mm_set1_epi16((short)0xFF00));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+        }
+        return n;
+    }
+
+    int y210_split_row_sse41(const uint16_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        // Even words are Y, odd words are the U V pairs: gather each half into a qword.
+        const __m128i evenOdd = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            const __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 2)), evenOdd);
+            const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 2 + 8)), evenOdd);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(y + x), _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(uv + x), _mm_unpackhi_epi64(a, b));
+        }
+        return n;
+    }
+
+    // One V210 group -> ab = (a | b << 16) and c per dword, where a/b/c are the
+    // 10-bit fields at bits 0/10/20. Word k of ab is field (k & 1 ? b : a) of dword k / 2.
+    static inline void split_v210(__m128i px, __m128i &ab, __m128i &c)
+    {
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        const __m128i a = _mm_and_si128(px, mask);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(px, 10), mask);
+        ab = _mm_or_si128(a, _mm_slli_epi32(b, 16));
+        c = _mm_and_si128(_mm_srli_epi32(px, 20), mask);
+    }
+
+    // Y = b0 a1 c1 b2 a3 c3, UV = a0 c0 b1 a2 c2 b3, U = a0 b1 c2, V = c0 a2 b3.
+    static inline __m128i v210_y(__m128i ab, __m128i c)
+    {
+        const __m128i fromAb = _mm_setr_epi8(2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1);
+        const __m128i fromC = _mm_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1);
+        return _mm_or_si128(_mm_shuffle_epi8(ab, fromAb), _mm_shuffle_epi8(c, fromC));
+    }
+
+    static inline __m128i v210_uv(__m128i ab, __m128i c)
+    {
+        const __m128i fromAb = _mm_setr_epi8(0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1);
+        const __m128i fromC = _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1);
+        return _mm_or_si128(_mm_shuffle_epi8(ab, fromAb), _mm_shuffle_epi8(c, fromC));
+    }
+
+    int v210_row_sse41(const uint8_t *src, uint16_t *y, uint16_t *uv, int width)
+    {
+        // Each store writes 8 words of which 6 are valid; the next group overwrites the rest.
+        int x = 0;
+        for (; x + 8 <= width; x += 6)
+        {
+            __m128i ab, c;
+            split_v210(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)(x / 6) * 16)), ab, c);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(y + x), _mm_slli_epi16(v210_y(ab, c), 6));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(uv + x), _mm_slli_epi16(v210_uv(ab, c), 6));
+        }
+        return x;
+    }
+
+    int v210_planar_row_sse41(const uint8_t *src, uint16_t *y, uint16_t *u, uint16_t *v, int width)
+    {
+        const __m128i uFromAb = _mm_setr_epi8(0, 1, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i uFromC = _mm_setr_epi8(-1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i vFromAb = _mm_setr_epi8(-1, -1, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i vFromC = _mm_setr_epi8(0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        int x = 0;
+        for (; x + 8 <= width; x += 6)
+        {
+            __m128i ab, c;
+            split_v210(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)(x / 6) * 16)), ab, c);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(y + x), v210_y(ab, c));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x / 2),
+                             _mm_or_si128(_mm_shuffle_epi8(ab, uFromAb), _mm_shuffle_epi8(c, uFromC)));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x / 2),
+                             _mm_or_si128(_mm_shuffle_epi8(ab, vFromAb), _mm_shuffle_epi8(c, vFromC)));
+        }
+        return x;
+    }
+
+    // 8 R210 pixels -> R, G, B as 10-bit values in 16-bit lanes.
+    static inline void split_r210(const uint8_t *src, __m128i &r, __m128i &g, __m128i &b)
+    {
+        const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        const __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), bswap);
+        const __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16)), bswap);
+        r = _mm_packus_epi32(_mm_and_si128(_mm_srli_epi32(lo, 20), mask), _mm_and_si128(_mm_srli_epi32(hi, 20), mask));
+        g = _mm_packus_epi32(_mm_and_si128(_mm_srli_epi32(lo, 10), mask), _mm_and_si128(_mm_srli_epi32(hi, 10), mask));
+        b = _mm_packus_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+    }
+
+    int r210_row_sse41(const uint8_t *src, uint8_t *dst, int width)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            r = y210_to_8bit(_mm_slli_epi16(r, 6));
+            g = y210_to_8bit(_mm_slli_epi16(g, 6));
+            b = y210_to_8bit(_mm_slli_epi16(b, 6));
+            const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+            const __m128i ra = _mm_or_si128(r, _mm_set1_epi16((short)0xFF00));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+        }
+        return n;
+    }
+
+    int r210_rgba64_row_sse41(const uint8_t *src, uint16_t *dst, int width)
+    {
+        const int n = width & ~7;
+        for (int x = 0; x < n; x += 8)
+        {
+            __m128i r, g, b;
+            split_r210(src + (size_t)x * 4, r, g, b);
+            store_rgba64(widen10(r), widen10(g), widen10(b), dst + (size_t)x * 4);
+        }
+        return n;
+    }
+
+    const gcap::simd::RowKernels kSse41Kernels = {
+        gcap::simd::Isa::Sse41, "SSE4.1", nv12_row_sse41, yuy2_row_sse41, y210_row_sse41,
+        p010_row_sse41, p010_rgba64_row_sse41, p010_x2rgb10_row_sse41, p010_dither_row_sse41,
+        y210_split_row_sse41, v210_row_sse41, v210_planar_row_sse41,
+        r210_row_sse41, r210_rgba64_row_sse41, hsum3_row_sse41, unsharp_row_sse41,
+        vacc8_row_sse41, vacc10_row_sse41};
+}
+
+const gcap::simd::RowKernels *gcap::simd::sse41_kernels()
+{
+    return &kSse41Kernels;
+}
+
+#else
+
+const gcap::simd::RowKernels *gcap::simd::sse41_kernels()
+{
+    return nullptr;
+}
+
+#endif
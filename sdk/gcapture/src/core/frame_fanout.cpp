@@ -0,0 +1,514 @@
+// frame_fanout.cpp
+#include "frame_fanout.h"
+#include <algorithm>
+#include <cstring>
+#include "frame_arena.h"
+#include "trace.h"
+
+namespace
+{
+    using gcap::YuvLayout;
+
+    bool source_layout(gcap_pixfmt_t fmt, YuvLayout &layout)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            layout = YuvLayout::Nv12;
+            return true;
+        case GCAP_FMT_YUY2:
+            layout = YuvLayout::Yuy2;
+            return true;
+        case GCAP_FMT_P010:
+            layout = YuvLayout::P010;
+            return true;
+        case GCAP_FMT_Y210:
+            layout = YuvLayout::Y210;
+            return true;
+        case GCAP_FMT_V210:
+            layout = YuvLayout::V210;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void copy_plane(const uint8_t *src, int srcStride, uint8_t *dst, int dstStride, int rowBytes, int rows)
+    {
+        for (int y = 0; y < rows; ++y)
+            memcpy(dst + (size_t)y * dstStride, src + (size_t)y * srcStride, (size_t)rowBytes);
+    }
+
+    // 8-bit luma / chroma from BGRA, limited range (BT.601 or BT.709 weights, x256).
+    struct RgbToYuv
+    {
+        int yr, yg, yb, ur, ug, ub, vr, vg, vb;
+    };
+    constexpr RgbToYuv kRgbToYuv601{66, 129, 25, -38, -74, 112, 112, -94, -18};
+    constexpr RgbToYuv kRgbToYuv709{47, 157, 16, -26, -87, 112, 112, -102, -10};
+
+    inline uint8_t clamp_u8(int v)
+    {
+        return (uint8_t)std::clamp(v, 0, 255);
+    }
+
+    void argb_to_nv12(const RgbToYuv &m, const uint8_t *src, int srcStride, int w, int h,
+                      uint8_t *y, int yStride, uint8_t *uv, int uvStride)
+    {
+        for (int r = 0; r < h; ++r)
+        {
+            const uint8_t *s = src + (size_t)r * srcStride;
+            uint8_t *d = y + (size_t)r * yStride;
+            for (int x = 0; x < w; ++x, s += 4)
+                d[x] = clamp_u8(((m.yr * s[2] + m.yg * s[1] + m.yb * s[0] + 128) >> 8) + 16);
+        }
+        // Chroma from the mean of each 2x2 block; odd edges repeat the last column / row.
+        for (int r = 0; r < (h + 1) / 2; ++r)
+        {
+            const uint8_t *s0 = src + (size_t)(2 * r) * srcStride;
+            const uint8_t *s1 = src + (size_t)std::min(2 * r + 1, h - 1) * srcStride;
+            uint8_t *d = uv + (size_t)r * uvStride;
+            for (int x = 0; x < (w + 1) / 2; ++x)
+            {
+                const int x0 = 2 * x * 4, x1 = std::min(2 * x + 1, w - 1) * 4;
+                const int b = s0[x0] + s0[x1] + s1[x0] + s1[x1];
+                const int g = s0[x0 + 1] + s0[x1 + 1] + s1[x0 + 1] + s1[x1 + 1];
+                const int rr = s0[x0 + 2] + s0[x1 + 2] + s1[x0 + 2] + s1[x1 + 2];
+                d[2 * x] = clamp_u8(((m.ur * rr + m.ug * g + m.ub * b + 512) >> 10) + 128);
+                d[2 * x + 1] = clamp_u8(((m.vr * rr + m.vg * g + m.vb * b + 512) >> 10) + 128);
+            }
+        }
+    }
+
+    // Packed 4:2:2 (YUY2 bytes or Y210 words, Y0 U Y1 V) → NV12 planes; T is the sample type.
+    template <typename T, int Shift>
+    void packed422_luma(const uint8_t *src, int srcStride, int w, int h, uint8_t *y, int yStride)
+    {
+        for (int r = 0; r < h; ++r)
+        {
+            const T *s = reinterpret_cast<const T *>(src + (size_t)r * srcStride);
+            uint8_t *d = y + (size_t)r * yStride;
+            for (int x = 0; x < w; ++x)
+                d[x] = (uint8_t)(s[2 * x] >> Shift);
+        }
+    }
+
+    template <typename T, int Shift>
+    void packed422_chroma(const uint8_t *src, int srcStride, int w, int h, uint8_t *uv, int uvStride)
+    {
+        const int pairs = (w + 1) / 2;
+        for (int r = 0; r < (h + 1) / 2; ++r)
+        {
+            const T *s0 = reinterpret_cast<const T *>(src + (size_t)(2 * r) * srcStride);
+            const T *s1 = reinterpret_cast<const T *>(src + (size_t)std::min(2 * r + 1, h - 1) * srcStride);
+            uint8_t *d = uv + (size_t)r * uvStride;
+            for (int x = 0; x < pairs; ++x)
+            {
+                d[2 * x] = (uint8_t)((((s0[4 * x + 1] >> Shift) + (s1[4 * x + 1] >> Shift)) + 1) >> 1);
+                d[2 * x + 1] = (uint8_t)((((s0[4 * x + 3] >> Shift) + (s1[4 * x + 3] >> Shift)) + 1) >> 1);
+            }
+        }
+    }
+
+    // MSB-aligned 16-bit words → bytes.
+    void words_to_bytes(const uint8_t *src, int srcStride, int count, int rows, uint8_t *dst, int dstStride)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            const uint16_t *s = reinterpret_cast<const uint16_t *>(src + (size_t)r * srcStride);
+            uint8_t *d = dst + (size_t)r * dstStride;
+            for (int x = 0; x < count; ++x)
+                d[x] = (uint8_t)(s[x] >> 8);
+        }
+    }
+}
+
+gcap::FrameFanout::FrameFanout(FramePool *pool)
+    : pool_(pool), list_(std::make_shared<const List>())
+{
+}
+
+int gcap::FrameFanout::subscribe(const gcap_subscriber_desc_t &desc)
+{
+    if (!desc.cb || desc.width < 0 || desc.height < 0 || desc.fps_num < 0 || desc.fps_den < 0)
+        return 0;
+
+    auto s = std::make_shared<Subscriber>();
+    s->desc = desc;
+    if (desc.fps_num > 0)
+        s->periodNs = (uint64_t)1000000000ull * (uint64_t)std::max(desc.fps_den, 1) / (uint64_t)desc.fps_num;
+
+    std::lock_guard<std::mutex> lk(listMtx_);
+    s->id = nextId_++;
+    auto next = std::make_shared<List>(*list_);
+    next->push_back(s);
+    list_ = std::move(next);
+    count_.store((int)list_->size(), std::memory_order_release);
+    return s->id;
+}
+
+bool gcap::FrameFanout::unsubscribe(int id)
+{
+    {
+        std::lock_guard<std::mutex> lk(listMtx_);
+        auto next = std::make_shared<List>(*list_);
+        auto it = std::find_if(next->begin(), next->end(), [&](const std::shared_ptr<Subscriber> &s)
+                               { return s->id == id; });
+        if (it == next->end())
+            return false;
+        (*it)->active.store(false, std::memory_order_release);
+        next->erase(it);
+        list_ = std::move(next);
+        count_.store((int)list_->size(), std::memory_order_release);
+    }
+    // Once this returns the callback is not running and will not be called again.
+    // From inside a callback the flag alone is enough: that dispatch checks it per subscriber.
+    if (dispatchThread_.load(std::memory_order_acquire) != std::this_thread::get_id())
+    {
+        std::lock_guard<std::mutex> wait(dispatchMtx_);
+    }
+    return true;
+}
+
+bool gcap::FrameFanout::due(Subscriber &s, uint64_t ptsNs) const
+{
+    if (s.periodNs == 0)
+        return true;
+    const uint64_t period = s.periodNs;
+    // Half a source interval either side of the due time picks the nearest frame.
+    const uint64_t tol = srcIntervalNs_ / 2;
+    // First frame, a pts jump backwards, or a gap longer than a period: restart the cadence here.
+    if (s.nextDueNs == 0 || ptsNs + 2 * period < s.nextDueNs || ptsNs > s.nextDueNs + period)
+        s.nextDueNs = ptsNs;
+    if (ptsNs + tol < s.nextDueNs)
+        return false;
+    s.nextDueNs += period;
+    return true;
+}
+
+void gcap::FrameFanout::dispatch(const gcap_frame_packet_t *pkt)
+{
+    if (!pkt || !active())
+        return;
+    std::shared_ptr<const List> list;
+    {
+        std::lock_guard<std::mutex> lk(listMtx_);
+        list = list_;
+    }
+
+    std::lock_guard<std::mutex> dl(dispatchMtx_);
+    dispatchThread_.store(std::this_thread::get_id(), std::memory_order_release);
+
+    const uint64_t pts = pkt->pts_smoothed_ns ? pkt->pts_smoothed_ns : pkt->pts_ns;
+    if (lastPtsNs_ && pts > lastPtsNs_)
+    {
+        const uint64_t d = pts - lastPtsNs_;
+        srcIntervalNs_ = srcIntervalNs_ ? (srcIntervalNs_ * 7 + d) / 8 : d;
+    }
+    lastPtsNs_ = pts;
+
+    nv12Luma_ = nv12Chroma_ = argbReady_ = false;
+    outputs_.clear();
+    outputs_.reserve(list->size());
+
+    for (const auto &s : *list)
+    {
+        if (!s->active.load(std::memory_order_acquire) || !due(*s, pts))
+            continue;
+
+        const gcap_subscriber_desc_t &d = s->desc;
+        int w = pkt->width, h = pkt->height;
+        video_output_size(gcap_video_output_t{d.width, d.height, d.filter}, pkt->width, pkt->height, w, h);
+        if (d.format == GCAP_FMT_NV12)
+        {
+            w = std::max(2, w & ~1);
+            h = std::max(2, h & ~1);
+        }
+        if (d.format == pkt->format && w == pkt->width && h == pkt->height)
+        {
+            GCAP_TRACE_SCOPE(Callback, pkt->frame_id);
+            d.cb(pkt, d.user);
+            continue;
+        }
+
+        auto it = std::find_if(outputs_.begin(), outputs_.end(), [&](const Output &o)
+                               { return o.format == d.format && o.width == w && o.height == h && o.filter == d.filter; });
+        if (it == outputs_.end())
+        {
+            outputs_.push_back(Output{d.format, w, h, d.filter, false, {}, {}});
+            it = outputs_.end() - 1;
+            GCAP_TRACE_SCOPE(Convert, pkt->frame_id);
+            it->ok = produce(*pkt, *it);
+        }
+        if (it->ok)
+        {
+            GCAP_TRACE_SCOPE(Callback, pkt->frame_id);
+            d.cb(&it->pkt, d.user);
+        }
+    }
+
+    // Drops the fan-out's references; slots the subscribers retained stay with them.
+    outputs_.clear();
+    dispatchThread_.store(std::thread::id(), std::memory_order_release);
+}
+
+bool gcap::FrameFanout::produce(const gcap_frame_packet_t &src, Output &out)
+{
+    if (!pool_ || !src.data[0] || src.width <= 0 || src.height <= 0)
+        return false;
+
+    const int w = out.width, h = out.height;
+    const bool scaled = w != src.width || h != src.height;
+    int strides[2] = {0, 0};
+    size_t offsets[2] = {0, 0};
+    int planes = 1;
+    size_t bytes = 0;
+    switch (out.format)
+    {
+    case GCAP_FMT_ARGB:
+        strides[0] = aligned_row_bytes(w * 4);
+        bytes = (size_t)strides[0] * h;
+        break;
+    case GCAP_FMT_Y8:
+        strides[0] = aligned_row_bytes(w);
+        bytes = (size_t)strides[0] * h;
+        break;
+    case GCAP_FMT_NV12:
+        strides[0] = strides[1] = aligned_row_bytes(w);
+        offsets[1] = (size_t)strides[0] * h;
+        bytes = offsets[1] + (size_t)strides[1] * (h / 2);
+        planes = 2;
+        break;
+    default:
+        return false; // other formats only pass through at the source size
+    }
+
+    out.lease = pool_->acquire(bytes);
+    if (!out.lease)
+        return false;
+    uint8_t *dst = out.lease.data();
+
+    if (out.format == GCAP_FMT_ARGB)
+    {
+        YuvLayout layout;
+        if (source_layout(src.format, layout) && scale_supported(layout))
+        {
+            const FrameConverter &cv = converter(layout, src.height);
+            if (scaled)
+                convert_frame_scaled(cv, plan(layout, src.width, src.height, w, h, out.filter),
+                                     (const uint8_t *)src.data[0], (const uint8_t *)src.data[1],
+                                     src.stride[0], src.stride[1], dst, strides[0]);
+            else
+                convert_frame(cv, (const uint8_t *)src.data[0], (const uint8_t *)src.data[1],
+                              src.stride[0], src.stride[1], src.width, src.height, dst, strides[0]);
+        }
+        else
+        {
+            int argbStride = 0;
+            const uint8_t *argb = sourceArgb(src, argbStride);
+            if (!argb)
+                return false;
+            if (scaled)
+                resample(argb, argbStride, 4, plan(YuvLayout::Yuy2, src.width, src.height, w, h, out.filter), dst, strides[0]);
+            else
+                copy_plane(argb, argbStride, dst, strides[0], w * 4, h);
+        }
+    }
+    else
+    {
+        Nv12View v;
+        if (!sourceNv12(src, out.format == GCAP_FMT_NV12, v))
+            return false;
+        if (scaled)
+            resample(v.y, v.yStride, 1, plan(YuvLayout::Yuy2, src.width, src.height, w, h, out.filter), dst, strides[0]);
+        else
+            copy_plane(v.y, v.yStride, dst, strides[0], w, h);
+        if (planes == 2)
+        {
+            const int cw = (src.width + 1) / 2, ch = (src.height + 1) / 2;
+            if (cw == w / 2 && ch == h / 2)
+                copy_plane(v.uv, v.uvStride, dst + offsets[1], strides[1], w, h / 2);
+            else
+                resample(v.uv, v.uvStride, 2, plan(YuvLayout::Yuy2, cw, ch, w / 2, h / 2, out.filter), dst + offsets[1], strides[1]);
+        }
+    }
+
+    gcap_frame_packet_t &p = out.pkt;
+    p = src;
+    p.width = w;
+    p.height = h;
+    p.format = out.format;
+    p.plane_count = planes;
+    p.gpu_backed = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        p.data[i] = i < planes ? dst + offsets[i] : nullptr;
+        p.stride[i] = i < planes ? strides[i] : 0;
+    }
+    out.lease.attach(p);
+    return true;
+}
+
+bool gcap::FrameFanout::sourceNv12(const gcap_frame_packet_t &src, bool chroma, Nv12View &out)
+{
+    const int w = src.width, h = src.height;
+    if (src.format == GCAP_FMT_NV12)
+    {
+        if (chroma && !src.data[1])
+            return false;
+        out.y = (const uint8_t *)src.data[0];
+        out.uv = (const uint8_t *)src.data[1];
+        out.yStride = src.stride[0];
+        out.uvStride = src.stride[1];
+        return true;
+    }
+
+    const int stride = aligned_row_bytes(w + (w & 1));
+    uint8_t *y = nullptr, *uv = nullptr;
+    if (!nv12Luma_ && !nv12Chroma_)
+        nv12_.resize((size_t)stride * (h + (h + 1) / 2));
+    y = nv12_.data();
+    uv = y + (size_t)stride * h;
+    out.y = y;
+    out.uv = uv;
+    out.yStride = out.uvStride = stride;
+    if (nv12Luma_ && (nv12Chroma_ || !chroma))
+        return true;
+
+    const uint8_t *s0 = (const uint8_t *)src.data[0];
+    switch (src.format)
+    {
+    case GCAP_FMT_P010:
+        if (chroma && !src.data[1])
+            return false;
+        if (!nv12Luma_)
+            words_to_bytes(s0, src.stride[0], w, h, y, stride);
+        if (chroma)
+            words_to_bytes((const uint8_t *)src.data[1], src.stride[1], (w + 1) & ~1, (h + 1) / 2, uv, stride);
+        break;
+    case GCAP_FMT_YUY2:
+        if (!nv12Luma_)
+            packed422_luma<uint8_t, 0>(s0, src.stride[0], w, h, y, stride);
+        if (chroma)
+            packed422_chroma<uint8_t, 0>(s0, src.stride[0], w, h, uv, stride);
+        break;
+    case GCAP_FMT_Y210:
+        if (!nv12Luma_)
+            packed422_luma<uint16_t, 8>(s0, src.stride[0], w, h, y, stride);
+        if (chroma)
+            packed422_chroma<uint16_t, 8>(s0, src.stride[0], w, h, uv, stride);
+        break;
+    case GCAP_FMT_V210:
+    {
+        // Unpacked once to P010 for both planes.
+        const int pStride = aligned_row_bytes(((w + 1) & ~1) * 2);
+        p010_.resize((size_t)pStride * (h + (h + 1) / 2));
+        uint8_t *py = p010_.data(), *puv = py + (size_t)pStride * h;
+        v210_to_p010(s0, w, h, src.stride[0], py, pStride, puv, pStride);
+        words_to_bytes(py, pStride, w, h, y, stride);
+        words_to_bytes(puv, pStride, (w + 1) & ~1, (h + 1) / 2, uv, stride);
+        chroma = true;
+        break;
+    }
+    case GCAP_FMT_ARGB:
+    case GCAP_FMT_R210:
+    {
+        int argbStride = 0;
+        const uint8_t *argb = sourceArgb(src, argbStride);
+        if (!argb)
+            return false;
+        const RgbToYuv &m = default_colorspace(h) == GCAP_CSP_BT709 ? kRgbToYuv709 : kRgbToYuv601;
+        argb_to_nv12(m, argb, argbStride, w, h, y, stride, uv, stride);
+        chroma = true;
+        break;
+    }
+    default:
+        return false;
+    }
+    nv12Luma_ = true;
+    nv12Chroma_ = nv12Chroma_ || chroma;
+    return true;
+}
+
+const uint8_t *gcap::FrameFanout::sourceArgb(const gcap_frame_packet_t &src, int &stride)
+{
+    if (src.format == GCAP_FMT_ARGB)
+    {
+        stride = src.stride[0];
+        return (const uint8_t *)src.data[0];
+    }
+    stride = argbStride_ = aligned_row_bytes(src.width * 4);
+    if (argbReady_)
+        return argb_.data();
+    argb_.resize((size_t)argbStride_ * src.height);
+
+    const uint8_t *s0 = (const uint8_t *)src.data[0];
+    YuvLayout layout;
+    if (src.format == GCAP_FMT_R210)
+        r210_to_argb(s0, src.width, src.height, src.stride[0], argb_.data(), argbStride_);
+    else if (source_layout(src.format, layout))
+        convert_frame(converter(layout, src.height), s0, (const uint8_t *)src.data[1],
+                      src.stride[0], src.stride[1], src.width, src.height, argb_.data(), argbStride_);
+    else
+        return nullptr;
+    argbReady_ = true;
+    return argb_.data();
+}
+
+const gcap::FrameConverter &gcap::FrameFanout::converter(YuvLayout layout, int height)
+{
+    const gcap_colorspace_t csp = default_colorspace(height);
+    if (!cv_.run || cv_.layout != layout || cv_.csp != csp)
+        cv_ = make_frame_converter(layout, csp, GCAP_RANGE_LIMITED, ProcAmpParams{});
+    return cv_;
+}
+
+const gcap::ScalePlan &gcap::FrameFanout::plan(YuvLayout layout, int srcW, int srcH, int dstW, int dstH,
+                                               gcap_scale_filter_t filter)
+{
+    for (const PlanEntry &e : plans_)
+        if (e.layout == layout && e.srcW == srcW && e.srcH == srcH && e.dstW == dstW && e.dstH == dstH && e.filter == filter)
+            return e.plan;
+    // Plans follow the subscriber set and the source size; drop them all when that churns.
+    if (plans_.size() >= 16)
+        plans_.clear();
+    plans_.push_back(PlanEntry{layout, srcW, srcH, dstW, dstH, filter,
+                               make_scale_plan(layout, srcW, srcH, dstW, dstH, filter)});
+    return plans_.back().plan;
+}
+
+void gcap::FrameFanout::resample(const uint8_t *src, int srcStride, int channels, const ScalePlan &sp,
+                                 uint8_t *dst, int dstStride)
+{
+    // Separable, the plan's luma axes for every channel: rows into rowAcc_, then columns.
+    const ScaleAxis &ax = sp.luma_x, &ay = sp.luma_y;
+    const int rowLen = sp.src_width * channels;
+    rowAcc_.resize((size_t)rowLen);
+    for (int oy = 0; oy < sp.dst_height; ++oy)
+    {
+        std::fill(rowAcc_.begin(), rowAcc_.end(), 0u);
+        const uint16_t *wy = ay.weight.data() + (size_t)oy * ay.taps;
+        for (int t = 0; t < ay.taps; ++t)
+        {
+            if (!wy[t])
+                continue;
+            const uint8_t *s = src + (size_t)(ay.start[oy] + t) * srcStride;
+            for (int i = 0; i < rowLen; ++i)
+                rowAcc_[i] += (uint32_t)wy[t] * s[i];
+        }
+
+        uint8_t *d = dst + (size_t)oy * dstStride;
+        for (int ox = 0; ox < sp.dst_width; ++ox)
+        {
+            const uint16_t *wx = ax.weight.data() + (size_t)ox * ax.taps;
+            const uint32_t *a = rowAcc_.data() + (size_t)ax.start[ox] * channels;
+            for (int c = 0; c < channels; ++c)
+            {
+                uint32_t acc = 0;
+                for (int t = 0; t < ax.taps; ++t)
+                    acc += wx[t] * a[t * channels + c];
+                d[ox * channels + c] = (uint8_t)std::min<uint32_t>((acc + 32768) >> 16, 255);
+            }
+        }
+    }
+}
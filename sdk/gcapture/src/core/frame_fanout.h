@@ -0,0 +1,116 @@
+// frame_fanout.h
+// gcap_subscribe(): per-subscriber format, size and rate on top of the packet
+// stream. Portable; one instance per CaptureManager.
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gcapture.h"
+#include "frame_converter.h"
+#include "frame_pool.h"
+
+namespace gcap
+{
+    /**
+     * Hands every provider packet to the subscribers that are due for it. A
+     * subscriber with a target rate gets the frames closest to its own cadence,
+     * picked by pts (the smoothed one when the provider has it), so 24 from 60
+     * comes out as an even 3:2 pattern instead of whatever the timer saw.
+     *
+     * Outputs are built once per distinct (format, size, filter) per frame into
+     * a pool slot and shared by every subscriber that asked for them; a
+     * subscriber asking for the source format and size gets the source packet.
+     *
+     * ARGB: fused convert + resize for NV12 / YUY2 / P010 / Y210, converted and
+     * then resampled for V210 / R210 / ARGB sources. NV12 and Y8 go through an
+     * 8-bit source-size NV12 view (zero-copy for NV12 sources), built once per
+     * frame and resampled per output. NV12 outputs are rounded down to even sizes.
+     *
+     * dispatch() is called by one thread at a time; subscribe() / unsubscribe()
+     * from any thread.
+     */
+    class FrameFanout
+    {
+    public:
+        explicit FrameFanout(FramePool *pool);
+        FrameFanout(const FrameFanout &) = delete;
+        FrameFanout &operator=(const FrameFanout &) = delete;
+
+        // Subscriber id (> 0), or 0 when the description is invalid.
+        int subscribe(const gcap_subscriber_desc_t &desc);
+        bool unsubscribe(int id);
+        bool active() const { return count_.load(std::memory_order_acquire) > 0; }
+
+        void dispatch(const gcap_frame_packet_t *pkt);
+
+    private:
+        struct Subscriber
+        {
+            int id = 0;
+            gcap_subscriber_desc_t desc{};
+            uint64_t periodNs = 0;          // 0 = every frame
+            uint64_t nextDueNs = 0;         // dispatch thread only
+            std::atomic<bool> active{true}; // cleared by unsubscribe()
+        };
+        using List = std::vector<std::shared_ptr<Subscriber>>;
+
+        struct Output
+        {
+            gcap_pixfmt_t format;
+            int width, height;
+            gcap_scale_filter_t filter;
+            bool ok;
+            gcap_frame_packet_t pkt;
+            FrameLease lease;
+        };
+
+        // 8-bit NV12 planes at the source size.
+        struct Nv12View
+        {
+            const uint8_t *y = nullptr;
+            const uint8_t *uv = nullptr;
+            int yStride = 0;
+            int uvStride = 0;
+        };
+
+        bool due(Subscriber &s, uint64_t ptsNs) const;
+        bool produce(const gcap_frame_packet_t &src, Output &out);
+        bool sourceNv12(const gcap_frame_packet_t &src, bool chroma, Nv12View &out);
+        const uint8_t *sourceArgb(const gcap_frame_packet_t &src, int &stride);
+        const FrameConverter &converter(YuvLayout layout, int height);
+        const ScalePlan &plan(YuvLayout layout, int srcW, int srcH, int dstW, int dstH, gcap_scale_filter_t filter);
+        void resample(const uint8_t *src, int srcStride, int channels, const ScalePlan &sp, uint8_t *dst, int dstStride);
+
+        FramePool *pool_;
+
+        std::mutex listMtx_;
+        std::shared_ptr<const List> list_; // replaced, never edited, so dispatch() reads a snapshot
+        std::atomic<int> count_{0};
+        int nextId_ = 1;
+
+        // Held for one dispatch(); unsubscribe() takes it to wait out a running callback.
+        std::mutex dispatchMtx_;
+        std::atomic<std::thread::id> dispatchThread_{};
+
+        // Dispatch thread only.
+        uint64_t lastPtsNs_ = 0;
+        uint64_t srcIntervalNs_ = 0;
+        std::vector<Output> outputs_;
+        std::vector<uint8_t> nv12_, p010_, argb_;
+        bool nv12Luma_ = false, nv12Chroma_ = false, argbReady_ = false;
+        int argbStride_ = 0;
+        std::vector<uint32_t> rowAcc_;
+        FrameConverter cv_;
+        int cvHeight_ = -1;
+        struct PlanEntry
+        {
+            YuvLayout layout;
+            int srcW, srcH, dstW, dstH;
+            gcap_scale_filter_t filter;
+            ScalePlan plan;
+        };
+        std::vector<PlanEntry> plans_;
+    };
+}
@@ -0,0 +1,367 @@
+// frame_pool.cpp
+#include "frame_pool.h"
+#include <algorithm>
+#include <new>
+#include <thread>
+
+namespace
+{
+    constexpr int kDefaultSlots = 4;
+    constexpr int kMaxSlots = 64;
+    constexpr size_t kAlign = 64;
+
+    // The first retain of a callback's descriptor copies it into the slot so the
+    // application gets a pointer that outlives the callback. Later retains (same
+    // frame from another consumer, or of the copy itself) only wait for it.
+    template <typename T>
+    const T *publish_descriptor(T &stored, std::atomic<int> &state, const T *src, gcap::FrameSlot *slot)
+    {
+        if (src == &stored)
+            return &stored;
+        int expected = 0;
+        if (state.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+        {
+            stored = *src;
+            stored.lease = slot;
+            state.store(2, std::memory_order_release);
+        }
+        else
+        {
+            while (state.load(std::memory_order_acquire) != 2)
+                std::this_thread::yield();
+        }
+        return &stored;
+    }
+}
+
+gcap::FrameLease &gcap::FrameLease::operator=(FrameLease &&o) noexcept
+{
+    if (this != &o)
+    {
+        reset();
+        slot_ = o.slot_;
+        o.slot_ = nullptr;
+    }
+    return *this;
+}
+
+void gcap::FrameLease::reset()
+{
+    if (!slot_)
+        return;
+    FramePool::unref(slot_);
+    slot_ = nullptr;
+}
+
+gcap::FramePool *gcap::FramePool::create()
+{
+    FramePool *pool = new FramePool();
+    gcap_lease_opts_t opts{};
+    pool->configure(opts);
+    return pool;
+}
+
+gcap::FramePool::~FramePool()
+{
+    for (FrameSlot *s : free_)
+        destroySlot(s);
+}
+
+void gcap::FramePool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        closed_ = true;
+        for (FrameSlot *s : free_)
+            destroySlot(s);
+        slots_ -= (int)free_.size();
+        free_.clear();
+    }
+    dropRef();
+}
+
+void gcap::FramePool::configure(const gcap_lease_opts_t &opts)
+{
+    const int slots = std::clamp(opts.slots > 0 ? opts.slots : kDefaultSlots, 1, kMaxSlots);
+    const int maxSlots = std::clamp(opts.max_slots > 0 ? opts.max_slots : 2 * slots, slots, kMaxSlots);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    leaseSlots_ = slots;
+    leaseMax_ = maxSlots;
+    policy_.store(opts.policy, std::memory_order_relaxed);
+    applySlotLimits();
+}
+
+void gcap::FramePool::setQueueSlots(int n)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    queueSlots_ = std::clamp(n, 0, kMaxSlots + 1);
+    applySlotLimits();
+}
+
+bool gcap::FramePool::setBuffers(int count, size_t bytesHint, bool hugePages)
+{
+    std::unique_ptr<FrameArena> arena;
+    if (count > 0 && bytesHint > 0)
+    {
+        arena = std::make_unique<FrameArena>(std::min(count, kMaxSlots), bytesHint, hugePages);
+        if (!arena->valid())
+            arena.reset();
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    // Free slots drop their old blocks now; leased ones on their way back.
+    for (FrameSlot *s : free_)
+        freeStorage(s);
+    if (arena_)
+    {
+        if (arena_->idle())
+            arena_.reset();
+        else
+            retired_.push_back(std::move(arena_));
+    }
+    arena_ = std::move(arena);
+    bufferSlots_ = std::clamp(count, 0, kMaxSlots);
+    applySlotLimits();
+
+    // Bind every free slot to a block up front, so prefault() covers them and
+    // the first frames do not allocate.
+    if (arena_)
+    {
+        for (FrameSlot *s : free_)
+        {
+            uint8_t *p = arena_->allocate(arena_->blockBytes());
+            if (!p)
+                break;
+            s->data = p;
+            s->capacity = arena_->blockBytes();
+            s->arena = arena_.get();
+        }
+    }
+    return arena_ != nullptr || count <= 0 || bytesHint == 0;
+}
+
+void gcap::FramePool::prefault()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!arena_)
+        return;
+    // Slots already bound to blocks hold them outside the arena's free list.
+    for (FrameSlot *s : free_)
+    {
+        if (s->arena != arena_.get())
+            continue;
+        volatile uint8_t *p = s->data;
+        for (size_t off = 0; off < s->capacity; off += 4096)
+            p[off] = 0;
+    }
+    arena_->prefault();
+}
+
+// Keeps the preallocated slot count at max(lease slots, buffer count) plus the
+// delivery queue's share and drops free slots above the growth limit.
+void gcap::FramePool::applySlotLimits()
+{
+    minSlots_ = std::max(leaseSlots_, bufferSlots_) + queueSlots_;
+    maxSlots_ = std::max(leaseMax_ + queueSlots_, minSlots_);
+    while (slots_ < minSlots_)
+    {
+        FrameSlot *s = new FrameSlot();
+        s->pool = this;
+        free_.push_back(s);
+        ++slots_;
+    }
+    while (slots_ > maxSlots_ && !free_.empty())
+    {
+        destroySlot(free_.back());
+        free_.pop_back();
+        --slots_;
+    }
+}
+
+bool gcap::FramePool::bindStorage(FrameSlot *slot, size_t bytes)
+{
+    // Storage from a replaced arena is dropped on recycle; anything else that fits is kept,
+    // including heap blocks, so an oversized format does not allocate every frame.
+    if (slot->data && slot->capacity >= bytes)
+        return true;
+
+    freeStorage(slot);
+    if (arena_)
+    {
+        if (uint8_t *p = arena_->allocate(bytes))
+        {
+            slot->data = p;
+            slot->capacity = arena_->blockBytes();
+            slot->arena = arena_.get();
+            return true;
+        }
+        ++arenaMisses_;
+    }
+
+    const size_t cap = (std::max<size_t>(bytes, 1) + kAlign - 1) / kAlign * kAlign;
+    slot->data = static_cast<uint8_t *>(::operator new(cap, std::align_val_t(kAlign), std::nothrow));
+    if (!slot->data)
+        return false;
+    slot->capacity = cap;
+    slot->arena = nullptr;
+    return true;
+}
+
+void gcap::FramePool::freeStorage(FrameSlot *slot)
+{
+    if (!slot->data)
+        return;
+    if (FrameArena *a = slot->arena)
+    {
+        a->release(slot->data);
+        if (a != arena_.get() && a->idle())
+        {
+            retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [a](const std::unique_ptr<FrameArena> &r)
+                                          { return r.get() == a; }),
+                           retired_.end());
+        }
+    }
+    else
+    {
+        ::operator delete(slot->data, std::align_val_t(kAlign));
+    }
+    slot->data = nullptr;
+    slot->capacity = 0;
+    slot->arena = nullptr;
+}
+
+void gcap::FramePool::destroySlot(FrameSlot *slot)
+{
+    freeStorage(slot);
+    delete slot;
+}
+
+gcap::FrameLease gcap::FramePool::acquire(size_t bytes)
+{
+    FrameSlot *slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (closed_)
+            return FrameLease();
+        if (!free_.empty())
+        {
+            // Prefer a slot that already fits, so resolution changes do not churn every buffer.
+            auto it = std::find_if(free_.begin(), free_.end(), [&](const FrameSlot *s)
+                                   { return s->data && s->capacity >= bytes; });
+            if (it == free_.end())
+                it = free_.begin();
+            slot = *it;
+            *it = free_.back();
+            free_.pop_back();
+        }
+        else if (slots_ < maxSlots_)
+        {
+            slot = new FrameSlot();
+            slot->pool = this;
+            ++slots_;
+        }
+        else
+        {
+            exhausted_.fetch_add(1, std::memory_order_relaxed);
+            return FrameLease();
+        }
+
+        if (!bindStorage(slot, bytes))
+        {
+            free_.push_back(slot);
+            exhausted_.fetch_add(1, std::memory_order_relaxed);
+            return FrameLease();
+        }
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot->frameState.store(0, std::memory_order_relaxed);
+    slot->packetState.store(0, std::memory_order_relaxed);
+    slot->refs.store(1, std::memory_order_release);
+    return FrameLease(slot);
+}
+
+gcap::FramePool::Stats gcap::FramePool::stats() const
+{
+    Stats st;
+    st.leases = leases_.load(std::memory_order_relaxed);
+    st.exhausted = exhausted_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    st.slots = slots_;
+    st.arenaMisses = arenaMisses_;
+    if (arena_)
+    {
+        st.arenaBytes = arena_->reservedBytes();
+        st.hugePages = arena_->hugePages();
+        // Blocks bound to free slots are parked, not in use.
+        size_t parked = 0;
+        for (const FrameSlot *s : free_)
+            if (s->arena == arena_.get())
+                parked += arena_->blockBytes();
+        st.arenaUsedBytes = arena_->usedBytes() - parked;
+    }
+    return st;
+}
+
+const gcap_frame_t *gcap::FramePool::retain(const gcap_frame_t *f)
+{
+    FrameSlot *slot = f ? static_cast<FrameSlot *>(const_cast<void *>(f->lease)) : nullptr;
+    if (!slot)
+        return nullptr;
+    slot->refs.fetch_add(1, std::memory_order_relaxed);
+    slot->pool->leases_.fetch_add(1, std::memory_order_relaxed);
+    return publish_descriptor(slot->frame, slot->frameState, f, slot);
+}
+
+const gcap_frame_packet_t *gcap::FramePool::retain(const gcap_frame_packet_t *p)
+{
+    FrameSlot *slot = p ? static_cast<FrameSlot *>(const_cast<void *>(p->lease)) : nullptr;
+    if (!slot)
+        return nullptr;
+    slot->refs.fetch_add(1, std::memory_order_relaxed);
+    slot->pool->leases_.fetch_add(1, std::memory_order_relaxed);
+    return publish_descriptor(slot->packet, slot->packetState, p, slot);
+}
+
+void gcap::FramePool::release(const void *lease)
+{
+    FrameSlot *slot = static_cast<FrameSlot *>(const_cast<void *>(lease));
+    if (!slot)
+        return;
+    slot->pool->leases_.fetch_sub(1, std::memory_order_relaxed);
+    unref(slot);
+}
+
+void gcap::FramePool::unref(FrameSlot *slot)
+{
+    if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        slot->pool->recycle(slot);
+}
+
+void gcap::FramePool::recycle(FrameSlot *slot)
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (closed_ || slots_ > maxSlots_)
+        {
+            destroySlot(slot);
+            --slots_;
+        }
+        else
+        {
+            // A block from a replaced arena goes back to it; the slot rebinds on its next use.
+            if (slot->arena && slot->arena != arena_.get())
+                freeStorage(slot);
+            free_.push_back(slot);
+        }
+    }
+    dropRef();
+}
+
+void gcap::FramePool::dropRef()
+{
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
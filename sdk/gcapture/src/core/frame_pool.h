@@ -0,0 +1,149 @@
+// frame_pool.h
+// Recycled frame slots behind gcap_frame_retain() / gcap_frame_release().
+// Internal to the SDK; one pool per CaptureManager, configured through
+// gcap_set_lease_policy() and gcap_set_buffers().
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "gcapture.h"
+#include "frame_arena.h"
+
+namespace gcap
+{
+    class FramePool;
+
+    /**
+     * One pooled frame buffer. `refs` counts the provider while it fills and
+     * delivers the frame plus every application lease; the slot goes back to the
+     * free list when the last one lets go.
+     */
+    struct FrameSlot
+    {
+        FramePool *pool = nullptr;
+        std::atomic<int> refs{0};
+        uint8_t *data = nullptr; // 64-byte aligned
+        size_t capacity = 0;
+        FrameArena *arena = nullptr; // block owner; nullptr = heap fallback
+        // Stable copies of the delivered descriptors, filled on the first retain.
+        gcap_frame_t frame{};
+        gcap_frame_packet_t packet{};
+        std::atomic<int> frameState{0}; // 0 empty, 1 being copied, 2 ready
+        std::atomic<int> packetState{0};
+    };
+
+    // Provider-side reference to a slot. Move-only; drops the provider's
+    // reference on destruction, after the callbacks have returned.
+    class FrameLease
+    {
+    public:
+        FrameLease() = default;
+        explicit FrameLease(FrameSlot *slot) : slot_(slot) {}
+        FrameLease(FrameLease &&o) noexcept : slot_(o.slot_) { o.slot_ = nullptr; }
+        FrameLease &operator=(FrameLease &&o) noexcept;
+        FrameLease(const FrameLease &) = delete;
+        FrameLease &operator=(const FrameLease &) = delete;
+        ~FrameLease() { reset(); }
+
+        explicit operator bool() const { return slot_ != nullptr; }
+        uint8_t *data() const { return slot_->data; }
+        size_t capacity() const { return slot_->capacity; }
+
+        // Marks a descriptor whose planes point into this slot as retainable.
+        void attach(gcap_frame_t &f) const { f.lease = slot_; }
+        void attach(gcap_frame_packet_t &p) const { p.lease = slot_; }
+
+        void reset();
+
+    private:
+        FrameSlot *slot_ = nullptr;
+    };
+
+    /**
+     * Frame slots recycled between the provider and the application. A frame
+     * delivered from a slot can be retained by the callback and read from any
+     * thread until released, without copying. When every slot is leased and
+     * the pool is at max_slots, acquire() comes back empty and the provider
+     * applies the configured gcap_lease_policy_t.
+     *
+     * Slot memory comes from the FrameArena sized by gcap_set_buffers() (heap
+     * blocks, counted as arena misses, when a frame does not fit or the arena is
+     * full), so steady-state capture allocates nothing once the slots are warm.
+     *
+     * The pool is reference counted by its owner and by every slot that is out
+     * of the free list, so leases released after gcap_close() stay valid.
+     */
+    class FramePool
+    {
+    public:
+        static FramePool *create();
+        // Drops the owner's reference; outstanding leases keep the pool alive.
+        void shutdown();
+
+        void configure(const gcap_lease_opts_t &opts);
+        // Extra slots, preallocated, for frames held by the delivery queue.
+        void setQueueSlots(int n);
+        gcap_lease_policy_t policy() const { return policy_.load(std::memory_order_relaxed); }
+
+        // Replaces the arena with `count` blocks of `bytesHint` (count or bytesHint 0 = no
+        // arena) and binds free slots to it. Blocks still leased keep the old arena alive.
+        // Returns false if the reservation failed (slots keep using the heap).
+        bool setBuffers(int count, size_t bytesHint, bool hugePages);
+        void prefault();
+
+        // Free slot with at least `bytes` of storage. Empty when the pool is exhausted.
+        FrameLease acquire(size_t bytes);
+
+        struct Stats
+        {
+            int slots = 0;
+            int leases = 0;
+            uint64_t exhausted = 0;
+            size_t arenaBytes = 0;
+            size_t arenaUsedBytes = 0;
+            bool hugePages = false;
+            uint64_t arenaMisses = 0;
+        };
+        Stats stats() const;
+
+        // C API entry points. Return nullptr for frames not delivered from a slot.
+        static const gcap_frame_t *retain(const gcap_frame_t *f);
+        static const gcap_frame_packet_t *retain(const gcap_frame_packet_t *p);
+        static void release(const void *lease);
+
+    private:
+        friend class FrameLease;
+
+        FramePool() = default;
+        ~FramePool();
+
+        static void unref(FrameSlot *slot);
+        void recycle(FrameSlot *slot);
+        void dropRef();
+        // Callers hold mtx_.
+        bool bindStorage(FrameSlot *slot, size_t bytes);
+        void freeStorage(FrameSlot *slot);
+        void destroySlot(FrameSlot *slot);
+        void applySlotLimits();
+
+        mutable std::mutex mtx_;
+        std::vector<FrameSlot *> free_;
+        int slots_ = 0;       // slots allocated (free + in use)
+        int leaseSlots_ = 4;  // gcap_lease_opts_t::slots
+        int leaseMax_ = 8;    // gcap_lease_opts_t::max_slots
+        int bufferSlots_ = 0; // gcap_set_buffers() count
+        int queueSlots_ = 0;  // gcap_set_delivery() depth + 1
+        int minSlots_ = 4;    // preallocated: max(leaseSlots_, bufferSlots_) + queueSlots_
+        int maxSlots_ = 8;    // growth limit while leases are held: max(leaseMax_, minSlots_) + queueSlots_
+        bool closed_ = false;
+        std::unique_ptr<FrameArena> arena_;
+        std::vector<std::unique_ptr<FrameArena>> retired_; // replaced arenas with blocks still leased
+        uint64_t arenaMisses_ = 0;
+        std::atomic<gcap_lease_policy_t> policy_{GCAP_LEASE_POLICY_UNLEASED};
+        std::atomic<int> refs_{1}; // owner + slots out of the free list
+        std::atomic<int> leases_{0};
+        std::atomic<uint64_t> exhausted_{0};
+    };
+}
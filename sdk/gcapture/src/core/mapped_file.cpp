@@ -0,0 +1,110 @@
+// mapped_file.cpp
+#include "mapped_file.h"
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <string>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool gcap::MappedFile::open(const char *pathUtf8)
+{
+    close();
+    if (!pathUtf8 || !*pathUtf8)
+        return false;
+#ifdef _WIN32
+    const int n = MultiByteToWideChar(CP_UTF8, 0, pathUtf8, -1, nullptr, 0);
+    if (n <= 0)
+        return false;
+    std::wstring wpath((size_t)n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, pathUtf8, -1, &wpath[0], n);
+
+    HANDLE f = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(f, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+    {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *p = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!p)
+    {
+        if (m)
+            CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    file_ = f;
+    mapping_ = m;
+    bytes_ = (uint64_t)size.QuadPart;
+#else
+    const int fd = ::open(pathUtf8, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= (uint64_t)SIZE_MAX)
+        p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+    // Larger kernel read-ahead, and pages behind the reader are reclaimed first.
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    fd_ = fd;
+    bytes_ = (uint64_t)st.st_size;
+#endif
+    base_ = (const uint8_t *)p;
+    return true;
+}
+
+void gcap::MappedFile::close()
+{
+    if (!base_)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle((HANDLE)mapping_);
+    CloseHandle((HANDLE)file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap((void *)base_, (size_t)bytes_);
+    ::close(fd_);
+    fd_ = -1;
+#endif
+    base_ = nullptr;
+    bytes_ = 0;
+}
+
+void gcap::MappedFile::willNeed(uint64_t offset, uint64_t bytes) const
+{
+    if (!base_ || offset >= bytes_ || bytes == 0)
+        return;
+    if (bytes > bytes_ - offset)
+        bytes = bytes_ - offset;
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range{(PVOID)(base_ + offset), (SIZE_T)bytes};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    // madvise wants a page-aligned start.
+    static const uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    const uint64_t start = offset / page * page;
+    madvise((void *)(base_ + start), (size_t)(offset + bytes - start), MADV_WILLNEED);
+#endif
+}
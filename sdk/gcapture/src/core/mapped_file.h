@@ -0,0 +1,38 @@
+// mapped_file.h
+// Read-only mapping of a whole file, with read-ahead hints for streaming through
+// it front to back (Win32 file mapping / POSIX mmap).
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace gcap
+{
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Fails for empty files and, in 32-bit processes, files larger than the address space.
+        bool open(const char *pathUtf8);
+        void close();
+        const uint8_t *data() const { return base_; }
+        uint64_t size() const { return bytes_; }
+
+        // Starts reading [offset, offset + bytes) in the background (clamped to the file),
+        // so the pages are resident by the time they are touched.
+        void willNeed(uint64_t offset, uint64_t bytes) const;
+
+    private:
+        const uint8_t *base_ = nullptr;
+        uint64_t bytes_ = 0;
+#ifdef _WIN32
+        void *file_ = nullptr;
+        void *mapping_ = nullptr;
+#else
+        int fd_ = -1;
+#endif
+    };
+}
@@ -0,0 +1,280 @@
+// packet_convert.cpp
+#include "packet_convert.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "frame_arena.h"
+#include "frame_converter.h"
+#include "trace.h"
+
+namespace
+{
+    using gcap::FrameOutput;
+    using gcap::YuvLayout;
+
+    // A few frames is enough: consumers of one frame ask for it within a frame time.
+    constexpr int kCacheEntries = 4;
+
+    int bytes_per_pixel(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_ARGB:
+        case GCAP_FMT_X2R10G10B10:
+            return 4;
+        case GCAP_FMT_RGBA64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    bool yuv_layout(gcap_pixfmt_t fmt, YuvLayout &layout)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            layout = YuvLayout::Nv12;
+            return true;
+        case GCAP_FMT_YUY2:
+            layout = YuvLayout::Yuy2;
+            return true;
+        case GCAP_FMT_P010:
+            layout = YuvLayout::P010;
+            return true;
+        case GCAP_FMT_Y210:
+            layout = YuvLayout::Y210;
+            return true;
+        case GCAP_FMT_V210:
+            layout = YuvLayout::V210;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool frame_output(gcap_pixfmt_t fmt, FrameOutput &out)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_ARGB:
+            out = FrameOutput::Bgra8;
+            return true;
+        case GCAP_FMT_RGBA64:
+            out = FrameOutput::Rgba64;
+            return true;
+        case GCAP_FMT_X2R10G10B10:
+            out = FrameOutput::X2R10G10B10;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool supported(gcap_pixfmt_t src, gcap_pixfmt_t dst)
+    {
+        YuvLayout layout;
+        if (yuv_layout(src, layout))
+            return dst == GCAP_FMT_ARGB || ((dst == GCAP_FMT_RGBA64 || dst == GCAP_FMT_X2R10G10B10) && gcap::is_10bit_layout(layout));
+        if (src == GCAP_FMT_R210)
+            return dst == GCAP_FMT_ARGB || dst == GCAP_FMT_RGBA64;
+        return false;
+    }
+
+    void convert(const gcap_frame_packet_t &p, gcap_pixfmt_t dstFormat, uint8_t *dst, int dstStride)
+    {
+        GCAP_TRACE_SCOPE(Convert, p.frame_id);
+        const uint8_t *s0 = (const uint8_t *)p.data[0];
+        if (p.format == GCAP_FMT_R210)
+        {
+            if (dstFormat == GCAP_FMT_RGBA64)
+                gcap::r210_to_rgba64(s0, p.width, p.height, p.stride[0], dst, dstStride);
+            else
+                gcap::r210_to_argb(s0, p.width, p.height, p.stride[0], dst, dstStride);
+            return;
+        }
+        YuvLayout layout = YuvLayout::Nv12;
+        FrameOutput output = FrameOutput::Bgra8;
+        yuv_layout(p.format, layout);
+        frame_output(dstFormat, output);
+        const gcap::FrameConverter cv = gcap::make_frame_converter(layout, gcap::default_colorspace(p.height), GCAP_RANGE_LIMITED,
+                                                                   gcap::ProcAmpParams{}, output);
+        gcap::convert_frame(cv, s0, (const uint8_t *)p.data[1], p.stride[0], p.stride[1], p.width, p.height, dst, dstStride);
+    }
+
+    void copy_rows(const uint8_t *src, int srcStride, uint8_t *dst, int dstStride, size_t rowBytes, int rows)
+    {
+        for (int y = 0; y < rows; ++y)
+            memcpy(dst + (size_t)y * dstStride, src + (size_t)y * srcStride, rowBytes);
+    }
+
+    struct Key
+    {
+        const void *data0;
+        uint64_t frameId;
+        uint64_t ptsNs;
+        int width, height;
+        gcap_pixfmt_t src, dst;
+
+        bool operator==(const Key &o) const
+        {
+            return data0 == o.data0 && frameId == o.frameId && ptsNs == o.ptsNs && width == o.width &&
+                   height == o.height && src == o.src && dst == o.dst;
+        }
+    };
+
+    class ConvertCache
+    {
+    public:
+        gcap_status_t run(const gcap_frame_packet_t &p, gcap_pixfmt_t dstFormat, uint8_t *dst, int dstStride)
+        {
+            const Key key{p.data[0], p.frame_id, p.pts_ns, p.width, p.height, p.format, dstFormat};
+            const size_t rowBytes = (size_t)p.width * bytes_per_pixel(dstFormat);
+
+            std::unique_lock<std::mutex> lk(mtx_);
+            for (;;)
+            {
+                Entry *e = find(key);
+                if (!e)
+                    break;
+                if (e->state == State::Ready)
+                {
+                    ++hits_;
+                    return copyOut(lk, *e, dst, dstStride, rowBytes, p.height);
+                }
+                // Another consumer is converting this frame; its result is ours.
+                readyCv_.wait(lk);
+            }
+
+            ++conversions_;
+            Entry *e = victim();
+            if (!e)
+            {
+                // Every entry busy: convert without caching rather than wait.
+                lk.unlock();
+                convert(p, dstFormat, dst, dstStride);
+                return GCAP_OK;
+            }
+            e->key = key;
+            e->state = State::Converting;
+            e->users = 1;
+            e->stride = gcap::aligned_row_bytes((int)rowBytes);
+            lk.unlock();
+
+            // The entry is ours until Ready; nobody else touches the buffer.
+            if (e->buf.size() < (size_t)e->stride * p.height)
+                e->buf.resize((size_t)e->stride * p.height);
+            convert(p, dstFormat, e->buf.data(), e->stride);
+
+            lk.lock();
+            e->state = State::Ready;
+            e->lastUse = ++clock_;
+            --e->users;
+            readyCv_.notify_all();
+            return copyOut(lk, *e, dst, dstStride, rowBytes, p.height);
+        }
+
+        gcap::PacketConvertStats stats()
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            gcap::PacketConvertStats st;
+            st.conversions = conversions_;
+            st.hits = hits_;
+            return st;
+        }
+
+    private:
+        enum class State
+        {
+            Empty,
+            Converting,
+            Ready
+        };
+
+        struct Entry
+        {
+            Key key{};
+            State state = State::Empty;
+            int users = 0; // converting or copying out; the entry is not reused meanwhile
+            int stride = 0;
+            uint64_t lastUse = 0;
+            std::vector<uint8_t> buf;
+        };
+
+        Entry *find(const Key &key)
+        {
+            for (Entry &e : entries_)
+                if (e.state != State::Empty && e.key == key)
+                    return &e;
+            return nullptr;
+        }
+
+        Entry *victim()
+        {
+            Entry *best = nullptr;
+            for (Entry &e : entries_)
+            {
+                if (e.users)
+                    continue;
+                if (e.state == State::Empty)
+                    return &e;
+                if (!best || e.lastUse < best->lastUse)
+                    best = &e;
+            }
+            return best;
+        }
+
+        gcap_status_t copyOut(std::unique_lock<std::mutex> &lk, Entry &e, uint8_t *dst, int dstStride, size_t rowBytes, int rows)
+        {
+            ++e.users;
+            e.lastUse = ++clock_;
+            lk.unlock();
+            copy_rows(e.buf.data(), e.stride, dst, dstStride, rowBytes, rows);
+            lk.lock();
+            --e.users;
+            return GCAP_OK;
+        }
+
+        std::mutex mtx_;
+        std::condition_variable readyCv_;
+        Entry entries_[kCacheEntries];
+        uint64_t clock_ = 0;
+        uint64_t conversions_ = 0;
+        uint64_t hits_ = 0;
+    };
+
+    ConvertCache &cache()
+    {
+        static ConvertCache c;
+        return c;
+    }
+}
+
+gcap_status_t gcap::packet_convert(const gcap_frame_packet_t &p, gcap_pixfmt_t dstFormat, uint8_t *dst, int dstStride)
+{
+    const int bpp = bytes_per_pixel(dstFormat);
+    if (!dst || p.gpu_backed || !p.data[0] || p.width <= 0 || p.height <= 0 || p.stride[0] <= 0)
+        return GCAP_EINVAL;
+    if (bpp == 0)
+        return GCAP_ENOTSUP;
+    if (dstStride < p.width * bpp)
+        return GCAP_EINVAL;
+
+    if (p.format == dstFormat)
+    {
+        copy_rows((const uint8_t *)p.data[0], p.stride[0], dst, dstStride, (size_t)p.width * bpp, p.height);
+        return GCAP_OK;
+    }
+    if (!supported(p.format, dstFormat))
+        return GCAP_ENOTSUP;
+    if ((p.format == GCAP_FMT_NV12 || p.format == GCAP_FMT_P010) && (!p.data[1] || p.stride[1] <= 0))
+        return GCAP_EINVAL;
+    return cache().run(p, dstFormat, dst, dstStride);
+}
+
+gcap::PacketConvertStats gcap::packet_convert_stats()
+{
+    return cache().stats();
+}
@@ -0,0 +1,36 @@
+// packet_convert.h
+// gcap_packet_convert(): on-demand conversion of delivered packets with the
+// SDK kernels, memoised process-wide per (frame, output format). Portable.
+#pragma once
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * Converts a CPU packet into `dst` (dstStride bytes per row, pkt.height rows).
+     *
+     *   GCAP_FMT_ARGB                 from NV12 / YUY2 / P010 / Y210 / V210 / R210 / ARGB
+     *   GCAP_FMT_RGBA64, X2R10G10B10  from P010 / Y210 / V210 (and R210 for RGBA64), full 10 bits
+     *
+     * YUV sources use the colour space the capture paths assume for an unsignalled
+     * source (BT.601 below 720 lines, BT.709 otherwise), limited range, neutral ProcAmp.
+     *
+     * The converted frame is kept in a small process-wide cache keyed by the packet's
+     * identity (planes, frame_id, pts, size, format) and the output format, so every
+     * other consumer asking for the same frame and format gets a row copy instead of
+     * a second conversion; a request racing the first one waits for it. A same-format
+     * request is a plain row copy and is not cached.
+     *
+     * GCAP_ENOTSUP for other format pairs, GCAP_EINVAL for a GPU-backed or empty packet
+     * or a dstStride too small for the row.
+     */
+    gcap_status_t packet_convert(const gcap_frame_packet_t &pkt, gcap_pixfmt_t dstFormat, uint8_t *dst, int dstStride);
+
+    struct PacketConvertStats
+    {
+        uint64_t conversions = 0; // frames converted
+        uint64_t hits = 0;        // requests served from the cache
+    };
+    PacketConvertStats packet_convert_stats();
+}
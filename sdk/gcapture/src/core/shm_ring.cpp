@@ -0,0 +1,624 @@
+// shm_ring.cpp
+#include "shm_ring.h"
+#include "gcap_shm.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+#endif
+
+using namespace gcap::shm;
+
+namespace
+{
+    // gcap_shm_wait looks at the publisher's pid at least this often.
+    constexpr int kPublisherCheckMs = 250;
+
+    uint32_t current_pid()
+    {
+#ifdef _WIN32
+        return (uint32_t)GetCurrentProcessId();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    bool process_alive(uint32_t pid)
+    {
+#ifdef _WIN32
+        HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+        if (!h)
+            return GetLastError() == ERROR_ACCESS_DENIED;
+        const bool alive = WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+        CloseHandle(h);
+        return alive;
+#else
+        return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+    }
+
+#ifdef _WIN32
+    std::wstring object_name(const std::string &name, const char *suffix = "")
+    {
+        // valid_name() keeps names ASCII, so widening is a plain copy.
+        const std::string s = "Local\\gcap." + name + suffix;
+        return std::wstring(s.begin(), s.end());
+    }
+
+    std::wstring event_name(const std::string &name, int reader, uint32_t generation)
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".r%d.%u", reader, generation);
+        return object_name(name, suffix);
+    }
+#endif
+
+    size_t header_bytes()
+    {
+        return (sizeof(Header) + kPageBytes - 1) & ~(kPageBytes - 1);
+    }
+
+    // Rows in plane `i` of a packet: the chroma plane of the 4:2:0 formats is half height.
+    int plane_rows(const gcap_frame_packet_t &p, int i)
+    {
+        return i == 1 && (p.format == GCAP_FMT_NV12 || p.format == GCAP_FMT_P010) ? (p.height + 1) / 2 : p.height;
+    }
+
+    size_t packet_bytes(const gcap_frame_packet_t &p)
+    {
+        size_t bytes = 0;
+        for (int i = 0; i < p.plane_count && i < 3; ++i)
+            bytes += ((size_t)p.stride[i] * (size_t)plane_rows(p, i) + 63) & ~(size_t)63;
+        return bytes;
+    }
+}
+
+// ------------------------------------------------------------
+// Mapping
+// ------------------------------------------------------------
+bool gcap::shm::valid_name(const char *name)
+{
+    if (!name || !*name)
+        return false;
+    size_t n = 0;
+    for (const char *c = name; *c; ++c, ++n)
+    {
+        const bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+                        *c == '.' || *c == '_' || *c == '-';
+        if (!ok || n >= 64)
+            return false;
+    }
+    return true;
+}
+
+uint64_t gcap::shm::now_ns()
+{
+    // steady_clock is system-wide (QPC / CLOCK_MONOTONIC), so publisher and reader stamps compare.
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool gcap::shm::Mapping::create(const std::string &name, size_t bytes)
+{
+    close();
+#ifdef _WIN32
+    const std::wstring wname = object_name(name);
+    HANDLE h = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                  (DWORD)((uint64_t)bytes >> 32), (DWORD)(bytes & 0xffffffffu), wname.c_str());
+    if (!h)
+        return false;
+    // Still mapped by readers of an earlier publisher; it goes away when they close it.
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(h);
+        return false;
+    }
+    void *p = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!p)
+    {
+        CloseHandle(h);
+        return false;
+    }
+    handle_ = h;
+#else
+    const std::string path = "/gcap." + name;
+    // A region left by a publisher that died keeps its name; readers still attached keep their mapping.
+    shm_unlink(path.c_str());
+    const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    fd_ = fd;
+#endif
+    base_ = (uint8_t *)p;
+    bytes_ = bytes;
+    owner_ = true;
+    name_ = name;
+    return true;
+}
+
+bool gcap::shm::Mapping::open(const std::string &name)
+{
+    close();
+#ifdef _WIN32
+    const std::wstring wname = object_name(name);
+    HANDLE h = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wname.c_str());
+    if (!h)
+        return false;
+    void *p = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION mbi{};
+    if (!p || !VirtualQuery(p, &mbi, sizeof(mbi)))
+    {
+        if (p)
+            UnmapViewOfFile(p);
+        CloseHandle(h);
+        return false;
+    }
+    handle_ = h;
+    bytes_ = mbi.RegionSize;
+#else
+    const std::string path = "/gcap." + name;
+    const int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    bytes_ = (size_t)st.st_size;
+#endif
+    base_ = (uint8_t *)p;
+    owner_ = false;
+    name_ = name;
+    return true;
+}
+
+void gcap::shm::Mapping::close()
+{
+    if (!base_)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle((HANDLE)handle_);
+    handle_ = nullptr;
+#else
+    munmap(base_, bytes_);
+    ::close(fd_);
+    fd_ = -1;
+    if (owner_)
+        shm_unlink(("/gcap." + name_).c_str());
+#endif
+    base_ = nullptr;
+    bytes_ = 0;
+    owner_ = false;
+}
+
+// ------------------------------------------------------------
+// Publisher
+// ------------------------------------------------------------
+gcap::ShmPublisher::ShmPublisher(const char *name, int slots, size_t slotBytes)
+    : name_(name ? name : ""),
+      slotCount_(slots <= 0 ? 4 : std::clamp(slots, 2, kMaxSlots)),
+      slotBytesHint_(slotBytes)
+{
+}
+
+gcap::ShmPublisher::~ShmPublisher()
+{
+    if (hdr_)
+    {
+        hdr_->closed.store(1, std::memory_order_seq_cst);
+        wakeReaders();
+    }
+#ifdef _WIN32
+    for (void *e : events_)
+        if (e)
+            CloseHandle((HANDLE)e);
+#endif
+    map_.close();
+}
+
+void gcap::ShmPublisher::onPacket(const gcap_frame_packet_t *p, void *self)
+{
+    if (p)
+        static_cast<ShmPublisher *>(self)->publish(*p);
+}
+
+bool gcap::ShmPublisher::createRegion(size_t frameBytes)
+{
+    const size_t slotBytes = std::max(slotBytesHint_, frameBytes);
+    const size_t stride = (slotBytes + kPageBytes - 1) & ~(kPageBytes - 1);
+    if (!map_.create(name_, header_bytes() + stride * (size_t)slotCount_))
+        return false;
+
+    Header *h = new (map_.data()) Header();
+    h->version = kVersion;
+    h->slotCount = (uint32_t)slotCount_;
+    h->publisherPid = current_pid();
+    h->slotBytes = slotBytes;
+    h->slotStride = stride;
+    h->dataOffset = header_bytes();
+    // Readers can map the region as soon as it has a name; the magic goes in last.
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = kMagic;
+    hdr_ = h;
+    return true;
+}
+
+bool gcap::ShmPublisher::publish(const gcap_frame_packet_t &p)
+{
+    if (p.gpu_backed || !p.data[0] || p.width <= 0 || p.height <= 0 || p.plane_count < 1)
+        return false;
+    for (int i = 0; i < p.plane_count && i < 3; ++i)
+        if (!p.data[i] || p.stride[i] <= 0)
+            return false;
+
+    const size_t bytes = packet_bytes(p);
+    if (!hdr_ && !createRegion(bytes))
+        return false; // name taken by a region still mapped elsewhere; retried on the next frame
+    if (bytes > hdr_->slotBytes)
+    {
+        hdr_->tooLarge.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t latest = hdr_->latest.load(std::memory_order_relaxed);
+    int slot = claimSlot(latest);
+    if (slot < 0)
+    {
+        reapDeadReaders();
+        slot = claimSlot(latest);
+    }
+    if (slot < 0)
+    {
+        hdr_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    SlotMeta &m = hdr_->slots[slot];
+    uint8_t *dst = map_.data() + hdr_->dataOffset + (size_t)slot * hdr_->slotStride;
+    size_t off = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (i < p.plane_count)
+        {
+            const size_t n = (size_t)p.stride[i] * (size_t)plane_rows(p, i);
+            memcpy(dst + off, p.data[i], n);
+            m.offset[i] = off;
+            m.stride[i] = p.stride[i];
+            off += (n + 63) & ~(size_t)63;
+        }
+        else
+        {
+            m.offset[i] = 0;
+            m.stride[i] = 0;
+        }
+    }
+    m.planeCount = std::min(p.plane_count, 3);
+    m.width = p.width;
+    m.height = p.height;
+    m.format = (int32_t)p.format;
+    m.bytes = off;
+    m.ptsNs = p.pts_ns;
+    m.ptsSmoothedNs = p.pts_smoothed_ns;
+    m.frameId = p.frame_id;
+    m.publishNs = now_ns();
+
+    const uint64_t seq = ++seq_;
+    m.seq.store(seq, std::memory_order_release);
+    hdr_->latest.store((seq << 8) | (uint64_t)slot, std::memory_order_seq_cst);
+    hdr_->published.fetch_add(1, std::memory_order_relaxed);
+    wakeReaders();
+    return true;
+}
+
+// A slot nobody holds, other than the latest frame (readers may be about to pin it).
+int gcap::ShmPublisher::claimSlot(uint64_t latest)
+{
+    const int latestSlot = latest ? (int)(latest & 0xff) : -1;
+    for (int k = 0; k < slotCount_; ++k)
+    {
+        const int i = (next_ + k) % slotCount_;
+        if (i == latestSlot)
+            continue;
+        SlotMeta &m = hdr_->slots[i];
+        if (m.readers.load(std::memory_order_relaxed) != 0)
+            continue;
+        const uint64_t old = m.seq.load(std::memory_order_relaxed);
+        m.seq.store(0, std::memory_order_seq_cst);
+        if (m.readers.load(std::memory_order_seq_cst) != 0)
+        {
+            // A reader pinned it between the two loads; it checks seq next and backs off
+            // if it sees 0, or reads the old frame if it got there first. Leave it alone.
+            m.seq.store(old, std::memory_order_seq_cst);
+            continue;
+        }
+        next_ = (i + 1) % slotCount_;
+        return i;
+    }
+    return -1;
+}
+
+void gcap::ShmPublisher::reapDeadReaders()
+{
+    for (ReaderEntry &r : hdr_->readers)
+    {
+        if (r.state.load(std::memory_order_acquire) != 2 || process_alive(r.pid))
+            continue;
+        for (int s = 0; s < slotCount_; ++s)
+            if (const uint16_t n = r.pins[s].exchange(0, std::memory_order_relaxed))
+                hdr_->slots[s].readers.fetch_sub(n, std::memory_order_seq_cst);
+        r.state.store(0, std::memory_order_release);
+    }
+}
+
+void gcap::ShmPublisher::wakeReaders()
+{
+    hdr_->wakeWord.fetch_add(1, std::memory_order_seq_cst);
+#ifdef _WIN32
+    for (int i = 0; i < kMaxReaders; ++i)
+    {
+        ReaderEntry &r = hdr_->readers[i];
+        if (r.state.load(std::memory_order_acquire) != 2)
+            continue;
+        const uint32_t gen = r.generation.load(std::memory_order_relaxed);
+        if (events_[i] && eventGen_[i] != gen)
+        {
+            CloseHandle((HANDLE)events_[i]);
+            events_[i] = nullptr;
+        }
+        if (!events_[i])
+        {
+            events_[i] = OpenEventW(EVENT_MODIFY_STATE, FALSE, event_name(name_, i, gen).c_str());
+            eventGen_[i] = gen;
+        }
+        if (events_[i])
+            SetEvent((HANDLE)events_[i]);
+    }
+#elif defined(__linux__)
+    if (hdr_->waiters.load(std::memory_order_seq_cst) != 0)
+        syscall(SYS_futex, (uint32_t *)&hdr_->wakeWord, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+// ------------------------------------------------------------
+// Reader (gcap_shm.h)
+// ------------------------------------------------------------
+struct gcap_shm_reader_t
+{
+    Mapping map;
+    Header *hdr = nullptr;
+    int entry = -1;
+#ifdef _WIN32
+    HANDLE event = nullptr;
+#endif
+};
+
+namespace
+{
+    void unpin(gcap_shm_reader r, int slot)
+    {
+        ReaderEntry &e = r->hdr->readers[r->entry];
+        if (e.pins[slot].load(std::memory_order_relaxed) == 0)
+            return;
+        e.pins[slot].fetch_sub(1, std::memory_order_relaxed);
+        r->hdr->slots[slot].readers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+extern "C"
+{
+    gcap_status_t gcap_shm_open(const char *name, gcap_shm_reader *out)
+    {
+        if (!out || !valid_name(name))
+            return GCAP_EINVAL;
+        *out = nullptr;
+        auto r = std::make_unique<gcap_shm_reader_t>();
+        if (!r->map.open(name) || r->map.size() < sizeof(Header))
+            return GCAP_ENODEV;
+        Header *h = (Header *)r->map.data();
+        const uint32_t magic = h->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (magic != kMagic || h->version != kVersion || h->slotCount == 0 || h->slotCount > (uint32_t)kMaxSlots ||
+            h->dataOffset + h->slotStride * h->slotCount > r->map.size())
+            return GCAP_ENODEV;
+        r->hdr = h;
+
+        for (int i = 0; i < kMaxReaders && r->entry < 0; ++i)
+        {
+            ReaderEntry &e = h->readers[i];
+            uint32_t expected = 0;
+            if (!e.state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+                continue;
+            e.pid = current_pid();
+            for (auto &pin : e.pins)
+                pin.store(0, std::memory_order_relaxed);
+            const uint32_t gen = e.generation.fetch_add(1, std::memory_order_relaxed) + 1;
+#ifdef _WIN32
+            r->event = CreateEventW(nullptr, FALSE, FALSE, event_name(name, i, gen).c_str());
+#else
+            (void)gen;
+#endif
+            e.state.store(2, std::memory_order_release);
+            r->entry = i;
+        }
+        if (r->entry < 0)
+            return GCAP_ESTATE;
+        *out = r.release();
+        return GCAP_OK;
+    }
+
+    int gcap_shm_wait(gcap_shm_reader r, uint64_t after_seq, int timeout_ms)
+    {
+        if (!r)
+            return -1;
+        Header *h = r->hdr;
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+        auto nextLivenessCheck = start + std::chrono::milliseconds(kPublisherCheckMs);
+        for (;;)
+        {
+            if ((h->latest.load(std::memory_order_acquire) >> 8) > after_seq)
+                return 1;
+            if (h->closed.load(std::memory_order_acquire))
+                return -1;
+            const auto now = std::chrono::steady_clock::now();
+            // A publisher that crashed never sets closed; waits are sliced so its pid gets looked at.
+            if (now >= nextLivenessCheck)
+            {
+                if (!process_alive(h->publisherPid))
+                    return -1;
+                nextLivenessCheck = now + std::chrono::milliseconds(kPublisherCheckMs);
+            }
+            int remaining = kPublisherCheckMs;
+            if (timeout_ms >= 0)
+            {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+                if (left <= 0)
+                    return 0;
+                remaining = (int)std::min<long long>(left, kPublisherCheckMs);
+            }
+#ifdef _WIN32
+            WaitForSingleObject(r->event, (DWORD)remaining);
+#elif defined(__linux__)
+            h->waiters.fetch_add(1, std::memory_order_seq_cst);
+            const uint32_t word = h->wakeWord.load(std::memory_order_seq_cst);
+            if ((h->latest.load(std::memory_order_seq_cst) >> 8) <= after_seq && !h->closed.load(std::memory_order_seq_cst))
+            {
+                struct timespec ts{remaining / 1000, (long)(remaining % 1000) * 1000000L};
+                syscall(SYS_futex, (uint32_t *)&h->wakeWord, FUTEX_WAIT, word, &ts, nullptr, 0);
+            }
+            h->waiters.fetch_sub(1, std::memory_order_seq_cst);
+#else
+            (void)remaining;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+        }
+    }
+
+    gcap_status_t gcap_shm_acquire_latest(gcap_shm_reader r, gcap_shm_frame_t *out)
+    {
+        if (!r || !out)
+            return GCAP_EINVAL;
+        Header *h = r->hdr;
+        ReaderEntry &e = h->readers[r->entry];
+        // Retried only when the publisher overtook this reader between the two loads.
+        for (int attempt = 0; attempt < 64; ++attempt)
+        {
+            const uint64_t latest = h->latest.load(std::memory_order_acquire);
+            if (!latest)
+                return GCAP_ESTATE;
+            const int slot = (int)(latest & 0xff);
+            const uint64_t seq = latest >> 8;
+            if (slot >= (int)h->slotCount)
+                return GCAP_EIO;
+            SlotMeta &m = h->slots[slot];
+            m.readers.fetch_add(1, std::memory_order_seq_cst);
+            e.pins[slot].fetch_add(1, std::memory_order_relaxed);
+            if (m.seq.load(std::memory_order_seq_cst) != seq)
+            {
+                unpin(r, slot);
+                continue;
+            }
+
+            const uint8_t *base = r->map.data() + h->dataOffset + (size_t)slot * h->slotStride;
+            memset(out, 0, sizeof(*out));
+            out->plane_count = m.planeCount;
+            for (int i = 0; i < m.planeCount; ++i)
+            {
+                out->data[i] = base + m.offset[i];
+                out->stride[i] = m.stride[i];
+            }
+            out->width = m.width;
+            out->height = m.height;
+            out->format = (gcap_pixfmt_t)m.format;
+            out->pts_ns = m.ptsNs;
+            out->pts_smoothed_ns = m.ptsSmoothedNs;
+            out->frame_id = m.frameId;
+            out->publish_ns = m.publishNs;
+            out->seq = seq;
+            out->slot = slot;
+            return GCAP_OK;
+        }
+        return GCAP_ESTATE;
+    }
+
+    void gcap_shm_release(gcap_shm_reader r, const gcap_shm_frame_t *frame)
+    {
+        if (!r || !frame || frame->slot < 0 || frame->slot >= (int)r->hdr->slotCount)
+            return;
+        unpin(r, frame->slot);
+    }
+
+    gcap_status_t gcap_shm_get_info(gcap_shm_reader r, gcap_shm_info_t *out)
+    {
+        if (!r || !out)
+            return GCAP_EINVAL;
+        const Header *h = r->hdr;
+        memset(out, 0, sizeof(*out));
+        out->slots = (int)h->slotCount;
+        for (const ReaderEntry &e : h->readers)
+            if (e.state.load(std::memory_order_relaxed) == 2)
+                ++out->readers;
+        out->published = h->published.load(std::memory_order_relaxed);
+        out->dropped = h->dropped.load(std::memory_order_relaxed);
+        out->too_large = h->tooLarge.load(std::memory_order_relaxed);
+        return GCAP_OK;
+    }
+
+    void gcap_shm_close(gcap_shm_reader r)
+    {
+        if (!r)
+            return;
+        ReaderEntry &e = r->hdr->readers[r->entry];
+        for (int s = 0; s < (int)r->hdr->slotCount; ++s)
+            if (const uint16_t n = e.pins[s].exchange(0, std::memory_order_relaxed))
+                r->hdr->slots[s].readers.fetch_sub(n, std::memory_order_seq_cst);
+        e.state.store(0, std::memory_order_release);
+#ifdef _WIN32
+        if (r->event)
+            CloseHandle(r->event);
+#endif
+        delete r;
+    }
+}
@@ -0,0 +1,149 @@
+// shm_ring.h
+// Named shared-memory frame ring: the publisher behind gcap_publish_shm() and the
+// reader behind gcap_shm.h. No Qt / capture dependencies; builds as gcapture_shm.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * One mapping shared by the publisher and every reader:
+     *
+     *   Header | slot 0 payload | slot 1 payload | ...   (payloads 4 KiB aligned)
+     *
+     * The publisher copies each frame's planes into a slot nobody holds and then
+     * publishes (seq, slot) in Header::latest. Readers pin the latest slot and
+     * read it in place; pinning and claiming are a Dekker pair on the slot's
+     * `readers` and `seq` (both sides store, then load the other's word), so a
+     * slot is never rewritten under a reader and nobody waits on a lock.
+     *
+     * Wakeups: a futex on Header::wakeWord on Linux (only when a reader is
+     * waiting), a named auto-reset event per reader on Windows, a 1 ms poll
+     * elsewhere. Each reader registers with its pid; when the publisher finds
+     * every slot held it drops the pins of readers whose process is gone.
+     */
+    namespace shm
+    {
+        constexpr uint32_t kMagic = 0x52534347; // "GCSR"
+        constexpr uint32_t kVersion = 1;
+        constexpr int kMaxSlots = 64;
+        constexpr int kMaxReaders = 32;
+        constexpr size_t kPageBytes = 4096;
+
+        struct alignas(64) SlotMeta
+        {
+            std::atomic<uint64_t> seq;     // seq of the frame held, 0 = being written
+            std::atomic<uint32_t> readers; // pins
+            int32_t planeCount;
+            int32_t width, height;
+            int32_t format;
+            int32_t stride[3];
+            uint64_t offset[3]; // plane offsets inside the slot payload
+            uint64_t bytes;
+            uint64_t ptsNs;
+            uint64_t ptsSmoothedNs;
+            uint64_t frameId;
+            uint64_t publishNs;
+        };
+
+        struct ReaderEntry
+        {
+            std::atomic<uint32_t> state; // 0 free, 1 claiming, 2 attached
+            std::atomic<uint32_t> generation;
+            uint32_t pid;
+            std::atomic<uint16_t> pins[kMaxSlots]; // this reader's share of SlotMeta::readers
+        };
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t slotCount;
+            uint32_t publisherPid; // readers treat the ring as closed once it is gone
+            uint64_t slotBytes;  // payload capacity
+            uint64_t slotStride; // payload distance, page multiple
+            uint64_t dataOffset;
+            alignas(64) std::atomic<uint64_t> latest; // (seq << 8) | slot, 0 = nothing yet
+            std::atomic<uint32_t> wakeWord;
+            std::atomic<uint32_t> waiters;
+            std::atomic<uint32_t> closed;
+            std::atomic<uint64_t> published;
+            std::atomic<uint64_t> dropped;
+            std::atomic<uint64_t> tooLarge;
+            SlotMeta slots[kMaxSlots];
+            ReaderEntry readers[kMaxReaders];
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+        static_assert(std::atomic<uint16_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+        // Platform mapping of the named region.
+        class Mapping
+        {
+        public:
+            Mapping() = default;
+            ~Mapping() { close(); }
+            Mapping(const Mapping &) = delete;
+            Mapping &operator=(const Mapping &) = delete;
+
+            bool create(const std::string &name, size_t bytes); // replaces a stale region of that name
+            bool open(const std::string &name);
+            void close();
+            uint8_t *data() const { return base_; }
+            size_t size() const { return bytes_; }
+
+        private:
+            uint8_t *base_ = nullptr;
+            size_t bytes_ = 0;
+            bool owner_ = false;
+            std::string name_;
+#ifdef _WIN32
+            void *handle_ = nullptr;
+#else
+            int fd_ = -1;
+#endif
+        };
+
+        // "[A-Za-z0-9._-]{1,64}"; the platform object name is derived from it.
+        bool valid_name(const char *name);
+        uint64_t now_ns();
+    }
+
+    class ShmPublisher
+    {
+    public:
+        // slots 0 = 4; slotBytes 0 = sized from the first frame. The region is created
+        // on the first frame, when its size is known.
+        ShmPublisher(const char *name, int slots, size_t slotBytes);
+        ~ShmPublisher();
+        ShmPublisher(const ShmPublisher &) = delete;
+        ShmPublisher &operator=(const ShmPublisher &) = delete;
+
+        // Copies the packet's CPU planes into a free slot. False when dropped.
+        bool publish(const gcap_frame_packet_t &p);
+        static void onPacket(const gcap_frame_packet_t *p, void *self);
+
+    private:
+        bool createRegion(size_t frameBytes);
+        int claimSlot(uint64_t latest);
+        void reapDeadReaders();
+        void wakeReaders();
+
+        std::string name_;
+        int slotCount_;
+        size_t slotBytesHint_;
+        shm::Mapping map_;
+        shm::Header *hdr_ = nullptr;
+        uint64_t seq_ = 0;
+        int next_ = 0;
+#ifdef _WIN32
+        void *events_[shm::kMaxReaders] = {};
+        uint32_t eventGen_[shm::kMaxReaders] = {};
+#endif
+    };
+}
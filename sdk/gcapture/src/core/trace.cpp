@@ -0,0 +1,322 @@
+// trace.cpp
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+std::atomic<bool> gcap::trace::g_enabled{false};
+
+const char *gcap::trace::stage_name(Stage s)
+{
+    switch (s)
+    {
+    case Stage::ReadSample:
+        return "read_sample";
+    case Stage::Receive:
+        return "receive";
+    case Stage::RawCopy:
+        return "raw_copy";
+    case Stage::Convert:
+        return "convert";
+    case Stage::ProcAmp:
+        return "procamp";
+    case Stage::Callback:
+        return "callback";
+    case Stage::RecorderWrite:
+        return "recorder_write";
+    case Stage::Present:
+        return "present";
+    default:
+        return "unknown";
+    }
+}
+
+#if GCAP_TRACE
+
+namespace
+{
+    using gcap::trace::Stage;
+
+    constexpr int kDefaultEvents = 1 << 16;
+    constexpr int kMaxEvents = 1 << 22;
+    constexpr int kNameBytes = 32;
+
+    // One span, 24 bytes. Relaxed atomics: plain stores on x86 / ARM64, and the
+    // exporter may read a slot the owner is rewriting (it drops those, see snapshot()).
+    struct Event
+    {
+        std::atomic<uint64_t> begin; // ticks()
+        std::atomic<uint64_t> frameId;
+        std::atomic<uint64_t> stageDur; // stage << 56 | duration in ticks
+    };
+
+    // Written by its thread only; `head` counts spans ever written and is
+    // published with release so the exporter sees complete slots below it.
+    struct Ring
+    {
+        explicit Ring(int capacity, int tid) : events(new Event[(size_t)capacity]), mask((uint64_t)capacity - 1), tid(tid) {}
+
+        std::unique_ptr<Event[]> events;
+        const uint64_t mask;
+        const int tid;
+        alignas(64) std::atomic<uint64_t> head{0};
+        uint64_t base = 0; // head at start(); guarded by the registry mutex
+        std::atomic<bool> retired{false};
+        char name[kNameBytes] = {};
+    };
+
+    struct Span
+    {
+        uint64_t begin;
+        uint64_t frameId;
+        uint64_t stageDur;
+    };
+
+    // Keeps the thread's ring alive and marks it retired when the thread exits, so
+    // its spans still reach the next export and the ring is dropped at the next start().
+    struct ThreadSlot
+    {
+        std::shared_ptr<Ring> ring;
+        char name[kNameBytes] = {};
+        ~ThreadSlot()
+        {
+            if (ring)
+                ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    thread_local ThreadSlot t_slot;
+    // The hot path reads this one: trivially destructible, so no TLS init guard.
+    thread_local Ring *t_ring = nullptr;
+
+    int round_pow2(int n)
+    {
+        int p = 1024;
+        while (p < n && p < kMaxEvents)
+            p <<= 1;
+        return p;
+    }
+
+    uint32_t process_id()
+    {
+#ifdef _WIN32
+        return (uint32_t)GetCurrentProcessId();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    std::FILE *open_utf8(const char *path)
+    {
+#ifdef _WIN32
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        if (n <= 0)
+            return nullptr;
+        std::wstring w((size_t)n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, &w[0], n);
+        return _wfopen(w.c_str(), L"wb");
+#else
+        return std::fopen(path, "wb");
+#endif
+    }
+
+    void write_json_string(std::FILE *f, const char *s)
+    {
+        std::fputc('"', f);
+        for (; *s; ++s)
+        {
+            const unsigned char c = (unsigned char)*s;
+            if (c == '"' || c == '\\')
+                std::fprintf(f, "\\%c", c);
+            else if (c < 0x20)
+                std::fprintf(f, "\\u%04x", c);
+            else
+                std::fputc(c, f);
+        }
+        std::fputc('"', f);
+    }
+
+    class Registry
+    {
+    public:
+        Ring *attach()
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            auto ring = std::make_shared<Ring>(capacity_, nextTid_++);
+            std::memcpy(ring->name, t_slot.name, kNameBytes);
+            ring->base = 0;
+            rings_.push_back(ring);
+            t_slot.ring = ring;
+            t_ring = ring.get();
+            return t_ring;
+        }
+
+        void setName(const char *name)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            std::snprintf(t_slot.name, kNameBytes, "%s", name ? name : "");
+            if (t_slot.ring)
+                std::memcpy(t_slot.ring->name, t_slot.name, kNameBytes);
+        }
+
+        gcap_status_t start(int eventsPerThread)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (gcap::trace::g_enabled.load(std::memory_order_relaxed))
+                return GCAP_ESTATE;
+            // Rings already allocated keep their size; new threads get the new one.
+            capacity_ = round_pow2(eventsPerThread > 0 ? eventsPerThread : kDefaultEvents);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<Ring> &r)
+                                        { return r->retired.load(std::memory_order_acquire); }),
+                         rings_.end());
+            for (auto &r : rings_)
+                r->base = r->head.load(std::memory_order_acquire);
+            startNs_ = gcap::trace::now_ns();
+            startTicks_ = gcap::trace::ticks();
+            gcap::trace::g_enabled.store(true, std::memory_order_release);
+            return GCAP_OK;
+        }
+
+        gcap_status_t stop(const char *path)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (!gcap::trace::g_enabled.exchange(false))
+                return GCAP_ESTATE;
+            if (!path)
+                return GCAP_OK;
+            const uint64_t stopNs = gcap::trace::now_ns();
+            const uint64_t stopTicks = gcap::trace::ticks();
+            double nsPerTick = 1.0;
+#if GCAP_TRACE_TSC
+            if (stopTicks > startTicks_ && stopNs > startNs_)
+                nsPerTick = (double)(stopNs - startNs_) / (double)(stopTicks - startTicks_);
+#endif
+            std::FILE *f = open_utf8(path);
+            if (!f)
+                return GCAP_EIO;
+
+            const uint32_t pid = process_id();
+            std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+            std::fprintf(f, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"gcapture\"}}", pid);
+            uint64_t overwritten = 0;
+            std::vector<Span> spans;
+            for (auto &r : rings_)
+            {
+                overwritten += snapshot(*r, spans);
+                if (spans.empty())
+                    continue;
+                char fallback[kNameBytes];
+                std::snprintf(fallback, sizeof(fallback), "thread %d", r->tid);
+                std::fprintf(f, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%d,\"args\":{\"name\":", pid, r->tid);
+                write_json_string(f, r->name[0] ? r->name : fallback);
+                std::fprintf(f, "}}");
+                for (const Span &s : spans)
+                {
+                    const Stage stage = (Stage)(s.stageDur >> 56);
+                    const uint64_t dur = (uint64_t)((double)(s.stageDur & ((1ull << 56) - 1)) * nsPerTick);
+                    const uint64_t ts = s.begin > startTicks_ ? (uint64_t)((double)(s.begin - startTicks_) * nsPerTick) : 0;
+                    std::fprintf(f,
+                                 ",\n{\"ph\":\"X\",\"cat\":\"gcap\",\"name\":\"%s\",\"pid\":%u,\"tid\":%d,"
+                                 "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"args\":{\"frame_id\":%llu}}",
+                                 gcap::trace::stage_name(stage), pid, r->tid,
+                                 (unsigned long long)(ts / 1000), (unsigned)(ts % 1000),
+                                 (unsigned long long)(dur / 1000), (unsigned)(dur % 1000),
+                                 (unsigned long long)s.frameId);
+                }
+            }
+            std::fprintf(f, "\n],\"otherData\":{\"overwritten_spans\":%llu}}\n", (unsigned long long)overwritten);
+            const bool ok = std::ferror(f) == 0;
+            return std::fclose(f) == 0 && ok ? GCAP_OK : GCAP_EIO;
+        }
+
+    private:
+        // Copies the ring's spans since start(). A slot the owner may be rewriting right now
+        // (index head - capacity, about to become head) is dropped by re-reading head afterwards.
+        static uint64_t snapshot(const Ring &r, std::vector<Span> &out)
+        {
+            out.clear();
+            const uint64_t cap = r.mask + 1;
+            const uint64_t h = r.head.load(std::memory_order_acquire);
+            const uint64_t lo = std::max(r.base, h > cap ? h - cap : 0);
+            out.reserve((size_t)(h - lo));
+            for (uint64_t i = lo; i < h; ++i)
+            {
+                const Event &e = r.events[i & r.mask];
+                out.push_back({e.begin.load(std::memory_order_relaxed), e.frameId.load(std::memory_order_relaxed),
+                               e.stageDur.load(std::memory_order_relaxed)});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t h2 = r.head.load(std::memory_order_relaxed);
+            const uint64_t valid = h2 + 1 > cap ? h2 + 1 - cap : 0;
+            if (valid > lo)
+                out.erase(out.begin(), out.begin() + (ptrdiff_t)std::min<uint64_t>(valid - lo, out.size()));
+            const uint64_t since = h2 - r.base;
+            return since > out.size() ? since - out.size() : 0;
+        }
+
+        std::mutex mtx_;
+        std::vector<std::shared_ptr<Ring>> rings_;
+        int capacity_ = kDefaultEvents;
+        int nextTid_ = 1;
+        uint64_t startNs_ = 0;
+        uint64_t startTicks_ = 0;
+    };
+
+    Registry &registry()
+    {
+        static Registry r;
+        return r;
+    }
+}
+
+void gcap::trace::record(Stage s, uint64_t frameId, uint64_t beginTicks, uint64_t endTicks)
+{
+    Ring *r = t_ring;
+    if (!r)
+        r = registry().attach();
+    const uint64_t h = r->head.load(std::memory_order_relaxed);
+    Event &e = r->events[h & r->mask];
+    const uint64_t dur = endTicks > beginTicks ? endTicks - beginTicks : 0;
+    e.begin.store(beginTicks, std::memory_order_relaxed);
+    e.frameId.store(frameId, std::memory_order_relaxed);
+    e.stageDur.store(((uint64_t)s << 56) | std::min<uint64_t>(dur, (1ull << 56) - 1), std::memory_order_relaxed);
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void gcap::trace::set_thread_name(const char *name)
+{
+    registry().setName(name);
+}
+
+gcap_status_t gcap::trace::start(int eventsPerThread)
+{
+    return registry().start(eventsPerThread);
+}
+
+gcap_status_t gcap::trace::stop(const char *jsonPathUtf8)
+{
+    return registry().stop(jsonPathUtf8);
+}
+
+#else
+
+void gcap::trace::record(Stage, uint64_t, uint64_t, uint64_t) {}
+void gcap::trace::set_thread_name(const char *) {}
+gcap_status_t gcap::trace::start(int) { return GCAP_ENOTSUP; }
+gcap_status_t gcap::trace::stop(const char *) { return GCAP_ENOTSUP; }
+
+#endif
@@ -0,0 +1,124 @@
+// trace.h
+// Hot-path tracing: stage spans (begin/end + frame_id) recorded into per-thread
+// lock-free rings and written as Chrome / Perfetto trace JSON by gcap_trace_stop().
+// Built with GCAP_TRACE=0, every GCAP_TRACE_* macro expands to nothing.
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "gcapture.h"
+
+#ifndef GCAP_TRACE
+#define GCAP_TRACE 1
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GCAP_TRACE_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define GCAP_TRACE_TSC 0
+#endif
+
+namespace gcap
+{
+    namespace trace
+    {
+        enum class Stage : uint8_t
+        {
+            ReadSample,    // IMFSourceReader::ReadSample
+            Receive,       // DirectShow input pin Receive()
+            RawCopy,       // raw sample copied into the triple buffer / a pool slot
+            Convert,       // CPU YUV -> RGB conversion (ProcAmp is folded into it)
+            ProcAmp,       // GPU YUV -> scene pass that applies ProcAmp (CPU submission time)
+            Callback,      // application video / packet callback
+            RecorderWrite, // IMFSinkWriter video sample write
+            Present,       // preview swap chain present
+            Count
+        };
+
+        const char *stage_name(Stage s);
+
+        extern std::atomic<bool> g_enabled;
+
+        inline bool enabled()
+        {
+            return g_enabled.load(std::memory_order_relaxed);
+        }
+
+        inline uint64_t now_ns()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Span timestamps: the invariant TSC on x86 (a few ns, rescaled to ns against
+        // steady_clock over the session at export), steady_clock elsewhere.
+        inline uint64_t ticks()
+        {
+#if GCAP_TRACE_TSC
+            return __rdtsc();
+#else
+            return now_ns();
+#endif
+        }
+
+        // Appends one span to the calling thread's ring (allocated on first use).
+        void record(Stage s, uint64_t frameId, uint64_t beginTicks, uint64_t endTicks);
+        // Names the calling thread's track in the exported trace.
+        void set_thread_name(const char *name);
+
+        // 0 = 65536 spans per thread; older spans are overwritten. GCAP_ESTATE when already
+        // tracing, GCAP_ENOTSUP when built with GCAP_TRACE=0.
+        gcap_status_t start(int eventsPerThread);
+        // Stops recording and writes the spans since start(); nullptr discards them.
+        // GCAP_ESTATE when not tracing, GCAP_EIO when the file cannot be written.
+        gcap_status_t stop(const char *jsonPathUtf8);
+
+        class Scope
+        {
+        public:
+            Scope(Stage s, uint64_t frameId) : begin_(enabled() ? ticks() : 0), frameId_(frameId), stage_(s) {}
+            ~Scope()
+            {
+                if (begin_)
+                    record(stage_, frameId_, begin_, ticks());
+            }
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            uint64_t begin_;
+            uint64_t frameId_;
+            Stage stage_;
+        };
+    }
+}
+
+#define GCAP_TRACE_CONCAT2(a, b) a##b
+#define GCAP_TRACE_CONCAT(a, b) GCAP_TRACE_CONCAT2(a, b)
+
+#if GCAP_TRACE
+// Span from here to the end of the enclosing block.
+#define GCAP_TRACE_SCOPE(stage, frameId) \
+    ::gcap::trace::Scope GCAP_TRACE_CONCAT(gcapTraceScope_, __LINE__)(::gcap::trace::Stage::stage, (frameId))
+// Span between GCAP_TRACE_MARK(var) and GCAP_TRACE_SPAN(stage, frameId, var), for
+// stages whose frame_id is only known once they are done.
+#define GCAP_TRACE_MARK(var) const uint64_t var = ::gcap::trace::enabled() ? ::gcap::trace::ticks() : 0
+#define GCAP_TRACE_SPAN(stage, frameId, var)                                                   \
+    do                                                                                         \
+    {                                                                                          \
+        if (var)                                                                               \
+            ::gcap::trace::record(::gcap::trace::Stage::stage, (frameId), var, ::gcap::trace::ticks()); \
+    } while (0)
+#define GCAP_TRACE_THREAD_NAME(name) ::gcap::trace::set_thread_name(name)
+#else
+#define GCAP_TRACE_SCOPE(stage, frameId) ((void)0)
+#define GCAP_TRACE_MARK(var) ((void)0)
+#define GCAP_TRACE_SPAN(stage, frameId, var) ((void)0)
+#define GCAP_TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,44 @@
+// triple_buffer.cpp
+#include "triple_buffer.h"
+
+uint8_t *gcap::TripleBuffer::writeBuffer(size_t bytes)
+{
+    Slot &s = slots_[back_];
+    if (s.data.size() < bytes)
+        s.data.resize(bytes);
+    return s.data.data();
+}
+
+uint64_t gcap::TripleBuffer::publish(size_t bytes, int stride, const Format &format, uint64_t hostNs, uint64_t ptsNs)
+{
+    Slot &s = slots_[back_];
+    s.bytes = bytes;
+    s.stride = stride;
+    s.format = format;
+    s.hostNs = hostNs;
+    s.ptsNs = ptsNs;
+    s.seq = ++seq_;
+    s.generation = generation_.load(std::memory_order_acquire);
+    // Release hands the slot's contents to whoever swaps it out of middle_; acquire
+    // takes ownership of the buffer the consumer (or an older publish) left there.
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    return s.seq;
+}
+
+bool gcap::TripleBuffer::latest(View &out)
+{
+    if (middle_.load(std::memory_order_relaxed) & kFresh)
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+
+    const Slot &s = slots_[front_];
+    if (s.seq == 0 || s.generation != generation_.load(std::memory_order_acquire))
+        return false;
+    out.data = s.data.data();
+    out.bytes = s.bytes;
+    out.stride = s.stride;
+    out.format = s.format;
+    out.seq = s.seq;
+    out.hostNs = s.hostNs;
+    out.ptsNs = s.ptsNs;
+    return true;
+}
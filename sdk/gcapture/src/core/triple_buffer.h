@@ -0,0 +1,85 @@
+// triple_buffer.h
+// Lock-free latest-frame handoff between one producer and one consumer.
+// Portable (no Windows headers); used by DShowRawRenderer.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gcap
+{
+    /**
+     * Three byte buffers rotated between a producer and a consumer. The producer
+     * fills its back buffer and publishes it with one atomic exchange; the
+     * consumer swaps the newest published buffer in as its front buffer and
+     * reads it in place until its next latest() call. Neither side waits, and
+     * frames the consumer did not get to are overwritten.
+     *
+     * Exactly one producer thread and one consumer thread; invalidate() may be
+     * called from any thread.
+     */
+    class TripleBuffer
+    {
+    public:
+        // What the bytes are, published with them so a format change between
+        // publish and read cannot pair a frame with another frame's layout.
+        struct Format
+        {
+            int width = 0;
+            int height = 0;
+            uint8_t id[16] = {}; // caller's format identifier (DShowRawRenderer: the subtype GUID)
+        };
+
+        struct View
+        {
+            const uint8_t *data = nullptr;
+            size_t bytes = 0;
+            int stride = 0;
+            Format format;
+            uint64_t seq = 0;      // publish count, starts at 1
+            uint64_t hostNs = 0;   // producer's timestamps, passed through
+            uint64_t ptsNs = 0;
+        };
+
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer &) = delete;
+        TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+        // Producer: the back buffer, grown to hold `bytes`. Buffers only grow, so
+        // after the first three frames of a size nothing is allocated.
+        uint8_t *writeBuffer(size_t bytes);
+        // Producer: makes the back buffer the newest frame. Returns its seq.
+        uint64_t publish(size_t bytes, int stride, const Format &format, uint64_t hostNs = 0, uint64_t ptsNs = 0);
+
+        // Consumer: newest frame, valid until the next latest() call. False until
+        // something was published since the last invalidate().
+        bool latest(View &out);
+
+        // Drops published frames (format change, graph rebuild). Buffers are kept.
+        void invalidate() { generation_.fetch_add(1, std::memory_order_acq_rel); }
+
+    private:
+        static constexpr int kIndexMask = 3;
+        static constexpr int kFresh = 4; // middle_ holds a frame the consumer has not taken
+
+        struct Slot
+        {
+            std::vector<uint8_t> data;
+            size_t bytes = 0;
+            int stride = 0;
+            Format format;
+            uint64_t seq = 0;
+            uint64_t hostNs = 0;
+            uint64_t ptsNs = 0;
+            uint32_t generation = 0;
+        };
+
+        Slot slots_[3];
+        int back_ = 0;              // producer only
+        int front_ = 1;             // consumer only
+        std::atomic<int> middle_{2}; // index | kFresh
+        uint64_t seq_ = 0;          // producer only
+        std::atomic<uint32_t> generation_{1};
+    };
+}
@@ -1,5 +1,6 @@
 #include "dshow_custom_sink.h"
 #include "dshow_raw_renderer.h"
+#include "../core/trace.h"
 
 #include <dvdmedia.h>
 #include <mfapi.h>
@@ -231,6 +232,7 @@ STDMETHODIMP DShowCustomSinkPin::QueryAccept(const AM_MEDIA_TYPE *pmt)
     if (!pmt) return E_POINTER;
     if (pmt->majortype != MEDIATYPE_Video) return S_FALSE;
     if (pmt->subtype == MEDIASUBTYPE_NV12 || pmt->subtype == MFVideoFormat_P010 || pmt->subtype == MEDIASUBTYPE_YUY2 || pmt->subtype == MEDIASUBTYPE_Y210 ||
+        pmt->subtype == GCAP_SUBTYPE_V210 || pmt->subtype == GCAP_SUBTYPE_R210 ||
         pmt->subtype == MEDIASUBTYPE_RGB24 || pmt->subtype == MEDIASUBTYPE_RGB32 || pmt->subtype == MEDIASUBTYPE_ARGB32) return S_OK;
     return S_FALSE;
 }
@@ -279,6 +281,8 @@ STDMETHODIMP DShowCustomSinkPin::GetAllocatorRequirements(ALLOCATOR_PROPERTIES *
 STDMETHODIMP DShowCustomSinkPin::Receive(IMediaSample *pSample)
 {
     if (!pSample) return E_POINTER;
+    // No frame id yet: the pump numbers the frames it takes from the triple buffer.
+    GCAP_TRACE_SCOPE(Receive, 0);
     std::lock_guard<std::mutex> lock(mtx_);
     if (!connectedPin_ || !mediaTypeValid_)
     {
@@ -403,8 +407,16 @@ HRESULT DShowCustomSinkFilter::onReceive(IMediaSample *sample, const AM_MEDIA_TY
         dshow_sink_log("[DShowRawSink] onReceive got empty sample");
         return S_OK;
     }
+    // Stream time of the sample (100 ns units); drives clock recovery in the frame pump.
+    REFERENCE_TIME tStart = 0, tStop = 0;
+    const HRESULT hrTime = sample->GetTime(&tStart, &tStop);
+    const int64_t deviceNs = (hrTime == S_OK || hrTime == VFW_S_NO_STOP_TIME) ? static_cast<int64_t>(tStart) * 100 : -1;
     renderer_->setNegotiated(subtype, width, height, fpsNum, fpsDen);
-    const bool pushed = renderer_->pushSample(ptr, static_cast<size_t>(size), 0);
+    bool pushed = false;
+    {
+        GCAP_TRACE_SCOPE(RawCopy, 0);
+        pushed = renderer_->pushSample(ptr, static_cast<size_t>(size), 0, deviceNs);
+    }
     static std::atomic<unsigned> s_pushLogs{0};
     const unsigned pushLogIdx = ++s_pushLogs;
     if (pushLogIdx <= 8 || !pushed)
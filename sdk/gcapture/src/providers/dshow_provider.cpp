@@ -8,6 +8,7 @@
 #include "dshow_provider.h"
 #include "dshow_custom_sink.h"
 #include "dshow_signal_probe.h"
+#include "../core/trace.h"
 #include <objbase.h>
 #include <dvdmedia.h>
 #include <mfapi.h>
@@ -27,6 +28,24 @@ namespace
         OutputDebugStringA(msg);
     }
 
+    uint64_t steady_now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    // Closes the frame pump's frame in the stats shard on every way out of the iteration.
+    struct StatsFrameScope
+    {
+        gcap::StatsShard *stats;
+        ~StatsFrameScope()
+        {
+            if (stats)
+                stats->endFrame(steady_now_ns());
+        }
+    };
+
     void dshow_log_hr(const char *prefix, HRESULT hr)
     {
         char sys[512] = {};
@@ -121,6 +140,10 @@ namespace
             return "Y210";
         if (g == MFVideoFormat_P010)
             return "P010";
+        if (g == GCAP_SUBTYPE_V210)
+            return "V210";
+        if (g == GCAP_SUBTYPE_R210)
+            return "R210";
         if (g == MEDIASUBTYPE_MJPG)
             return "MJPG";
         if (g == MEDIASUBTYPE_RGB24)
@@ -162,6 +185,8 @@ namespace
                : (fmt == GCAP_FMT_NV12) ? MEDIASUBTYPE_NV12
                : (fmt == GCAP_FMT_YUY2) ? MEDIASUBTYPE_YUY2
                : (fmt == GCAP_FMT_ARGB) ? MEDIASUBTYPE_ARGB32
+               : (fmt == GCAP_FMT_V210) ? GCAP_SUBTYPE_V210
+               : (fmt == GCAP_FMT_R210) ? GCAP_SUBTYPE_R210
                                         : GUID{};
     }
 
@@ -447,6 +472,24 @@ void DShowProvider::setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *us
     user_ = user;
 }
 
+void DShowProvider::setVideoOutput(const gcap_video_output_t &out)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    videoOutput_ = out;
+}
+
+void DShowProvider::setFramePool(gcap::FramePool *pool)
+{
+    framePool_ = pool;
+}
+
+// Receive() runs on DirectShow's streaming thread, conversion and callbacks on the frame pump.
+void DShowProvider::setStats(gcap::CaptureStats *stats)
+{
+    stats_ = stats ? &stats->shard(gcap::CaptureStats::Thread::Capture) : nullptr;
+    rawRenderer_.setStats(stats ? &stats->shard(gcap::CaptureStats::Thread::Device) : nullptr);
+}
+
 bool DShowProvider::refreshSignalProbe(bool force)
 {
     if (currentIndex_ < 0)
@@ -586,7 +629,7 @@ bool DShowProvider::getRuntimeInfo(gcap_runtime_info_t &out)
         out.negotiated.hdr = 0;
     }
 
-    out.runtime_fps = rawRenderer_.runtimeFpsAvg();
+    gcap::fill_clock_runtime_info(out, rawRenderer_.clockStats());
     out.active_backend = GCAP_BACKEND_DSHOW;
     strcpy_s(out.backend_name, rawOnlyActive_ ? "DShow Raw" : "DShow");
     strcpy_s(out.path_name, rawOnlyActive_ ? "DShow Raw Preview" : "DShow VMR9 Preview");
@@ -671,7 +714,14 @@ bool DShowProvider::enumerate(std::vector<gcap_device_info_t> &list)
                                     nameBuf, sizeof(nameBuf), nullptr, nullptr);
                 strncpy_s(di.name, nameBuf, sizeof(di.name) - 1);
                 di.caps = 0;
-                di.symbolic_link[0] = 'NULL';
+                // DevicePath is the interface path WinMF reports as the symbolic link
+                // (absent on virtual sources); the device cache keys capabilities on it.
+                VARIANT varPath;
+                VariantInit(&varPath);
+                if (SUCCEEDED(propBag->Read(L"DevicePath", &varPath, nullptr)) && varPath.vt == VT_BSTR)
+                    WideCharToMultiByte(CP_UTF8, 0, varPath.bstrVal, -1, di.symbolic_link,
+                                        sizeof(di.symbolic_link) - 1, nullptr, nullptr);
+                VariantClear(&varPath);
                 list.push_back(di);
                 ++index;
             }
@@ -947,6 +997,7 @@ bool DShowProvider::configureCaptureFormat(IAMStreamConfig *streamConfig)
 bool DShowProvider::isRawCandidate() const
 {
     return (subtype_ == MEDIASUBTYPE_NV12 || subtype_ == MFVideoFormat_P010 || subtype_ == MEDIASUBTYPE_YUY2 || subtype_ == MEDIASUBTYPE_Y210 ||
+            subtype_ == GCAP_SUBTYPE_V210 || subtype_ == GCAP_SUBTYPE_R210 ||
             subtype_ == MEDIASUBTYPE_RGB24 || subtype_ == MEDIASUBTYPE_RGB32 || subtype_ == MEDIASUBTYPE_ARGB32);
 }
 
@@ -1460,21 +1511,22 @@ bool DShowProvider::setProfile(const gcap_profile_t &p)
     return true;
 }
 
+// Frame memory is the handle's FramePool arena, sized by CaptureManager::setBuffersEx().
 bool DShowProvider::setBuffers(int, size_t)
 {
     return true;
 }
 
-bool DShowProvider::captureRawFrameToArgb(std::vector<uint8_t> &out, int &w, int &h, int &stride)
+bool DShowProvider::captureRawFrameToArgb(const uint8_t *raw, int w, int h, int rawStride, const GUID &subtype, uint8_t *out, int outStride)
 {
-    if (!rawRenderer_.copyLatestFrameToArgb(out, w, h, stride))
+    if (!rawRenderer_.convertToArgb(raw, w, h, rawStride, subtype, out, outStride))
     {
         static bool once = false;
         if (!once)
         {
             once = true;
             char msg[256] = {};
-            sprintf_s(msg, "[DShow] rawRenderer copyLatestFrameToArgb = NO hasFrame=%s sampleCount=%llu bytes=%llu",
+            sprintf_s(msg, "[DShow] rawRenderer convertToArgb = NO hasFrame=%s sampleCount=%llu bytes=%llu",
                       rawRenderer_.hasFrame() ? "YES" : "NO",
                       static_cast<unsigned long long>(rawRenderer_.sampleCount()),
                       static_cast<unsigned long long>(rawRenderer_.lastSampleBytes()));
@@ -1487,7 +1539,7 @@ bool DShowProvider::captureRawFrameToArgb(std::vector<uint8_t> &out, int &w, int
     {
         onceOk = true;
         char msg[256] = {};
-        sprintf_s(msg, "[DShow] rawRenderer copyLatestFrameToArgb = YES sampleCount=%llu bytes=%llu",
+        sprintf_s(msg, "[DShow] rawRenderer convertToArgb = YES sampleCount=%llu bytes=%llu",
                   static_cast<unsigned long long>(rawRenderer_.sampleCount()),
                   static_cast<unsigned long long>(rawRenderer_.lastSampleBytes()));
         dshow_log(msg);
@@ -1554,6 +1606,7 @@ void DShowProvider::logPreviewProbeStats(uint64_t frameId, int frameW, int frame
 
 void DShowProvider::framePumpLoop()
 {
+    GCAP_TRACE_THREAD_NAME("dshow frame pump");
     dshow_log("[DShow] framePumpLoop begin");
     disableDirectY210Preview_ = false;
     resetPreviewProbeStats();
@@ -1615,21 +1668,38 @@ void DShowProvider::framePumpLoop()
         gcap_on_video_cb vcb = nullptr;
         gcap_on_frame_packet_cb pcb = nullptr;
         void *user = nullptr;
+        gcap_video_output_t videoOut{};
         {
             std::lock_guard<std::mutex> lock(mtx_);
             vcb = vcb_;
             pcb = pcb_;
             user = user_;
+            videoOut = videoOutput_;
         }
 
         const uint64_t curSampleCount = rawRenderer_.sampleCount();
         if (rawOnlyActive_ && curSampleCount != 0 && curSampleCount == lastProcessedSampleCount)
             continue;
-        std::vector<uint8_t> raw;
-        int rw = 0, rh = 0, rstride = 0;
-        GUID rawSubtype = MEDIASUBTYPE_NULL;
+        // The newest sample is read in place from the renderer's triple buffer. Only a
+        // packet callback gets a copy, in a pool slot, so it can retain the frame.
         const auto tCopyRaw0 = std::chrono::steady_clock::now();
-        const bool haveRaw = rawRenderer_.copyLatestRaw(raw, rw, rh, rstride, rawSubtype) && !raw.empty();
+        DShowRawRenderer::RawFrame rf;
+        const bool haveRaw = rawRenderer_.borrowLatestRaw(rf) && rf.bytes > 0;
+        const int rw = rf.width, rh = rf.height, rstride = rf.stride;
+        const GUID rawSubtype = rf.subtype;
+        const size_t rawBytes = rf.bytes;
+        const uint8_t *raw = rf.data;
+        gcap::FrameLease rawLease = (framePool_ && pcb && haveRaw) ? framePool_->acquire(rawBytes) : gcap::FrameLease();
+        const bool skipPacket = framePool_ && pcb && !rawLease && framePool_->policy() == GCAP_LEASE_POLICY_SKIP;
+        if (rawLease)
+        {
+            // Spans before the frame id is assigned carry the id this frame is about to get.
+            GCAP_TRACE_SCOPE(RawCopy, frameCounter_ + 1);
+            std::memcpy(rawLease.data(), rf.data, rawBytes);
+            raw = rawLease.data();
+        }
+        if (stats_ && haveRaw)
+            stats_->copied(rawLease ? rawBytes * 2 : rawBytes); // Receive()'s copy into the triple buffer, and this one
         const auto tCopyRaw1 = std::chrono::steady_clock::now();
         static uint64_t s_lastActualSampleLogNs = 0;
         if (haveRaw)
@@ -1647,16 +1717,15 @@ void DShowProvider::framePumpLoop()
                               rh,
                               subtypeName(rawSubtype),
                               rstride,
-                              static_cast<unsigned long long>(raw.size()),
+                              static_cast<unsigned long long>(rawBytes),
                               static_cast<unsigned long long>(curSampleCount));
                 dshow_log(msg);
             }
         }
 
-        std::vector<uint8_t> buf;
         int w = 0, h = 0, stride = 0;
         const bool previewOnlyActive = (previewHwnd_ != nullptr);
-        const bool directY210Allowed = (rawSubtype != MEDIASUBTYPE_Y210) || canUseDirectY210Preview(rw, rh, rstride, raw.size());
+        const bool directY210Allowed = (rawSubtype != MEDIASUBTYPE_Y210) || canUseDirectY210Preview(rw, rh, rstride, rawBytes);
         const bool canUseSharedRaw = pipeline_ && haveRaw && rawOnlyActive_ &&
                                      (rawSubtype == MEDIASUBTYPE_NV12 || rawSubtype == MFVideoFormat_P010 || rawSubtype == MEDIASUBTYPE_YUY2 || rawSubtype == MEDIASUBTYPE_Y210) &&
                                      directY210Allowed;
@@ -1666,23 +1735,55 @@ void DShowProvider::framePumpLoop()
         //   - ARGB video callback is allowed during preview, but only at a low frequency
         //     so it does not drag preview smoothness back down.
         const bool allowVideoCallbackPath = (vcb != nullptr);
-        const bool needArgb = !canUseSharedRaw && (allowVideoCallbackPath || previewOnlyActive || rawSubtype == MEDIASUBTYPE_RGB24 || rawSubtype == MEDIASUBTYPE_RGB32 || rawSubtype == MEDIASUBTYPE_ARGB32);
-        const bool haveArgb = needArgb ? captureRawFrameToArgb(buf, w, h, stride) : false;
+        // With a video output size set, the ARGB-bridge callback converts + resizes the raw
+        // sample in one pass, so the full-size ARGB frame is only built for the preview.
+        int scaledW = 0, scaledH = 0;
+        const bool scaledVideo = allowVideoCallbackPath && haveRaw && !canUseSharedRaw &&
+                                 DShowRawRenderer::isScalableSubtype(rawSubtype) &&
+                                 gcap::video_output_size(videoOut, rw, rh, scaledW, scaledH);
+        const bool needArgb = !canUseSharedRaw && ((allowVideoCallbackPath && !scaledVideo) || previewOnlyActive || rawSubtype == MEDIASUBTYPE_RGB24 || rawSubtype == MEDIASUBTYPE_RGB32 || rawSubtype == MEDIASUBTYPE_ARGB32);
+        // Full-size ARGB goes into a pool slot when a callback may get it, so it can be
+        // retained without a copy; preview-only frames use the scratch buffer.
+        gcap::FrameLease argbLease;
+        uint8_t *argb = nullptr;
+        if (needArgb && haveRaw)
+        {
+            w = rw;
+            h = rh;
+            stride = DShowRawRenderer::argbRowBytes(rw);
+            const size_t argbBytes = (size_t)stride * (size_t)rh;
+            if (framePool_ && (vcb || pcb))
+                argbLease = framePool_->acquire(argbBytes);
+            if (!argbLease && argbScratch_.size() < argbBytes)
+                argbScratch_.resize(argbBytes);
+            argb = argbLease ? argbLease.data() : argbScratch_.data();
+        }
+        GCAP_TRACE_MARK(traceConvert0);
+        const uint64_t convert0 = (stats_ && argb) ? steady_now_ns() : 0;
+        const bool haveArgb = argb ? captureRawFrameToArgb(raw, rw, rh, rstride, rawSubtype, argb, stride) : false;
+        if (argb)
+            GCAP_TRACE_SPAN(Convert, frameCounter_ + 1, traceConvert0);
+        if (convert0)
+            stats_->record(gcap::StatHist::Convert, steady_now_ns() - convert0);
 
         if (haveRaw || haveArgb)
         {
             if (haveRaw && curSampleCount != 0)
                 lastProcessedSampleCount = curSampleCount;
+            // Raw frames keep the time Receive() got them, not the time the pump woke up.
             auto now = std::chrono::steady_clock::now().time_since_epoch();
-            const uint64_t ptsNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            const uint64_t ptsNs = (haveRaw && rf.hostNs) ? rf.hostNs : (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            const uint64_t ptsSmoothedNs = haveRaw ? rf.ptsSmoothedNs : 0;
             const uint64_t frameId = ++frameCounter_;
+            StatsFrameScope statsFrame{stats_};
 
-            if (pcb && haveRaw && rawOnlyActive_)
+            if (pcb && haveRaw && rawOnlyActive_ && !skipPacket)
             {
                 gcap_frame_packet_t pkt{};
                 pkt.width = rw;
                 pkt.height = rh;
                 pkt.pts_ns = ptsNs;
+                pkt.pts_smoothed_ns = ptsSmoothedNs;
                 pkt.frame_id = frameId;
                 pkt.backend = GCAP_BACKEND_DSHOW;
                 pkt.source_kind = GCAP_SOURCE_DSHOW_RAWSINK;
@@ -1692,8 +1793,8 @@ void DShowProvider::framePumpLoop()
                 {
                     pkt.format = GCAP_FMT_NV12;
                     pkt.plane_count = 2;
-                    pkt.data[0] = raw.data();
-                    pkt.data[1] = raw.data() + (size_t)rstride * (size_t)rh;
+                    pkt.data[0] = raw;
+                    pkt.data[1] = raw + (size_t)rstride * (size_t)rh;
                     pkt.stride[0] = rstride;
                     pkt.stride[1] = rstride;
                 }
@@ -1701,15 +1802,15 @@ void DShowProvider::framePumpLoop()
                 {
                     pkt.format = GCAP_FMT_YUY2;
                     pkt.plane_count = 1;
-                    pkt.data[0] = raw.data();
+                    pkt.data[0] = raw;
                     pkt.stride[0] = rstride;
                 }
                 else if (rawSubtype == MFVideoFormat_P010)
                 {
                     pkt.format = GCAP_FMT_P010;
                     pkt.plane_count = 2;
-                    pkt.data[0] = raw.data();
-                    pkt.data[1] = raw.data() + (size_t)rstride * (size_t)rh;
+                    pkt.data[0] = raw;
+                    pkt.data[1] = raw + (size_t)rstride * (size_t)rh;
                     pkt.stride[0] = rstride;
                     pkt.stride[1] = rstride;
                 }
@@ -1717,16 +1818,27 @@ void DShowProvider::framePumpLoop()
                 {
                     pkt.format = GCAP_FMT_Y210;
                     pkt.plane_count = 1;
-                    pkt.data[0] = raw.data();
+                    pkt.data[0] = raw;
+                    pkt.stride[0] = rstride;
+                }
+                else if (rawSubtype == GCAP_SUBTYPE_V210 || rawSubtype == GCAP_SUBTYPE_R210)
+                {
+                    pkt.format = (rawSubtype == GCAP_SUBTYPE_V210) ? GCAP_FMT_V210 : GCAP_FMT_R210;
+                    pkt.plane_count = 1;
+                    pkt.data[0] = raw;
                     pkt.stride[0] = rstride;
                 }
                 else
                 {
                     pkt.format = GCAP_FMT_ARGB;
                     pkt.plane_count = 1;
-                    pkt.data[0] = haveArgb ? buf.data() : nullptr;
+                    pkt.data[0] = haveArgb ? argb : nullptr;
                     pkt.stride[0] = stride;
                 }
+                if (rawLease && pkt.data[0] == raw)
+                    rawLease.attach(pkt);
+                else if (argbLease && pkt.data[0] == argb)
+                    argbLease.attach(pkt);
                 if (frameId <= 5 || (frameId % 60) == 0)
                 {
                     char dbg[256];
@@ -1740,6 +1852,7 @@ void DShowProvider::framePumpLoop()
                                   user);
                     dshow_log(dbg);
                 }
+                GCAP_TRACE_SCOPE(Callback, frameId);
                 pcb(&pkt, user);
             }
 
@@ -1816,8 +1929,8 @@ void DShowProvider::framePumpLoop()
                     bool uploaded = false;
                     if (rawSubtype == MEDIASUBTYPE_NV12)
                     {
-                        const uint8_t *y = raw.data();
-                        const uint8_t *uv = raw.data() + (size_t)rstride * (size_t)rh;
+                        const uint8_t *y = raw;
+                        const uint8_t *uv = raw + (size_t)rstride * (size_t)rh;
                         {
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->upload_nv12_frame(y, rstride, uv, rstride, rw, rh);
@@ -1826,6 +1939,7 @@ void DShowProvider::framePumpLoop()
                         }
                         if (uploaded)
                         {
+                            GCAP_TRACE_SCOPE(ProcAmp, frameId);
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->render_uploaded_yuv_to_fp16(GCAP_FMT_NV12, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
@@ -1841,8 +1955,8 @@ void DShowProvider::framePumpLoop()
                     }
                     else if (rawSubtype == MFVideoFormat_P010)
                     {
-                        const uint8_t *y = raw.data();
-                        const uint8_t *uv = raw.data() + (size_t)rstride * (size_t)rh;
+                        const uint8_t *y = raw;
+                        const uint8_t *uv = raw + (size_t)rstride * (size_t)rh;
                         {
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->upload_p010_frame(y, rstride, uv, rstride, rw, rh);
@@ -1851,6 +1965,7 @@ void DShowProvider::framePumpLoop()
                         }
                         if (uploaded)
                         {
+                            GCAP_TRACE_SCOPE(ProcAmp, frameId);
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->render_uploaded_yuv_to_fp16(GCAP_FMT_P010, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
@@ -1868,12 +1983,13 @@ void DShowProvider::framePumpLoop()
                     {
                         {
                             const auto t0 = std::chrono::steady_clock::now();
-                            uploaded = pipeline_->upload_yuy2_frame(raw.data(), rstride, rw, rh);
+                            uploaded = pipeline_->upload_yuy2_frame(raw, rstride, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
                             probeUploadNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
                         }
                         if (uploaded)
                         {
+                            GCAP_TRACE_SCOPE(ProcAmp, frameId);
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->render_uploaded_yuv_to_fp16(GCAP_FMT_YUY2, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
@@ -1891,16 +2007,17 @@ void DShowProvider::framePumpLoop()
                     {
                         {
                             const auto t0 = std::chrono::steady_clock::now();
-                            uploaded = pipeline_->upload_y210_frame(raw.data(), rstride, rw, rh);
+                            uploaded = pipeline_->upload_y210_frame(raw, rstride, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
                             probeUploadNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
                         }
                         if (!uploaded)
                         {
-                            noteDirectY210PreviewFailure("upload_y210_frame failed", rw, rh, rstride, raw.size());
+                            noteDirectY210PreviewFailure("upload_y210_frame failed", rw, rh, rstride, rawBytes);
                         }
                         if (uploaded)
                         {
+                            GCAP_TRACE_SCOPE(ProcAmp, frameId);
                             const auto t0 = std::chrono::steady_clock::now();
                             uploaded = pipeline_->render_uploaded_yuv_to_fp16(GCAP_FMT_Y210, rw, rh);
                             const auto t1 = std::chrono::steady_clock::now();
@@ -1908,7 +2025,7 @@ void DShowProvider::framePumpLoop()
                         }
                         if (!uploaded && !disableDirectY210Preview_.load())
                         {
-                            noteDirectY210PreviewFailure("render_uploaded_yuv_to_fp16(Y210) failed", rw, rh, rstride, raw.size());
+                            noteDirectY210PreviewFailure("render_uploaded_yuv_to_fp16(Y210) failed", rw, rh, rstride, rawBytes);
                         }
                         if (uploaded)
                         {
@@ -1919,7 +2036,7 @@ void DShowProvider::framePumpLoop()
                         }
                         if (!uploaded && !disableDirectY210Preview_.load())
                         {
-                            noteDirectY210PreviewFailure("copy_fp16_to_scene after Y210 failed", rw, rh, rstride, raw.size());
+                            noteDirectY210PreviewFailure("copy_fp16_to_scene after Y210 failed", rw, rh, rstride, rawBytes);
                         }
                     }
                     if (uploaded)
@@ -1935,6 +2052,7 @@ void DShowProvider::framePumpLoop()
                     }
                     if (uploaded)
                     {
+                        GCAP_TRACE_SCOPE(Present, frameId);
                         const auto t0 = std::chrono::steady_clock::now();
                         pipeline_->present_preview(rw, rh);
                         const auto t1 = std::chrono::steady_clock::now();
@@ -1979,12 +2097,13 @@ void DShowProvider::framePumpLoop()
                 if (ensuredRt && ensuredSwap)
                 {
                     const auto t0 = std::chrono::steady_clock::now();
-                    uploaded = pipeline_->upload_argb_frame(buf.data(), w, h, stride);
+                    uploaded = pipeline_->upload_argb_frame(argb, w, h, stride);
                     const auto t1 = std::chrono::steady_clock::now();
                     probeUploadNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
                 }
                 if (uploaded)
                 {
+                    GCAP_TRACE_SCOPE(ProcAmp, frameId);
                     const auto t0 = std::chrono::steady_clock::now();
                     uploaded = pipeline_->render_uploaded_argb_to_fp16(w, h);
                     const auto t1 = std::chrono::steady_clock::now();
@@ -2006,6 +2125,7 @@ void DShowProvider::framePumpLoop()
                 }
                 if (uploaded)
                 {
+                    GCAP_TRACE_SCOPE(Present, frameId);
                     const auto t0 = std::chrono::steady_clock::now();
                     pipeline_->present_preview(w, h);
                     const auto t1 = std::chrono::steady_clock::now();
@@ -2081,36 +2201,76 @@ void DShowProvider::framePumpLoop()
                                           canUseSharedRaw ? (rawSubtype == MEDIASUBTYPE_NV12 ? "NV12-direct" : (rawSubtype == MFVideoFormat_P010 ? "P010-direct" : (rawSubtype == MEDIASUBTYPE_Y210 ? "Y210-direct" : "YUY2-direct"))) : ((rawSubtype == MEDIASUBTYPE_Y210) ? "Y210-argb-fallback" : ((rawSubtype == MEDIASUBTYPE_RGB24 || rawSubtype == MEDIASUBTYPE_RGB32 || rawSubtype == MEDIASUBTYPE_ARGB32) ? "RGB-bridge" : "ARGB-bridge")));
                                 OutputDebugStringA(msg);
                             }
-                            vcb(&f, user);
+                            {
+                                GCAP_TRACE_SCOPE(Callback, frameId);
+                                vcb(&f, user);
+                            }
                             ++previewProbeStats_.callbackFrames;
                             ctx_->Unmap(pipeline_->rt_stage_.Get(), 0);
                         }
                     }
                 }
-                else if (haveArgb && wantVideoCallback)
+                else if ((haveArgb || scaledVideo) && wantVideoCallback)
                 {
+                    // The callback frame goes out from a pool slot (retainable): the full-size
+                    // ARGB frame was converted into one, the resized frame gets its own.
+                    gcap::FrameLease cbLease;
+                    uint8_t *cbData = argb;
+                    int cbStride = stride;
+                    if (scaledVideo)
+                    {
+                        cbStride = DShowRawRenderer::argbRowBytes(scaledW);
+                        const size_t scaledBytes = (size_t)cbStride * (size_t)scaledH;
+                        if (framePool_)
+                            cbLease = framePool_->acquire(scaledBytes);
+                        if (!cbLease && scaledArgb_.size() < scaledBytes)
+                            scaledArgb_.resize(scaledBytes);
+                        cbData = cbLease ? cbLease.data() : scaledArgb_.data();
+                    }
+                    const gcap::FrameLease &outLease = scaledVideo ? cbLease : argbLease;
+                    if (framePool_ && !outLease && framePool_->policy() == GCAP_LEASE_POLICY_SKIP)
+                        continue;
+                    GCAP_TRACE_MARK(traceScale0);
+                    const uint64_t scale0 = (stats_ && scaledVideo) ? steady_now_ns() : 0;
+                    const bool scaledOk = scaledVideo &&
+                                          rawRenderer_.convertRawScaled(raw, rw, rh, rstride, rawSubtype, scaledW, scaledH,
+                                                                        videoOut.filter, cbData, cbStride);
+                    if (scaledVideo)
+                        GCAP_TRACE_SPAN(Convert, frameId, traceScale0);
+                    if (scale0)
+                        stats_->record(gcap::StatHist::Convert, steady_now_ns() - scale0);
+                    if (!scaledOk && !haveArgb)
+                        continue;
+                    if (scaledOk)
+                        lastCallbackSource_ = CallbackSource::RawSink;
+                    const int cbW = scaledOk ? scaledW : w;
+                    const int cbH = scaledOk ? scaledH : h;
                     gcap_frame_t f{};
-                    f.data[0] = buf.data();
-                    f.stride[0] = stride;
+                    f.data[0] = scaledOk ? cbData : argb;
+                    f.stride[0] = scaledOk ? cbStride : stride;
+                    const gcap::FrameLease &fLease = scaledOk ? cbLease : argbLease;
+                    if (fLease)
+                        fLease.attach(f);
                     f.plane_count = 1;
-                    f.width = w;
-                    f.height = h;
+                    f.width = cbW;
+                    f.height = cbH;
                     f.format = GCAP_FMT_ARGB;
                     f.pts_ns = ptsNs;
                     f.frame_id = frameId;
-                    if (frameId <= 5 || (frameId % 60) == 0 || w != width_ || h != height_)
+                    if (frameId <= 5 || (frameId % 60) == 0 || cbW != width_ || cbH != height_)
                     {
                         char cbmsg[320] = {};
                         sprintf_s(cbmsg,
-                                  "[DShow][CallbackRawSample] frame=%llu src=argb-bridge out=%dx%d stride=%d negotiated=%dx%d source=%s resize=%s",
+                                  "[DShow][CallbackRawSample] frame=%llu src=%s out=%dx%d stride=%d negotiated=%dx%d source=%s resize=%s",
                                   static_cast<unsigned long long>(frameId),
-                                  w,
-                                  h,
-                                  stride,
+                                  scaledOk ? "argb-bridge-scaled" : "argb-bridge",
+                                  cbW,
+                                  cbH,
+                                  f.stride[0],
                                   width_,
                                   height_,
                                   callbackSourceName(lastCallbackSource_.load()),
-                                  (w == width_ && h == height_) ? "NO" : "YES");
+                                  (cbW == width_ && cbH == height_) ? "NO" : "YES");
                         dshow_log(cbmsg);
                     }
                     if (f.frame_id == 1 || (previewOnlyActive && previewProbeStats_.callbackFrames == 0))
@@ -2118,13 +2278,16 @@ void DShowProvider::framePumpLoop()
                         char msg[256] = {};
                         double fps = (negotiatedFpsNum_ > 0 && negotiatedFpsDen_ > 0) ? ((double)negotiatedFpsNum_ / (double)negotiatedFpsDen_) : 0.0;
                         sprintf_s(msg, "[DShow] callback frame -> %d x %d fmt=ARGB negotiated=%s %d x %d %.2ffps source=%s raw-candidate=%s raw-sink-plan=%s",
-                                  w, h, subtypeName(subtype_), width_, height_, fps,
+                                  cbW, cbH, subtypeName(subtype_), width_, height_, fps,
                                   callbackSourceName(lastCallbackSource_.load()),
                                   isRawCandidate() ? "YES" : "NO",
                                   rawSinkPlanned() ? "CUSTOM_V4_RAW_PREVIEW" : "NO");
                         OutputDebugStringA(msg);
                     }
-                    vcb(&f, user);
+                    {
+                        GCAP_TRACE_SCOPE(Callback, frameId);
+                        vcb(&f, user);
+                    }
                     ++previewProbeStats_.callbackFrames;
                 }
             }
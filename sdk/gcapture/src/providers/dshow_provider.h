@@ -22,6 +22,7 @@
 #include "dshow_raw_renderer.h"
 #include "dshow_custom_sink.h"
 #include "../core/capture_manager.h"
+#include "../core/frame_pool.h"
 #include "../pipeline/shared_scene_pipeline.h"
 
 class DShowProvider : public ICaptureProvider
@@ -39,6 +40,9 @@ public:
     void close() override;
     void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user) override;
     void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override;
+    void setVideoOutput(const gcap_video_output_t &out) override;
+    void setFramePool(gcap::FramePool *pool) override;
+    void setStats(gcap::CaptureStats *stats) override;
     bool getSignalStatus(gcap_signal_status_t &out) override;
     bool getRuntimeInfo(gcap_runtime_info_t &out) override;
     bool setPreview(const gcap_preview_desc_t &desc) override;
@@ -69,7 +73,7 @@ private:
         RawSink
     };
 
-    bool captureRawFrameToArgb(std::vector<uint8_t> &out, int &w, int &h, int &stride);
+    bool captureRawFrameToArgb(const uint8_t *raw, int w, int h, int rawStride, const GUID &subtype, uint8_t *out, int outStride);
     int framePumpSleepMs() const;
     bool shouldDoSharedReadback(uint64_t ptsNs, uint64_t frameId, bool sharedReady, bool havePreview, bool haveCallback, uint64_t &lastReadbackPtsNs) const;
     int callbackTargetFps() const;
@@ -119,9 +123,15 @@ private:
     gcap_on_frame_packet_cb pcb_ = nullptr;
     gcap_on_error_cb ecb_ = nullptr;
     void *user_ = nullptr;
+    gcap_video_output_t videoOutput_{}; // video callback size; guarded by mtx_
 
     std::mutex mtx_;
-    std::vector<uint8_t> argbBuffer_;
+    // Frame pump fallbacks when no pool slot is free (or no callback wants one);
+    // they only grow, so steady-state capture does not allocate.
+    std::vector<uint8_t> argbScratch_;
+    std::vector<uint8_t> scaledArgb_;
+    gcap::FramePool *framePool_ = nullptr; // retainable raw / callback frames (owned by CaptureManager)
+    gcap::StatsShard *stats_ = nullptr;    // frame pump's gcap_get_stats() shard (owned by CaptureManager)
     std::atomic<uint64_t> frameCounter_{0};
     std::atomic<CallbackSource> lastCallbackSource_{CallbackSource::Unknown};
 
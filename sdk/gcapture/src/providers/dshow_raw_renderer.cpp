@@ -1,41 +1,20 @@
 #include "dshow_raw_renderer.h"
 #include "../core/frame_converter.h"
+#include "../core/frame_arena.h"
 
 #include <algorithm>
 #include <cstring>
 #include <mfapi.h>
 #include <chrono>
 
-namespace
-{
-    static inline void yuvToRgb(int y, int u, int v, uint8_t &b, uint8_t &g, uint8_t &r)
-    {
-        const int c = y - 16;
-        const int d = u - 128;
-        const int e = v - 128;
-
-        const int rr = (298 * c + 409 * e + 128) >> 8;
-        const int gg = (298 * c - 100 * d - 208 * e + 128) >> 8;
-        const int bb = (298 * c + 516 * d + 128) >> 8;
-
-        auto clampByteLocal = [](int vv) -> uint8_t {
-            if (vv < 0) return 0;
-            if (vv > 255) return 255;
-            return static_cast<uint8_t>(vv);
-        };
-
-        r = clampByteLocal(rr);
-        g = clampByteLocal(gg);
-        b = clampByteLocal(bb);
-    }
-}
-
 const char *DShowRawRenderer::subtypeName(const GUID &g)
 {
     if (g == MEDIASUBTYPE_NV12 || g == MFVideoFormat_NV12) return "NV12";
     if (g == MFVideoFormat_P010) return "P010";
     if (g == MEDIASUBTYPE_YUY2 || g == MFVideoFormat_YUY2) return "YUY2";
     if (g == MEDIASUBTYPE_Y210 || g == MFVideoFormat_Y210) return "Y210";
+    if (g == GCAP_SUBTYPE_V210) return "V210";
+    if (g == GCAP_SUBTYPE_R210) return "R210";
     if (g == MEDIASUBTYPE_MJPG) return "MJPG";
     if (g == MEDIASUBTYPE_RGB24) return "RGB24";
     if (g == MEDIASUBTYPE_RGB32) return "RGB32";
@@ -73,12 +52,11 @@ void DShowRawRenderer::reset()
     height_ = 0;
     fpsNum_ = 0;
     fpsDen_ = 0;
-    latestSample_.clear();
-    latestStride_ = 0;
-    sampleCount_ = 0;
-    lastSampleBytes_ = 0;
-    lastSamplePtsNs_ = 0;
-    runtimeFpsAvg_ = 0.0;
+    accepting_.store(false, std::memory_order_release);
+    samples_.invalidate();
+    sampleCount_.store(0, std::memory_order_relaxed);
+    lastSampleBytes_.store(0, std::memory_order_relaxed);
+    clock_.reset();
     if (frameReadyEvent_)
         SetEvent(frameReadyEvent_);
 }
@@ -95,18 +73,55 @@ void DShowRawRenderer::setNegotiated(const GUID &subtype, int width, int height,
     fpsDen_ = fpsDen;
     if (!sameFormat)
     {
-        latestSample_.clear();
-        latestStride_ = 0;
-        sampleCount_ = 0;
-        lastSampleBytes_ = 0;
-        lastSamplePtsNs_ = 0;
-        runtimeFpsAvg_ = 0.0;
+        // Resolve colorimetry + converter specialisation once per media type.
+        gcap::YuvLayout layout = gcap::YuvLayout::Nv12;
+        yuvLayout(subtype, layout);
+        converter_ = gcap::make_frame_converter(layout, gcap::default_colorspace(height), GCAP_RANGE_LIMITED,
+                                                gcap::ProcAmpParams{});
+
+        samples_.invalidate();
+        sampleCount_.store(0, std::memory_order_relaxed);
+        lastSampleBytes_.store(0, std::memory_order_relaxed);
+        clock_.reset(fpsNum, fpsDen);
     }
+    accepting_.store(width_ > 0 && height_ > 0 && isSupportedSubtype(), std::memory_order_release);
+}
+
+bool DShowRawRenderer::yuvLayout(const GUID &subtype, gcap::YuvLayout &out)
+{
+    if (subtype == MEDIASUBTYPE_NV12)
+        out = gcap::YuvLayout::Nv12;
+    else if (subtype == MEDIASUBTYPE_YUY2)
+        out = gcap::YuvLayout::Yuy2;
+    else if (subtype == MEDIASUBTYPE_Y210)
+        out = gcap::YuvLayout::Y210;
+    else if (subtype == MFVideoFormat_P010)
+        out = gcap::YuvLayout::P010;
+    else if (subtype == GCAP_SUBTYPE_V210)
+        out = gcap::YuvLayout::V210;
+    else
+        return false;
+    return true;
+}
+
+gcap::FrameConverter DShowRawRenderer::converterFor(const GUID &subtype, int height) const
+{
+    gcap::YuvLayout layout = gcap::YuvLayout::Nv12;
+    yuvLayout(subtype, layout);
+    {
+        std::lock_guard<std::mutex> lock(sampleMtx_);
+        if (converter_.layout == layout && height_ == height)
+            return converter_;
+    }
+    // A frame published before the last media type change.
+    return gcap::make_frame_converter(layout, gcap::default_colorspace(height), GCAP_RANGE_LIMITED,
+                                      gcap::ProcAmpParams{});
 }
 
 bool DShowRawRenderer::isSupportedSubtype() const
 {
     return subtype_ == MEDIASUBTYPE_NV12 || subtype_ == MFVideoFormat_P010 || subtype_ == MEDIASUBTYPE_YUY2 || subtype_ == MEDIASUBTYPE_Y210 ||
+           subtype_ == GCAP_SUBTYPE_V210 || subtype_ == GCAP_SUBTYPE_R210 ||
            subtype_ == MEDIASUBTYPE_RGB24 || subtype_ == MEDIASUBTYPE_RGB32 || subtype_ == MEDIASUBTYPE_ARGB32;
 }
 
@@ -116,6 +131,8 @@ GUID DShowRawRenderer::negotiatedFormat() const
     if (subtype_ == MFVideoFormat_P010) return MFVideoFormat_P010;
     if (subtype_ == MEDIASUBTYPE_YUY2) return MEDIASUBTYPE_YUY2;
     if (subtype_ == MEDIASUBTYPE_Y210) return MEDIASUBTYPE_Y210;
+    if (subtype_ == GCAP_SUBTYPE_V210) return GCAP_SUBTYPE_V210;
+    if (subtype_ == GCAP_SUBTYPE_R210) return GCAP_SUBTYPE_R210;
     if (subtype_ == MEDIASUBTYPE_RGB24) return MEDIASUBTYPE_RGB24;
     if (subtype_ == MEDIASUBTYPE_RGB32) return MEDIASUBTYPE_RGB32;
     if (subtype_ == MEDIASUBTYPE_ARGB32) return MEDIASUBTYPE_ARGB32;
@@ -127,26 +144,42 @@ const char *DShowRawRenderer::negotiatedSubtypeName() const
     return subtypeName(subtype_);
 }
 
-bool DShowRawRenderer::pushSample(const uint8_t *data, size_t bytes, int sampleStride)
+bool DShowRawRenderer::pushSample(const uint8_t *data, size_t bytes, int sampleStride, int64_t deviceNs)
 {
-    if (!data || bytes == 0 || width_ <= 0 || height_ <= 0 || !isSupportedSubtype())
+    if (!data || bytes == 0 || !accepting_.load(std::memory_order_acquire))
         return false;
 
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    latestSample_.assign(data, data + bytes);
-    latestStride_ = sampleStride;
-    sampleCount_ += 1;
-    lastSampleBytes_ = bytes;
-
+    // Arrival time is taken before the copy so it does not include it.
     const auto now = std::chrono::steady_clock::now().time_since_epoch();
     const uint64_t nowNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
-    if (lastSamplePtsNs_ != 0 && nowNs > lastSamplePtsNs_)
+    // Every sample goes through the clock, including ones the pump never sees, so
+    // drops are counted at the device cadence.
+    gcap::ClockRecovery::Gap gap;
+    const uint64_t ptsNs = clock_.update(deviceNs, nowNs, &gap);
+    if (stats_)
+    {
+        stats_->arrived(nowNs);
+        stats_->add(gcap::StatCounter::FramesDropped, gap.dropped);
+        stats_->add(gcap::StatCounter::FramesDuplicated, gap.duplicated);
+        stats_->tick(nowNs);
+    }
+
+    // The frame carries the media type it arrived with; setNegotiated() may change it
+    // before the pump reads the frame.
+    gcap::TripleBuffer::Format format;
     {
-        const double fpsNow = 1e9 / double(nowNs - lastSamplePtsNs_);
-        if (fpsNow > 0.0)
-            runtimeFpsAvg_ = (runtimeFpsAvg_ <= 0.0) ? fpsNow : (runtimeFpsAvg_ * 0.9 + fpsNow * 0.1);
+        std::lock_guard<std::mutex> lock(sampleMtx_);
+        format.width = width_;
+        format.height = height_;
+        std::memcpy(format.id, &subtype_, sizeof(GUID));
     }
-    lastSamplePtsNs_ = nowNs;
+
+    // The only copy of the frame: DirectShow wants its sample back when Receive() returns.
+    std::memcpy(samples_.writeBuffer(bytes), data, bytes);
+    samples_.publish(bytes, sampleStride, format, nowNs, ptsNs);
+    lastSampleBytes_.store(bytes, std::memory_order_relaxed);
+    sampleCount_.fetch_add(1, std::memory_order_release);
+
     if (frameReadyEvent_)
         SetEvent(frameReadyEvent_);
     return true;
@@ -154,169 +187,156 @@ bool DShowRawRenderer::pushSample(const uint8_t *data, size_t bytes, int sampleS
 
 bool DShowRawRenderer::hasFrame() const
 {
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    return !latestSample_.empty();
+    return sampleCount_.load(std::memory_order_acquire) != 0;
 }
 
-bool DShowRawRenderer::copyLatestRaw(std::vector<uint8_t> &out, int &w, int &h, int &stride, GUID &subtype) const
+bool DShowRawRenderer::borrowLatestRaw(RawFrame &out)
 {
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    if (latestSample_.empty() || width_ <= 0 || height_ <= 0)
+    gcap::TripleBuffer::View v;
+    if (!samples_.latest(v))
+        return false;
+
+    // Layout from the frame's own format, never from the current media type.
+    const int w = v.format.width;
+    const int h = v.format.height;
+    GUID subtype;
+    std::memcpy(&subtype, v.format.id, sizeof(GUID));
+    if (w <= 0 || h <= 0)
         return false;
 
-    out = latestSample_;
-    w = width_;
-    h = height_;
-    subtype = subtype_;
-    if (latestStride_ > 0)
+    int rowBytes = 0;
+    int rows = h;
+    if (subtype == MEDIASUBTYPE_NV12)
     {
-        stride = latestStride_;
+        rowBytes = w;
+        rows = h + (h + 1) / 2;
     }
-    else if (subtype_ == MEDIASUBTYPE_NV12)
+    else if (subtype == MEDIASUBTYPE_YUY2)
     {
-        stride = width_;
+        rowBytes = w * 2;
     }
-    else if (subtype_ == MEDIASUBTYPE_YUY2)
+    else if (subtype == MEDIASUBTYPE_Y210)
     {
-        stride = width_ * 2;
+        rowBytes = w * 4;
     }
-    else if (subtype_ == MEDIASUBTYPE_Y210)
+    else if (subtype == MFVideoFormat_P010)
     {
-        stride = width_ * 4;
+        // P010 is 4:2:0, 16 bits per sample; one luma row is width * 2 bytes.
+        rowBytes = w * 2;
+        rows = h + (h + 1) / 2;
     }
-    else if (subtype_ == MFVideoFormat_P010)
+    else if (subtype == GCAP_SUBTYPE_V210)
     {
-        // P010 is 4:2:0, 16 bits per sample; one luma row is width * 2 bytes.
-        stride = width_ * 2;
+        rowBytes = gcap::v210_row_bytes(w);
     }
-    else if (subtype_ == MEDIASUBTYPE_RGB24)
+    else if (subtype == GCAP_SUBTYPE_R210)
     {
-        stride = width_ * 3;
+        rowBytes = gcap::r210_row_bytes(w);
     }
-    else if (subtype_ == MEDIASUBTYPE_RGB32 || subtype_ == MEDIASUBTYPE_ARGB32)
+    else if (subtype == MEDIASUBTYPE_RGB24)
     {
-        stride = width_ * 4;
+        rowBytes = w * 3;
     }
-    else
+    else if (subtype == MEDIASUBTYPE_RGB32 || subtype == MEDIASUBTYPE_ARGB32)
     {
-        stride = 0;
+        rowBytes = w * 4;
     }
+    const int stride = v.stride > 0 ? v.stride : rowBytes;
+    // A short sample would send the converter past the end of the buffer.
+    if (rowBytes > 0 && (stride < rowBytes || (size_t)stride * (size_t)(rows - 1) + (size_t)rowBytes > v.bytes))
+        return false;
+
+    out.data = v.data;
+    out.bytes = v.bytes;
+    out.seq = v.seq;
+    out.hostNs = v.hostNs;
+    out.ptsSmoothedNs = v.ptsNs;
+    out.width = w;
+    out.height = h;
+    out.subtype = subtype;
+    out.stride = stride;
     return true;
 }
 
-bool DShowRawRenderer::copyLatestFrameToArgb(std::vector<uint8_t> &out, int &w, int &h, int &stride) const
+int DShowRawRenderer::argbRowBytes(int w)
+{
+    return gcap::aligned_row_bytes(w * 4);
+}
+
+bool DShowRawRenderer::convertToArgb(const uint8_t *raw, int w, int h, int stride, const GUID &subtype, uint8_t *out, int outStride) const
 {
-    std::vector<uint8_t> raw;
-    GUID subtype = MEDIASUBTYPE_NULL;
-    if (!copyLatestRaw(raw, w, h, stride, subtype))
+    if (!raw || !out || w <= 0 || h <= 0 || outStride < w * 4)
         return false;
 
-    if (subtype == MEDIASUBTYPE_NV12)
-    {
-        nv12ToArgb(raw.data(), w, h, stride, out, stride);
-        return true;
-    }
-    if (subtype == MEDIASUBTYPE_YUY2)
+    if (subtype == MEDIASUBTYPE_NV12 || subtype == MFVideoFormat_P010 || subtype == MEDIASUBTYPE_YUY2 || subtype == MEDIASUBTYPE_Y210 ||
+        subtype == GCAP_SUBTYPE_V210)
     {
-        yuy2ToArgb(raw.data(), w, h, stride, out, stride);
+        yuvToArgb(converterFor(subtype, h), raw, w, h, stride, out, outStride);
         return true;
     }
-    if (subtype == MEDIASUBTYPE_Y210)
+    if (subtype == GCAP_SUBTYPE_R210)
     {
-        y210ToArgb(raw.data(), w, h, stride, out, stride);
+        gcap::r210_to_argb(raw, w, h, stride, out, outStride);
         return true;
     }
     if (subtype == MEDIASUBTYPE_RGB24)
     {
-        rgb24ToArgb(raw.data(), w, h, stride, out, stride);
+        rgb24ToArgb(raw, w, h, stride, out, outStride);
         return true;
     }
     if (subtype == MEDIASUBTYPE_RGB32 || subtype == MEDIASUBTYPE_ARGB32)
     {
-        bgraToArgb(raw.data(), w, h, stride, out, stride);
+        bgraToArgb(raw, w, h, stride, out, outStride);
         return true;
     }
     return false;
 }
 
-void DShowRawRenderer::nv12ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride)
+bool DShowRawRenderer::isScalableSubtype(const GUID &g)
 {
-    dstStride = width * 4;
-    dst.resize(static_cast<size_t>(dstStride) * static_cast<size_t>(height));
-
-    const uint8_t *yPlane = src;
-    const uint8_t *uvPlane = src + static_cast<size_t>(srcStride) * static_cast<size_t>(height);
-
-    for (int y = 0; y < height; ++y)
-    {
-        const uint8_t *yRow = yPlane + static_cast<size_t>(y) * srcStride;
-        const uint8_t *uvRow = uvPlane + static_cast<size_t>(y / 2) * srcStride;
-        uint8_t *dstRow = dst.data() + static_cast<size_t>(y) * dstStride;
-        for (int x = 0; x < width; ++x)
-        {
-            const int Y = yRow[x];
-            const int U = uvRow[(x & ~1) + 0];
-            const int V = uvRow[(x & ~1) + 1];
-            uint8_t b = 0, g = 0, r = 0;
-            yuvToRgb(Y, U, V, b, g, r);
-            uint8_t *p = dstRow + static_cast<size_t>(x) * 4;
-            p[0] = b;
-            p[1] = g;
-            p[2] = r;
-            p[3] = 255;
-        }
-    }
+    return g == MEDIASUBTYPE_NV12 || g == MFVideoFormat_P010 || g == MEDIASUBTYPE_YUY2 || g == MEDIASUBTYPE_Y210;
 }
 
-void DShowRawRenderer::yuy2ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride)
+bool DShowRawRenderer::convertRawScaled(const uint8_t *raw, int w, int h, int stride, const GUID &subtype, int outW,
+                                        int outH, gcap_scale_filter_t filter, uint8_t *out, int outStride)
 {
-    dstStride = width * 4;
-    dst.resize(static_cast<size_t>(dstStride) * static_cast<size_t>(height));
+    if (!raw || !out || !isScalableSubtype(subtype) || outW <= 0 || outH <= 0 || outStride < outW * 4)
+        return false;
+    const gcap::FrameConverter cv = converterFor(subtype, h);
+    if (!gcap::scale_supported(cv.layout))
+        return false;
 
-    for (int y = 0; y < height; ++y)
+    if (scalePlan_.layout != cv.layout || scalePlan_.src_width != w || scalePlan_.src_height != h ||
+        scalePlan_.dst_width != outW || scalePlan_.dst_height != outH || scaleFilter_ != filter)
     {
-        const uint8_t *srcRow = src + static_cast<size_t>(y) * srcStride;
-        uint8_t *dstRow = dst.data() + static_cast<size_t>(y) * dstStride;
-        for (int x = 0; x < width; x += 2)
-        {
-            const uint8_t y0 = srcRow[x * 2 + 0];
-            const uint8_t u  = srcRow[x * 2 + 1];
-            const uint8_t y1 = srcRow[x * 2 + 2];
-            const uint8_t v  = srcRow[x * 2 + 3];
-
-            uint8_t b = 0, g = 0, r = 0;
-            yuvToRgb(y0, u, v, b, g, r);
-            uint8_t *p0 = dstRow + static_cast<size_t>(x) * 4;
-            p0[0] = b; p0[1] = g; p0[2] = r; p0[3] = 255;
-
-            if (x + 1 < width)
-            {
-                yuvToRgb(y1, u, v, b, g, r);
-                uint8_t *p1 = dstRow + static_cast<size_t>(x + 1) * 4;
-                p1[0] = b; p1[1] = g; p1[2] = r; p1[3] = 255;
-            }
-        }
+        scalePlan_ = gcap::make_scale_plan(cv.layout, w, h, outW, outH, filter);
+        scaleFilter_ = filter;
     }
+
+    const uint8_t *uvPlane = (cv.layout == gcap::YuvLayout::Nv12 || cv.layout == gcap::YuvLayout::P010)
+                                 ? raw + static_cast<size_t>(stride) * static_cast<size_t>(h)
+                                 : nullptr;
+    gcap::convert_frame_scaled(cv, scalePlan_, raw, uvPlane, stride, stride, out, outStride);
+    return true;
 }
 
-void DShowRawRenderer::y210ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride)
+void DShowRawRenderer::yuvToArgb(const gcap::FrameConverter &cv, const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride)
 {
-    dstStride = width * 4;
-    dst.resize(static_cast<size_t>(dstStride) * static_cast<size_t>(height));
-
-    gcap::y210_to_argb(src, width, height, srcStride, dst.data(), dstStride);
+    // NV12 / P010: UV plane follows the Y plane with the same stride.
+    const uint8_t *uvPlane = (cv.layout == gcap::YuvLayout::Nv12 || cv.layout == gcap::YuvLayout::P010)
+                                 ? src + static_cast<size_t>(srcStride) * static_cast<size_t>(height)
+                                 : nullptr;
+    gcap::convert_frame(cv, src, uvPlane, srcStride, srcStride, width, height, dst, dstStride);
 }
 
 uint64_t DShowRawRenderer::sampleCount() const
 {
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    return sampleCount_;
+    return sampleCount_.load(std::memory_order_acquire);
 }
 
 size_t DShowRawRenderer::lastSampleBytes() const
 {
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    return lastSampleBytes_;
+    return lastSampleBytes_.load(std::memory_order_relaxed);
 }
 
 HANDLE DShowRawRenderer::frameReadyEvent() const
@@ -326,17 +346,14 @@ HANDLE DShowRawRenderer::frameReadyEvent() const
 
 
 
-void DShowRawRenderer::rgb24ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride)
+void DShowRawRenderer::rgb24ToArgb(const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride)
 {
-    dstStride = width * 4;
-    dst.resize(static_cast<size_t>(dstStride) * static_cast<size_t>(height));
-
     // DShow RGB24 samples are commonly delivered bottom-up. Flip rows here so
     // preview/callback ARGB becomes top-down for Qt / D3D upload.
     for (int y = 0; y < height; ++y)
     {
         const uint8_t *srcRow = src + static_cast<size_t>(height - 1 - y) * static_cast<size_t>(srcStride);
-        uint8_t *dstRow = dst.data() + static_cast<size_t>(y) * static_cast<size_t>(dstStride);
+        uint8_t *dstRow = dst + static_cast<size_t>(y) * static_cast<size_t>(dstStride);
         for (int x = 0; x < width; ++x)
         {
             const uint8_t *s = srcRow + static_cast<size_t>(x) * 3;
@@ -349,23 +366,19 @@ void DShowRawRenderer::rgb24ToArgb(const uint8_t *src, int width, int height, in
     }
 }
 
-void DShowRawRenderer::bgraToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride)
+void DShowRawRenderer::bgraToArgb(const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride)
 {
-    dstStride = width * 4;
-    dst.resize(static_cast<size_t>(dstStride) * static_cast<size_t>(height));
-
     // DShow RGB32/ARGB32 samples are commonly delivered as bottom-up DIB rows.
     // Keep preview/callback output top-down, same as rgb24ToArgb().
     for (int y = 0; y < height; ++y)
     {
         const uint8_t *srcRow = src + static_cast<size_t>(height - 1 - y) * static_cast<size_t>(srcStride);
-        uint8_t *dstRow = dst.data() + static_cast<size_t>(y) * static_cast<size_t>(dstStride);
-        std::memcpy(dstRow, srcRow, static_cast<size_t>(dstStride));
+        uint8_t *dstRow = dst + static_cast<size_t>(y) * static_cast<size_t>(dstStride);
+        std::memcpy(dstRow, srcRow, static_cast<size_t>(width) * 4);
     }
 }
 
-double DShowRawRenderer::runtimeFpsAvg() const
+gcap::ClockRecovery::Stats DShowRawRenderer::clockStats() const
 {
-    std::lock_guard<std::mutex> lock(sampleMtx_);
-    return runtimeFpsAvg_;
+    return clock_.stats();
 }
@@ -3,9 +3,21 @@
 #include <windows.h>
 #include <dshow.h>
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include <mutex>
 
+#include "../core/capture_stats.h"
+#include "../core/clock_recovery.h"
+#include "../core/frame_converter.h"
+#include "../core/triple_buffer.h"
+
+// FourCC subtypes for the SDI-style 10-bit formats: v210 (packed 4:2:2) and
+// r210 (big-endian 10-bit RGB). Both follow the {FOURCC-0000-0010-8000-00AA00389B71}
+// rule DirectShow and MF share; r210 has no name in the Windows SDK.
+static const GUID GCAP_SUBTYPE_V210 = {0x30313276, 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+static const GUID GCAP_SUBTYPE_R210 = {0x30313272, 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+
 class DShowRawRenderer
 {
 public:
@@ -22,23 +34,52 @@ public:
     // DS13 custom raw sink core API:
     // The future DirectShow custom renderer filter will call pushSample() from
     // its IMemInputPin/Receive() path after media type negotiation is complete.
-    bool pushSample(const uint8_t *data, size_t bytes, int sampleStride = 0);
+    // deviceNs is the sample's start time (IMediaSample::GetTime, ns), -1 when it has none.
+    bool pushSample(const uint8_t *data, size_t bytes, int sampleStride = 0, int64_t deviceNs = -1);
+    // Shard pushSample() counts arrivals and clock gaps on (the streaming thread's); set while stopped.
+    void setStats(gcap::StatsShard *stats) { stats_ = stats; }
 
     bool hasFrame() const;
     uint64_t sampleCount() const;
     size_t lastSampleBytes() const;
     HANDLE frameReadyEvent() const;
-    bool copyLatestRaw(std::vector<uint8_t> &out, int &w, int &h, int &stride, GUID &subtype) const;
-    bool copyLatestFrameToArgb(std::vector<uint8_t> &out, int &w, int &h, int &stride) const;
-    double runtimeFpsAvg() const;
+    struct RawFrame
+    {
+        const uint8_t *data = nullptr;
+        size_t bytes = 0;
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+        GUID subtype = MEDIASUBTYPE_NULL;
+        uint64_t seq = 0;
+        uint64_t hostNs = 0;        // steady_clock when Receive() got the sample
+        uint64_t ptsSmoothedNs = 0; // recovered frame time, same clock
+    };
+    // Newest sample, read in place (no copy). Single consumer: only the frame pump
+    // may call it. The buffer stays valid and untouched by pushSample() until the
+    // next call.
+    bool borrowLatestRaw(RawFrame &out);
+    // Converts a raw sample (from borrowLatestRaw) to w x h BGRA, top-down, at `outStride`
+    // (at least w * 4; argbRowBytes() gives the aligned pitch).
+    bool convertToArgb(const uint8_t *raw, int w, int h, int stride, const GUID &subtype, uint8_t *out, int outStride) const;
+    static int argbRowBytes(int w);
+    // Converts a raw sample straight to outW x outH BGRA in one pass.
+    // Only NV12 / P010 / YUY2 / Y210; the resampling plan is cached between calls, so
+    // call it from one thread (the frame pump).
+    bool convertRawScaled(const uint8_t *raw, int w, int h, int stride, const GUID &subtype, int outW, int outH,
+                          gcap_scale_filter_t filter, uint8_t *out, int outStride);
+    static bool isScalableSubtype(const GUID &g);
+    // Frame rate, drops and jitter recovered from the sample times.
+    gcap::ClockRecovery::Stats clockStats() const;
 
 private:
     static uint8_t clampByte(int v);
-    static void nv12ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride);
-    static void yuy2ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride);
-    static void y210ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride);
-    static void rgb24ToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride);
-    static void bgraToArgb(const uint8_t *src, int width, int height, int srcStride, std::vector<uint8_t> &dst, int &dstStride);
+    static bool yuvLayout(const GUID &subtype, gcap::YuvLayout &out);
+    // converter_ when it matches `subtype`, else one made for the frame's own media type.
+    gcap::FrameConverter converterFor(const GUID &subtype, int height) const;
+    static void yuvToArgb(const gcap::FrameConverter &cv, const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride);
+    static void rgb24ToArgb(const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride);
+    static void bgraToArgb(const uint8_t *src, int width, int height, int srcStride, uint8_t *dst, int dstStride);
 
 private:
     GUID subtype_ = MEDIASUBTYPE_NULL;
@@ -46,13 +87,20 @@ private:
     int height_ = 0;
     int fpsNum_ = 0;
     int fpsDen_ = 0;
+    gcap::FrameConverter converter_; // chosen in setNegotiated()
+    gcap::ScalePlan scalePlan_;      // convertRawScaled() cache
+    gcap_scale_filter_t scaleFilter_ = GCAP_SCALE_AUTO;
 
+    // Guards the negotiated format and converter above; pushSample() only snapshots the
+    // format under it, the sample bytes do not go through it.
     mutable std::mutex sampleMtx_;
-    std::vector<uint8_t> latestSample_;
-    int latestStride_ = 0;
-    uint64_t sampleCount_ = 0;
-    size_t lastSampleBytes_ = 0;
-    uint64_t lastSamplePtsNs_ = 0;
-    double runtimeFpsAvg_ = 0.0;
+    // Streaming thread -> frame pump, lock-free: pushSample() writes the back buffer
+    // and publishes it with its format, borrowLatestRaw() reads the front buffer in place.
+    gcap::TripleBuffer samples_;
+    std::atomic<bool> accepting_{false}; // negotiated format is one pushSample() handles
+    std::atomic<uint64_t> sampleCount_{0};
+    std::atomic<size_t> lastSampleBytes_{0};
+    gcap::ClockRecovery clock_; // fed by pushSample() only
+    gcap::StatsShard *stats_ = nullptr;
     HANDLE frameReadyEvent_ = nullptr;
 };
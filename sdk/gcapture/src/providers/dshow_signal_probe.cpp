@@ -1,4 +1,5 @@
 #include "dshow_signal_probe.h"
+#include "dshow_raw_renderer.h"
 
 #include <objbase.h>
 #include <dvdmedia.h>
@@ -1091,7 +1092,8 @@ static bool dshow_known_capture_subtype(const GUID &sub)
     return sub == MEDIASUBTYPE_NV12 || sub == MEDIASUBTYPE_YUY2 || sub == MEDIASUBTYPE_Y210 ||
            sub == MEDIASUBTYPE_RGB24 || sub == MEDIASUBTYPE_RGB32 || sub == MEDIASUBTYPE_ARGB32 ||
            sub == MFVideoFormat_NV12 || sub == MFVideoFormat_YUY2 || sub == MFVideoFormat_P010 ||
-           sub == MFVideoFormat_Y210 || sub == MFVideoFormat_ARGB32;
+           sub == MFVideoFormat_Y210 || sub == MFVideoFormat_ARGB32 ||
+           sub == GCAP_SUBTYPE_V210 || sub == GCAP_SUBTYPE_R210;
 }
 
 gcap_pixfmt_t gcap_subtype_to_pixfmt(const GUID &sub)
@@ -1104,6 +1106,10 @@ gcap_pixfmt_t gcap_subtype_to_pixfmt(const GUID &sub)
         return GCAP_FMT_Y210;
     if (sub == MEDIASUBTYPE_RGB24 || sub == MEDIASUBTYPE_RGB32 || sub == MEDIASUBTYPE_ARGB32)
         return GCAP_FMT_ARGB;
+    if (sub == GCAP_SUBTYPE_V210)
+        return GCAP_FMT_V210;
+    if (sub == GCAP_SUBTYPE_R210)
+        return GCAP_FMT_R210;
 #ifdef MFVideoFormat_NV12
     if (sub == MFVideoFormat_NV12)
         return GCAP_FMT_NV12;
@@ -1147,6 +1153,10 @@ const char *gcap_pixfmt_name(gcap_pixfmt_t f)
         return "Y210";
     case GCAP_FMT_ARGB:
         return "ARGB";
+    case GCAP_FMT_V210:
+        return "V210";
+    case GCAP_FMT_R210:
+        return "R210";
     default:
         return "Unknown";
     }
@@ -1182,6 +1192,10 @@ const char *gcap_subtype_name(const GUID &sub)
         return "RGB32";
     if (sub == MFVideoFormat_MJPG)
         return "MJPG";
+    if (sub == GCAP_SUBTYPE_V210)
+        return "V210";
+    if (sub == GCAP_SUBTYPE_R210)
+        return "R210";
 
     return "Unknown";
 }
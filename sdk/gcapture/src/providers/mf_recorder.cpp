@@ -22,6 +22,125 @@
 
 using Microsoft::WRL::ComPtr;
 
+static constexpr size_t kMaxSpareBuffers = 16; // WasapiCapture::spare_
+static constexpr size_t kMaxFreeSamples = 8;   // MfSamplePool::free_
+
+// ------------------------------------------------------------
+// MfSamplePool
+//  - Samples are IMFTrackedSample: when the sink writer drops its last
+//    reference, Invoke() gets the sample back instead of it being freed.
+//  - Each sample keeps one memory buffer; a free sample that is too small
+//    for the next request is dropped and a bigger one is made.
+// ------------------------------------------------------------
+class MfSamplePool : public IMFAsyncCallback
+{
+public:
+    // Sample with a single buffer of at least `bytes`, lengths and attributes reset.
+    HRESULT acquire(DWORD bytes, IMFSample **out)
+    {
+        ComPtr<IMFSample> sample;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            while (!free_.empty() && !sample)
+            {
+                ComPtr<IMFSample> s = std::move(free_.back());
+                free_.pop_back();
+                ComPtr<IMFMediaBuffer> b;
+                DWORD maxLen = 0;
+                if (SUCCEEDED(s->GetBufferByIndex(0, &b)) && SUCCEEDED(b->GetMaxLength(&maxLen)) && maxLen >= bytes)
+                    sample = s;
+            }
+        }
+
+        HRESULT hr = S_OK;
+        if (sample)
+        {
+            sample->DeleteAllItems();
+        }
+        else
+        {
+            ComPtr<IMFTrackedSample> tracked;
+            hr = MFCreateTrackedSample(&tracked);
+            if (SUCCEEDED(hr))
+                hr = tracked.As(&sample);
+            ComPtr<IMFMediaBuffer> b;
+            if (SUCCEEDED(hr))
+                hr = MFCreateMemoryBuffer(bytes, &b);
+            if (SUCCEEDED(hr))
+                hr = sample->AddBuffer(b.Get());
+            if (FAILED(hr))
+                return hr;
+        }
+
+        ComPtr<IMFTrackedSample> tracked;
+        hr = sample.As(&tracked);
+        if (FAILED(hr))
+            return hr;
+        AddRef(); // dropped in Invoke(); keeps the pool alive while the writer holds samples
+        hr = tracked->SetAllocator(this, nullptr);
+        if (FAILED(hr))
+        {
+            Release();
+            return hr;
+        }
+        *out = sample.Detach();
+        return S_OK;
+    }
+
+    // Drops the free samples; ones still queued in the writer are freed when it lets go.
+    void close()
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        closed_ = true;
+        free_.clear();
+    }
+
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (!ppv)
+            return E_POINTER;
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IMFAsyncCallback))
+        {
+            *ppv = static_cast<IMFAsyncCallback *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override { return ++refs_; }
+    STDMETHODIMP_(ULONG) Release() override
+    {
+        const ULONG n = --refs_;
+        if (n == 0)
+            delete this;
+        return n;
+    }
+
+    STDMETHODIMP GetParameters(DWORD *, DWORD *) override { return E_NOTIMPL; }
+    STDMETHODIMP Invoke(IMFAsyncResult *result) override
+    {
+        ComPtr<IUnknown> obj;
+        ComPtr<IMFSample> sample;
+        if (result && SUCCEEDED(result->GetObject(&obj)) && SUCCEEDED(obj.As(&sample)))
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (!closed_ && free_.size() < kMaxFreeSamples)
+                free_.push_back(std::move(sample));
+        }
+        sample.Reset();
+        obj.Reset();
+        Release();
+        return S_OK;
+    }
+
+private:
+    std::atomic<ULONG> refs_{1};
+    std::mutex mtx_;
+    bool closed_ = false;
+    std::vector<ComPtr<IMFSample>> free_;
+};
+
 // WASAPI 需要 ole32
 #pragma comment(lib, "ole32.lib")
 
@@ -131,7 +250,10 @@ bool WasapiCapture::pop(Chunk &out)
     std::lock_guard<std::mutex> lk(mutex_);
     if (queue_.empty())
         return false;
-    out = std::move(queue_.front());
+    // Swap rather than move, so the caller's previous PCM buffer goes back to run().
+    std::swap(out, queue_.front());
+    if (spare_.size() < kMaxSpareBuffers)
+        spare_.push_back(std::move(queue_.front().pcm));
     queue_.pop_front();
     return true;
 }
@@ -337,6 +459,14 @@ void WasapiCapture::run()
             // Output is always PCM16 (even if engine gives float32)
             const UINT32 outBytesPerFrame = channels_ * 2;
             const UINT32 bytesOut = frames * outBytesPerFrame;
+            {
+                std::lock_guard<std::mutex> lk(mutex_);
+                if (!spare_.empty())
+                {
+                    ck.pcm.swap(spare_.back());
+                    spare_.pop_back();
+                }
+            }
             ck.pcm.resize(bytesOut);
 
             if (flags2 & AUDCLNT_BUFFERFLAGS_SILENT || !data)
@@ -375,7 +505,11 @@ void WasapiCapture::run()
                 // cap queue length (~2 seconds for stable recording)
                 const size_t maxQueue = (size_t)200; // 10ms * 200 = 2s
                 if (queue_.size() > maxQueue)
+                {
+                    if (spare_.size() < kMaxSpareBuffers)
+                        spare_.push_back(std::move(queue_.front().pcm));
                     queue_.pop_front();
+                }
                 queue_.push_back(std::move(ck));
             }
             cv_.notify_one();
@@ -405,6 +539,19 @@ void WinMFProvider::MfRecorder::stopAudioThread()
         audioThread.join();
 }
 
+WinMFProvider::MfRecorder::~MfRecorder()
+{
+    for (MfSamplePool **pool : {&videoSamples, &audioSamples})
+    {
+        if (*pool)
+        {
+            (*pool)->close();
+            (*pool)->Release();
+            *pool = nullptr;
+        }
+    }
+}
+
 void WinMFProvider::MfRecorder::close()
 {
     stopAudioThread();
@@ -425,13 +572,15 @@ bool WinMFProvider::MfRecorder::writeOneAudioSample(LONGLONG ts100ns, LONGLONG d
     if (!writer)
         return false;
 
+    if (!audioSamples)
+        audioSamples = new MfSamplePool();
     ComPtr<IMFSample> s;
-    HRESULT hr = MFCreateSample(&s);
+    HRESULT hr = audioSamples->acquire(bytes, &s);
     if (FAILED(hr))
         return false;
 
     ComPtr<IMFMediaBuffer> b;
-    hr = MFCreateMemoryBuffer(bytes, &b);
+    hr = s->GetBufferByIndex(0, &b);
     if (FAILED(hr))
         return false;
 
@@ -445,10 +594,6 @@ bool WinMFProvider::MfRecorder::writeOneAudioSample(LONGLONG ts100ns, LONGLONG d
     b->Unlock();
     b->SetCurrentLength(bytes);
 
-    hr = s->AddBuffer(b.Get());
-    if (FAILED(hr))
-        return false;
-
     s->SetSampleTime(ts100ns);
     s->SetSampleDuration(dur100ns);
 
@@ -790,13 +935,15 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
     const DWORD uvBytes = rowBytesUV_tight * (h / 2);
     const DWORD frameBytes = yBytes + uvBytes;
 
+    if (!videoSamples)
+        videoSamples = new MfSamplePool();
     ComPtr<IMFSample> sample;
-    HRESULT hr = MFCreateSample(&sample);
+    HRESULT hr = videoSamples->acquire(frameBytes, &sample);
     if (FAILED(hr))
         return false;
 
     ComPtr<IMFMediaBuffer> buf;
-    hr = MFCreateMemoryBuffer(frameBytes, &buf);
+    hr = sample->GetBufferByIndex(0, &buf);
     if (FAILED(hr))
         return false;
 
@@ -828,10 +975,6 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
     buf->Unlock();
     buf->SetCurrentLength(frameBytes);
 
-    hr = sample->AddBuffer(buf.Get());
-    if (FAILED(hr))
-        return false;
-
     // timestamp (relative)
     LONGLONG rtStart = ts100ns - firstTs100ns;
     sample->SetSampleTime(rtStart);
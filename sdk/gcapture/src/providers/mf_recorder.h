@@ -100,6 +100,7 @@ private:
     std::mutex mutex_;
     std::condition_variable cv_;
     std::deque<Chunk> queue_;
+    std::vector<std::vector<uint8_t>> spare_; // PCM buffers handed back through pop(), reused by run()
     LONGLONG tsCursor100ns_ = 0;
 
     std::mutex initMutex_;
@@ -109,10 +110,14 @@ private:
     ActualFormat actual_{};
 };
 
+class MfSamplePool; // recycled IMFTrackedSample + memory buffer (mf_recorder.cpp)
+
 // Media Foundation Sink Writer recorder (NV12->H.264, P010->HEVC) extracted.
 // NOTE: This is still a nested type of WinMFProvider.
 struct WinMFProvider::MfRecorder
 {
+    ~MfRecorder();
+
     Microsoft::WRL::ComPtr<IMFSinkWriter> writer;
     INT32 fpsN = 0, fpsD = 1;
     DWORD streamIndex = 0;
@@ -143,6 +148,11 @@ struct WinMFProvider::MfRecorder
     std::vector<uint8_t> audioAccum;  // PCM16 bytes accumulator
     LONGLONG audioPtsCursor100ns = 0; // continuous audio PTS (OBS-style)
 
+    // Samples come back from the sink writer once encoded and are refilled, so
+    // recording does not create a sample + buffer per frame.
+    MfSamplePool *videoSamples = nullptr;
+    MfSamplePool *audioSamples = nullptr;
+
     void stopAudioThread();
     void close();
 
@@ -0,0 +1,1121 @@
+// replay_provider.cpp
+#include "replay_provider.h"
+#include "../core/capture_stats.h"
+#include "../core/convert_pool.h"
+#include "../core/frame_arena.h"
+#include "../core/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+    using Container = ReplayProvider::Container;
+
+    constexpr uint32_t kRg10Magic = 0x30314752u; // 'RG10', gcap_export_preview_scene_rgb10
+    constexpr size_t kRg10HeaderBytes = 20;      // magic, width, height, channels, bit depth
+    constexpr size_t kMaxY4mHeader = 1024;
+    constexpr size_t kMaxY4mFrameTag = 256;
+    constexpr int kMaxDim = 16384;
+    constexpr int kMaxRate = 1000000; // keeps slotNs() exact in 64 bits
+
+    // Read-ahead: at least this far past the frame being delivered, refreshed when half used.
+    constexpr uint64_t kReadAheadBytes = 64ull << 20;
+    constexpr int kReadAheadFrames = 4;
+
+#ifdef _WIN32
+    constexpr uint64_t kSpinNs = 2000000;
+#else
+    constexpr uint64_t kSpinNs = 200000;
+#endif
+
+    struct Options
+    {
+        std::string path;
+        gcap_replay_pacing_t pacing = GCAP_REPLAY_PACE_PTS;
+        int fpsNum = 0, fpsDen = 0;
+        bool loop = false;
+    };
+
+    std::mutex g_opts_mtx;
+    Options g_opts;
+
+    Options current_options()
+    {
+        std::lock_guard<std::mutex> lk(g_opts_mtx);
+        return g_opts;
+    }
+
+    uint64_t steady_now_ns()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    struct StatsFrameScope
+    {
+        gcap::StatsShard *stats;
+        ~StatsFrameScope()
+        {
+            if (stats)
+                stats->endFrame(steady_now_ns());
+        }
+    };
+
+    // What the first bytes of a file say about it.
+    struct Header
+    {
+        Container kind = Container::Raw;
+        int width = 0, height = 0;
+        gcap_pixfmt_t format = GCAP_FMT_NV12;
+        int fpsNum = 0, fpsDen = 1;
+        gcap_range_t range = GCAP_RANGE_LIMITED;
+        uint64_t first = 0;      // offset of the first frame
+        uint64_t frameBytes = 0; // payload of one frame
+    };
+
+    // Anything that is neither Y4M nor RG10 is raw. fileSize UINT64_MAX = unknown.
+    bool parse_header(const uint8_t *p, size_t avail, uint64_t fileSize, Header &h, const char *&err)
+    {
+        h = Header{};
+        if (avail >= 10 && std::memcmp(p, "YUV4MPEG2 ", 10) == 0)
+        {
+            h.kind = Container::Y4m;
+            const uint8_t *eol = (const uint8_t *)std::memchr(p, '\n', std::min(avail, kMaxY4mHeader));
+            if (!eol)
+            {
+                err = "Y4M header line is missing or too long";
+                return false;
+            }
+            std::string chroma = "420jpeg";
+            const std::string line((const char *)p + 10, (const char *)eol);
+            size_t pos = 0;
+            while (pos < line.size())
+            {
+                size_t end = line.find(' ', pos);
+                if (end == std::string::npos)
+                    end = line.size();
+                const std::string tok = line.substr(pos, end - pos);
+                pos = end + 1;
+                if (tok.size() < 2)
+                    continue;
+                switch (tok[0])
+                {
+                case 'W':
+                    h.width = std::atoi(tok.c_str() + 1);
+                    break;
+                case 'H':
+                    h.height = std::atoi(tok.c_str() + 1);
+                    break;
+                case 'F':
+                    if (std::sscanf(tok.c_str() + 1, "%d:%d", &h.fpsNum, &h.fpsDen) != 2)
+                        h.fpsNum = 0;
+                    break;
+                case 'C':
+                    chroma = tok.substr(1);
+                    break;
+                case 'X':
+                    if (tok == "XCOLORRANGE=FULL")
+                        h.range = GCAP_RANGE_FULL;
+                    break;
+                default:
+                    break;
+                }
+            }
+            if (h.width <= 0 || h.height <= 0 || h.width > kMaxDim || h.height > kMaxDim || (h.width & 1) || (h.height & 1))
+            {
+                err = "Y4M frame size is missing, odd or too large";
+                return false;
+            }
+            int bytesPerSample;
+            if (chroma == "420" || chroma == "420jpeg" || chroma == "420paldv" || chroma == "420mpeg2")
+            {
+                h.format = GCAP_FMT_I420;
+                bytesPerSample = 1;
+            }
+            else if (chroma == "420p10")
+            {
+                h.format = GCAP_FMT_I010;
+                bytesPerSample = 2;
+            }
+            else
+            {
+                err = "Y4M colour space is not 4:2:0 8-bit or C420p10";
+                return false;
+            }
+            if (h.fpsNum <= 0 || h.fpsDen <= 0)
+                h.fpsNum = 30, h.fpsDen = 1;
+            if (h.fpsNum > kMaxRate || h.fpsDen > kMaxRate)
+            {
+                err = "Y4M frame rate is out of range";
+                return false;
+            }
+            h.first = (uint64_t)(eol - p) + 1;
+            h.frameBytes = (uint64_t)h.width * h.height * bytesPerSample * 3 / 2;
+            return true;
+        }
+
+        uint32_t words[5];
+        if (avail >= kRg10HeaderBytes && (std::memcpy(words, p, sizeof(words)), words[0] == kRg10Magic))
+        {
+            h.kind = Container::Rg10;
+            if (words[3] != 3 || words[4] != 10 || words[1] == 0 || words[2] == 0 || words[1] > (uint32_t)kMaxDim ||
+                words[2] > (uint32_t)kMaxDim)
+            {
+                err = "RG10 header is not 3 x 10-bit";
+                return false;
+            }
+            h.width = (int)words[1];
+            h.height = (int)words[2];
+            h.format = GCAP_FMT_RG10;
+            h.first = kRg10HeaderBytes;
+            h.frameBytes = (uint64_t)h.width * h.height * 6;
+            if (fileSize != UINT64_MAX && fileSize < h.first + h.frameBytes)
+            {
+                err = "RG10 file is truncated";
+                return false;
+            }
+            return true;
+        }
+
+        h.kind = Container::Raw;
+        return true;
+    }
+
+    bool raw_layout(gcap_pixfmt_t fmt, gcap::YuvLayout &layout)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            layout = gcap::YuvLayout::Nv12;
+            return true;
+        case GCAP_FMT_YUY2:
+            layout = gcap::YuvLayout::Yuy2;
+            return true;
+        case GCAP_FMT_P010:
+            layout = gcap::YuvLayout::P010;
+            return true;
+        case GCAP_FMT_Y210:
+            layout = gcap::YuvLayout::Y210;
+            return true;
+        case GCAP_FMT_V210:
+            layout = gcap::YuvLayout::V210;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Packed row of the first plane, as SyntheticProvider records it.
+    int raw_row_bytes(gcap::YuvLayout l, int width)
+    {
+        switch (l)
+        {
+        case gcap::YuvLayout::Nv12:
+            return width;
+        case gcap::YuvLayout::Yuy2:
+        case gcap::YuvLayout::P010:
+            return width * 2;
+        case gcap::YuvLayout::Y210:
+            return width * 4;
+        case gcap::YuvLayout::V210:
+        default:
+            return gcap::v210_row_bytes(width);
+        }
+    }
+
+    const char *pixfmt_name(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            return "NV12";
+        case GCAP_FMT_YUY2:
+            return "YUY2";
+        case GCAP_FMT_P010:
+            return "P010";
+        case GCAP_FMT_Y210:
+            return "Y210";
+        case GCAP_FMT_V210:
+            return "V210";
+        case GCAP_FMT_I420:
+            return "I420";
+        case GCAP_FMT_I010:
+            return "I010";
+        case GCAP_FMT_RG10:
+            return "RG10";
+        default:
+            return "Unknown";
+        }
+    }
+
+    const char *container_name(Container c)
+    {
+        switch (c)
+        {
+        case Container::Y4m:
+            return "Y4M";
+        case Container::Rg10:
+            return "RG10";
+        case Container::Raw:
+        default:
+            return "Raw";
+        }
+    }
+
+    bool is_8bit(gcap_pixfmt_t fmt)
+    {
+        return fmt == GCAP_FMT_NV12 || fmt == GCAP_FMT_YUY2 || fmt == GCAP_FMT_I420;
+    }
+
+    // Y4M planes as NV12 chroma (8-bit), or as a whole P010 frame (10-bit, little-endian
+    // samples in the low bits; the Y4M frame tag leaves them at any alignment).
+    struct StageJob
+    {
+        const uint8_t *y, *u, *v;
+        int yStride, cStride;
+        uint8_t *dstY, *dstUV;
+        int dstStride;
+        int width;
+        bool tenBit;
+    };
+
+    inline uint16_t p010_word(const uint8_t *s)
+    {
+        const unsigned v = (unsigned)s[0] | (unsigned)s[1] << 8;
+        return (uint16_t)(std::min(v, 1023u) << 6);
+    }
+
+    void stage_band(void *ctx, int y0, int y1)
+    {
+        const StageJob &j = *static_cast<const StageJob *>(ctx);
+        const int cw = j.width / 2;
+        if (j.tenBit)
+        {
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint8_t *s = j.y + (size_t)y * j.yStride;
+                uint16_t *d = (uint16_t *)(j.dstY + (size_t)y * j.dstStride);
+                for (int x = 0; x < j.width; ++x)
+                    d[x] = p010_word(s + x * 2);
+            }
+        }
+        for (int y = y0 / 2; y < y1 / 2; ++y)
+        {
+            const uint8_t *u = j.u + (size_t)y * j.cStride, *v = j.v + (size_t)y * j.cStride;
+            uint8_t *d = j.dstUV + (size_t)y * j.dstStride;
+            if (j.tenBit)
+            {
+                uint16_t *d16 = (uint16_t *)d;
+                for (int x = 0; x < cw; ++x)
+                {
+                    d16[x * 2] = p010_word(u + x * 2);
+                    d16[x * 2 + 1] = p010_word(v + x * 2);
+                }
+            }
+            else
+            {
+                for (int x = 0; x < cw; ++x)
+                {
+                    d[x * 2] = u[x];
+                    d[x * 2 + 1] = v[x];
+                }
+            }
+        }
+    }
+
+    struct Rg10Job
+    {
+        const uint8_t *src;
+        int srcStride;
+        uint8_t *out;
+        int outStride;
+        int width;
+        gcap::FrameOutput output;
+    };
+
+    void rg10_band(void *ctx, int y0, int y1)
+    {
+        const Rg10Job &j = *static_cast<const Rg10Job *>(ctx);
+        for (int y = y0; y < y1; ++y)
+        {
+            const uint16_t *s = (const uint16_t *)(j.src + (size_t)y * j.srcStride);
+            uint8_t *o = j.out + (size_t)y * j.outStride;
+            for (int x = 0; x < j.width; ++x, s += 3)
+            {
+                const unsigned r = std::min<unsigned>(s[0], 1023), g = std::min<unsigned>(s[1], 1023),
+                               b = std::min<unsigned>(s[2], 1023);
+                switch (j.output)
+                {
+                case gcap::FrameOutput::Rgba64:
+                {
+                    uint16_t *d = (uint16_t *)o + (size_t)x * 4;
+                    d[0] = (uint16_t)(r << 6 | r >> 4);
+                    d[1] = (uint16_t)(g << 6 | g >> 4);
+                    d[2] = (uint16_t)(b << 6 | b >> 4);
+                    d[3] = 0xffff;
+                    break;
+                }
+                case gcap::FrameOutput::X2R10G10B10:
+                    ((uint32_t *)o)[x] = (3u << 30) | (r << 20) | (g << 10) | b;
+                    break;
+                default:
+                {
+                    uint8_t *d = o + (size_t)x * 4;
+                    d[0] = (uint8_t)((b * 255 + 511) / 1023);
+                    d[1] = (uint8_t)((g * 255 + 511) / 1023);
+                    d[2] = (uint8_t)((r * 255 + 511) / 1023);
+                    d[3] = 255;
+                    break;
+                }
+                }
+            }
+        }
+    }
+
+    std::FILE *open_read_utf8(const char *path)
+    {
+#ifdef _WIN32
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        if (n <= 0)
+            return nullptr;
+        std::wstring w((size_t)n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, &w[0], n);
+        return _wfopen(w.c_str(), L"rb");
+#else
+        return std::fopen(path, "rb");
+#endif
+    }
+}
+
+int replay_enum_supported_pixel_formats(gcap_pixfmt_t *outFormats, int maxFormats)
+{
+    static const gcap_pixfmt_t kRawFormats[] = {GCAP_FMT_NV12, GCAP_FMT_YUY2, GCAP_FMT_P010, GCAP_FMT_Y210, GCAP_FMT_V210};
+    const Options o = current_options();
+    if (o.path.empty())
+        return 0;
+    std::FILE *fp = open_read_utf8(o.path.c_str());
+    if (!fp)
+        return 0;
+    uint8_t head[kMaxY4mHeader];
+    const size_t got = std::fread(head, 1, sizeof(head), fp);
+    std::fclose(fp);
+
+    Header h;
+    const char *err = nullptr;
+    if (got == 0 || !parse_header(head, got, UINT64_MAX, h, err))
+        return 0;
+    const gcap_pixfmt_t *formats = kRawFormats;
+    int total = (int)(sizeof(kRawFormats) / sizeof(kRawFormats[0]));
+    if (h.kind != Container::Raw)
+    {
+        formats = &h.format;
+        total = 1;
+    }
+    if (!outFormats || maxFormats <= 0)
+        return total;
+    const int n = std::min(maxFormats, total);
+    for (int i = 0; i < n; ++i)
+        outFormats[i] = formats[i];
+    return n;
+}
+
+void ReplayProvider::setOptions(const gcap_replay_opts_t *opts)
+{
+    Options o;
+    if (opts)
+    {
+        o.path = opts->path_utf8 ? opts->path_utf8 : "";
+        o.pacing = opts->pacing;
+        o.fpsNum = opts->fps_num;
+        o.fpsDen = opts->fps_den;
+        o.loop = opts->loop != 0;
+    }
+    std::lock_guard<std::mutex> lk(g_opts_mtx);
+    g_opts = o;
+}
+
+ReplayProvider::ReplayProvider() = default;
+
+ReplayProvider::~ReplayProvider()
+{
+    close();
+}
+
+bool ReplayProvider::enumerate(std::vector<gcap_device_info_t> &list)
+{
+    list.clear();
+    const Options o = current_options();
+    if (o.path.empty())
+        return true;
+    std::FILE *fp = open_read_utf8(o.path.c_str());
+    if (!fp)
+        return true;
+    std::fclose(fp);
+
+    const size_t slash = o.path.find_last_of("/\\");
+    const char *base = o.path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    gcap_device_info_t d{};
+    d.index = 0;
+    std::snprintf(d.name, sizeof(d.name), "Replay: %s", base);
+    std::snprintf(d.symbolic_link, sizeof(d.symbolic_link), "replay://%s", o.path.c_str());
+    d.caps = 0;
+    list.push_back(d);
+    return true;
+}
+
+bool ReplayProvider::open(int index)
+{
+    if (running_)
+        return index == 0;
+    close();
+    if (index != 0)
+        return false;
+
+    const Options o = current_options();
+    path_ = o.path;
+    pacing_ = o.pacing;
+    fixed_num_ = o.fpsNum;
+    fixed_den_ = o.fpsDen;
+    loop_ = o.loop;
+    if (path_.empty() || !file_.open(path_.c_str()))
+    {
+        emitError(GCAP_ENODEV, "[Replay] cannot map the recording");
+        return false;
+    }
+
+    Header h;
+    const char *err = nullptr;
+    if (!parse_header(file_.data(), (size_t)std::min<uint64_t>(file_.size(), kMaxY4mHeader), file_.size(), h, err))
+    {
+        char msg[160];
+        std::snprintf(msg, sizeof(msg), "[Replay] %s", err);
+        emitError(GCAP_EINVAL, msg);
+        file_.close();
+        return false;
+    }
+    container_ = h.kind;
+    if (container_ != Container::Raw)
+    {
+        width_ = h.width;
+        height_ = h.height;
+        format_ = h.format;
+        range_ = h.range;
+        file_fps_num_ = h.fpsNum;
+        file_fps_den_ = h.fpsDen;
+        first_frame_ = h.first;
+        frame_bytes_ = h.frameBytes;
+    }
+    prepareGeometry();
+    std::lock_guard<std::mutex> lk(mtx_);
+    rebuildConverterLocked();
+    return true;
+}
+
+// Y4M and RG10 frames are described by the file; the profile only matters for raw
+// files (size, format, rate) and for the rate of RG10 stills.
+bool ReplayProvider::setProfile(const gcap_profile_t &p)
+{
+    if (running_)
+        return false;
+    profile_ = p;
+    if (!file_.data())
+        return true;
+    const bool ok = prepareGeometry();
+    std::lock_guard<std::mutex> lk(mtx_);
+    rebuildConverterLocked();
+    return ok;
+}
+
+bool ReplayProvider::prepareGeometry()
+{
+    const bool profileRate = profile_.mode == GCAP_PROFILE_CUSTOM && profile_.fps_num > 0 && profile_.fps_den > 0 &&
+                             profile_.fps_num <= kMaxRate && profile_.fps_den <= kMaxRate;
+    if (container_ != Container::Y4m)
+    {
+        file_fps_num_ = profileRate ? profile_.fps_num : 60;
+        file_fps_den_ = profileRate ? profile_.fps_den : 1;
+    }
+
+    bool ok = true;
+    switch (container_)
+    {
+    case Container::Raw:
+    {
+        gcap::YuvLayout layout;
+        width_ = height_ = 0;
+        if (profile_.mode != GCAP_PROFILE_CUSTOM || !raw_layout(profile_.format, layout) || profile_.width <= 0 ||
+            profile_.height <= 0 || profile_.width > kMaxDim || profile_.height > kMaxDim || (profile_.width & 1) ||
+            (profile_.height & 1))
+        {
+            ok = false;
+            break;
+        }
+        const bool planar = layout == gcap::YuvLayout::Nv12 || layout == gcap::YuvLayout::P010;
+        row_bytes_ = raw_row_bytes(layout, profile_.width);
+        frame_bytes_ = (uint64_t)row_bytes_ * (profile_.height + (planar ? profile_.height / 2 : 0));
+        first_frame_ = 0;
+        if (file_.size() < frame_bytes_)
+        {
+            ok = false;
+            break;
+        }
+        width_ = profile_.width;
+        height_ = profile_.height;
+        format_ = profile_.format;
+        range_ = GCAP_RANGE_LIMITED;
+        layout_ = layout;
+        break;
+    }
+    case Container::Y4m:
+        layout_ = format_ == GCAP_FMT_I010 ? gcap::YuvLayout::P010 : gcap::YuvLayout::Nv12;
+        break;
+    case Container::Rg10:
+        break;
+    }
+    csp_ = gcap::default_colorspace(height_);
+
+    if (pacing_ == GCAP_REPLAY_PACE_FIXED)
+    {
+        rate_num_ = fixed_num_;
+        rate_den_ = fixed_den_;
+    }
+    else
+    {
+        rate_num_ = file_fps_num_;
+        rate_den_ = file_fps_den_;
+    }
+    return ok;
+}
+
+bool ReplayProvider::setBuffers(int count, size_t bytes_hint)
+{
+    // Frames are views into the mapping; nothing to size here.
+    (void)count;
+    (void)bytes_hint;
+    return true;
+}
+
+bool ReplayProvider::start()
+{
+    if (!file_.data())
+        return false;
+    if (running_)
+        return true;
+    if (!prepareGeometry())
+    {
+        emitError(GCAP_EINVAL, "[Replay] raw files need a GCAP_PROFILE_CUSTOM profile (even size, "
+                               "NV12 / YUY2 / P010 / Y210 / V210) of at most the file's size");
+        return false;
+    }
+
+    gcap::FrameConverter cv;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        rebuildConverterLocked();
+        cv = converter_;
+    }
+    clock_.reset(rate_num_, rate_den_);
+    frame_id_ = 0;
+    advised_end_ = 0;
+
+    char msg[320];
+    const uint64_t per = frame_bytes_ + (container_ == Container::Y4m ? 6 : 0);
+    const uint64_t frames = (file_.size() - first_frame_) / per;
+    std::snprintf(msg, sizeof(msg), "[Replay] %s %dx%d %s, %s%llu frames, @ %d/%d (%s%s), converter=%s, out=%s",
+                  container_name(container_), width_, height_, pixfmt_name(format_),
+                  container_ == Container::Y4m ? "~" : "", (unsigned long long)frames, rate_num_, rate_den_,
+                  pacing_ == GCAP_REPLAY_PACE_FREE_RUN ? "free-run" : (pacing_ == GCAP_REPLAY_PACE_FIXED ? "fixed" : "pts"),
+                  loop_ ? ", loop" : "", gcap::converter_kernel_name(), gcap::frame_output_name(cv.output));
+    emitError(GCAP_OK, msg);
+    if (container_ == Container::Raw && (file_.size() % frame_bytes_) != 0)
+    {
+        std::snprintf(msg, sizeof(msg), "[Replay] raw file is not a whole number of %llu-byte frames; check the profile",
+                      (unsigned long long)frame_bytes_);
+        emitError(GCAP_OK, msg);
+    }
+
+    running_ = true;
+    th_ = std::thread([this]
+                      { loop(); });
+    return true;
+}
+
+void ReplayProvider::stop()
+{
+    {
+        std::lock_guard<std::mutex> lk(wake_mtx_);
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    if (th_.joinable())
+        th_.join();
+}
+
+void ReplayProvider::close()
+{
+    stop();
+    file_.close();
+    width_ = height_ = 0;
+    std::vector<uint8_t>().swap(staging_);
+}
+
+void ReplayProvider::setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    vcb_ = vcb;
+    ecb_ = ecb;
+    user_ = user;
+}
+
+void ReplayProvider::setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    pcb_ = pcb;
+    user_ = user;
+}
+
+void ReplayProvider::setVideoOutput(const gcap_video_output_t &out)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    video_output_ = out;
+}
+
+void ReplayProvider::setFramePool(gcap::FramePool *pool)
+{
+    frame_pool_ = pool;
+}
+
+// One thread reads, converts and calls back, so it takes the Capture shard.
+void ReplayProvider::setStats(gcap::CaptureStats *stats)
+{
+    stats_ = stats ? &stats->shard(gcap::CaptureStats::Thread::Capture) : nullptr;
+}
+
+bool ReplayProvider::getDeviceProps(gcap_device_props_t &out)
+{
+    if (!file_.data())
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    std::snprintf(out.driver_version, sizeof(out.driver_version), "gcapture replay (%s)", container_name(container_));
+    out.input = GCAP_INPUT_UNKNOWN;
+    out.hdcp = 0;
+    return true;
+}
+
+bool ReplayProvider::getSignalStatus(gcap_signal_status_t &out)
+{
+    if (!file_.data() || width_ <= 0)
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    out.width = width_;
+    out.height = height_;
+    out.fps_num = file_fps_num_;
+    out.fps_den = file_fps_den_;
+    out.pixfmt = format_;
+    out.bit_depth = is_8bit(format_) ? 8 : 10;
+    out.csp = csp_;
+    out.range = range_;
+    out.hdr = 0;
+    return true;
+}
+
+bool ReplayProvider::getRuntimeInfo(gcap_runtime_info_t &out)
+{
+    std::memset(&out, 0, sizeof(out));
+    if (!getSignalStatus(out.signal))
+        return false;
+    out.signal_probe = out.signal;
+    out.negotiated = out.signal;
+    out.negotiated.fps_num = rate_num_;
+    out.negotiated.fps_den = rate_den_;
+    gcap::fill_clock_runtime_info(out, clock_.stats());
+
+    gcap::FrameOutput output;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        output = converter_.output;
+    }
+    out.active_backend = GCAP_BACKEND_REPLAY;
+    std::snprintf(out.backend_name, sizeof(out.backend_name), "Replay");
+    std::snprintf(out.frame_source, sizeof(out.frame_source), "File (mmap)");
+    std::snprintf(out.path_name, sizeof(out.path_name), "Replay CPU");
+    std::snprintf(out.source_format, sizeof(out.source_format), "%s", pixfmt_name(format_));
+    std::snprintf(out.render_format, sizeof(out.render_format), "%s CPU", gcap::frame_output_name(output));
+    std::snprintf(out.input_signal_desc, sizeof(out.input_signal_desc), "%s %s / %d-bit", container_name(container_),
+                  pixfmt_name(format_), out.signal.bit_depth);
+    std::snprintf(out.input_signal_note, sizeof(out.input_signal_note), "Recorded");
+    std::snprintf(out.negotiated_desc, sizeof(out.negotiated_desc), "%s", pixfmt_name(format_));
+    return true;
+}
+
+bool ReplayProvider::setProcessing(const gcap_processing_opts_t &opts)
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        force_range_ = opts.force_range;
+        switch (opts.cpu_output)
+        {
+        case GCAP_CPU_OUT_ARGB_DITHER:
+            cpu_output_ = gcap::FrameOutput::Bgra8Dither;
+            break;
+        case GCAP_CPU_OUT_RGBA64:
+            cpu_output_ = gcap::FrameOutput::Rgba64;
+            break;
+        case GCAP_CPU_OUT_X2R10G10B10:
+            cpu_output_ = gcap::FrameOutput::X2R10G10B10;
+            break;
+        default:
+            cpu_output_ = gcap::FrameOutput::Bgra8;
+            break;
+        }
+        rebuildConverterLocked();
+    }
+    // The source format is the file's; only force_range / cpu_output apply here.
+    return opts.preferred_pixfmt == GCAP_FMT_NV12 && opts.deinterlace == GCAP_DEINT_AUTO;
+}
+
+bool ReplayProvider::setProcAmp(const gcap_procamp_t &p)
+{
+    auto clamp255 = [](int v) -> int
+    { return std::clamp(v, 0, 255); };
+
+    gcap::ProcAmpParams pp;
+    pp.brightness = clamp255(p.brightness);
+    pp.contrast = clamp255(p.contrast);
+    pp.hue = clamp255(p.hue);
+    pp.saturation = clamp255(p.saturation);
+    pp.sharpness = clamp255(p.sharpness);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    procamp_params_ = pp;
+    rebuildConverterLocked();
+    return true;
+}
+
+void ReplayProvider::rebuildConverterLocked()
+{
+    const gcap_range_t range = force_range_ != GCAP_RANGE_UNKNOWN ? force_range_ : range_;
+    converter_ = gcap::make_frame_converter(layout_, csp_, range, procamp_params_, cpu_output_);
+}
+
+void ReplayProvider::emitError(gcap_status_t c, const char *msg)
+{
+    gcap_on_error_cb ecb;
+    void *user;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        ecb = ecb_;
+        user = user_;
+    }
+    if (ecb)
+        ecb(c, msg, user);
+}
+
+// floor(n * den * 1e9 / num) without overflow: num and den are at most 10^6.
+uint64_t ReplayProvider::slotNs(uint64_t n) const
+{
+    const uint64_t num = (uint64_t)rate_num_, den = (uint64_t)rate_den_;
+    const uint64_t q = n % num * den;
+    return n / num * den * 1000000000ull + q / num * 1000000000ull + q % num * 1000000000ull / num;
+}
+
+bool ReplayProvider::frameAt(uint64_t offset, Frame &f) const
+{
+    const uint8_t *base = file_.data();
+    const uint64_t size = file_.size();
+    uint64_t data = offset;
+    if (container_ == Container::Y4m)
+    {
+        if (offset >= size || size - offset < 6 || std::memcmp(base + offset, "FRAME", 5) != 0)
+            return false;
+        const void *eol = std::memchr(base + offset, '\n', (size_t)std::min<uint64_t>(size - offset, kMaxY4mFrameTag));
+        if (!eol)
+            return false;
+        data = (uint64_t)((const uint8_t *)eol - base) + 1;
+    }
+    if (data > size || size - data < frame_bytes_)
+        return false;
+
+    const uint8_t *p = base + data;
+    switch (format_)
+    {
+    case GCAP_FMT_I420:
+    case GCAP_FMT_I010:
+    {
+        const int bps = format_ == GCAP_FMT_I010 ? 2 : 1;
+        f.planes = 3;
+        f.stride[0] = width_ * bps;
+        f.stride[1] = f.stride[2] = width_ / 2 * bps;
+        f.data[0] = p;
+        f.data[1] = p + (size_t)f.stride[0] * height_;
+        f.data[2] = f.data[1] + (size_t)f.stride[1] * (height_ / 2);
+        break;
+    }
+    case GCAP_FMT_RG10:
+        f.planes = 1;
+        f.stride[0] = width_ * 6;
+        f.data[0] = p;
+        break;
+    default:
+        f.planes = (format_ == GCAP_FMT_NV12 || format_ == GCAP_FMT_P010) ? 2 : 1;
+        f.stride[0] = row_bytes_;
+        f.data[0] = p;
+        if (f.planes == 2)
+        {
+            f.stride[1] = row_bytes_;
+            f.data[1] = p + (size_t)row_bytes_ * height_;
+        }
+        break;
+    }
+    f.end = data + frame_bytes_;
+    return true;
+}
+
+void ReplayProvider::readAhead(uint64_t frameEnd)
+{
+    const uint64_t window = std::max<uint64_t>(kReadAheadBytes, frame_bytes_ * kReadAheadFrames);
+    if (advised_end_ >= frameEnd + window / 2)
+        return;
+    const uint64_t from = std::max(advised_end_, frameEnd);
+    file_.willNeed(from, frameEnd + window - from);
+    advised_end_ = frameEnd + window;
+}
+
+// Output memory for one frame: a pool slot the callbacks can retain, or the scratch
+// vector when every slot is retained (nullptr under GCAP_LEASE_POLICY_SKIP).
+uint8_t *ReplayProvider::outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes)
+{
+    if (frame_pool_)
+    {
+        lease = frame_pool_->acquire(bytes);
+        if (lease)
+            return lease.data();
+        if (frame_pool_->policy() == GCAP_LEASE_POLICY_SKIP)
+            return nullptr;
+    }
+    if (scratch.size() < bytes)
+        scratch.resize(bytes);
+    return scratch.data();
+}
+
+void ReplayProvider::convertRg10(const Frame &src, gcap::FrameOutput output, uint8_t *out, int outStride) const
+{
+    Rg10Job job{src.data[0], src.stride[0], out, outStride, width_, output};
+    gcap::parallel_rows(width_, height_, 1, rg10_band, &job);
+}
+
+// Converts for the video callback, resizing in the same pass when an output size is
+// set (YUV sources; RG10 stills are delivered at their own size).
+void ReplayProvider::deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, gcap_on_video_cb vcb,
+                                  void *user, const Frame &src, gcap_frame_t &f)
+{
+    const int w = width_, h = height_;
+    const bool rgb = format_ == GCAP_FMT_RG10;
+    int dw = w, dh = h;
+    const bool scaled = !rgb && gcap::scale_supported(cv.layout) && gcap::video_output_size(vo, w, h, dw, dh);
+    if (scaled && (scale_plan_.layout != cv.layout || scale_plan_.src_width != w || scale_plan_.src_height != h ||
+                   scale_plan_.dst_width != dw || scale_plan_.dst_height != dh || scale_filter_ != vo.filter))
+    {
+        scale_plan_ = gcap::make_scale_plan(cv.layout, w, h, dw, dh, vo.filter);
+        scale_filter_ = vo.filter;
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "[Replay] CPU video output %dx%d -> %dx%d (%s)", w, h, dw, dh,
+                      scale_plan_.filter == GCAP_SCALE_BOX ? "box" : "bilinear");
+        emitError(GCAP_OK, msg);
+    }
+    if (!scaled)
+        dw = w, dh = h;
+
+    const int outStride = gcap::aligned_row_bytes(dw * gcap::frame_output_bytes_per_pixel(cv.output));
+    gcap::FrameLease lease;
+    uint8_t *out = outputBuffer(lease, scaled ? cpu_scaled_ : cpu_out_, (size_t)outStride * (size_t)dh);
+    if (!out)
+        return;
+    {
+        GCAP_TRACE_SCOPE(Convert, f.frame_id);
+        const uint64_t t0 = stats_ ? steady_now_ns() : 0;
+        const uint8_t *s0 = src.data[0], *s1 = src.data[1];
+        int st0 = src.stride[0], st1 = src.stride[1];
+        if (format_ == GCAP_FMT_I420 || format_ == GCAP_FMT_I010)
+        {
+            const bool tenBit = format_ == GCAP_FMT_I010;
+            const int stride = gcap::aligned_row_bytes(w * (tenBit ? 2 : 1));
+            const size_t rows = (size_t)(tenBit ? h : 0) + (size_t)h / 2;
+            if (staging_.size() < (size_t)stride * rows)
+                staging_.resize((size_t)stride * rows);
+            uint8_t *dstY = tenBit ? staging_.data() : nullptr;
+            uint8_t *dstUV = staging_.data() + (tenBit ? (size_t)stride * h : 0);
+            StageJob job{src.data[0], src.data[1], src.data[2], src.stride[0], src.stride[1], dstY, dstUV, stride, w, tenBit};
+            gcap::parallel_rows(w, h, 2, stage_band, &job);
+            if (stats_)
+                stats_->copied((uint64_t)stride * rows);
+            if (tenBit)
+            {
+                s0 = dstY;
+                st0 = stride;
+            }
+            s1 = dstUV;
+            st1 = stride;
+        }
+
+        if (rgb)
+            convertRg10(src, cv.output, out, outStride);
+        else if (scaled)
+            gcap::convert_frame_scaled(cv, scale_plan_, s0, s1, st0, st1, out, outStride);
+        else
+            gcap::convert_frame(cv, s0, s1, st0, st1, w, h, out, outStride);
+        if (stats_)
+            stats_->record(gcap::StatHist::Convert, steady_now_ns() - t0);
+    }
+
+    f.format = gcap::frame_output_pixfmt(cv.output);
+    f.plane_count = 1;
+    f.width = dw;
+    f.height = dh;
+    f.data[0] = out;
+    f.stride[0] = outStride;
+    f.lease = nullptr;
+    if (lease)
+        lease.attach(f);
+    GCAP_TRACE_SCOPE(Callback, f.frame_id);
+    vcb(&f, user);
+}
+
+void ReplayProvider::loop()
+{
+    GCAP_TRACE_THREAD_NAME("replay");
+    const bool paced = pacing_ != GCAP_REPLAY_PACE_FREE_RUN;
+    const uint64_t period = slotNs(1);
+    uint64_t offset = first_frame_;
+    uint64_t fileFrames = 0; // frames delivered since the start of the file
+    uint64_t t0 = steady_now_ns(), n0 = 0;
+    char msg[160];
+
+    for (uint64_t n = 0; running_; ++n)
+    {
+        Frame fr;
+        if (!frameAt(offset, fr))
+        {
+            // Raw files end at the last whole frame; a Y4M file ends exactly at its last frame.
+            if (container_ == Container::Y4m && offset < file_.size())
+            {
+                std::snprintf(msg, sizeof(msg), "[Replay] malformed Y4M frame at byte %llu; playback stopped",
+                              (unsigned long long)offset);
+                emitError(GCAP_EIO, msg);
+                break;
+            }
+            if (!loop_ || fileFrames == 0)
+            {
+                std::snprintf(msg, sizeof(msg), "[Replay] end of file after %llu frames", (unsigned long long)fileFrames);
+                emitError(GCAP_OK, msg);
+                break;
+            }
+            offset = first_frame_;
+            fileFrames = 0;
+            advised_end_ = 0;
+            if (!frameAt(offset, fr))
+                break;
+        }
+
+        if (paced)
+        {
+            const uint64_t due = t0 + slotNs(n - n0);
+            const uint64_t now = steady_now_ns();
+            if (now < due)
+            {
+                if (due - now > kSpinNs)
+                {
+                    const auto wake = std::chrono::steady_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(due - kSpinNs)));
+                    std::unique_lock<std::mutex> lk(wake_mtx_);
+                    wake_cv_.wait_until(lk, wake, [this]
+                                        { return !running_; });
+                }
+                while (running_ && steady_now_ns() < due)
+                    std::this_thread::yield();
+                if (!running_)
+                    break;
+            }
+            else if (now - due >= period)
+            {
+                // A whole period late (disk stall, slow callback): play this frame now
+                // and time the rest from it, rather than skip frames of the recording.
+                t0 = now;
+                n0 = n;
+            }
+        }
+        readAhead(fr.end);
+
+        const uint64_t deviceNs = slotNs(n);
+        const uint64_t hostNs = steady_now_ns();
+        gcap::ClockRecovery::Gap gap;
+        const uint64_t ptsSmoothedNs = clock_.update((int64_t)deviceNs, hostNs, &gap);
+        if (stats_)
+        {
+            stats_->arrived(hostNs);
+            stats_->add(gcap::StatCounter::FramesDropped, gap.dropped);
+            stats_->add(gcap::StatCounter::FramesDuplicated, gap.duplicated);
+        }
+
+        const uint64_t frameId = ++frame_id_;
+        StatsFrameScope statsFrame{stats_};
+
+        gcap_on_video_cb vcb;
+        gcap_on_frame_packet_cb pcb;
+        void *user;
+        gcap::FrameConverter cv;
+        gcap_video_output_t vo;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            vcb = vcb_;
+            pcb = pcb_;
+            user = user_;
+            cv = converter_;
+            vo = video_output_;
+        }
+
+        if (pcb)
+        {
+            gcap_frame_packet_t pkt{};
+            pkt.width = width_;
+            pkt.height = height_;
+            pkt.format = format_;
+            pkt.plane_count = fr.planes;
+            for (int i = 0; i < fr.planes; ++i)
+            {
+                pkt.data[i] = fr.data[i];
+                pkt.stride[i] = fr.stride[i];
+            }
+            pkt.pts_ns = deviceNs;
+            pkt.pts_smoothed_ns = ptsSmoothedNs;
+            pkt.frame_id = frameId;
+            pkt.backend = GCAP_BACKEND_REPLAY;
+            pkt.source_kind = GCAP_SOURCE_REPLAY;
+            pkt.gpu_backed = 0;
+            GCAP_TRACE_SCOPE(Callback, frameId);
+            pcb(&pkt, user);
+        }
+
+        if (vcb)
+        {
+            gcap_frame_t f{};
+            f.pts_ns = deviceNs;
+            f.frame_id = frameId;
+            deliverVideo(cv, vo, vcb, user, fr, f);
+        }
+
+        offset = fr.end;
+        ++fileFrames;
+    }
+}
@@ -0,0 +1,146 @@
+// replay_provider.h
+// GCAP_BACKEND_REPLAY: plays a recording back through the capture paths, so a
+// field problem recorded once can be reproduced frame for frame.
+// Portable; the file is memory-mapped (gcap::MappedFile).
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gcapture.h"
+#include "../core/capture_manager.h"
+#include "../core/clock_recovery.h"
+#include "../core/frame_converter.h"
+#include "../core/frame_pool.h"
+#include "../core/mapped_file.h"
+
+namespace gcap
+{
+    class StatsShard;
+}
+
+int replay_enum_supported_pixel_formats(gcap_pixfmt_t *outFormats, int maxFormats);
+
+/**
+ * Packets point straight into the mapping, so a frame costs no copy on the
+ * way to the packet callback; the video callback converts from the mapping
+ * (Y4M planar chroma is interleaved into a scratch plane first). A window of
+ * frames ahead of the one being delivered is kept in flight with
+ * MappedFile::willNeed, so playback runs at disk speed once the file is
+ * larger than the page cache.
+ *
+ * The file is walked front to back: Y4M frame headers are parsed as they are
+ * reached, so opening a multi-GB file reads nothing but its header.
+ */
+class ReplayProvider : public ICaptureProvider
+{
+public:
+    ReplayProvider();
+    ~ReplayProvider() override;
+
+    // Process-wide, like the backend selection (gcap_set_replay_opts).
+    static void setOptions(const gcap_replay_opts_t *opts);
+
+    bool enumerate(std::vector<gcap_device_info_t> &list) override;
+    bool open(int index) override;
+    bool setProfile(const gcap_profile_t &p) override;
+    bool setBuffers(int count, size_t bytes_hint) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+
+    void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user) override;
+    void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override;
+    void setVideoOutput(const gcap_video_output_t &out) override;
+    void setFramePool(gcap::FramePool *pool) override;
+    void setStats(gcap::CaptureStats *stats) override;
+
+    bool getDeviceProps(gcap_device_props_t &out) override;
+    bool getSignalStatus(gcap_signal_status_t &out) override;
+    bool getRuntimeInfo(gcap_runtime_info_t &out) override;
+    bool setProcessing(const gcap_processing_opts_t &opts) override;
+    bool setProcAmp(const gcap_procamp_t &p) override;
+
+    enum class Container
+    {
+        Raw,
+        Y4m,
+        Rg10
+    };
+
+private:
+    // One frame of the file.
+    struct Frame
+    {
+        const uint8_t *data[3] = {};
+        int stride[3] = {};
+        int planes = 0;
+        uint64_t end = 0; // file offset after the frame
+    };
+
+    void loop();
+    bool frameAt(uint64_t offset, Frame &f) const;
+    void readAhead(uint64_t frameEnd);
+    bool prepareGeometry(); // from the container header, or the profile for raw files
+    void deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, gcap_on_video_cb vcb,
+                      void *user, const Frame &src, gcap_frame_t &f);
+    void convertRg10(const Frame &src, gcap::FrameOutput output, uint8_t *out, int outStride) const;
+    uint8_t *outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes);
+    void rebuildConverterLocked();
+    void emitError(gcap_status_t c, const char *msg);
+
+    uint64_t slotNs(uint64_t n) const; // n frame periods at the playback rate
+
+    // Guards the callbacks, the converter and the video output size; the frame
+    // loop copies them once per frame.
+    std::mutex mtx_;
+    gcap_on_video_cb vcb_ = nullptr;
+    gcap_on_frame_packet_cb pcb_ = nullptr;
+    gcap_on_error_cb ecb_ = nullptr;
+    void *user_ = nullptr;
+    gcap_video_output_t video_output_{};
+    gcap::ProcAmpParams procamp_params_;
+    gcap_range_t force_range_ = GCAP_RANGE_UNKNOWN;
+    gcap::FrameOutput cpu_output_ = gcap::FrameOutput::Bgra8;
+    gcap::FrameConverter converter_;
+
+    // Snapshot of the options taken by open().
+    std::string path_;
+    gcap_replay_pacing_t pacing_ = GCAP_REPLAY_PACE_PTS;
+    int fixed_num_ = 0, fixed_den_ = 0;
+    bool loop_ = false;
+
+    gcap::MappedFile file_;
+    Container container_ = Container::Raw;
+    gcap_profile_t profile_{};
+    // Geometry of the file's frames: from its header, or from profile_ for raw files.
+    int width_ = 0, height_ = 0;
+    gcap_pixfmt_t format_ = GCAP_FMT_NV12;
+    gcap::YuvLayout layout_ = gcap::YuvLayout::Nv12; // converter input (I420 -> NV12, I010 -> P010)
+    gcap_colorspace_t csp_ = GCAP_CSP_BT709;
+    gcap_range_t range_ = GCAP_RANGE_LIMITED;
+    int file_fps_num_ = 0, file_fps_den_ = 1; // Y4M header rate
+    int rate_num_ = 60, rate_den_ = 1;       // playback timeline
+    uint64_t first_frame_ = 0;               // offset of the first frame (or its Y4M FRAME tag)
+    uint64_t frame_bytes_ = 0;               // payload of one frame
+    int row_bytes_ = 0;                      // raw: packed row of the first plane
+
+    std::atomic<bool> running_{false};
+    std::thread th_;
+    std::mutex wake_mtx_; // lets stop() cut a pacing wait short
+    std::condition_variable wake_cv_;
+    uint64_t frame_id_ = 0;
+    uint64_t advised_end_ = 0;
+    gcap::ClockRecovery clock_;
+
+    gcap::FramePool *frame_pool_ = nullptr; // owned by CaptureManager
+    gcap::StatsShard *stats_ = nullptr;     // frame thread's shard (owned by CaptureManager)
+    std::vector<uint8_t> staging_;          // I420 / I010 as NV12 / P010 for the converter
+    std::vector<uint8_t> cpu_out_;          // converter output when the pool is exhausted
+    std::vector<uint8_t> cpu_scaled_;
+    gcap::ScalePlan scale_plan_;
+    gcap_scale_filter_t scale_filter_ = GCAP_SCALE_AUTO;
+};
@@ -0,0 +1,942 @@
+// synthetic_provider.cpp
+#include "synthetic_provider.h"
+#include "../core/capture_stats.h"
+#include "../core/convert_pool.h"
+#include "../core/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+    constexpr int kDefaultWidth = 1920;
+    constexpr int kDefaultHeight = 1080;
+    constexpr int kDefaultFps = 60;
+    constexpr int kMaxWidth = 7680;
+    constexpr int kMaxHeight = 4320;
+    constexpr int kMaxFps = 120;
+    constexpr int kMaxDevices = 16;
+
+    // Frame-index stamp: 32 cells, 12 pixels wide (two V210 groups) and 8 rows high.
+    constexpr int kStampCells = 32;
+    constexpr int kStampCellW = 12;
+    constexpr int kStampRows = 8;
+    constexpr int kStampWidth = kStampCells * kStampCellW;
+
+    // The pacing wait sleeps until this long before the deadline and yields from there:
+    // Linux wakes within ~50 us, Windows timers have ~1 ms granularity.
+#ifdef _WIN32
+    constexpr uint64_t kSpinNs = 2000000;
+#else
+    constexpr uint64_t kSpinNs = 200000;
+#endif
+
+    std::mutex g_opts_mtx;
+    gcap_synthetic_opts_t g_opts{};
+
+    gcap_synthetic_opts_t current_options()
+    {
+        std::lock_guard<std::mutex> lk(g_opts_mtx);
+        return g_opts;
+    }
+
+    uint64_t steady_now_ns()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Closes the frame in the stats shard on every way out of the loop iteration.
+    struct StatsFrameScope
+    {
+        gcap::StatsShard *stats;
+        ~StatsFrameScope()
+        {
+            if (stats)
+                stats->endFrame(steady_now_ns());
+        }
+    };
+
+    bool layout_of(gcap_pixfmt_t fmt, gcap::YuvLayout &layout)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            layout = gcap::YuvLayout::Nv12;
+            return true;
+        case GCAP_FMT_YUY2:
+            layout = gcap::YuvLayout::Yuy2;
+            return true;
+        case GCAP_FMT_P010:
+            layout = gcap::YuvLayout::P010;
+            return true;
+        case GCAP_FMT_Y210:
+            layout = gcap::YuvLayout::Y210;
+            return true;
+        case GCAP_FMT_V210:
+            layout = gcap::YuvLayout::V210;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    const char *pixfmt_name(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            return "NV12";
+        case GCAP_FMT_YUY2:
+            return "YUY2";
+        case GCAP_FMT_P010:
+            return "P010";
+        case GCAP_FMT_Y210:
+            return "Y210";
+        case GCAP_FMT_V210:
+            return "V210";
+        default:
+            return "Unknown";
+        }
+    }
+
+    bool is_planar(gcap::YuvLayout l)
+    {
+        return l == gcap::YuvLayout::Nv12 || l == gcap::YuvLayout::P010;
+    }
+
+    // Bytes of `width` pixels in the first plane (also the UV plane of NV12 / P010).
+    int row_bytes(gcap::YuvLayout l, int width)
+    {
+        switch (l)
+        {
+        case gcap::YuvLayout::Nv12:
+            return width;
+        case gcap::YuvLayout::Yuy2:
+        case gcap::YuvLayout::P010:
+            return width * 2;
+        case gcap::YuvLayout::Y210:
+            return width * 4;
+        case gcap::YuvLayout::V210:
+        default:
+            return gcap::v210_row_bytes(width);
+        }
+    }
+
+    // Packs one row of 10-bit samples: y[width], cb / cr[width / 2] (co-sited with the
+    // even pixels). width is even, and a multiple of 6 for V210. row1 takes the UV row
+    // of the planar layouts.
+    void pack_row(gcap::YuvLayout l, const uint16_t *y, const uint16_t *cb, const uint16_t *cr, int width,
+                  uint8_t *row0, uint8_t *row1)
+    {
+        auto to8 = [](uint16_t v)
+        { return (uint8_t)std::min((v + 2) >> 2, 255); };
+        auto put16 = [](uint8_t *p, uint16_t v)
+        {
+            const uint16_t w = (uint16_t)(v << 6);
+            std::memcpy(p, &w, 2); // little-endian hosts, as the converters assume
+        };
+        switch (l)
+        {
+        case gcap::YuvLayout::Nv12:
+            for (int x = 0; x < width; ++x)
+                row0[x] = to8(y[x]);
+            for (int i = 0; i < width / 2; ++i)
+            {
+                row1[i * 2] = to8(cb[i]);
+                row1[i * 2 + 1] = to8(cr[i]);
+            }
+            break;
+        case gcap::YuvLayout::P010:
+            for (int x = 0; x < width; ++x)
+                put16(row0 + x * 2, y[x]);
+            for (int i = 0; i < width / 2; ++i)
+            {
+                put16(row1 + i * 4, cb[i]);
+                put16(row1 + i * 4 + 2, cr[i]);
+            }
+            break;
+        case gcap::YuvLayout::Yuy2:
+            for (int i = 0; i < width / 2; ++i)
+            {
+                row0[i * 4] = to8(y[i * 2]);
+                row0[i * 4 + 1] = to8(cb[i]);
+                row0[i * 4 + 2] = to8(y[i * 2 + 1]);
+                row0[i * 4 + 3] = to8(cr[i]);
+            }
+            break;
+        case gcap::YuvLayout::Y210:
+            for (int i = 0; i < width / 2; ++i)
+            {
+                put16(row0 + i * 8, y[i * 2]);
+                put16(row0 + i * 8 + 2, cb[i]);
+                put16(row0 + i * 8 + 4, y[i * 2 + 1]);
+                put16(row0 + i * 8 + 6, cr[i]);
+            }
+            break;
+        case gcap::YuvLayout::V210:
+            for (int x = 0; x < width; x += 6)
+            {
+                const uint16_t *py = y + x, *pb = cb + x / 2, *pr = cr + x / 2;
+                const uint32_t w[4] = {
+                    (uint32_t)pb[0] | (uint32_t)py[0] << 10 | (uint32_t)pr[0] << 20,
+                    (uint32_t)py[1] | (uint32_t)pb[1] << 10 | (uint32_t)py[2] << 20,
+                    (uint32_t)pr[1] | (uint32_t)py[3] << 10 | (uint32_t)pb[2] << 20,
+                    (uint32_t)py[4] | (uint32_t)pr[2] << 10 | (uint32_t)py[5] << 20};
+                std::memcpy(row0 + (size_t)(x / 6) * 16, w, sizeof(w));
+            }
+            break;
+        }
+    }
+
+    struct CopyJob
+    {
+        const uint8_t *src[2];
+        int srcStride[2];
+        uint8_t *dst[2];
+        int dstStride;
+        int rowBytes;
+        bool planar;
+    };
+
+    // Rows [y0, y1) of the first plane and, for 4:2:0, the chroma rows under them.
+    void copy_band(void *ctx, int y0, int y1)
+    {
+        const CopyJob &j = *static_cast<const CopyJob *>(ctx);
+        for (int y = y0; y < y1; ++y)
+            std::memcpy(j.dst[0] + (size_t)y * j.dstStride, j.src[0] + (size_t)y * j.srcStride[0], (size_t)j.rowBytes);
+        if (!j.planar)
+            return;
+        for (int y = y0 / 2; y < y1 / 2; ++y)
+            std::memcpy(j.dst[1] + (size_t)y * j.dstStride, j.src[1] + (size_t)y * j.srcStride[1], (size_t)j.rowBytes);
+    }
+
+#ifdef _WIN32
+    std::FILE *open_utf8(const char *path)
+    {
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        if (n <= 0)
+            return nullptr;
+        std::wstring w((size_t)n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, &w[0], n);
+        return _wfopen(w.c_str(), L"wb");
+    }
+#else
+    std::FILE *open_utf8(const char *path)
+    {
+        return std::fopen(path, "wb");
+    }
+#endif
+}
+
+int synthetic_enum_supported_pixel_formats(gcap_pixfmt_t *outFormats, int maxFormats)
+{
+    static const gcap_pixfmt_t kFormats[] = {GCAP_FMT_NV12, GCAP_FMT_YUY2, GCAP_FMT_P010, GCAP_FMT_Y210, GCAP_FMT_V210};
+    const int total = (int)(sizeof(kFormats) / sizeof(kFormats[0]));
+    if (!outFormats || maxFormats <= 0)
+        return total;
+    const int n = std::min(maxFormats, total);
+    for (int i = 0; i < n; ++i)
+        outFormats[i] = kFormats[i];
+    return n;
+}
+
+void SyntheticProvider::setOptions(const gcap_synthetic_opts_t &opts)
+{
+    std::lock_guard<std::mutex> lk(g_opts_mtx);
+    g_opts = opts;
+}
+
+SyntheticProvider::SyntheticProvider()
+{
+    profile_.width = kDefaultWidth;
+    profile_.height = kDefaultHeight;
+    profile_.fps_num = kDefaultFps;
+    profile_.fps_den = 1;
+    profile_.format = GCAP_FMT_NV12;
+    profile_.mode = GCAP_PROFILE_CUSTOM;
+    csp_ = gcap::default_colorspace(profile_.height);
+    std::lock_guard<std::mutex> lk(mtx_);
+    rebuildConverterLocked();
+}
+
+SyntheticProvider::~SyntheticProvider()
+{
+    close();
+}
+
+bool SyntheticProvider::enumerate(std::vector<gcap_device_info_t> &list)
+{
+    const gcap_synthetic_opts_t o = current_options();
+    const int count = o.device_count > 0 ? std::min(o.device_count, kMaxDevices) : 1;
+    list.clear();
+    for (int i = 0; i < count; ++i)
+    {
+        gcap_device_info_t d{};
+        d.index = i;
+        std::snprintf(d.name, sizeof(d.name), "Synthetic Test Pattern %d", i + 1);
+        std::snprintf(d.symbolic_link, sizeof(d.symbolic_link), "synthetic://%d", i);
+        d.caps = 1u << 2; // 10-bit formats
+        list.push_back(d);
+    }
+    return true;
+}
+
+bool SyntheticProvider::open(int index)
+{
+    std::vector<gcap_device_info_t> list;
+    enumerate(list);
+    if (index < 0 || index >= (int)list.size())
+        return false;
+    if (running_)
+        return device_ == index;
+    device_ = index;
+    clock_.reset(profile_.fps_num, profile_.fps_den);
+    return true;
+}
+
+bool SyntheticProvider::setProfile(const gcap_profile_t &p)
+{
+    gcap_profile_t np{};
+    np.width = kDefaultWidth;
+    np.height = kDefaultHeight;
+    np.fps_num = kDefaultFps;
+    np.fps_den = 1;
+    np.format = GCAP_FMT_NV12;
+    np.mode = GCAP_PROFILE_CUSTOM;
+    if (p.mode == GCAP_PROFILE_CUSTOM)
+    {
+        // Zero fields keep the defaults.
+        if (p.width > 0 || p.height > 0)
+        {
+            np.width = p.width;
+            np.height = p.height;
+        }
+        if (p.fps_num > 0)
+        {
+            np.fps_num = p.fps_num;
+            np.fps_den = p.fps_den > 0 ? p.fps_den : 1;
+        }
+        np.format = p.format;
+    }
+
+    gcap::YuvLayout layout;
+    if (!layout_of(np.format, layout))
+        return false;
+    // Even sizes keep 4:2:0 / 4:2:2 chroma whole; the rate limit keeps slotNs() exact.
+    if (np.width < 16 || np.height < 16 || np.width > kMaxWidth || np.height > kMaxHeight ||
+        (np.width & 1) || (np.height & 1))
+        return false;
+    if (np.fps_den > 1000000 || np.fps_num > 1000000 || (int64_t)np.fps_num > (int64_t)kMaxFps * np.fps_den)
+        return false;
+    if (running_)
+        return false;
+
+    profile_ = np;
+    layout_ = layout;
+    csp_ = gcap::default_colorspace(np.height);
+    std::lock_guard<std::mutex> lk(mtx_);
+    rebuildConverterLocked();
+    return true;
+}
+
+bool SyntheticProvider::setBuffers(int count, size_t bytes_hint)
+{
+    // Frames come from the CaptureManager's pool; nothing to size here.
+    (void)count;
+    (void)bytes_hint;
+    return true;
+}
+
+bool SyntheticProvider::start()
+{
+    if (device_ < 0)
+        return false;
+    if (running_)
+        return true;
+
+    opts_ = current_options();
+    renderPattern();
+    clock_.reset(profile_.fps_num, profile_.fps_den);
+    frame_id_ = 0;
+
+    gcap::FrameConverter cv;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        cv = converter_;
+    }
+    char msg[256];
+    std::snprintf(msg, sizeof(msg), "[Synthetic] %dx%d %s @ %d/%d, pacing=%s%s, converter=%s, out=%s",
+                  profile_.width, profile_.height, pixfmt_name(profile_.format), profile_.fps_num, profile_.fps_den,
+                  opts_.pacing == GCAP_SYNTHETIC_PACE_FREE_RUN ? "free-run" : "clock",
+                  opts_.zero_copy ? ", zero-copy" : "", gcap::converter_kernel_name(), gcap::frame_output_name(cv.output));
+    emitError(GCAP_OK, msg);
+
+    running_ = true;
+    th_ = std::thread([this]
+                      { loop(); });
+    return true;
+}
+
+void SyntheticProvider::stop()
+{
+    {
+        std::lock_guard<std::mutex> lk(wake_mtx_);
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    if (th_.joinable())
+        th_.join();
+}
+
+void SyntheticProvider::close()
+{
+    stop();
+    stopRecording();
+    std::vector<uint8_t>().swap(strip_);
+    device_ = -1;
+}
+
+void SyntheticProvider::setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    vcb_ = vcb;
+    ecb_ = ecb;
+    user_ = user;
+}
+
+void SyntheticProvider::setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    pcb_ = pcb;
+    user_ = user;
+}
+
+void SyntheticProvider::setVideoOutput(const gcap_video_output_t &out)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    video_output_ = out;
+}
+
+void SyntheticProvider::setFramePool(gcap::FramePool *pool)
+{
+    frame_pool_ = pool;
+}
+
+// One thread generates, converts and calls back, so it takes the Capture shard.
+void SyntheticProvider::setStats(gcap::CaptureStats *stats)
+{
+    stats_ = stats ? &stats->shard(gcap::CaptureStats::Thread::Capture) : nullptr;
+}
+
+bool SyntheticProvider::getDeviceProps(gcap_device_props_t &out)
+{
+    if (device_ < 0)
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    std::snprintf(out.driver_version, sizeof(out.driver_version), "gcapture synthetic");
+    std::snprintf(out.serial_number, sizeof(out.serial_number), "SYNTH-%04d", device_ + 1);
+    out.input = GCAP_INPUT_UNKNOWN;
+    out.hdcp = 0;
+    return true;
+}
+
+bool SyntheticProvider::getSignalStatus(gcap_signal_status_t &out)
+{
+    if (device_ < 0)
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    out.width = profile_.width;
+    out.height = profile_.height;
+    out.fps_num = profile_.fps_num;
+    out.fps_den = profile_.fps_den;
+    out.pixfmt = profile_.format;
+    out.bit_depth = gcap::is_10bit_layout(layout_) ? 10 : 8;
+    out.csp = csp_;
+    out.range = GCAP_RANGE_LIMITED;
+    out.hdr = 0;
+    return true;
+}
+
+bool SyntheticProvider::getRuntimeInfo(gcap_runtime_info_t &out)
+{
+    std::memset(&out, 0, sizeof(out));
+    if (!getSignalStatus(out.signal))
+        return false;
+    out.signal_probe = out.signal;
+    out.negotiated = out.signal;
+    gcap::fill_clock_runtime_info(out, clock_.stats());
+
+    gcap::FrameOutput output;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        output = converter_.output;
+    }
+    out.active_backend = GCAP_BACKEND_SYNTHETIC;
+    std::snprintf(out.backend_name, sizeof(out.backend_name), "Synthetic");
+    std::snprintf(out.frame_source, sizeof(out.frame_source), "%s", opts_.zero_copy ? "Pattern (zero-copy)" : "Pattern");
+    std::snprintf(out.path_name, sizeof(out.path_name), "Synthetic CPU");
+    std::snprintf(out.source_format, sizeof(out.source_format), "%s", pixfmt_name(profile_.format));
+    std::snprintf(out.render_format, sizeof(out.render_format), "%s CPU", gcap::frame_output_name(output));
+    std::snprintf(out.input_signal_desc, sizeof(out.input_signal_desc), "YCbCr %s / %s / %d-bit",
+                  is_planar(layout_) ? "4:2:0" : "4:2:2", csp_ == GCAP_CSP_BT601 ? "BT.601" : "BT.709",
+                  out.signal.bit_depth);
+    std::snprintf(out.input_signal_note, sizeof(out.input_signal_note), "Generated");
+    std::snprintf(out.negotiated_desc, sizeof(out.negotiated_desc), "%s", pixfmt_name(profile_.format));
+    return true;
+}
+
+bool SyntheticProvider::setProcessing(const gcap_processing_opts_t &opts)
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        force_range_ = opts.force_range;
+        switch (opts.cpu_output)
+        {
+        case GCAP_CPU_OUT_ARGB_DITHER:
+            cpu_output_ = gcap::FrameOutput::Bgra8Dither;
+            break;
+        case GCAP_CPU_OUT_RGBA64:
+            cpu_output_ = gcap::FrameOutput::Rgba64;
+            break;
+        case GCAP_CPU_OUT_X2R10G10B10:
+            cpu_output_ = gcap::FrameOutput::X2R10G10B10;
+            break;
+        default:
+            cpu_output_ = gcap::FrameOutput::Bgra8;
+            break;
+        }
+        rebuildConverterLocked();
+    }
+    // The source format is the profile's; only force_range / cpu_output apply here.
+    return opts.preferred_pixfmt == GCAP_FMT_NV12 && opts.deinterlace == GCAP_DEINT_AUTO;
+}
+
+bool SyntheticProvider::setProcAmp(const gcap_procamp_t &p)
+{
+    auto clamp255 = [](int v) -> int
+    { return std::clamp(v, 0, 255); };
+
+    gcap::ProcAmpParams pp;
+    pp.brightness = clamp255(p.brightness);
+    pp.contrast = clamp255(p.contrast);
+    pp.hue = clamp255(p.hue);
+    pp.saturation = clamp255(p.saturation);
+    pp.sharpness = clamp255(p.sharpness);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    procamp_params_ = pp;
+    rebuildConverterLocked();
+    return true;
+}
+
+void SyntheticProvider::rebuildConverterLocked()
+{
+    // The pattern is generated in limited range; force_range still overrides it.
+    const gcap_range_t range = force_range_ != GCAP_RANGE_UNKNOWN ? force_range_ : GCAP_RANGE_LIMITED;
+    converter_ = gcap::make_frame_converter(layout_, csp_, range, procamp_params_, cpu_output_);
+}
+
+gcap_status_t SyntheticProvider::startRecording(const char *pathUtf8)
+{
+    if (!pathUtf8 || !*pathUtf8)
+        return GCAP_EINVAL;
+    std::lock_guard<std::mutex> lk(recorder_mtx_);
+    if (recorder_)
+        return GCAP_ESTATE;
+    recorder_ = open_utf8(pathUtf8);
+    if (!recorder_)
+        return GCAP_EIO;
+    std::setvbuf(recorder_, nullptr, _IOFBF, 1 << 20);
+    return GCAP_OK;
+}
+
+gcap_status_t SyntheticProvider::stopRecording()
+{
+    std::lock_guard<std::mutex> lk(recorder_mtx_);
+    if (!recorder_)
+        return GCAP_ESTATE;
+    const bool ok = std::fclose(recorder_) == 0;
+    recorder_ = nullptr;
+    return ok ? GCAP_OK : GCAP_EIO;
+}
+
+void SyntheticProvider::emitError(gcap_status_t c, const char *msg)
+{
+    gcap_on_error_cb ecb;
+    void *user;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        ecb = ecb_;
+        user = user_;
+    }
+    if (ecb)
+        ecb(c, msg, user);
+}
+
+uint64_t SyntheticProvider::periodNs() const
+{
+    return slotNs(1);
+}
+
+// floor(n * den * 1e9 / num) without overflow: num and den are at most 10^6.
+uint64_t SyntheticProvider::slotNs(uint64_t n) const
+{
+    const uint64_t num = (uint64_t)profile_.fps_num, den = (uint64_t)profile_.fps_den;
+    const uint64_t q = n % num * den;
+    return n / num * den * 1000000000ull + q / num * 1000000000ull + q % num * 1000000000ull / num;
+}
+
+int SyntheticProvider::rowBytes() const
+{
+    return row_bytes(layout_, profile_.width);
+}
+
+size_t SyntheticProvider::frameBytes(int stride0) const
+{
+    const size_t rows = (size_t)profile_.height + (is_planar(layout_) ? (size_t)profile_.height / 2 : 0);
+    return (size_t)stride0 * rows;
+}
+
+// The strip holds the pattern for x in [0, stripWidth_), periodic in period_, so every
+// frame-sized window starting below period_ is a valid frame. Every row of a region is
+// the same, so two rows per plane are packed and then replicated.
+void SyntheticProvider::renderPattern()
+{
+    const int w = profile_.width, h = profile_.height;
+    period_ = std::max(48, (w / 2 + 47) / 48 * 48);
+    stripWidth_ = period_ + (w + 47) / 48 * 48;
+    step_ = 6 * std::max(1, w / 640);
+    stripStride_ = gcap::aligned_row_bytes(row_bytes(layout_, stripWidth_));
+    const bool planar = is_planar(layout_);
+    strip_.assign(frameBytes(stripStride_), 0);
+
+    // 75% colour bars (white, yellow, cyan, green, magenta, red, blue, black) in the
+    // source matrix, 10-bit limited range.
+    const double kr = csp_ == GCAP_CSP_BT601 ? 0.299 : 0.2126;
+    const double kb = csp_ == GCAP_CSP_BT601 ? 0.114 : 0.0722;
+    uint16_t barY[8], barCb[8], barCr[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        static const int kRgb[8] = {7, 6, 3, 2, 5, 4, 1, 0}; // R << 2 | G << 1 | B
+        const double r = (kRgb[i] & 4) ? 0.75 : 0.0, g = (kRgb[i] & 2) ? 0.75 : 0.0, b = (kRgb[i] & 1) ? 0.75 : 0.0;
+        const double y = kr * r + (1.0 - kr - kb) * g + kb * b;
+        barY[i] = (uint16_t)std::lround(64.0 + 876.0 * y);
+        barCb[i] = (uint16_t)std::lround(512.0 + 896.0 * (b - y) / (2.0 * (1.0 - kb)));
+        barCr[i] = (uint16_t)std::lround(512.0 + 896.0 * (r - y) / (2.0 * (1.0 - kr)));
+    }
+
+    std::vector<uint16_t> ys((size_t)stripWidth_), cbs((size_t)stripWidth_ / 2), crs((size_t)stripWidth_ / 2);
+    std::vector<uint8_t> bars0((size_t)stripStride_), bars1((size_t)stripStride_);
+    std::vector<uint8_t> ramp0((size_t)stripStride_), ramp1((size_t)stripStride_);
+    for (int x = 0; x < stripWidth_; ++x)
+    {
+        const int bar = x % period_ * 8 / period_;
+        ys[(size_t)x] = barY[bar];
+        if ((x & 1) == 0)
+        {
+            cbs[(size_t)x / 2] = barCb[bar];
+            crs[(size_t)x / 2] = barCr[bar];
+        }
+    }
+    pack_row(layout_, ys.data(), cbs.data(), crs.data(), stripWidth_, bars0.data(), bars1.data());
+    for (int x = 0; x < stripWidth_; ++x)
+    {
+        ys[(size_t)x] = (uint16_t)(64 + (876 * (x % period_) + (period_ - 1) / 2) / (period_ - 1));
+        if ((x & 1) == 0)
+            cbs[(size_t)x / 2] = crs[(size_t)x / 2] = 512;
+    }
+    pack_row(layout_, ys.data(), cbs.data(), crs.data(), stripWidth_, ramp0.data(), ramp1.data());
+
+    const int barRows = h * 2 / 3 & ~1;
+    uint8_t *plane0 = strip_.data();
+    for (int y = 0; y < h; ++y)
+        std::memcpy(plane0 + (size_t)y * stripStride_, y < barRows ? bars0.data() : ramp0.data(), (size_t)stripStride_);
+    if (!planar)
+        return;
+    uint8_t *plane1 = plane0 + (size_t)stripStride_ * h;
+    for (int y = 0; y < h / 2; ++y)
+        std::memcpy(plane1 + (size_t)y * stripStride_, y * 2 < barRows ? bars1.data() : ramp1.data(), (size_t)stripStride_);
+}
+
+// Frame n starts (n * step + device * 48) pixels into the strip: a multiple of 6, so
+// whole V210 groups and chroma pairs.
+SyntheticProvider::Planes SyntheticProvider::patternAt(uint64_t n) const
+{
+    const int x = (int)((n * (uint64_t)step_ + (uint64_t)device_ * 48) % (uint64_t)period_);
+    const size_t off = layout_ == gcap::YuvLayout::V210 ? (size_t)(x / 6) * 16 : (size_t)row_bytes(layout_, x);
+    Planes p;
+    p.data[0] = strip_.data() + off;
+    p.stride[0] = stripStride_;
+    if (is_planar(layout_))
+    {
+        p.data[1] = strip_.data() + (size_t)stripStride_ * profile_.height + off;
+        p.stride[1] = stripStride_;
+    }
+    return p;
+}
+
+bool SyntheticProvider::copyFrame(const Planes &src, uint64_t n, uint8_t *dst, int dstStride) const
+{
+    const bool planar = is_planar(layout_);
+    const CopyJob job{{src.data[0], src.data[1]},
+                      {src.stride[0], src.stride[1]},
+                      {dst, planar ? dst + (size_t)dstStride * profile_.height : nullptr},
+                      dstStride,
+                      rowBytes(),
+                      planar};
+    gcap::parallel_rows(profile_.width, profile_.height, planar ? 2 : 1, copy_band, const_cast<CopyJob *>(&job));
+    stamp(dst, dstStride, n);
+    return true;
+}
+
+void SyntheticProvider::stamp(uint8_t *data0, int stride0, uint64_t n) const
+{
+    if (profile_.width < kStampWidth || profile_.height < kStampRows)
+        return;
+    uint16_t y[kStampWidth], cb[kStampWidth / 2], cr[kStampWidth / 2];
+    for (int x = 0; x < kStampWidth; ++x)
+    {
+        const bool bit = (((uint32_t)n >> (kStampCells - 1 - x / kStampCellW)) & 1u) != 0;
+        y[x] = bit ? 940 : 64;
+        if ((x & 1) == 0)
+            cb[x / 2] = cr[x / 2] = 512;
+    }
+    uint8_t row0[kStampWidth * 4], row1[kStampWidth * 2];
+    pack_row(layout_, y, cb, cr, kStampWidth, row0, row1);
+
+    const size_t bytes = (size_t)row_bytes(layout_, kStampWidth);
+    for (int r = 0; r < kStampRows; ++r)
+        std::memcpy(data0 + (size_t)r * stride0, row0, bytes);
+    if (!is_planar(layout_))
+        return;
+    uint8_t *uv = data0 + (size_t)stride0 * profile_.height;
+    for (int r = 0; r < kStampRows / 2; ++r)
+        std::memcpy(uv + (size_t)r * stride0, row1, bytes);
+}
+
+void SyntheticProvider::writeRecording(const Planes &src, uint64_t frameId)
+{
+    std::lock_guard<std::mutex> lk(recorder_mtx_);
+    if (!recorder_)
+        return;
+    GCAP_TRACE_SCOPE(RecorderWrite, frameId);
+    (void)frameId; // GCAP_TRACE=0
+    const size_t bytes = (size_t)rowBytes();
+    bool ok = true;
+    for (int y = 0; y < profile_.height && ok; ++y)
+        ok = std::fwrite(src.data[0] + (size_t)y * src.stride[0], 1, bytes, recorder_) == bytes;
+    if (is_planar(layout_))
+        for (int y = 0; y < profile_.height / 2 && ok; ++y)
+            ok = std::fwrite(src.data[1] + (size_t)y * src.stride[1], 1, bytes, recorder_) == bytes;
+    if (ok)
+        return;
+    std::fclose(recorder_);
+    recorder_ = nullptr;
+    emitError(GCAP_EIO, "[Synthetic] recording write failed; recording stopped");
+}
+
+// Output memory for one frame: a pool slot the callbacks can retain, or the scratch
+// vector when every slot is retained (nullptr under GCAP_LEASE_POLICY_SKIP).
+uint8_t *SyntheticProvider::outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes)
+{
+    if (frame_pool_)
+    {
+        lease = frame_pool_->acquire(bytes);
+        if (lease)
+            return lease.data();
+        if (frame_pool_->policy() == GCAP_LEASE_POLICY_SKIP)
+            return nullptr;
+    }
+    if (scratch.size() < bytes)
+        scratch.resize(bytes);
+    return scratch.data();
+}
+
+// Converts for the video callback, resizing in the same pass when an output size is set.
+void SyntheticProvider::deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo,
+                                     gcap_on_video_cb vcb, void *user, const Planes &src, gcap_frame_t &f)
+{
+    const int w = profile_.width, h = profile_.height;
+    int dw = w, dh = h;
+    const bool scaled = gcap::scale_supported(cv.layout) && gcap::video_output_size(vo, w, h, dw, dh);
+    if (scaled && (scale_plan_.layout != cv.layout || scale_plan_.src_width != w || scale_plan_.src_height != h ||
+                   scale_plan_.dst_width != dw || scale_plan_.dst_height != dh || scale_filter_ != vo.filter))
+    {
+        scale_plan_ = gcap::make_scale_plan(cv.layout, w, h, dw, dh, vo.filter);
+        scale_filter_ = vo.filter;
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "[Synthetic] CPU video output %dx%d -> %dx%d (%s)", w, h, dw, dh,
+                      scale_plan_.filter == GCAP_SCALE_BOX ? "box" : "bilinear");
+        emitError(GCAP_OK, msg);
+    }
+    if (!scaled)
+        dw = w, dh = h;
+
+    const int outStride = gcap::aligned_row_bytes(dw * gcap::frame_output_bytes_per_pixel(cv.output));
+    gcap::FrameLease lease;
+    uint8_t *out = outputBuffer(lease, scaled ? cpu_scaled_ : cpu_out_, (size_t)outStride * (size_t)dh);
+    if (!out)
+        return;
+    {
+        GCAP_TRACE_SCOPE(Convert, f.frame_id);
+        const uint64_t t0 = stats_ ? steady_now_ns() : 0;
+        if (scaled)
+            gcap::convert_frame_scaled(cv, scale_plan_, src.data[0], src.data[1], src.stride[0], src.stride[1], out, outStride);
+        else
+            gcap::convert_frame(cv, src.data[0], src.data[1], src.stride[0], src.stride[1], w, h, out, outStride);
+        if (stats_)
+            stats_->record(gcap::StatHist::Convert, steady_now_ns() - t0);
+    }
+
+    f.format = gcap::frame_output_pixfmt(cv.output);
+    f.plane_count = 1;
+    f.width = dw;
+    f.height = dh;
+    f.data[0] = out;
+    f.stride[0] = outStride;
+    f.lease = nullptr;
+    if (lease)
+        lease.attach(f);
+    GCAP_TRACE_SCOPE(Callback, f.frame_id);
+    vcb(&f, user);
+}
+
+void SyntheticProvider::loop()
+{
+    GCAP_TRACE_THREAD_NAME("synthetic capture");
+    const bool paced = opts_.pacing != GCAP_SYNTHETIC_PACE_FREE_RUN;
+    const uint64_t period = periodNs();
+    const bool planar = is_planar(layout_);
+    const uint64_t t0 = steady_now_ns();
+
+    for (uint64_t n = 0; running_; ++n)
+    {
+        if (paced)
+        {
+            const uint64_t due = t0 + slotNs(n);
+            uint64_t now = steady_now_ns();
+            if (now < due)
+            {
+                if (due - now > kSpinNs)
+                {
+                    const auto wake = std::chrono::steady_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(due - kSpinNs)));
+                    std::unique_lock<std::mutex> lk(wake_mtx_);
+                    wake_cv_.wait_until(lk, wake, [this]
+                                        { return !running_; });
+                }
+                while (running_ && steady_now_ns() < due)
+                    std::this_thread::yield();
+                if (!running_)
+                    break;
+            }
+            else if (now - due >= period)
+            {
+                // Behind by whole periods: skip to the slot in progress, as a device would.
+                const uint64_t elapsed = now - t0;
+                uint64_t m = (uint64_t)((long double)elapsed * profile_.fps_num / ((long double)profile_.fps_den * 1e9L));
+                while (slotNs(m + 1) <= elapsed)
+                    ++m;
+                while (m > n && slotNs(m) > elapsed)
+                    --m;
+                n = std::max(n, m);
+            }
+        }
+
+        // The frame's device time is its slot on the synthetic timeline, so skipped
+        // slots show up as gaps, and free-run shows up as a fast device clock.
+        const uint64_t deviceNs = slotNs(n);
+        const uint64_t hostNs = steady_now_ns();
+        gcap::ClockRecovery::Gap gap;
+        const uint64_t ptsSmoothedNs = clock_.update((int64_t)deviceNs, hostNs, &gap);
+        if (stats_)
+        {
+            stats_->arrived(hostNs);
+            stats_->add(gcap::StatCounter::FramesDropped, gap.dropped);
+            stats_->add(gcap::StatCounter::FramesDuplicated, gap.duplicated);
+        }
+
+        const uint64_t frameId = ++frame_id_;
+        StatsFrameScope statsFrame{stats_};
+
+        gcap_on_video_cb vcb;
+        gcap_on_frame_packet_cb pcb;
+        void *user;
+        gcap::FrameConverter cv;
+        gcap_video_output_t vo;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            vcb = vcb_;
+            pcb = pcb_;
+            user = user_;
+            cv = converter_;
+            vo = video_output_;
+        }
+
+        Planes src = patternAt(n);
+        gcap::FrameLease srcLease;
+        if (!opts_.zero_copy)
+        {
+            const int stride = gcap::aligned_row_bytes(rowBytes());
+            const size_t bytes = frameBytes(stride);
+            uint8_t *dst = outputBuffer(srcLease, src_scratch_, bytes);
+            if (!dst)
+                continue;
+            {
+                GCAP_TRACE_SCOPE(RawCopy, frameId);
+                copyFrame(src, n, dst, stride);
+            }
+            if (stats_)
+                stats_->copied(bytes);
+            src.data[0] = dst;
+            src.data[1] = planar ? dst + (size_t)stride * profile_.height : nullptr;
+            src.stride[0] = stride;
+            src.stride[1] = planar ? stride : 0;
+        }
+
+        writeRecording(src, frameId);
+
+        if (pcb)
+        {
+            gcap_frame_packet_t pkt{};
+            pkt.width = profile_.width;
+            pkt.height = profile_.height;
+            pkt.format = profile_.format;
+            pkt.plane_count = planar ? 2 : 1;
+            for (int i = 0; i < pkt.plane_count; ++i)
+            {
+                pkt.data[i] = src.data[i];
+                pkt.stride[i] = src.stride[i];
+            }
+            pkt.pts_ns = deviceNs;
+            pkt.pts_smoothed_ns = ptsSmoothedNs;
+            pkt.frame_id = frameId;
+            pkt.backend = GCAP_BACKEND_SYNTHETIC;
+            pkt.source_kind = GCAP_SOURCE_SYNTHETIC;
+            pkt.gpu_backed = 0;
+            if (srcLease)
+                srcLease.attach(pkt);
+            GCAP_TRACE_SCOPE(Callback, frameId);
+            pcb(&pkt, user);
+        }
+
+        if (vcb)
+        {
+            gcap_frame_t f{};
+            f.pts_ns = deviceNs;
+            f.frame_id = frameId;
+            deliverVideo(cv, vo, vcb, user, src, f);
+        }
+    }
+}
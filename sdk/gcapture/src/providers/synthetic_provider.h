@@ -0,0 +1,139 @@
+// synthetic_provider.h
+// GCAP_BACKEND_SYNTHETIC: generated test patterns, so the capture, conversion,
+// callback and recording paths run (and can be load-tested) without hardware.
+// Portable; no platform APIs beyond the standard library.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gcapture.h"
+#include "../core/capture_manager.h"
+#include "../core/clock_recovery.h"
+#include "../core/frame_converter.h"
+#include "../core/frame_pool.h"
+
+namespace gcap
+{
+    class StatsShard;
+}
+
+int synthetic_enum_supported_pixel_formats(gcap_pixfmt_t *outFormats, int maxFormats);
+
+/**
+ * Generates frames from a pattern rendered once per start(): a strip one scroll
+ * period wider than the frame, each frame being a window into it at an offset
+ * that advances with the frame index. A frame therefore costs one copy per row
+ * (spread over the conversion pool), or nothing in zero-copy mode, which keeps
+ * 8K120 within reach of memory bandwidth.
+ *
+ * Frames are paced against an absolute timeline (start + n * period), so
+ * sleep overshoot never accumulates; a slot that is already over when the
+ * thread gets to it is skipped, and ClockRecovery counts it as a drop from the
+ * gap in the frame's device time (n * period).
+ */
+class SyntheticProvider : public ICaptureProvider
+{
+public:
+    SyntheticProvider();
+    ~SyntheticProvider() override;
+
+    // Process-wide, like the backend selection (gcap_set_synthetic_opts).
+    static void setOptions(const gcap_synthetic_opts_t &opts);
+
+    bool enumerate(std::vector<gcap_device_info_t> &list) override;
+    bool open(int index) override;
+    bool setProfile(const gcap_profile_t &p) override;
+    bool setBuffers(int count, size_t bytes_hint) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+
+    void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user) override;
+    void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override;
+    void setVideoOutput(const gcap_video_output_t &out) override;
+    void setFramePool(gcap::FramePool *pool) override;
+    void setStats(gcap::CaptureStats *stats) override;
+
+    bool getDeviceProps(gcap_device_props_t &out) override;
+    bool getSignalStatus(gcap_signal_status_t &out) override;
+    bool getRuntimeInfo(gcap_runtime_info_t &out) override;
+    bool setProcessing(const gcap_processing_opts_t &opts) override;
+    bool setProcAmp(const gcap_procamp_t &p) override;
+
+    // Raw source frames, rows packed, appended to the file (no container).
+    gcap_status_t startRecording(const char *pathUtf8);
+    gcap_status_t stopRecording();
+
+private:
+    // One window into the pattern, or the frame copied out of it.
+    struct Planes
+    {
+        const uint8_t *data[2] = {};
+        int stride[2] = {};
+    };
+
+    void loop();
+    void renderPattern();
+    Planes patternAt(uint64_t n) const;
+    bool copyFrame(const Planes &src, uint64_t n, uint8_t *dst, int dstStride) const;
+    void stamp(uint8_t *data0, int stride0, uint64_t n) const;
+    void writeRecording(const Planes &src, uint64_t frameId);
+    void deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, gcap_on_video_cb vcb,
+                      void *user, const Planes &src, gcap_frame_t &f);
+    uint8_t *outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes);
+    void rebuildConverterLocked();
+    void emitError(gcap_status_t c, const char *msg);
+
+    uint64_t periodNs() const;
+    uint64_t slotNs(uint64_t n) const; // n * period, exact for fractional rates
+    int rowBytes() const;              // one packed row of the first plane
+    size_t frameBytes(int stride0) const;
+
+    // Guards the callbacks, the converter and the video output size; the
+    // frame loop copies them once per frame.
+    std::mutex mtx_;
+    gcap_on_video_cb vcb_ = nullptr;
+    gcap_on_frame_packet_cb pcb_ = nullptr;
+    gcap_on_error_cb ecb_ = nullptr;
+    void *user_ = nullptr;
+    gcap_video_output_t video_output_{};
+    gcap::ProcAmpParams procamp_params_;
+    gcap_range_t force_range_ = GCAP_RANGE_UNKNOWN;
+    gcap::FrameOutput cpu_output_ = gcap::FrameOutput::Bgra8;
+    gcap::FrameConverter converter_;
+
+    int device_ = -1;
+    gcap_profile_t profile_{};
+    gcap::YuvLayout layout_ = gcap::YuvLayout::Nv12;
+    gcap_colorspace_t csp_ = GCAP_CSP_BT709;
+    gcap_synthetic_opts_t opts_{}; // snapshot taken by start()
+
+    // Pattern strip: stripWidth_ pixels, period_ of them repeat; rendered by start().
+    std::vector<uint8_t> strip_;
+    int stripStride_ = 0;
+    int stripWidth_ = 0;
+    int period_ = 0;
+    int step_ = 0;
+
+    std::atomic<bool> running_{false};
+    std::thread th_;
+    std::mutex wake_mtx_; // lets stop() cut a pacing wait short
+    std::condition_variable wake_cv_;
+    uint64_t frame_id_ = 0;
+    gcap::ClockRecovery clock_;
+
+    gcap::FramePool *frame_pool_ = nullptr; // owned by CaptureManager
+    gcap::StatsShard *stats_ = nullptr;     // frame thread's shard (owned by CaptureManager)
+    std::vector<uint8_t> src_scratch_;      // source frame when the pool is exhausted (UNLEASED)
+    std::vector<uint8_t> cpu_out_;          // converter output when the pool is exhausted
+    std::vector<uint8_t> cpu_scaled_;
+    gcap::ScalePlan scale_plan_;
+    gcap_scale_filter_t scale_filter_ = GCAP_SCALE_AUTO;
+
+    std::mutex recorder_mtx_;
+    std::FILE *recorder_ = nullptr;
+};
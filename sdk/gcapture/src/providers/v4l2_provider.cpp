@@ -0,0 +1,1140 @@
+// v4l2_provider.cpp
+#include "v4l2_provider.h"
+#include "../core/capture_stats.h"
+#include "../core/convert_pool.h"
+#include "../core/frame_arena.h"
+#include "../core/trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr int kMaxNodes = 64; // /dev/video0../dev/video63
+    constexpr int kDefaultBuffers = 4;
+    constexpr int kMinBuffers = 2;
+    constexpr int kMaxBuffers = 32;
+    constexpr int kPollMs = 50;          // also how long stop() may wait for the frame thread
+    constexpr int kMaxIoErrors = 16;     // consecutive VIDIOC_DQBUF EIO before giving up
+    constexpr uint64_t kStallNs = 1000000000ull;
+
+    int sys_open(const char *path, int flags) { return ::open(path, flags); }
+    int sys_close(int fd) { return ::close(fd); }
+    int sys_ioctl(int fd, unsigned long request, void *arg) { return ::ioctl(fd, request, arg); }
+    void *sys_mmap(size_t length, int fd, int64_t offset)
+    {
+        return ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)offset);
+    }
+    int sys_munmap(void *addr, size_t length) { return ::munmap(addr, length); }
+    int sys_poll(struct pollfd *pfd, int timeoutMs) { return ::poll(pfd, 1, timeoutMs); }
+
+    const V4l2Io kSystemIo = {sys_open, sys_close, sys_ioctl, sys_mmap, sys_munmap, sys_poll};
+    std::atomic<const V4l2Io *> g_io{&kSystemIo};
+
+    const V4l2Io &io()
+    {
+        return *g_io.load(std::memory_order_acquire);
+    }
+
+    int xioctl(int fd, unsigned long request, void *arg)
+    {
+        int r;
+        do
+            r = io().ioctl(fd, request, arg);
+        while (r < 0 && errno == EINTR);
+        return r;
+    }
+
+    uint64_t steady_now_ns()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    struct StatsFrameScope
+    {
+        gcap::StatsShard *stats;
+        ~StatsFrameScope()
+        {
+            if (stats)
+                stats->endFrame(steady_now_ns());
+        }
+    };
+
+    // Driver formats the SDK can take, in the order DEVICE_DEFAULT profiles fall back on.
+    struct FormatMap
+    {
+        uint32_t fourcc;
+        gcap_pixfmt_t format;
+    };
+    const FormatMap kFormats[] = {
+        {V4L2_PIX_FMT_NV12, GCAP_FMT_NV12},
+        {V4L2_PIX_FMT_YUYV, GCAP_FMT_YUY2},
+#ifdef V4L2_PIX_FMT_P010
+        {V4L2_PIX_FMT_P010, GCAP_FMT_P010},
+#endif
+#ifdef V4L2_PIX_FMT_Y210
+        {V4L2_PIX_FMT_Y210, GCAP_FMT_Y210},
+#endif
+        // B, G, R, X bytes: GCAP_FMT_ARGB's memory order
+        {V4L2_PIX_FMT_XBGR32, GCAP_FMT_ARGB},
+        {V4L2_PIX_FMT_ABGR32, GCAP_FMT_ARGB},
+        {V4L2_PIX_FMT_BGR32, GCAP_FMT_ARGB},
+    };
+
+    bool to_pixfmt(uint32_t fourcc, gcap_pixfmt_t &fmt)
+    {
+        for (const FormatMap &m : kFormats)
+            if (m.fourcc == fourcc)
+            {
+                fmt = m.format;
+                return true;
+            }
+        return false;
+    }
+
+    gcap::YuvLayout layout_of(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_YUY2:
+            return gcap::YuvLayout::Yuy2;
+        case GCAP_FMT_P010:
+            return gcap::YuvLayout::P010;
+        case GCAP_FMT_Y210:
+            return gcap::YuvLayout::Y210;
+        case GCAP_FMT_NV12:
+        default:
+            return gcap::YuvLayout::Nv12;
+        }
+    }
+
+    int bytes_per_pixel(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            return 1;
+        case GCAP_FMT_YUY2:
+        case GCAP_FMT_P010:
+            return 2;
+        default:
+            return 4; // Y210, ARGB
+        }
+    }
+
+    bool is_planar(gcap_pixfmt_t fmt)
+    {
+        return fmt == GCAP_FMT_NV12 || fmt == GCAP_FMT_P010;
+    }
+
+    bool is_10bit(gcap_pixfmt_t fmt)
+    {
+        return fmt == GCAP_FMT_P010 || fmt == GCAP_FMT_Y210;
+    }
+
+    const char *pixfmt_name(gcap_pixfmt_t fmt)
+    {
+        switch (fmt)
+        {
+        case GCAP_FMT_NV12:
+            return "NV12";
+        case GCAP_FMT_YUY2:
+            return "YUY2";
+        case GCAP_FMT_P010:
+            return "P010";
+        case GCAP_FMT_Y210:
+            return "Y210";
+        case GCAP_FMT_ARGB:
+            return "ARGB";
+        default:
+            return "Unknown";
+        }
+    }
+
+    struct FourccName
+    {
+        char s[5];
+    };
+
+    FourccName fourcc_name(uint32_t fourcc)
+    {
+        FourccName n{};
+        for (int i = 0; i < 4; ++i)
+        {
+            const char c = (char)((fourcc >> (8 * i)) & 0xff);
+            n.s[i] = (c >= 0x20 && c < 0x7f) ? c : '?';
+        }
+        return n;
+    }
+
+    // Matrix and range of a negotiated format; driver defaults follow the V4L2 rules
+    // (sRGB / JPEG colorspaces are BT.601, JPEG is full range).
+    void colorimetry(const v4l2_pix_format &pix, gcap_colorspace_t &csp, gcap_range_t &range)
+    {
+        switch (pix.ycbcr_enc)
+        {
+        case V4L2_YCBCR_ENC_601:
+        case V4L2_YCBCR_ENC_XV601:
+            csp = GCAP_CSP_BT601;
+            break;
+        case V4L2_YCBCR_ENC_709:
+        case V4L2_YCBCR_ENC_XV709:
+            csp = GCAP_CSP_BT709;
+            break;
+        case V4L2_YCBCR_ENC_BT2020:
+        case V4L2_YCBCR_ENC_BT2020_CONST_LUM:
+            csp = GCAP_CSP_BT2020;
+            break;
+        default:
+            switch (pix.colorspace)
+            {
+            case V4L2_COLORSPACE_SMPTE170M:
+            case V4L2_COLORSPACE_470_SYSTEM_M:
+            case V4L2_COLORSPACE_470_SYSTEM_BG:
+            case V4L2_COLORSPACE_SRGB:
+            case V4L2_COLORSPACE_JPEG:
+                csp = GCAP_CSP_BT601;
+                break;
+            case V4L2_COLORSPACE_REC709:
+                csp = GCAP_CSP_BT709;
+                break;
+            case V4L2_COLORSPACE_BT2020:
+                csp = GCAP_CSP_BT2020;
+                break;
+            default:
+                csp = gcap::default_colorspace((int)pix.height);
+                break;
+            }
+            break;
+        }
+        if (pix.quantization == V4L2_QUANTIZATION_FULL_RANGE)
+            range = GCAP_RANGE_FULL;
+        else if (pix.quantization == V4L2_QUANTIZATION_LIM_RANGE)
+            range = GCAP_RANGE_LIMITED;
+        else
+            range = pix.colorspace == V4L2_COLORSPACE_JPEG ? GCAP_RANGE_FULL : GCAP_RANGE_LIMITED;
+    }
+
+    struct Node
+    {
+        std::string path;
+        v4l2_capability cap{};
+    };
+
+    // Opens a node that streams video capture frames; -1 otherwise.
+    int open_node(const char *path, v4l2_capability &cap)
+    {
+        const int fd = io().open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            return -1;
+        std::memset(&cap, 0, sizeof(cap));
+        if (xioctl(fd, VIDIOC_QUERYCAP, &cap) == 0)
+        {
+            const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+            if ((caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING))
+                return fd;
+        }
+        io().close(fd);
+        return -1;
+    }
+
+    std::vector<Node> list_nodes()
+    {
+        std::vector<Node> nodes;
+        for (int i = 0; i < kMaxNodes; ++i)
+        {
+            Node n;
+            n.path = "/dev/video" + std::to_string(i);
+            const int fd = open_node(n.path.c_str(), n.cap);
+            if (fd < 0)
+                continue;
+            io().close(fd);
+            nodes.push_back(n);
+        }
+        return nodes;
+    }
+
+    int open_by_index(int index, Node &node)
+    {
+        const std::vector<Node> nodes = list_nodes();
+        if (index < 0 || index >= (int)nodes.size())
+            return -1;
+        node = nodes[(size_t)index];
+        return open_node(node.path.c_str(), node.cap);
+    }
+
+    // Driver formats the SDK maps, in the driver's order.
+    std::vector<uint32_t> device_formats(int fd)
+    {
+        std::vector<uint32_t> out;
+        v4l2_fmtdesc d{};
+        d.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        for (d.index = 0; xioctl(fd, VIDIOC_ENUM_FMT, &d) == 0; ++d.index)
+        {
+            gcap_pixfmt_t fmt;
+            if (!(d.flags & V4L2_FMT_FLAG_COMPRESSED) && to_pixfmt(d.pixelformat, fmt))
+                out.push_back(d.pixelformat);
+        }
+        return out;
+    }
+
+    // Discrete intervals as listed; stepwise / continuous ranges as their fastest rate.
+    void frame_rates(int fd, uint32_t fourcc, uint32_t w, uint32_t h, std::vector<v4l2_fract> &out)
+    {
+        out.clear();
+        v4l2_frmivalenum iv{};
+        iv.pixel_format = fourcc;
+        iv.width = w;
+        iv.height = h;
+        for (iv.index = 0; xioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &iv) == 0; ++iv.index)
+        {
+            if (iv.type == V4L2_FRMIVAL_TYPE_DISCRETE)
+                out.push_back(iv.discrete);
+            else
+            {
+                out.push_back(iv.stepwise.min);
+                break;
+            }
+        }
+    }
+}
+
+void V4L2Provider::setIo(const V4l2Io *io)
+{
+    g_io.store(io ? io : &kSystemIo, std::memory_order_release);
+}
+
+int v4l2_enum_video_caps_by_index(int device_index, gcap_video_cap_t *out_caps, int max_caps)
+{
+    Node node;
+    const int fd = open_by_index(device_index, node);
+    if (fd < 0)
+        return 0;
+
+    std::vector<gcap_video_cap_t> caps;
+    std::vector<v4l2_fract> rates;
+    auto add = [&](uint32_t fourcc, gcap_pixfmt_t fmt, uint32_t w, uint32_t h)
+    {
+        frame_rates(fd, fourcc, w, h, rates);
+        if (rates.empty())
+            rates.push_back(v4l2_fract{0, 0});
+        for (const v4l2_fract &r : rates)
+        {
+            gcap_video_cap_t c{};
+            c.width = (int)w;
+            c.height = (int)h;
+            c.fps_num = (int)r.denominator; // timeperframe is the inverse of the rate
+            c.fps_den = r.numerator ? (int)r.numerator : 1;
+            c.pixfmt = fmt;
+            c.bit_depth = is_10bit(fmt) ? 10 : 8;
+            caps.push_back(c);
+        }
+    };
+    for (uint32_t fourcc : device_formats(fd))
+    {
+        gcap_pixfmt_t fmt = GCAP_FMT_NV12;
+        to_pixfmt(fourcc, fmt);
+        v4l2_frmsizeenum fs{};
+        fs.pixel_format = fourcc;
+        for (fs.index = 0; xioctl(fd, VIDIOC_ENUM_FRAMESIZES, &fs) == 0; ++fs.index)
+        {
+            if (fs.type == V4L2_FRMSIZE_TYPE_DISCRETE)
+                add(fourcc, fmt, fs.discrete.width, fs.discrete.height);
+            else
+            {
+                add(fourcc, fmt, fs.stepwise.max_width, fs.stepwise.max_height);
+                break;
+            }
+        }
+    }
+    io().close(fd);
+
+    const int total = (int)caps.size();
+    if (!out_caps || max_caps <= 0)
+        return total;
+    const int n = std::min(max_caps, total);
+    for (int i = 0; i < n; ++i)
+        out_caps[i] = caps[(size_t)i];
+    return n;
+}
+
+int v4l2_enum_supported_pixel_formats_by_index(int device_index, gcap_pixfmt_t *out_formats, int max_formats)
+{
+    Node node;
+    const int fd = open_by_index(device_index, node);
+    if (fd < 0)
+        return 0;
+    std::vector<gcap_pixfmt_t> uniq;
+    for (uint32_t fourcc : device_formats(fd))
+    {
+        gcap_pixfmt_t fmt;
+        if (to_pixfmt(fourcc, fmt) && std::find(uniq.begin(), uniq.end(), fmt) == uniq.end())
+            uniq.push_back(fmt);
+    }
+    io().close(fd);
+
+    const int total = (int)uniq.size();
+    if (!out_formats || max_formats <= 0)
+        return total;
+    const int n = std::min(max_formats, total);
+    for (int i = 0; i < n; ++i)
+        out_formats[i] = uniq[(size_t)i];
+    return n;
+}
+
+V4L2Provider::V4L2Provider() = default;
+
+V4L2Provider::~V4L2Provider()
+{
+    close();
+}
+
+bool V4L2Provider::enumerate(std::vector<gcap_device_info_t> &list)
+{
+    list.clear();
+    const std::vector<Node> nodes = list_nodes();
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const Node &n = nodes[i];
+        gcap_device_info_t d{};
+        d.index = (int)i;
+        std::snprintf(d.name, sizeof(d.name), "%s", (const char *)n.cap.card);
+        std::snprintf(d.symbolic_link, sizeof(d.symbolic_link), "%s", n.path.c_str());
+        v4l2_capability cap;
+        const int fd = open_node(n.path.c_str(), cap);
+        if (fd >= 0)
+        {
+            for (uint32_t fourcc : device_formats(fd))
+            {
+                gcap_pixfmt_t fmt;
+                if (to_pixfmt(fourcc, fmt) && is_10bit(fmt))
+                    d.caps |= 1u << 2;
+            }
+            io().close(fd);
+        }
+        list.push_back(d);
+    }
+    return true;
+}
+
+bool V4L2Provider::open(int index)
+{
+    if (running_)
+        return false;
+    close();
+
+    Node node;
+    const int fd = open_by_index(index, node);
+    if (fd < 0)
+    {
+        emitError(GCAP_ENODEV, "[V4L2] no capture device at that index");
+        return false;
+    }
+    fd_ = fd;
+    path_ = node.path;
+    card_ = (const char *)node.cap.card;
+    driver_ = (const char *)node.cap.driver;
+    bus_info_ = (const char *)node.cap.bus_info;
+    driver_version_ = node.cap.version;
+
+    // What the device is set to now, for getSignalStatus() before start().
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    gcap_pixfmt_t pf;
+    if (xioctl(fd_, VIDIOC_G_FMT, &fmt) == 0 && to_pixfmt(fmt.fmt.pix.pixelformat, pf))
+    {
+        fourcc_ = fmt.fmt.pix.pixelformat;
+        format_ = pf;
+        width_ = (int)fmt.fmt.pix.width;
+        height_ = (int)fmt.fmt.pix.height;
+        colorimetry(fmt.fmt.pix, csp_, range_);
+    }
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator)
+    {
+        fps_num_ = (int)parm.parm.capture.timeperframe.denominator;
+        fps_den_ = (int)parm.parm.capture.timeperframe.numerator;
+    }
+    return true;
+}
+
+bool V4L2Provider::setProfile(const gcap_profile_t &p)
+{
+    if (running_)
+        return false;
+    if (p.mode == GCAP_PROFILE_CUSTOM)
+    {
+        bool mapped = false;
+        for (const FormatMap &m : kFormats)
+            mapped = mapped || m.format == p.format;
+        if (!mapped || p.width <= 0 || p.height <= 0)
+            return false;
+    }
+    // Negotiated with the driver by start().
+    profile_ = p;
+    return true;
+}
+
+// The driver's buffers: the pool sized by CaptureManager::setBuffersEx() only holds
+// converted frames.
+bool V4L2Provider::setBuffers(int count, size_t bytes_hint)
+{
+    (void)bytes_hint;
+    buffer_count_ = count;
+    return true;
+}
+
+bool V4L2Provider::negotiate()
+{
+    char msg[256];
+    const std::vector<uint32_t> offered = device_formats(fd_);
+    auto pick = [&](gcap_pixfmt_t want) -> uint32_t
+    {
+        for (const FormatMap &m : kFormats)
+            if (m.format == want && std::find(offered.begin(), offered.end(), m.fourcc) != offered.end())
+                return m.fourcc;
+        return 0;
+    };
+
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_G_FMT, &fmt) < 0)
+    {
+        emitError(GCAP_EIO, "[V4L2] VIDIOC_G_FMT failed");
+        return false;
+    }
+
+    uint32_t fourcc = 0;
+    gcap_pixfmt_t cur;
+    if (profile_.mode == GCAP_PROFILE_CUSTOM)
+    {
+        fourcc = pick(profile_.format);
+        if (!fourcc)
+        {
+            std::snprintf(msg, sizeof(msg), "[V4L2] %s does not offer %s", card_.c_str(), pixfmt_name(profile_.format));
+            emitError(GCAP_EINVAL, msg);
+            return false;
+        }
+        fmt.fmt.pix.width = (uint32_t)profile_.width;
+        fmt.fmt.pix.height = (uint32_t)profile_.height;
+    }
+    else
+    {
+        fourcc = pick(preferred_);
+        if (!fourcc && to_pixfmt(fmt.fmt.pix.pixelformat, cur))
+            fourcc = fmt.fmt.pix.pixelformat;
+        if (!fourcc && !offered.empty())
+            fourcc = offered.front();
+        if (!fourcc)
+        {
+            std::snprintf(msg, sizeof(msg), "[V4L2] %s offers no NV12 / YUYV / P010 / Y210 / 32-bit RGB format",
+                          card_.c_str());
+            emitError(GCAP_EINVAL, msg);
+            return false;
+        }
+    }
+    fmt.fmt.pix.pixelformat = fourcc;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix.bytesperline = 0; // driver's choice
+    fmt.fmt.pix.sizeimage = 0;
+    if (xioctl(fd_, VIDIOC_S_FMT, &fmt) < 0)
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] VIDIOC_S_FMT failed: %s", std::strerror(errno));
+        emitError(GCAP_EIO, msg);
+        return false;
+    }
+
+    const v4l2_pix_format &pix = fmt.fmt.pix;
+    gcap_pixfmt_t pf;
+    if (pix.pixelformat != fourcc || !to_pixfmt(pix.pixelformat, pf))
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] driver switched %s to %s", fourcc_name(fourcc).s,
+                      fourcc_name(pix.pixelformat).s);
+        emitError(GCAP_EINVAL, msg);
+        return false;
+    }
+    const int w = (int)pix.width, h = (int)pix.height;
+    const bool planar = is_planar(pf);
+    if (w <= 0 || h <= 0 || (pf != GCAP_FMT_ARGB && (w & 1)) || (planar && (h & 1)))
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] unusable frame size %dx%d for %s", w, h, pixfmt_name(pf));
+        emitError(GCAP_EINVAL, msg);
+        return false;
+    }
+    const int bpl = std::max((int)pix.bytesperline, w * bytes_per_pixel(pf));
+    const size_t image = (size_t)bpl * (size_t)(h + (planar ? h / 2 : 0));
+    if (pix.sizeimage && pix.sizeimage < image)
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] driver frame of %u bytes is smaller than %dx%d %s", pix.sizeimage, w, h,
+                      pixfmt_name(pf));
+        emitError(GCAP_EINVAL, msg);
+        return false;
+    }
+    if (profile_.mode == GCAP_PROFILE_CUSTOM && (w != profile_.width || h != profile_.height))
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] driver adjusted %dx%d to %dx%d", profile_.width, profile_.height, w, h);
+        emitError(GCAP_OK, msg);
+    }
+
+    fourcc_ = fourcc;
+    format_ = pf;
+    width_ = w;
+    height_ = h;
+    bytes_per_line_ = bpl;
+    image_bytes_ = image;
+    colorimetry(pix, csp_, range_);
+
+    // Frame rate, where the driver lets us pick it.
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fps_num_ = 0;
+    fps_den_ = 1;
+    if (xioctl(fd_, VIDIOC_G_PARM, &parm) == 0)
+    {
+        timeperframe_ = (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) != 0;
+        if (timeperframe_ && profile_.mode == GCAP_PROFILE_CUSTOM && profile_.fps_num > 0 && profile_.fps_den > 0)
+        {
+            parm.parm.capture.timeperframe.numerator = (uint32_t)profile_.fps_den;
+            parm.parm.capture.timeperframe.denominator = (uint32_t)profile_.fps_num;
+            if (xioctl(fd_, VIDIOC_S_PARM, &parm) < 0)
+                xioctl(fd_, VIDIOC_G_PARM, &parm);
+        }
+        const v4l2_fract &tpf = parm.parm.capture.timeperframe;
+        if (tpf.numerator && tpf.denominator)
+        {
+            fps_num_ = (int)tpf.denominator;
+            fps_den_ = (int)tpf.numerator;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    layout_ = layout_of(format_);
+    rebuildConverterLocked();
+    return true;
+}
+
+bool V4L2Provider::mapBuffers()
+{
+    char msg[160];
+    v4l2_requestbuffers req{};
+    req.count = (uint32_t)(buffer_count_ > 0 ? std::clamp(buffer_count_, kMinBuffers, kMaxBuffers) : kDefaultBuffers);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd_, VIDIOC_REQBUFS, &req) < 0)
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] VIDIOC_REQBUFS failed: %s", std::strerror(errno));
+        emitError(GCAP_EIO, msg);
+        return false;
+    }
+    // The driver may round the count up to its minimum; fewer than two cannot stream.
+    buffers_.resize(req.count);
+    bool ok = req.count >= (uint32_t)kMinBuffers;
+    for (uint32_t i = 0; ok && i < req.count; ++i)
+    {
+        v4l2_buffer b{};
+        b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        b.memory = V4L2_MEMORY_MMAP;
+        b.index = i;
+        if (xioctl(fd_, VIDIOC_QUERYBUF, &b) < 0 || b.length < image_bytes_)
+        {
+            ok = false;
+            break;
+        }
+        void *p = io().mmap(b.length, fd_, (int64_t)b.m.offset);
+        if (p == MAP_FAILED)
+        {
+            ok = false;
+            break;
+        }
+        buffers_[i].data = p;
+        buffers_[i].length = b.length;
+    }
+    for (uint32_t i = 0; ok && i < req.count; ++i)
+        ok = requeue(i);
+    if (!ok)
+    {
+        std::snprintf(msg, sizeof(msg), "[V4L2] cannot map %u driver buffers: %s", req.count, std::strerror(errno));
+        emitError(GCAP_EIO, msg);
+        unmapBuffers();
+    }
+    return ok;
+}
+
+void V4L2Provider::unmapBuffers()
+{
+    for (Buffer &b : buffers_)
+        if (b.data)
+            io().munmap(b.data, b.length);
+    buffers_.clear();
+    v4l2_requestbuffers req{};
+    req.count = 0;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    xioctl(fd_, VIDIOC_REQBUFS, &req);
+}
+
+bool V4L2Provider::requeue(uint32_t index)
+{
+    v4l2_buffer b{};
+    b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    b.memory = V4L2_MEMORY_MMAP;
+    b.index = index;
+    return xioctl(fd_, VIDIOC_QBUF, &b) == 0;
+}
+
+bool V4L2Provider::start()
+{
+    if (fd_ < 0)
+        return false;
+    if (running_)
+        return true;
+    if (!negotiate() || !mapBuffers())
+        return false;
+
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_STREAMON, &type) < 0)
+    {
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "[V4L2] VIDIOC_STREAMON failed: %s", std::strerror(errno));
+        emitError(GCAP_EIO, msg);
+        unmapBuffers();
+        return false;
+    }
+
+    gcap::FrameConverter cv;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        cv = converter_;
+    }
+    clock_.reset(fps_num_, fps_den_);
+    frame_id_ = 0;
+
+    char msg[320];
+    std::snprintf(msg, sizeof(msg), "[V4L2] %s (%s) %dx%d %s (%s) @ %d/%d, %zu mmap buffers, converter=%s, out=%s",
+                  path_.c_str(), card_.c_str(), width_, height_, pixfmt_name(format_), fourcc_name(fourcc_).s, fps_num_,
+                  fps_den_, buffers_.size(), gcap::converter_kernel_name(),
+                  format_ == GCAP_FMT_ARGB ? "ARGB (passthrough)" : gcap::frame_output_name(cv.output));
+    emitError(GCAP_OK, msg);
+
+    running_ = true;
+    th_ = std::thread([this]
+                      { loop(); });
+    return true;
+}
+
+void V4L2Provider::stop()
+{
+    running_ = false;
+    if (th_.joinable())
+        th_.join();
+    if (!buffers_.empty())
+    {
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd_, VIDIOC_STREAMOFF, &type);
+        unmapBuffers();
+    }
+}
+
+void V4L2Provider::close()
+{
+    stop();
+    if (fd_ >= 0)
+        io().close(fd_);
+    fd_ = -1;
+    width_ = height_ = 0;
+}
+
+void V4L2Provider::setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    vcb_ = vcb;
+    ecb_ = ecb;
+    user_ = user;
+}
+
+void V4L2Provider::setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    pcb_ = pcb;
+    user_ = user;
+}
+
+void V4L2Provider::setVideoOutput(const gcap_video_output_t &out)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    video_output_ = out;
+}
+
+void V4L2Provider::setFramePool(gcap::FramePool *pool)
+{
+    frame_pool_ = pool;
+}
+
+// One thread dequeues, converts and calls back, so it takes the Capture shard.
+void V4L2Provider::setStats(gcap::CaptureStats *stats)
+{
+    stats_ = stats ? &stats->shard(gcap::CaptureStats::Thread::Capture) : nullptr;
+}
+
+bool V4L2Provider::getDeviceProps(gcap_device_props_t &out)
+{
+    if (fd_ < 0)
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    std::snprintf(out.driver_version, sizeof(out.driver_version), "%s %u.%u.%u", driver_.c_str(),
+                  driver_version_ >> 16, (driver_version_ >> 8) & 0xff, driver_version_ & 0xff);
+    std::snprintf(out.serial_number, sizeof(out.serial_number), "%s", bus_info_.c_str());
+    out.input = GCAP_INPUT_UNKNOWN;
+    out.hdcp = -1;
+    return true;
+}
+
+bool V4L2Provider::getSignalStatus(gcap_signal_status_t &out)
+{
+    if (fd_ < 0 || width_ <= 0)
+        return false;
+    std::memset(&out, 0, sizeof(out));
+    out.width = width_;
+    out.height = height_;
+    out.fps_num = fps_num_;
+    out.fps_den = fps_den_;
+    out.pixfmt = format_;
+    out.bit_depth = is_10bit(format_) ? 10 : 8;
+    out.csp = csp_;
+    out.range = range_;
+    out.hdr = -1;
+    return true;
+}
+
+bool V4L2Provider::getRuntimeInfo(gcap_runtime_info_t &out)
+{
+    std::memset(&out, 0, sizeof(out));
+    if (!getSignalStatus(out.signal))
+        return false;
+    out.signal_probe = out.signal;
+    out.negotiated = out.signal;
+    gcap::fill_clock_runtime_info(out, clock_.stats());
+
+    gcap::FrameOutput output;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        output = converter_.output;
+    }
+    out.active_backend = GCAP_BACKEND_V4L2;
+    std::snprintf(out.backend_name, sizeof(out.backend_name), "V4L2");
+    std::snprintf(out.frame_source, sizeof(out.frame_source), "MMAP x%zu", buffers_.size());
+    std::snprintf(out.path_name, sizeof(out.path_name), "V4L2 CPU");
+    std::snprintf(out.source_format, sizeof(out.source_format), "%s", fourcc_name(fourcc_).s);
+    std::snprintf(out.render_format, sizeof(out.render_format), "%s CPU",
+                  format_ == GCAP_FMT_ARGB ? "ARGB" : gcap::frame_output_name(output));
+    std::snprintf(out.input_signal_desc, sizeof(out.input_signal_desc), "%s %s / %d-bit", card_.c_str(),
+                  pixfmt_name(format_), out.signal.bit_depth);
+    std::snprintf(out.input_signal_note, sizeof(out.input_signal_note), "%s", driver_.c_str());
+    std::snprintf(out.negotiated_desc, sizeof(out.negotiated_desc), "%s %dx%d", fourcc_name(fourcc_).s, width_,
+                  height_);
+    return true;
+}
+
+bool V4L2Provider::setProcessing(const gcap_processing_opts_t &opts)
+{
+    bool mapped = false;
+    for (const FormatMap &m : kFormats)
+        mapped = mapped || m.format == opts.preferred_pixfmt;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (mapped)
+            preferred_ = opts.preferred_pixfmt;
+        force_range_ = opts.force_range;
+        switch (opts.cpu_output)
+        {
+        case GCAP_CPU_OUT_ARGB_DITHER:
+            cpu_output_ = gcap::FrameOutput::Bgra8Dither;
+            break;
+        case GCAP_CPU_OUT_RGBA64:
+            cpu_output_ = gcap::FrameOutput::Rgba64;
+            break;
+        case GCAP_CPU_OUT_X2R10G10B10:
+            cpu_output_ = gcap::FrameOutput::X2R10G10B10;
+            break;
+        default:
+            cpu_output_ = gcap::FrameOutput::Bgra8;
+            break;
+        }
+        rebuildConverterLocked();
+    }
+    // preferred_pixfmt picks the format of DEVICE_DEFAULT profiles from the next start().
+    return mapped && opts.deinterlace == GCAP_DEINT_AUTO;
+}
+
+bool V4L2Provider::setProcAmp(const gcap_procamp_t &p)
+{
+    auto clamp255 = [](int v) -> int
+    { return std::clamp(v, 0, 255); };
+
+    gcap::ProcAmpParams pp;
+    pp.brightness = clamp255(p.brightness);
+    pp.contrast = clamp255(p.contrast);
+    pp.hue = clamp255(p.hue);
+    pp.saturation = clamp255(p.saturation);
+    pp.sharpness = clamp255(p.sharpness);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    procamp_params_ = pp;
+    rebuildConverterLocked();
+    return true;
+}
+
+void V4L2Provider::rebuildConverterLocked()
+{
+    const gcap_range_t range = force_range_ != GCAP_RANGE_UNKNOWN ? force_range_ : range_;
+    converter_ = gcap::make_frame_converter(layout_, csp_, range, procamp_params_, cpu_output_);
+}
+
+void V4L2Provider::emitError(gcap_status_t c, const char *msg)
+{
+    gcap_on_error_cb ecb;
+    void *user;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        ecb = ecb_;
+        user = user_;
+    }
+    if (ecb)
+        ecb(c, msg, user);
+}
+
+// Output memory for one frame: a pool slot the callbacks can retain, or the scratch
+// vector when every slot is retained (nullptr under GCAP_LEASE_POLICY_SKIP).
+uint8_t *V4L2Provider::outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes)
+{
+    if (frame_pool_)
+    {
+        lease = frame_pool_->acquire(bytes);
+        if (lease)
+            return lease.data();
+        if (frame_pool_->policy() == GCAP_LEASE_POLICY_SKIP)
+            return nullptr;
+    }
+    if (scratch.size() < bytes)
+        scratch.resize(bytes);
+    return scratch.data();
+}
+
+// Converts for the video callback, resizing in the same pass when an output size is
+// set. ARGB sources are handed over in the driver buffer, at their own size.
+void V4L2Provider::deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, gcap_on_video_cb vcb,
+                                void *user, const uint8_t *src, gcap_frame_t &f)
+{
+    const int w = width_, h = height_;
+    if (format_ == GCAP_FMT_ARGB)
+    {
+        f.format = GCAP_FMT_ARGB;
+        f.plane_count = 1;
+        f.width = w;
+        f.height = h;
+        f.data[0] = src;
+        f.stride[0] = bytes_per_line_;
+        f.lease = nullptr;
+        GCAP_TRACE_SCOPE(Callback, f.frame_id);
+        vcb(&f, user);
+        return;
+    }
+
+    int dw = w, dh = h;
+    const bool scaled = gcap::scale_supported(cv.layout) && gcap::video_output_size(vo, w, h, dw, dh);
+    if (scaled && (scale_plan_.layout != cv.layout || scale_plan_.src_width != w || scale_plan_.src_height != h ||
+                   scale_plan_.dst_width != dw || scale_plan_.dst_height != dh || scale_filter_ != vo.filter))
+    {
+        scale_plan_ = gcap::make_scale_plan(cv.layout, w, h, dw, dh, vo.filter);
+        scale_filter_ = vo.filter;
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "[V4L2] CPU video output %dx%d -> %dx%d (%s)", w, h, dw, dh,
+                      scale_plan_.filter == GCAP_SCALE_BOX ? "box" : "bilinear");
+        emitError(GCAP_OK, msg);
+    }
+    if (!scaled)
+        dw = w, dh = h;
+
+    const int outStride = gcap::aligned_row_bytes(dw * gcap::frame_output_bytes_per_pixel(cv.output));
+    gcap::FrameLease lease;
+    uint8_t *out = outputBuffer(lease, scaled ? cpu_scaled_ : cpu_out_, (size_t)outStride * (size_t)dh);
+    if (!out)
+        return;
+    {
+        GCAP_TRACE_SCOPE(Convert, f.frame_id);
+        const uint64_t t0 = stats_ ? steady_now_ns() : 0;
+        const int bpl = bytes_per_line_;
+        const uint8_t *uv = is_planar(format_) ? src + (size_t)bpl * h : nullptr;
+        if (scaled)
+            gcap::convert_frame_scaled(cv, scale_plan_, src, uv, bpl, bpl, out, outStride);
+        else
+            gcap::convert_frame(cv, src, uv, bpl, bpl, w, h, out, outStride);
+        if (stats_)
+            stats_->record(gcap::StatHist::Convert, steady_now_ns() - t0);
+    }
+
+    f.format = gcap::frame_output_pixfmt(cv.output);
+    f.plane_count = 1;
+    f.width = dw;
+    f.height = dh;
+    f.data[0] = out;
+    f.stride[0] = outStride;
+    f.lease = nullptr;
+    if (lease)
+        lease.attach(f);
+    GCAP_TRACE_SCOPE(Callback, f.frame_id);
+    vcb(&f, user);
+}
+
+void V4L2Provider::loop()
+{
+    GCAP_TRACE_THREAD_NAME("v4l2");
+    char msg[160];
+    uint64_t lastFrameNs = steady_now_ns();
+    bool stalled = false;
+    int ioErrors = 0;
+    bool haveSeq = false;
+    bool seqCounts = false; // the driver's sequence numbers advance
+    uint32_t nextSeq = 0;
+
+    while (running_)
+    {
+        pollfd pfd{fd_, POLLIN, 0};
+        const int r = io().poll(&pfd, kPollMs);
+        if (r < 0 && errno != EINTR)
+        {
+            std::snprintf(msg, sizeof(msg), "[V4L2] poll failed: %s", std::strerror(errno));
+            emitError(GCAP_EIO, msg);
+            break;
+        }
+        if (r <= 0 || !(pfd.revents & (POLLIN | POLLERR)))
+        {
+            if (!stalled && steady_now_ns() - lastFrameNs >= kStallNs)
+            {
+                stalled = true;
+                emitError(GCAP_OK, "[V4L2] no frames for 1 s (no signal?)");
+            }
+            continue;
+        }
+
+        v4l2_buffer b{};
+        b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        b.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd_, VIDIOC_DQBUF, &b) < 0)
+        {
+            // EIO is transient (signal loss) unless it keeps coming; anything else
+            // (ENODEV on unplug) ends the stream.
+            if (errno == EAGAIN || (errno == EIO && ++ioErrors < kMaxIoErrors))
+                continue;
+            std::snprintf(msg, sizeof(msg), "[V4L2] device lost (VIDIOC_DQBUF: %s)", std::strerror(errno));
+            emitError(GCAP_EIO, msg);
+            break;
+        }
+        ioErrors = 0;
+        const uint64_t hostNs = steady_now_ns();
+        lastFrameNs = hostNs;
+        stalled = false;
+        if (b.index >= buffers_.size())
+            continue;
+        // Corrupt or short frames go straight back; the timestamp gap counts them as dropped.
+        if ((b.flags & V4L2_BUF_FLAG_ERROR) || (b.bytesused && b.bytesused < image_bytes_))
+        {
+            if (!requeue(b.index))
+                break;
+            continue;
+        }
+
+        {
+            int64_t deviceNs = -1;
+            if ((b.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+                deviceNs = (int64_t)b.timestamp.tv_sec * 1000000000 + (int64_t)b.timestamp.tv_usec * 1000;
+            gcap::ClockRecovery::Gap gap;
+            const uint64_t ptsSmoothedNs = clock_.update(deviceNs, hostNs, &gap);
+            // The driver's sequence numbers, where they advance, count drops exactly and
+            // on the frame after them; the timestamp gaps are the fallback.
+            uint64_t dropped = gap.dropped;
+            seqCounts = seqCounts || (haveSeq && b.sequence >= nextSeq);
+            if (seqCounts)
+                dropped = haveSeq && b.sequence > nextSeq ? b.sequence - nextSeq : 0;
+            haveSeq = true;
+            nextSeq = b.sequence + 1;
+            if (stats_)
+            {
+                stats_->arrived(hostNs);
+                stats_->add(gcap::StatCounter::FramesDropped, dropped);
+                stats_->add(gcap::StatCounter::FramesDuplicated, gap.duplicated);
+            }
+            // CLOCK_MONOTONIC timestamps are already on the host steady clock.
+            const uint64_t ptsNs = deviceNs >= 0 ? (uint64_t)deviceNs : hostNs;
+
+            const uint64_t frameId = ++frame_id_;
+            StatsFrameScope statsFrame{stats_};
+
+            gcap_on_video_cb vcb;
+            gcap_on_frame_packet_cb pcb;
+            void *user;
+            gcap::FrameConverter cv;
+            gcap_video_output_t vo;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                vcb = vcb_;
+                pcb = pcb_;
+                user = user_;
+                cv = converter_;
+                vo = video_output_;
+            }
+
+            const uint8_t *src = (const uint8_t *)buffers_[b.index].data;
+            if (pcb)
+            {
+                gcap_frame_packet_t pkt{};
+                pkt.width = width_;
+                pkt.height = height_;
+                pkt.format = format_;
+                pkt.plane_count = is_planar(format_) ? 2 : 1;
+                pkt.data[0] = src;
+                pkt.stride[0] = bytes_per_line_;
+                if (pkt.plane_count == 2)
+                {
+                    pkt.data[1] = src + (size_t)bytes_per_line_ * height_;
+                    pkt.stride[1] = bytes_per_line_;
+                }
+                pkt.pts_ns = ptsNs;
+                pkt.pts_smoothed_ns = ptsSmoothedNs;
+                pkt.frame_id = frameId;
+                pkt.backend = GCAP_BACKEND_V4L2;
+                pkt.source_kind = GCAP_SOURCE_V4L2_MMAP;
+                pkt.gpu_backed = 0;
+                GCAP_TRACE_SCOPE(Callback, frameId);
+                pcb(&pkt, user);
+            }
+
+            if (vcb)
+            {
+                gcap_frame_t f{};
+                f.pts_ns = ptsNs;
+                f.frame_id = frameId;
+                deliverVideo(cv, vo, vcb, user, src, f);
+            }
+        }
+
+        if (!requeue(b.index))
+        {
+            std::snprintf(msg, sizeof(msg), "[V4L2] device lost (VIDIOC_QBUF: %s)", std::strerror(errno));
+            emitError(GCAP_EIO, msg);
+            break;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// v4l2_provider.h
+// GCAP_BACKEND_V4L2: Video4Linux2 capture devices (/dev/video*), mmap streaming.
+// Linux only (GCAP_LINUX_V4L2).
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gcapture.h"
+#include "../core/capture_manager.h"
+#include "../core/clock_recovery.h"
+#include "../core/frame_converter.h"
+#include "../core/frame_pool.h"
+
+struct pollfd;
+
+namespace gcap
+{
+    class StatsShard;
+}
+
+/**
+ * The device calls the provider makes, so it can run against a fake driver.
+ * Same contract as the system calls (-1 and errno on failure); mmap maps
+ * read/write, MAP_SHARED, and returns MAP_FAILED on failure.
+ */
+struct V4l2Io
+{
+    int (*open)(const char *path, int flags);
+    int (*close)(int fd);
+    int (*ioctl)(int fd, unsigned long request, void *arg);
+    void *(*mmap)(size_t length, int fd, int64_t offset);
+    int (*munmap)(void *addr, size_t length);
+    int (*poll)(struct pollfd *pfd, int timeoutMs);
+};
+
+int v4l2_enum_video_caps_by_index(int device_index, gcap_video_cap_t *out_caps, int max_caps);
+int v4l2_enum_supported_pixel_formats_by_index(int device_index, gcap_pixfmt_t *out_formats, int max_formats);
+
+/**
+ * Capture nodes are probed as /dev/video0../dev/video63; metadata and output
+ * nodes are skipped, as are devices without streaming I/O. Single-planar
+ * buffers only (V4L2_BUF_TYPE_VIDEO_CAPTURE).
+ *
+ * start() negotiates the format (VIDIOC_S_FMT / VIDIOC_S_PARM), then maps the
+ * gcap_set_buffers count of driver buffers (VIDIOC_REQBUFS, V4L2_MEMORY_MMAP).
+ * The frame thread waits in poll() and dequeues one buffer per frame: packets
+ * point into the driver buffer, which goes back to the driver once the
+ * callbacks return, so nothing is copied before the packet callback. The video
+ * callback converts from the driver buffer (ARGB sources are passed through).
+ */
+class V4L2Provider : public ICaptureProvider
+{
+public:
+    V4L2Provider();
+    ~V4L2Provider() override;
+
+    // Replaces the device calls process-wide (nullptr = the kernel). For tests;
+    // set before any device is opened.
+    static void setIo(const V4l2Io *io);
+
+    bool enumerate(std::vector<gcap_device_info_t> &list) override;
+    bool open(int index) override;
+    bool setProfile(const gcap_profile_t &p) override;
+    bool setBuffers(int count, size_t bytes_hint) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+
+    void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user) override;
+    void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override;
+    void setVideoOutput(const gcap_video_output_t &out) override;
+    void setFramePool(gcap::FramePool *pool) override;
+    void setStats(gcap::CaptureStats *stats) override;
+
+    bool getDeviceProps(gcap_device_props_t &out) override;
+    bool getSignalStatus(gcap_signal_status_t &out) override;
+    bool getRuntimeInfo(gcap_runtime_info_t &out) override;
+    bool setProcessing(const gcap_processing_opts_t &opts) override;
+    bool setProcAmp(const gcap_procamp_t &p) override;
+
+private:
+    struct Buffer
+    {
+        void *data = nullptr;
+        size_t length = 0;
+    };
+
+    void loop();
+    bool negotiate();     // VIDIOC_S_FMT / VIDIOC_S_PARM from the profile
+    bool mapBuffers();    // VIDIOC_REQBUFS, VIDIOC_QUERYBUF, mmap, VIDIOC_QBUF
+    void unmapBuffers();  // munmap and VIDIOC_REQBUFS(0)
+    bool requeue(uint32_t index);
+    void deliverVideo(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, gcap_on_video_cb vcb,
+                      void *user, const uint8_t *src, gcap_frame_t &f);
+    uint8_t *outputBuffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes);
+    void rebuildConverterLocked();
+    void emitError(gcap_status_t c, const char *msg);
+
+    // Guards the callbacks, the converter and the video output size; the frame
+    // loop copies them once per frame.
+    std::mutex mtx_;
+    gcap_on_video_cb vcb_ = nullptr;
+    gcap_on_frame_packet_cb pcb_ = nullptr;
+    gcap_on_error_cb ecb_ = nullptr;
+    void *user_ = nullptr;
+    gcap_video_output_t video_output_{};
+    gcap::ProcAmpParams procamp_params_;
+    gcap_range_t force_range_ = GCAP_RANGE_UNKNOWN;
+    gcap::FrameOutput cpu_output_ = gcap::FrameOutput::Bgra8;
+    gcap::FrameConverter converter_;
+
+    int fd_ = -1;
+    std::string path_;
+    std::string card_, driver_, bus_info_;
+    uint32_t driver_version_ = 0;
+    bool timeperframe_ = false; // V4L2_CAP_TIMEPERFRAME
+    gcap_profile_t profile_{};
+    gcap_pixfmt_t preferred_ = GCAP_FMT_NV12; // DEVICE_DEFAULT profile, when the device offers it
+    int buffer_count_ = 0;                    // gcap_set_buffers; 0 = default
+
+    // Negotiated by start().
+    uint32_t fourcc_ = 0;
+    int width_ = 0, height_ = 0;
+    gcap_pixfmt_t format_ = GCAP_FMT_NV12;
+    gcap::YuvLayout layout_ = gcap::YuvLayout::Nv12;
+    int bytes_per_line_ = 0;
+    size_t image_bytes_ = 0; // one frame at bytes_per_line_
+    int fps_num_ = 0, fps_den_ = 1;
+    gcap_colorspace_t csp_ = GCAP_CSP_BT709;
+    gcap_range_t range_ = GCAP_RANGE_LIMITED;
+    std::vector<Buffer> buffers_;
+
+    std::atomic<bool> running_{false};
+    std::thread th_;
+    uint64_t frame_id_ = 0;
+    gcap::ClockRecovery clock_;
+
+    gcap::FramePool *frame_pool_ = nullptr; // owned by CaptureManager
+    gcap::StatsShard *stats_ = nullptr;     // frame thread's shard (owned by CaptureManager)
+    std::vector<uint8_t> cpu_out_;          // converter output when the pool is exhausted
+    std::vector<uint8_t> cpu_scaled_;
+    gcap::ScalePlan scale_plan_;
+    gcap_scale_filter_t scale_filter_ = GCAP_SCALE_AUTO;
+};
@@ -6,6 +6,8 @@
 #include "dshow_signal_probe.h"
 #include "../pipeline/shared_scene_pipeline.h"
 #include "mf_recorder.h"
+#include "../core/capture_stats.h"
+#include "../core/trace.h"
 #include <mferror.h>
 #include <cassert>
 #include <chrono>
@@ -46,6 +48,7 @@ namespace
 }
 #pragma comment(lib, "setupapi.lib")
 #include "../core/frame_converter.h"
+#include "../core/convert_pool.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -656,7 +659,7 @@ bool WinMFProvider::getRuntimeInfo(gcap_runtime_info_t &out)
     out.negotiated.hdr = -1;
 
     const bool gpu = (use_dxgi_ && !cpu_path_);
-    out.runtime_fps = fps_avg_;
+    gcap::fill_clock_runtime_info(out, clock_.stats());
     out.active_backend = gpu ? GCAP_BACKEND_WINMF_GPU : GCAP_BACKEND_WINMF_CPU;
     strcpy_s(out.backend_name, gpu ? "WinMF GPU" : "WinMF CPU");
     strcpy_s(out.frame_source, gpu ? "DXGI" : "CPU");
@@ -669,9 +672,28 @@ bool WinMFProvider::getRuntimeInfo(gcap_runtime_info_t &out)
 
 bool WinMFProvider::setProcessing(const gcap_processing_opts_t &opts)
 {
-    (void)opts;
-    // 先回不支援：等你要做「切 NV12/YUY2/P010 / Deinterlace」再補 setProfile / rebuild reader
-    return false;
+    {
+        std::lock_guard<std::mutex> lk(cpu_converter_mtx_);
+        force_range_ = opts.force_range;
+        switch (opts.cpu_output)
+        {
+        case GCAP_CPU_OUT_ARGB_DITHER:
+            cpu_output_ = gcap::FrameOutput::Bgra8Dither;
+            break;
+        case GCAP_CPU_OUT_RGBA64:
+            cpu_output_ = gcap::FrameOutput::Rgba64;
+            break;
+        case GCAP_CPU_OUT_X2R10G10B10:
+            cpu_output_ = gcap::FrameOutput::X2R10G10B10;
+            break;
+        default:
+            cpu_output_ = gcap::FrameOutput::Bgra8;
+            break;
+        }
+        rebuild_cpu_converter_locked();
+    }
+    // 切 NV12/YUY2/P010 / Deinterlace 還不支援（需 setProfile / rebuild reader）；只有 force_range / cpu_output 生效。
+    return opts.preferred_pixfmt == GCAP_FMT_NV12 && opts.deinterlace == GCAP_DEINT_AUTO;
 }
 
 bool WinMFProvider::setProcAmp(const gcap_procamp_t &p)
@@ -685,9 +707,99 @@ bool WinMFProvider::setProcAmp(const gcap_procamp_t &p)
     procamp_.hue = clamp255(p.hue);
     procamp_.saturation = clamp255(p.saturation);
     procamp_.sharpness = clamp255(p.sharpness);
+
+    // Compile the CPU-path plan here so the capture loop never does trig/float per frame.
+    gcap::ProcAmpParams pp;
+    pp.brightness = procamp_.brightness;
+    pp.contrast = procamp_.contrast;
+    pp.hue = procamp_.hue;
+    pp.saturation = procamp_.saturation;
+    pp.sharpness = procamp_.sharpness;
+    {
+        std::lock_guard<std::mutex> lk(cpu_converter_mtx_);
+        procamp_params_ = pp;
+        rebuild_cpu_converter_locked();
+    }
     return true;
 }
 
+// Colorimetry signalled on the media type; UNKNOWN when the attribute is absent.
+static void mf_colorimetry(IMFMediaType *mt, gcap_colorspace_t &csp, gcap_range_t &range)
+{
+    csp = GCAP_CSP_UNKNOWN;
+    range = GCAP_RANGE_UNKNOWN;
+    if (!mt)
+        return;
+
+    UINT32 v = 0;
+    if (SUCCEEDED(mt->GetUINT32(MF_MT_YUV_MATRIX, &v)))
+    {
+        if (v == MFVideoTransferMatrix_BT601)
+            csp = GCAP_CSP_BT601;
+        else if (v == MFVideoTransferMatrix_BT709)
+            csp = GCAP_CSP_BT709;
+        else if (v == MFVideoTransferMatrix_BT2020_10 || v == MFVideoTransferMatrix_BT2020_12)
+            csp = GCAP_CSP_BT2020;
+    }
+    if (SUCCEEDED(mt->GetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, &v)))
+    {
+        if (v == MFNominalRange_16_235)
+            range = GCAP_RANGE_LIMITED;
+        else if (v == MFNominalRange_0_255)
+            range = GCAP_RANGE_FULL;
+    }
+}
+
+// Called whenever the negotiated media type changes (open / CURRENTMEDIATYPECHANGED):
+// resolves colorimetry and the converter specialisation once, outside the frame loop.
+void WinMFProvider::select_cpu_converter()
+{
+    gcap_colorspace_t csp = GCAP_CSP_UNKNOWN;
+    gcap_range_t range = GCAP_RANGE_UNKNOWN;
+    if (reader_)
+    {
+        ComPtr<IMFMediaType> cur;
+        if (SUCCEEDED(reader_->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &cur)) && cur)
+            mf_colorimetry(cur.Get(), csp, range);
+    }
+    if (csp == GCAP_CSP_UNKNOWN)
+        csp = gcap::default_colorspace(cur_h_);
+
+    gcap::YuvLayout layout = gcap::YuvLayout::Nv12;
+    if (cur_subtype_ == MFVideoFormat_YUY2)
+        layout = gcap::YuvLayout::Yuy2;
+    else if (cur_subtype_ == MFVideoFormat_Y210)
+        layout = gcap::YuvLayout::Y210;
+    else if (cur_subtype_ == MFVideoFormat_P010)
+        layout = gcap::YuvLayout::P010;
+
+    gcap::FrameConverter cv;
+    {
+        std::lock_guard<std::mutex> lk(cpu_converter_mtx_);
+        src_csp_ = csp;
+        src_range_ = range;
+        cpu_layout_ = layout;
+        rebuild_cpu_converter_locked();
+        cv = cpu_converter_;
+    }
+
+    std::ostringstream oss;
+    oss << "[WinMF] CPU converter: " << gcap::yuv_layout_name(cv.layout)
+        << (cv.csp == GCAP_CSP_BT2020 ? " BT.2020" : cv.csp == GCAP_CSP_BT709 ? " BT.709" : " BT.601")
+        << (cv.range == GCAP_RANGE_FULL ? " full" : " limited")
+        << (range == GCAP_RANGE_UNKNOWN ? " (range assumed)" : "")
+        << ", procamp=" << (cv.plan.color_neutral ? "off" : "on")
+        << ", sharpen=" << (cv.plan.sharpness != 128 ? "on" : "off")
+        << ", out=" << gcap::frame_output_name(cv.output);
+    emit_error(GCAP_OK, oss.str().c_str());
+}
+
+void WinMFProvider::rebuild_cpu_converter_locked()
+{
+    const gcap_range_t range = force_range_ != GCAP_RANGE_UNKNOWN ? force_range_ : src_range_;
+    cpu_converter_ = gcap::make_frame_converter(cpu_layout_, src_csp_, range, procamp_params_, cpu_output_);
+}
+
 // ---- logging helpers (for negotiated media type / stride debug) ----
 static const char *mf_subtype_name(const GUID &g)
 {
@@ -794,6 +906,9 @@ bool WinMFProvider::sync_current_media_type(bool *changed)
     oss << " fps, stride=" << cur_stride_;
     emit_error(GCAP_OK, oss.str().c_str());
 
+    if (cpu_path_)
+        select_cpu_converter();
+
     if (changed)
         *changed = true;
     return true;
@@ -1257,6 +1372,7 @@ bool WinMFProvider::open(int index)
     reader_->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
 
     refresh_signal_probe(true);
+    select_cpu_converter();
 
     OutputDebugStringA("[WinMF] open(): using CPU pipeline\n");
     emit_error(GCAP_OK, "[WinMF] open(): using CPU pipeline");
@@ -1300,6 +1416,7 @@ bool WinMFProvider::setProfile(const gcap_profile_t &p)
 
     return true;
 }
+// Frame memory is the handle's FramePool arena, sized by CaptureManager::setBuffersEx().
 bool WinMFProvider::setBuffers(int, size_t) { return true; }
 
 bool WinMFProvider::start()
@@ -1307,6 +1424,8 @@ bool WinMFProvider::start()
     if (running_)
         return true;
     running_ = true;
+    clock_.reset(cur_fps_num_, cur_fps_den_);
+    pts_smoothed_ns_ = 0;
     start_probe_thread();
     th_ = std::thread(&WinMFProvider::loop, this);
     return true;
@@ -1393,9 +1512,33 @@ void WinMFProvider::setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *us
     user_ = user;
 }
 
+void WinMFProvider::setVideoOutput(const gcap_video_output_t &out)
+{
+    std::lock_guard<std::mutex> lk(cpu_converter_mtx_);
+    video_output_ = out;
+}
+
+void WinMFProvider::setFramePool(gcap::FramePool *pool)
+{
+    frame_pool_ = pool;
+}
+
+// Everything happens on the capture loop, so one shard takes all of it.
+void WinMFProvider::setStats(gcap::CaptureStats *stats)
+{
+    stats_ = stats ? &stats->shard(gcap::CaptureStats::Thread::Capture) : nullptr;
+}
+
+static inline uint64_t steady_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
 static inline void emit_frame_packet_cb(gcap_on_frame_packet_cb pcb, void *user,
                                         int backend, int sourceKind, int gpuBacked,
-                                        const gcap_frame_t &f)
+                                        const gcap_frame_t &f, uint64_t ptsSmoothedNs)
 {
     if (!pcb)
         return;
@@ -1410,13 +1553,118 @@ static inline void emit_frame_packet_cb(gcap_on_frame_packet_cb pcb, void *user,
         pkt.stride[i] = f.stride[i];
     }
     pkt.pts_ns = f.pts_ns;
+    pkt.pts_smoothed_ns = ptsSmoothedNs;
     pkt.frame_id = f.frame_id;
+    pkt.lease = f.lease;
     pkt.backend = backend;
     pkt.source_kind = sourceKind;
     pkt.gpu_backed = gpuBacked;
+    GCAP_TRACE_SCOPE(Callback, pkt.frame_id);
     pcb(&pkt, user);
 }
 
+// CPU path delivery for YUV sources. The packet callback always gets the source-size
+// frame; with a video output size set, the video callback gets a frame converted and
+// resized in one pass, and the full-size conversion is skipped when nobody needs it.
+void WinMFProvider::deliver_cpu_frame(const gcap::FrameConverter &cv, const gcap_video_output_t &vo,
+                                      const uint8_t *src0, const uint8_t *src1, int stride0, int stride1,
+                                      gcap_frame_t &f)
+{
+    const int bpp = gcap::frame_output_bytes_per_pixel(cv.output);
+    f.format = gcap::frame_output_pixfmt(cv.output);
+    f.plane_count = 1;
+
+    int dw = cur_w_, dh = cur_h_;
+    const bool scaled = vcb_ && gcap::scale_supported(cv.layout) && gcap::video_output_size(vo, cur_w_, cur_h_, dw, dh);
+
+    if (pcb_ || (vcb_ && !scaled))
+    {
+        const int outStride = gcap::aligned_row_bytes(cur_w_ * bpp);
+        const size_t needed = (size_t)outStride * (size_t)cur_h_;
+        gcap::FrameLease lease;
+        if (uint8_t *out = cpu_output_buffer(lease, cpu_argb_, needed))
+        {
+            // CPU conversion path supports ProcAmp (Brightness/Contrast/Hue/Saturation/Sharpness)
+            {
+                GCAP_TRACE_SCOPE(Convert, f.frame_id);
+                const uint64_t t0 = stats_ ? steady_now_ns() : 0;
+                gcap::convert_frame(cv, src0, src1, stride0, stride1, cur_w_, cur_h_, out, outStride);
+                if (stats_)
+                    stats_->record(gcap::StatHist::Convert, steady_now_ns() - t0);
+            }
+
+            f.width = cur_w_;
+            f.height = cur_h_;
+            f.data[0] = out;
+            f.stride[0] = outStride;
+            f.lease = nullptr;
+            if (lease)
+                lease.attach(f);
+            emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_CPU, GCAP_SOURCE_WINMF_CPU, 0, f, pts_smoothed_ns_);
+            if (vcb_ && !scaled)
+            {
+                GCAP_TRACE_SCOPE(Callback, f.frame_id);
+                vcb_(&f, user_);
+            }
+        }
+    }
+    if (!scaled)
+        return;
+
+    const gcap::ScalePlan &sp = cpu_scale_plan_;
+    if (sp.layout != cv.layout || sp.src_width != cur_w_ || sp.src_height != cur_h_ ||
+        sp.dst_width != dw || sp.dst_height != dh || cpu_scale_filter_ != vo.filter)
+    {
+        cpu_scale_plan_ = gcap::make_scale_plan(cv.layout, cur_w_, cur_h_, dw, dh, vo.filter);
+        cpu_scale_filter_ = vo.filter;
+        std::ostringstream oss;
+        oss << "[WinMF] CPU video output " << cur_w_ << "x" << cur_h_ << " -> " << dw << "x" << dh
+            << (cpu_scale_plan_.filter == GCAP_SCALE_BOX ? " (box)" : " (bilinear)");
+        emit_error(GCAP_OK, oss.str().c_str());
+    }
+
+    const int outStride = gcap::aligned_row_bytes(dw * bpp);
+    const size_t needed = (size_t)outStride * (size_t)dh;
+    gcap::FrameLease lease;
+    uint8_t *out = cpu_output_buffer(lease, cpu_scaled_, needed);
+    if (!out)
+        return;
+    {
+        GCAP_TRACE_SCOPE(Convert, f.frame_id);
+        const uint64_t t0 = stats_ ? steady_now_ns() : 0;
+        gcap::convert_frame_scaled(cv, cpu_scale_plan_, src0, src1, stride0, stride1, out, outStride);
+        if (stats_)
+            stats_->record(gcap::StatHist::Convert, steady_now_ns() - t0);
+    }
+
+    f.width = dw;
+    f.height = dh;
+    f.data[0] = out;
+    f.stride[0] = outStride;
+    f.lease = nullptr;
+    if (lease)
+        lease.attach(f);
+    GCAP_TRACE_SCOPE(Callback, f.frame_id);
+    vcb_(&f, user_);
+}
+
+// Output memory for one CPU frame: a pool slot the callbacks can retain, or the
+// scratch vector when every slot is retained (nullptr under GCAP_LEASE_POLICY_SKIP).
+uint8_t *WinMFProvider::cpu_output_buffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes)
+{
+    if (frame_pool_)
+    {
+        lease = frame_pool_->acquire(bytes);
+        if (lease)
+            return lease.data();
+        if (frame_pool_->policy() == GCAP_LEASE_POLICY_SKIP)
+            return nullptr;
+    }
+    if (scratch.size() < bytes)
+        scratch.resize(bytes);
+    return scratch.data();
+}
+
 // -------------------- D3D / MF init --------------------
 
 bool WinMFProvider::create_d3d()
@@ -2663,6 +2911,7 @@ bool WinMFProvider::gpu_overlay_text(const wchar_t *text)
 
 void WinMFProvider::loop()
 {
+    GCAP_TRACE_THREAD_NAME("winmf capture");
     // Log stride/buffer length diagnostics only once per run (avoid spamming).
     bool logged_layout = false;
     bool logged_len_mismatch = false;
@@ -2675,7 +2924,10 @@ void WinMFProvider::loop()
         DWORD stream = 0, flags = 0;
         LONGLONG ts = 0;
         ComPtr<IMFSample> sample;
+        GCAP_TRACE_MARK(traceRead0);
         HRESULT hr = reader_->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, &stream, &flags, &ts, &sample);
+        // Spans carry the id the sample's frame is about to get.
+        GCAP_TRACE_SPAN(ReadSample, frame_id_ + 1, traceRead0);
         if (FAILED(hr))
         {
             emit_error(GCAP_EIO, "ReadSample failed");
@@ -2715,6 +2967,20 @@ void WinMFProvider::loop()
         if (!sample)
             continue;
 
+        // ts is the device's sample time (100 ns); the clock maps it onto steady_clock.
+        {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            const uint64_t nowNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            gcap::ClockRecovery::Gap gap;
+            pts_smoothed_ns_ = clock_.update((int64_t)ts * 100, nowNs, &gap);
+            if (stats_)
+            {
+                stats_->arrived(nowNs);
+                stats_->add(gcap::StatCounter::FramesDropped, gap.dropped);
+                stats_->add(gcap::StatCounter::FramesDuplicated, gap.duplicated);
+            }
+        }
+
         if (cpu_path_)
         {
             ComPtr<IMFMediaBuffer> buf;
@@ -2736,6 +3002,8 @@ void WinMFProvider::loop()
                     << ", code_assumes_stride=";
                 oss << mf_row_bytes(cur_subtype_, cur_w_);
                 oss << " bytes";
+                oss << ", cpu_kernels=" << gcap::converter_kernel_name()
+                    << ", cpu_threads=" << gcap::convert_threads();
                 emit_error(GCAP_OK, oss.str().c_str());
                 logged_layout = true;
             }
@@ -2775,15 +3043,26 @@ void WinMFProvider::loop()
             f.pts_ns = (uint64_t)ts * 100;
             f.frame_id = ++frame_id_;
 
+            gcap::FrameConverter cpuConv;
+            gcap_video_output_t videoOut;
+            {
+                std::lock_guard<std::mutex> lk(cpu_converter_mtx_);
+                cpuConv = cpu_converter_;
+                videoOut = video_output_;
+            }
+
             if (cur_subtype_ == MFVideoFormat_ARGB32)
             {
                 f.format = GCAP_FMT_ARGB;
                 f.data[0] = pData;
                 f.stride[0] = cur_w_ * 4;
                 f.plane_count = 1;
-                emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_CPU, GCAP_SOURCE_WINMF_CPU, 0, f);
+                emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_CPU, GCAP_SOURCE_WINMF_CPU, 0, f, pts_smoothed_ns_);
                 if (vcb_)
+                {
+                    GCAP_TRACE_SCOPE(Callback, f.frame_id);
                     vcb_(&f, user_);
+                }
             }
             else if (cur_subtype_ == MFVideoFormat_NV12)
             {
@@ -2798,6 +3077,7 @@ void WinMFProvider::loop()
                     std::lock_guard<std::mutex> lock(recorderMutex_);
                     if (recorder_)
                     {
+                        GCAP_TRACE_SCOPE(RecorderWrite, f.frame_id);
                         recorder_->writeNV12(y, uv,
                                              static_cast<UINT32>(yStride),
                                              static_cast<UINT32>(uvStride),
@@ -2805,81 +3085,52 @@ void WinMFProvider::loop()
                     }
                 }
 
-                const size_t needed = (size_t)cur_w_ * (size_t)cur_h_ * 4;
-                if (cpu_argb_.size() < needed)
-                    cpu_argb_.resize(needed);
-
-                // CPU conversion path supports ProcAmp (Brightness/Contrast/Hue/Saturation/Sharpness)
-                gcap::ProcAmpParams pp;
-                pp.brightness = procamp_.brightness;
-                pp.contrast = procamp_.contrast;
-                pp.hue = procamp_.hue;
-                pp.saturation = procamp_.saturation;
-                pp.sharpness = procamp_.sharpness;
-
-                gcap::nv12_to_argb(y, uv, cur_w_, cur_h_, yStride, uvStride,
-                                   cpu_argb_.data(), cur_w_ * 4, pp);
-
-                f.format = GCAP_FMT_ARGB;
-                f.data[0] = cpu_argb_.data();
-                f.stride[0] = cur_w_ * 4;
-                f.plane_count = 1;
-                emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_CPU, GCAP_SOURCE_WINMF_CPU, 0, f);
-                if (vcb_)
-                    vcb_(&f, user_);
+                deliver_cpu_frame(cpuConv, videoOut, y, uv, yStride, uvStride, f);
             }
             else if (cur_subtype_ == MFVideoFormat_YUY2)
             {
                 const int yuy2Stride = (cur_stride_ > 0) ? cur_stride_ : (cur_w_ * 2);
                 const uint8_t *yuy2 = pData;
 
-                const size_t needed = (size_t)cur_w_ * (size_t)cur_h_ * 4;
-                if (cpu_argb_.size() < needed)
-                    cpu_argb_.resize(needed);
+                deliver_cpu_frame(cpuConv, videoOut, yuy2, nullptr, yuy2Stride, 0, f);
+            }
+            else if (cur_subtype_ == MFVideoFormat_P010)
+            {
+                // P010: 16-bit Y 面在前，UV 在後（同 stride）
+                const int yStride = (cur_stride_ > 0) ? cur_stride_ : (cur_w_ * 2);
+                const int uvStride = yStride;
+                const uint8_t *y = pData;
+                const uint8_t *uv = pData + (size_t)yStride * (size_t)cur_h_;
 
-                gcap::ProcAmpParams pp;
-                pp.brightness = procamp_.brightness;
-                pp.contrast = procamp_.contrast;
-                pp.hue = procamp_.hue;
-                pp.saturation = procamp_.saturation;
-                pp.sharpness = procamp_.sharpness;
+                {
+                    std::lock_guard<std::mutex> lock(recorderMutex_);
+                    if (recorder_)
+                    {
+                        GCAP_TRACE_SCOPE(RecorderWrite, f.frame_id);
+                        recorder_->writeP010(y, uv,
+                                             static_cast<UINT32>(yStride),
+                                             static_cast<UINT32>(uvStride),
+                                             ts);
+                    }
+                }
 
-                gcap::yuy2_to_argb(yuy2, cur_w_, cur_h_, yuy2Stride,
-                                   cpu_argb_.data(), cur_w_ * 4, pp);
+                // 10-bit source: the converter may deliver RGBA64 / X2R10G10B10 directly.
+                deliver_cpu_frame(cpuConv, videoOut, y, uv, yStride, uvStride, f);
+            }
+            else if (cur_subtype_ == MFVideoFormat_Y210)
+            {
+                const int y210Stride = (cur_stride_ > 0) ? cur_stride_ : (cur_w_ * 4);
 
-                f.format = GCAP_FMT_ARGB;
-                f.data[0] = cpu_argb_.data();
-                f.stride[0] = cur_w_ * 4;
-                f.plane_count = 1;
-                emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_CPU, GCAP_SOURCE_WINMF_CPU, 0, f);
-                if (vcb_)
-                    vcb_(&f, user_);
+                deliver_cpu_frame(cpuConv, videoOut, pData, nullptr, y210Stride, 0, f);
             }
             // 其他（例如 MJPG）理論上 VP 會幫我們解到 NV12/ARGB 之一；萬一還是 MJPG，可再加一個軟解（先不做）
 
             buf->Unlock();
+            if (stats_)
+                stats_->endFrame(steady_now_ns());
             continue;
         }
 
-        // 每一筆 sample 都會有 ts (100ns 單位)；我們前面用 f.pts_ns = ts * 100
-        double fps_now = 0.0;
-        if (last_pts_ns_ != 0)
-        {
-            uint64_t delta = ((uint64_t)ts * 100) - last_pts_ns_; // ns
-            if (delta > 0)
-                fps_now = 1e9 / (double)delta;
-        }
-        // 簡單一階濾波
-        if (fps_now > 0.0)
-        {
-            if (fps_avg_ <= 0.0)
-                fps_avg_ = fps_now;
-            else
-                fps_avg_ = fps_avg_ * 0.9 + fps_now * 0.1;
-        }
-
-        last_pts_ns_ = (uint64_t)ts * 100;
-
         if (!logged_render_chain && pipeline_)
         {
             std::ostringstream oss;
@@ -3037,6 +3288,7 @@ void WinMFProvider::loop()
                     std::lock_guard<std::mutex> lock(recorderMutex_);
                     if (recorder_)
                     {
+                        GCAP_TRACE_SCOPE(RecorderWrite, frame_id_ + 1);
                         if (cur_subtype_ == MFVideoFormat_NV12)
                             recorder_->writeNV12(srcY, srcUV, static_cast<UINT32>(srcStride), static_cast<UINT32>(srcStride), ts);
                         else
@@ -3045,10 +3297,15 @@ void WinMFProvider::loop()
                 }
 
                 uint8_t *dst = static_cast<uint8_t *>(mapped.pData);
-                for (int y = 0; y < h; ++y)
-                    memcpy(dst + mapped.RowPitch * y, srcY + (size_t)srcStride * y, rowBytes);
-                for (int y = 0; y < h / 2; ++y)
-                    memcpy(dst + mapped.RowPitch * (h + y), srcUV + (size_t)srcStride * y, rowBytes);
+                {
+                    GCAP_TRACE_SCOPE(RawCopy, frame_id_ + 1);
+                    for (int y = 0; y < h; ++y)
+                        memcpy(dst + mapped.RowPitch * y, srcY + (size_t)srcStride * y, rowBytes);
+                    for (int y = 0; y < h / 2; ++y)
+                        memcpy(dst + mapped.RowPitch * (h + y), srcUV + (size_t)srcStride * y, rowBytes);
+                }
+                if (stats_)
+                    stats_->copied(rowBytes * (size_t)(h + h / 2));
 
                 ctx_->Unmap(upload_yuv_.Get(), 0);
                 if (locked2d)
@@ -3187,7 +3444,11 @@ void WinMFProvider::loop()
         if (!yuvTex)
             continue;
 
-        if (!render_yuv_to_fp16(yuvTex.Get()))
+        // The YUV -> scene pass is where the GPU path applies ProcAmp.
+        GCAP_TRACE_MARK(traceProcAmp0);
+        const bool rendered = render_yuv_to_fp16(yuvTex.Get());
+        GCAP_TRACE_SPAN(ProcAmp, frame_id_ + 1, traceProcAmp0);
+        if (!rendered)
         {
             MDBG("DXGI: render_yuv_to_fp16 failed", E_FAIL);
             continue;
@@ -3256,8 +3517,8 @@ void WinMFProvider::loop()
         double fps_show = 0.0;
         if (cur_fps_num_ > 0 && cur_fps_den_ > 0)
             fps_show = (double)cur_fps_num_ / (double)cur_fps_den_;
-        else if (fps_avg_ > 0.0)
-            fps_show = fps_avg_;
+        else
+            fps_show = clock_.stats().fps;
 
         double probeFps = 0.0;
         if (probeFpsNum > 0 && probeFpsDen > 0)
@@ -3306,6 +3567,7 @@ void WinMFProvider::loop()
         {
             if (ensure_preview_swapchain(cur_w_, cur_h_))
             {
+                GCAP_TRACE_SCOPE(Present, frame_id_ + 1);
                 present_preview();
             }
         }
@@ -3315,11 +3577,16 @@ void WinMFProvider::loop()
         const uint64_t outFrameId = ++frame_id_;
         if (pipeline_ && pipeline_->readback_to_frame(cur_w_, cur_h_, (uint64_t)ts * 100, outFrameId, &f))
         {
-            emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_GPU, GCAP_SOURCE_WINMF_GPU, 1, f);
+            emit_frame_packet_cb(pcb_, user_, GCAP_BACKEND_WINMF_GPU, GCAP_SOURCE_WINMF_GPU, 1, f, pts_smoothed_ns_);
             if (vcb_)
+            {
+                GCAP_TRACE_SCOPE(Callback, f.frame_id);
                 vcb_(&f, user_);
+            }
             ctx_->Unmap(pipeline_->rt_stage_.Get(), 0);
         }
+        if (stats_)
+            stats_->endFrame(steady_now_ns());
     }
 }
 
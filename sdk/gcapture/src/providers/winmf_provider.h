@@ -11,6 +11,9 @@
 
 #include "gcapture.h"
 #include "../core/capture_manager.h"
+#include "../core/clock_recovery.h"
+#include "../core/frame_converter.h"
+#include "../core/frame_pool.h"
 #include "../pipeline/shared_scene_pipeline.h"
 
 // Media Foundation
@@ -74,6 +77,9 @@ public:
     // Set callback functions for video frames and errors
     void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user) override;
     void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override;
+    void setVideoOutput(const gcap_video_output_t &out) override;
+    void setFramePool(gcap::FramePool *pool) override;
+    void setStats(gcap::CaptureStats *stats) override;
 
     bool getDeviceProps(gcap_device_props_t &out) override;
     bool getSignalStatus(gcap_signal_status_t &out) override;
@@ -103,8 +109,8 @@ private:
     uint64_t frame_id_ = 0;
     std::string dev_name_;        // 目前選用的裝置名稱（UTF-8）
     std::wstring dev_sym_link_w_; // MF device symbolic link（給 SetupAPI 查 Driver/FW/Serial 用）
-    double fps_avg_ = 0.0;
-    uint64_t last_pts_ns_ = 0;
+    gcap::ClockRecovery clock_;    // fed with each sample's (timestamp, arrival)
+    uint64_t pts_smoothed_ns_ = 0; // current sample's recovered time; capture thread only
     bool use_dxgi_ = false;
     bool cpu_path_ = true;
     int current_index_ = -1;
@@ -129,6 +135,17 @@ private:
     // ---- ProcAmp (CPU conversion path) ----
     // Default is neutral (128).
     gcap_procamp_t procamp_{128, 128, 128, 128, 128};
+    // CPU converter: rebuilt when the media type, ProcAmp or force_range changes;
+    // copied once per frame by the CPU loop. Guarded by cpu_converter_mtx_.
+    std::mutex cpu_converter_mtx_;
+    gcap::ProcAmpParams procamp_params_;
+    gcap_range_t force_range_ = GCAP_RANGE_UNKNOWN;
+    gcap_colorspace_t src_csp_ = GCAP_CSP_UNKNOWN;
+    gcap_range_t src_range_ = GCAP_RANGE_UNKNOWN;
+    gcap::YuvLayout cpu_layout_ = gcap::YuvLayout::Nv12;
+    gcap::FrameOutput cpu_output_ = gcap::FrameOutput::Bgra8; // gcap_processing_opts_t::cpu_output
+    gcap::FrameConverter cpu_converter_;
+    gcap_video_output_t video_output_{}; // video callback size (gcap_set_callbacks_ex)
 
     // ---- MF objects ----
     ComPtr<IMFMediaSource> source_;
@@ -215,6 +232,11 @@ private:
     bool create_reader_cpu_only(int devIndex);
     bool refresh_signal_probe(bool force);
     bool sync_current_media_type(bool *changed = nullptr);
+    void select_cpu_converter();
+    void rebuild_cpu_converter_locked();
+    void deliver_cpu_frame(const gcap::FrameConverter &cv, const gcap_video_output_t &vo, const uint8_t *src0,
+                           const uint8_t *src1, int stride0, int stride1, gcap_frame_t &f);
+    uint8_t *cpu_output_buffer(gcap::FrameLease &lease, std::vector<uint8_t> &scratch, size_t bytes);
     void probe_loop();
     void start_probe_thread();
     void stop_probe_thread();
@@ -226,7 +248,14 @@ private:
     // Recording audio endpoint id (WASAPI endpoint id, UTF-8). Empty => system default.
     std::string rec_audio_device_id_;
 
-    std::vector<uint8_t> cpu_argb_;
+    gcap::FramePool *frame_pool_ = nullptr; // retainable CPU output slots (owned by CaptureManager)
+    gcap::StatsShard *stats_ = nullptr;     // capture thread's gcap_get_stats() shard (owned by CaptureManager)
+    // Scratch output when the pool is exhausted under GCAP_LEASE_POLICY_UNLEASED.
+    std::vector<uint8_t> cpu_argb_; // CPU converter output (BGRA, RGBA64 or X2R10G10B10)
+    // Resized video-callback frames (capture thread only); the plan is rebuilt when sizes change.
+    std::vector<uint8_t> cpu_scaled_;
+    gcap::ScalePlan cpu_scale_plan_;
+    gcap_scale_filter_t cpu_scale_filter_ = GCAP_SCALE_AUTO;
 
     bool prefer_gpu_ = true;
 
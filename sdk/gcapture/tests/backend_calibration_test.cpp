@@ -0,0 +1,219 @@
+// backend_calibration_test.cpp
+// pick_best() on hand-made results, and measure_candidate() against fake providers
+// that differ in frame rate, CPU cost per frame, time to the first frame, jitter and
+// pixel format control.
+#include "backend_calibration.h"
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    struct FakeDevice
+    {
+        double fps = 60.0;
+        int cpuUs = 0;        // busy time per frame, in the provider's thread
+        int firstMs = 0;      // start() to the first frame
+        int jitterUs = 0;     // every other frame is late by this much
+        bool opens = true;
+        bool formatControl = true;           // setProcessing(preferred_pixfmt) is supported
+        gcap_pixfmt_t streams = GCAP_FMT_NV12; // what start() ends up streaming without a request
+        int *processingCalls = nullptr;
+    };
+
+    class FakeProvider : public ICaptureProvider
+    {
+    public:
+        explicit FakeProvider(const FakeDevice &d) : dev_(d), format_(d.streams) {}
+        ~FakeProvider() override { stop(); }
+
+        bool enumerate(std::vector<gcap_device_info_t> &list) override
+        {
+            list.assign(1, gcap_device_info_t{});
+            return true;
+        }
+        bool open(int) override { return dev_.opens; }
+        bool setProfile(const gcap_profile_t &) override { return true; }
+        bool setBuffers(int, size_t) override { return true; }
+        bool setProcessing(const gcap_processing_opts_t &opts) override
+        {
+            if (dev_.processingCalls)
+                ++*dev_.processingCalls;
+            if (!dev_.formatControl)
+                return false;
+            format_ = opts.preferred_pixfmt;
+            return true;
+        }
+        bool getSignalStatus(gcap_signal_status_t &out) override
+        {
+            out = gcap_signal_status_t{};
+            out.pixfmt = format_;
+            return true;
+        }
+        void setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb, void *user) override
+        {
+            vcb_ = vcb;
+            user_ = user;
+        }
+        void setFramePacketCallback(gcap_on_frame_packet_cb pcb, void *user) override
+        {
+            pcb_ = pcb;
+            user_ = user;
+        }
+
+        bool start() override
+        {
+            running_ = true;
+            thread_ = std::thread([this]
+                                  { run(); });
+            return true;
+        }
+        void stop() override
+        {
+            running_ = false;
+            if (thread_.joinable())
+                thread_.join();
+        }
+        void close() override { stop(); }
+
+    private:
+        void run()
+        {
+            using clock = std::chrono::steady_clock;
+            std::this_thread::sleep_for(std::chrono::milliseconds(dev_.firstMs));
+            clock::time_point next = clock::now();
+            for (unsigned k = 0; running_; ++k)
+            {
+                const clock::time_point busyUntil = clock::now() + std::chrono::microseconds(dev_.cpuUs);
+                while (clock::now() < busyUntil)
+                {
+                }
+                gcap_frame_t f{};
+                gcap_frame_packet_t p{};
+                if (vcb_)
+                    vcb_(&f, user_);
+                if (pcb_)
+                    pcb_(&p, user_);
+                next += std::chrono::microseconds((long long)(1e6 / dev_.fps));
+                std::this_thread::sleep_until(next + std::chrono::microseconds((k & 1) ? dev_.jitterUs : 0));
+            }
+        }
+
+        FakeDevice dev_;
+        gcap_pixfmt_t format_;
+        gcap_on_video_cb vcb_ = nullptr;
+        gcap_on_frame_packet_cb pcb_ = nullptr;
+        void *user_ = nullptr;
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+    };
+
+    gcap::CalibrationResult result(int backend, double fps, double cpuUs, double jitterMs, double firstMs)
+    {
+        gcap::CalibrationResult r;
+        r.candidate.backend = backend;
+        r.started = true;
+        r.frames = 60;
+        r.fps = fps;
+        r.cpuUsPerFrame = cpuUs;
+        r.jitterMs = jitterMs;
+        r.firstFrameMs = firstMs;
+        return r;
+    }
+
+    void pick_best()
+    {
+        CHECK(gcap::pick_best({}, 60.0) == -1);
+        // Cheap but short of the target rate loses to a full-rate candidate.
+        CHECK(gcap::pick_best({result(0, 59.9, 900, 0.1, 50), result(1, 59.9, 300, 0.2, 80),
+                               result(2, 30.0, 100, 0.1, 10)},
+                              60.0) == 1);
+        // Within 10% CPU: lower jitter, then the faster first frame.
+        CHECK(gcap::pick_best({result(0, 59.9, 310, 0.1, 50), result(1, 59.9, 300, 0.2, 80)}, 60.0) == 0);
+        CHECK(gcap::pick_best({result(0, 59.9, 310, 0.1, 50), result(1, 59.9, 300, 0.1, 20)}, 60.0) == 1);
+        // Nobody reaches the target: the best measured rate is the bar.
+        CHECK(gcap::pick_best({result(0, 29.9, 310, 0.1, 50), result(1, 29.8, 300, 0.1, 20)}, 60.0) == 1);
+        CHECK(gcap::pick_best({result(0, 29.9, 310, 0.1, 50), result(1, 29.8, 300, 0.1, 20)}, 0.0) == 1);
+        gcap::CalibrationResult none = result(0, 0, 0, 0, -1);
+        none.frames = 0;
+        CHECK(gcap::pick_best({none}, 60.0) == -1);
+    }
+
+    void measure()
+    {
+        std::vector<FakeDevice> devs(5);
+        devs[0].cpuUs = 4000;  // expensive
+        devs[1].cpuUs = 500;   // cheap, slow to start
+        devs[1].firstMs = 200;
+        devs[2].fps = 30.0;    // cheapest, but half the rate
+        devs[3].opens = false;
+        devs[4].cpuUs = 600;   // cheap, jittery
+        devs[4].jitterUs = 3000;
+        gcap::ProviderFactory make = [&](int backend) -> std::unique_ptr<ICaptureProvider>
+        { return std::unique_ptr<ICaptureProvider>(new FakeProvider(devs[(size_t)backend])); };
+
+        gcap::CalibrationSettings s;
+        s.warmupMs = 100;
+        s.measureMs = 400;
+        std::vector<gcap::CalibrationResult> rs;
+        for (int b = 0; b < (int)devs.size(); ++b)
+        {
+            gcap::CalibrationCandidate c;
+            c.backend = b;
+            rs.push_back(gcap::measure_candidate(make, c, 0, nullptr, (b & 1) != 0, s));
+        }
+        CHECK(!rs[3].started && rs[3].frames == 0 && rs[3].firstFrameMs < 0);
+        CHECK(rs[0].started && rs[0].cpuUsPerFrame > 3000);
+        CHECK(rs[1].cpuUsPerFrame < 1500 && rs[1].firstFrameMs >= 190);
+        CHECK(rs[2].fps > 25 && rs[2].fps < 35);
+        CHECK(rs[4].jitterMs > 1.0);
+        CHECK(gcap::pick_best(rs, 60.0) == 1);
+    }
+
+    void formats()
+    {
+        gcap::CalibrationSettings s;
+        s.warmupMs = 20;
+        s.measureMs = 100;
+        int processingCalls = 0;
+        FakeDevice dev;
+        dev.processingCalls = &processingCalls;
+        gcap::ProviderFactory make = [&](int) -> std::unique_ptr<ICaptureProvider>
+        { return std::unique_ptr<ICaptureProvider>(new FakeProvider(dev)); };
+        gcap::CalibrationCandidate yuy2;
+        yuy2.format = GCAP_FMT_YUY2;
+
+        // NV12 is the backend's default and is never asked for.
+        gcap::CalibrationCandidate nv12;
+        CHECK(gcap::measure_candidate(make, nv12, 0, nullptr, false, s).frames >= 2);
+        CHECK(processingCalls == 0);
+
+        // A backend that cannot be asked for a format is not a candidate for it.
+        dev.formatControl = false;
+        CHECK(!gcap::measure_candidate(make, yuy2, 0, nullptr, false, s).started);
+
+        // Nor is one that accepts the request and streams something else.
+        struct Stubborn : FakeProvider
+        {
+            using FakeProvider::FakeProvider;
+            bool setProcessing(const gcap_processing_opts_t &) override { return true; }
+        };
+        dev.formatControl = true;
+        gcap::ProviderFactory stubborn = [&](int) -> std::unique_ptr<ICaptureProvider>
+        { return std::unique_ptr<ICaptureProvider>(new Stubborn(dev)); };
+        CHECK(!gcap::measure_candidate(stubborn, yuy2, 0, nullptr, false, s).started);
+
+        const gcap::CalibrationResult r = gcap::measure_candidate(make, yuy2, 0, nullptr, true, s);
+        CHECK(r.started && r.frames >= 2 && r.candidate.format == GCAP_FMT_YUY2);
+    }
+}
+
+int main()
+{
+    pick_best();
+    measure();
+    formats();
+    return 0;
+}
@@ -0,0 +1,15 @@
+// check.h
+// Minimal assertion for the gcapture tests: prints the failed expression and exits non-zero.
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(x)                                                                  \
+    do                                                                            \
+    {                                                                             \
+        if (!(x))                                                                 \
+        {                                                                         \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #x); \
+            std::exit(1);                                                         \
+        }                                                                         \
+    } while (0)
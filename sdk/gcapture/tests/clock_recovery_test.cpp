@@ -0,0 +1,109 @@
+// clock_recovery_test.cpp
+// Drop and duplicate counting and the recovered rate across frame-rate changes, with
+// device timestamps and on host arrival times alone.
+#include "clock_recovery.h"
+#include "check.h"
+
+#include <cmath>
+
+namespace
+{
+    constexpr int64_t kBaseNs = 1000000000;
+
+    struct Feed
+    {
+        gcap::ClockRecovery clock;
+        bool device = true;
+        double t = 0.0; // ns since kBaseNs
+        uint64_t gapDropped = 0;
+
+        // n frames period ns apart; with dropEvery, every dropEvery-th one is missing.
+        void frames(int n, double period, int dropEvery = 0)
+        {
+            for (int i = 1; i <= n; ++i)
+            {
+                t += period;
+                if (dropEvery && i % dropEvery == 0)
+                    continue;
+                const int64_t ns = kBaseNs + (int64_t)t;
+                gcap::ClockRecovery::Gap gap;
+                clock.update(device ? ns : -1, (uint64_t)ns + 5000, &gap);
+                gapDropped += gap.dropped;
+            }
+        }
+    };
+
+    bool near(double fps, double want) { return std::fabs(fps - want) < want * 0.01; }
+
+    void wrong_nominal_rate()
+    {
+        for (bool device : {true, false})
+        {
+            Feed f;
+            f.device = device;
+            f.clock.reset(30, 1);
+            f.frames(300, 1e9 / 15);
+            const gcap::ClockRecovery::Stats st = f.clock.stats();
+            CHECK(st.frames == 300 && st.dropped == 0 && st.duplicated == 0);
+            CHECK(near(st.fps, 15.0));
+        }
+    }
+
+    void rate_change()
+    {
+        for (bool device : {true, false})
+        {
+            Feed f;
+            f.device = device;
+            f.frames(300, 1e9 / 30);
+            CHECK(near(f.clock.stats().fps, 30.0));
+            f.frames(300, 1e9 / 15);
+            CHECK(near(f.clock.stats().fps, 15.0) && f.clock.stats().dropped == 0);
+            f.frames(300, 1e9 / 60);
+            const gcap::ClockRecovery::Stats st = f.clock.stats();
+            CHECK(near(st.fps, 60.0) && st.dropped == 0 && st.duplicated == 0);
+        }
+    }
+
+    void real_drops()
+    {
+        for (bool device : {true, false})
+        {
+            Feed f;
+            f.device = device;
+            f.clock.reset(30, 1);
+            f.frames(305, 1e9 / 30, 10); // one in ten missing, the last confirmed by frame 301
+            CHECK(f.clock.stats().dropped == 30 && f.gapDropped == 30);
+            CHECK(near(f.clock.stats().fps, 30.0));
+        }
+        // Two long gaps in a row: counted once the next frame is back on the period.
+        Feed f;
+        f.frames(30, 1e9 / 30);
+        f.t += 2e9 / 30;
+        f.frames(1, 1e9 / 30);
+        f.t += 1e9 / 30;
+        f.frames(1, 1e9 / 30);
+        CHECK(f.clock.stats().dropped == 0);
+        f.frames(1, 1e9 / 30);
+        CHECK(f.clock.stats().dropped == 3 && f.gapDropped == 3);
+    }
+
+    void duplicates()
+    {
+        Feed f;
+        f.frames(30, 1e9 / 30);
+        gcap::ClockRecovery::Gap gap;
+        const int64_t ns = kBaseNs + (int64_t)f.t;
+        f.clock.update(ns, (uint64_t)ns + 6000, &gap);
+        CHECK(gap.duplicated == 1 && f.clock.stats().duplicated == 1);
+    }
+}
+
+int main()
+{
+    wrong_nominal_rate();
+    rate_change();
+    real_drops();
+    duplicates();
+    return 0;
+}
@@ -0,0 +1,91 @@
+// frame_arena_test.cpp
+// Block layout and reuse, and that a huge-page arena gets transparent huge pages
+// wherever the kernel offers them, advising nothing outside its own mapping.
+#include "frame_arena.h"
+#include "check.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // THP usable through madvise(MADV_HUGEPAGE): "always" or "madvise" is selected.
+    bool thp_available()
+    {
+#ifdef __linux__
+        std::FILE *fp = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (!fp)
+            return false;
+        char line[128] = {};
+        const bool read = std::fgets(line, sizeof(line), fp) != nullptr;
+        std::fclose(fp);
+        return read && !std::strstr(line, "[never]");
+#else
+        return false;
+#endif
+    }
+
+    // Mappings advised MADV_HUGEPAGE ("hg" in /proc/self/smaps VmFlags); -1 = unknown.
+    int advised_mappings()
+    {
+#ifdef __linux__
+        std::FILE *fp = std::fopen("/proc/self/smaps", "r");
+        if (!fp)
+            return -1;
+        int n = 0;
+        char line[512];
+        while (std::fgets(line, sizeof(line), fp))
+            if (!std::strncmp(line, "VmFlags:", 8) && std::strstr(line, " hg"))
+                ++n;
+        std::fclose(fp);
+        return n;
+#else
+        return -1;
+#endif
+    }
+
+    void check_arena(size_t hint, bool hugePages)
+    {
+        gcap::FrameArena a(3, hint, hugePages);
+        CHECK(a.valid());
+        CHECK(a.blockBytes() >= hint && a.blockBytes() % 64 == 0);
+        CHECK(a.reservedBytes() == a.blockBytes() * 3);
+        uint8_t *b[3];
+        for (uint8_t *&p : b)
+        {
+            p = a.allocate(hint);
+            CHECK(p && (uintptr_t)p % 64 == 0);
+            std::memset(p, 0xA5, hint);
+        }
+        CHECK(!a.allocate(1) && a.usedBytes() == a.reservedBytes());
+        a.release(b[1]);
+        CHECK(!a.allocate(a.blockBytes() + 1));
+        CHECK(a.allocate(a.blockBytes()) == b[1]);
+        for (uint8_t *p : b)
+            a.release(p);
+        CHECK(a.idle());
+        a.prefault();
+        // Windows large pages depend on the account's privileges; only THP is predictable.
+        if (!hugePages || thp_available())
+            CHECK(a.hugePages() == hugePages);
+    }
+
+    void blocks(bool hugePages)
+    {
+        // Sizes that leave the arena's end off a 2 MiB boundary.
+        for (size_t hint : {(size_t)1000, (size_t)3 << 20, ((size_t)5 << 20) + 12345})
+        {
+            const int advised = advised_mappings();
+            check_arena(hint, hugePages);
+            // The advice stayed inside the arena's own mapping: none outlives it.
+            CHECK(advised_mappings() == advised);
+        }
+    }
+}
+
+int main()
+{
+    blocks(false);
+    blocks(true);
+    return 0;
+}
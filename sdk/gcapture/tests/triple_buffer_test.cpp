@@ -0,0 +1,112 @@
+// triple_buffer_test.cpp
+// One producer publishing frames whose bytes, size and format all derive from their
+// sequence number, one consumer checking every frame it reads is whole, and a third
+// thread invalidating now and then.
+#include "triple_buffer.h"
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    constexpr uint64_t kFrames = 200000;
+
+    size_t frame_bytes(uint64_t seq) { return 64 + (size_t)(seq % 97) * 16; }
+
+    gcap::TripleBuffer::Format frame_format(uint64_t seq)
+    {
+        gcap::TripleBuffer::Format f;
+        f.width = (int)(seq % 1920) + 1;
+        f.height = (int)(seq % 1080) + 1;
+        std::memcpy(f.id, &seq, sizeof(seq));
+        return f;
+    }
+
+    void single_thread()
+    {
+        gcap::TripleBuffer tb;
+        gcap::TripleBuffer::View v;
+        CHECK(!tb.latest(v));
+        std::memset(tb.writeBuffer(16), 7, 16);
+        CHECK(tb.publish(16, 4, frame_format(1), 10, 20) == 1);
+        CHECK(tb.latest(v) && v.seq == 1 && v.bytes == 16 && v.stride == 4 && v.hostNs == 10 && v.ptsNs == 20);
+        CHECK(v.data[15] == 7 && v.format.width == 2 && v.format.height == 2);
+        // Nothing new: the same frame again, in place.
+        gcap::TripleBuffer::View again;
+        CHECK(tb.latest(again) && again.seq == 1 && again.data == v.data);
+        // Only the newest of several publishes is seen.
+        for (uint64_t i = 2; i <= 4; ++i)
+        {
+            tb.writeBuffer(8);
+            tb.publish(8, 0, frame_format(i));
+        }
+        CHECK(tb.latest(v) && v.seq == 4 && v.format.width == 5);
+        tb.invalidate();
+        CHECK(!tb.latest(v));
+        tb.writeBuffer(8);
+        tb.publish(8, 0, frame_format(5));
+        CHECK(tb.latest(v) && v.seq == 5);
+    }
+
+    void stress()
+    {
+        gcap::TripleBuffer tb;
+        std::atomic<bool> done{false};
+
+        std::thread producer([&]
+                             {
+            for (uint64_t seq = 1; seq <= kFrames; ++seq)
+            {
+                const size_t bytes = frame_bytes(seq);
+                std::memset(tb.writeBuffer(bytes), (int)(seq & 0xFF), bytes);
+                CHECK(tb.publish(bytes, (int)(seq % 7), frame_format(seq), seq * 2, seq * 3) == seq);
+            }
+            done = true; });
+
+        std::thread invalidator([&]
+                                {
+            while (!done)
+            {
+                tb.invalidate();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            } });
+
+        uint64_t reads = 0, last = 0;
+        for (;;)
+        {
+            const bool finished = done.load();
+            gcap::TripleBuffer::View v;
+            if (tb.latest(v))
+            {
+                const uint64_t seq = v.seq;
+                CHECK(seq >= last && seq <= kFrames);
+                CHECK(v.bytes == frame_bytes(seq) && v.stride == (int)(seq % 7));
+                CHECK(v.hostNs == seq * 2 && v.ptsNs == seq * 3);
+                const gcap::TripleBuffer::Format f = frame_format(seq);
+                CHECK(v.format.width == f.width && v.format.height == f.height);
+                CHECK(std::memcmp(v.format.id, f.id, sizeof(f.id)) == 0);
+                for (size_t i = 0; i < v.bytes; ++i)
+                    CHECK(v.data[i] == (uint8_t)(seq & 0xFF));
+                last = seq;
+                ++reads;
+            }
+            if (finished)
+                break;
+        }
+        producer.join();
+        invalidator.join();
+        CHECK(reads > 0);
+        std::printf("triple_buffer: %llu frames published, %llu read, last %llu\n", (unsigned long long)kFrames,
+                    (unsigned long long)reads, (unsigned long long)last);
+    }
+}
+
+int main()
+{
+    single_thread();
+    stress();
+    return 0;
+}
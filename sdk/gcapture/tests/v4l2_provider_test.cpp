@@ -0,0 +1,533 @@
+// v4l2_provider_test.cpp
+// GCAP_BACKEND_V4L2 against a fake driver installed with V4L2Provider::setIo():
+// enumeration, format negotiation (S_FMT / S_PARM), REQBUFS / QUERYBUF / mmap,
+// QBUF / DQBUF with EAGAIN, STREAMON / STREAMOFF, zero-copy packets, sequence-gap
+// drops and device loss; and GCAP_BACKEND_AUTO reopening with the application's
+// processing options.
+#include "gcapture.h"
+#include "v4l2_provider.h"
+#include "check.h"
+
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fake
+{
+    // /dev/video0: capture node offering MJPEG, YUYV and NV12 at 640x480 / 1280x720,
+    // 30 and 59.94 fps, with padded rows. /dev/video1: metadata only.
+    constexpr int kCaptureFd = 1000;
+    constexpr int kMetaFd = 1001;
+    constexpr uint32_t kSkippedSeq = 5; // the driver drops this sequence number
+
+    std::mutex m;
+    uint32_t fourcc = V4L2_PIX_FMT_YUYV;
+    uint32_t width = 640, height = 480, bytesPerLine = 1280;
+    uint32_t tpfNum = 1, tpfDen = 30;
+    std::vector<std::vector<uint8_t>> bufs;
+    std::deque<uint32_t> queued;
+    bool streaming = false;
+    uint32_t seq = 0;
+    uint64_t lastNs = 0;
+    uint64_t frameNs = 10000000; // a frame every 10 ms
+    int mapped = 0;
+    bool unplugged = false;
+    bool spuriousWakeups = false; // poll() reports POLLIN before a buffer is ready
+    int eagain = 0;
+
+    uint64_t now_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    uint32_t size_image() { return fourcc == V4L2_PIX_FMT_NV12 ? bytesPerLine * height * 3 / 2 : bytesPerLine * height; }
+    bool frame_ready() { return streaming && !queued.empty() && now_ns() - lastNs >= frameNs; }
+
+    int f_open(const char *path, int)
+    {
+        if (!std::strcmp(path, "/dev/video0"))
+            return kCaptureFd;
+        if (!std::strcmp(path, "/dev/video1"))
+            return kMetaFd;
+        errno = ENOENT;
+        return -1;
+    }
+
+    int f_close(int) { return 0; }
+
+    int f_ioctl(int fd, unsigned long req, void *arg)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        if (req == VIDIOC_QUERYCAP)
+        {
+            auto *c = (v4l2_capability *)arg;
+            std::memset(c, 0, sizeof(*c));
+            std::strcpy((char *)c->driver, "fakecap");
+            std::strcpy((char *)c->card, fd == kCaptureFd ? "Fake HDMI" : "Fake meta");
+            c->capabilities = V4L2_CAP_DEVICE_CAPS | V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_META_CAPTURE | V4L2_CAP_STREAMING;
+            c->device_caps = (fd == kCaptureFd ? V4L2_CAP_VIDEO_CAPTURE : V4L2_CAP_META_CAPTURE) | V4L2_CAP_STREAMING;
+            return 0;
+        }
+        if (fd != kCaptureFd)
+        {
+            errno = ENOTTY;
+            return -1;
+        }
+        switch (req)
+        {
+        case VIDIOC_ENUM_FMT:
+        {
+            auto *d = (v4l2_fmtdesc *)arg;
+            const uint32_t formats[] = {V4L2_PIX_FMT_MJPEG, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12};
+            if (d->index >= 3)
+                break;
+            d->pixelformat = formats[d->index];
+            d->flags = d->index == 0 ? V4L2_FMT_FLAG_COMPRESSED : 0;
+            return 0;
+        }
+        case VIDIOC_ENUM_FRAMESIZES:
+        {
+            auto *s = (v4l2_frmsizeenum *)arg;
+            if (s->index >= 2)
+                break;
+            s->type = V4L2_FRMSIZE_TYPE_DISCRETE;
+            s->discrete.width = s->index ? 1280 : 640;
+            s->discrete.height = s->index ? 720 : 480;
+            return 0;
+        }
+        case VIDIOC_ENUM_FRAMEINTERVALS:
+        {
+            auto *iv = (v4l2_frmivalenum *)arg;
+            if (iv->index >= 2)
+                break;
+            iv->type = V4L2_FRMIVAL_TYPE_DISCRETE;
+            iv->discrete.numerator = iv->index ? 1001 : 1;
+            iv->discrete.denominator = iv->index ? 60000 : 30;
+            return 0;
+        }
+        case VIDIOC_G_FMT:
+        case VIDIOC_S_FMT:
+        {
+            v4l2_pix_format &p = ((v4l2_format *)arg)->fmt.pix;
+            if (req == VIDIOC_S_FMT)
+            {
+                if (streaming || !bufs.empty())
+                {
+                    errno = EBUSY;
+                    return -1;
+                }
+                // Like a real driver: unsupported requests are adjusted, not refused.
+                fourcc = p.pixelformat == V4L2_PIX_FMT_NV12 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_YUYV;
+                width = p.width >= 1000 ? 1280 : 640;
+                height = p.width >= 1000 ? 720 : 480;
+                bytesPerLine = (width * (fourcc == V4L2_PIX_FMT_NV12 ? 1 : 2) + 32 + 63) & ~63u;
+            }
+            std::memset(&p, 0, sizeof(p));
+            p.width = width;
+            p.height = height;
+            p.pixelformat = fourcc;
+            p.field = V4L2_FIELD_NONE;
+            p.bytesperline = bytesPerLine;
+            p.sizeimage = size_image();
+            p.colorspace = V4L2_COLORSPACE_REC709;
+            p.quantization = V4L2_QUANTIZATION_FULL_RANGE;
+            return 0;
+        }
+        case VIDIOC_G_PARM:
+        case VIDIOC_S_PARM:
+        {
+            auto *pm = (v4l2_streamparm *)arg;
+            if (req == VIDIOC_S_PARM)
+            {
+                tpfNum = pm->parm.capture.timeperframe.numerator;
+                tpfDen = pm->parm.capture.timeperframe.denominator;
+            }
+            std::memset(&pm->parm, 0, sizeof(pm->parm));
+            pm->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+            pm->parm.capture.timeperframe.numerator = tpfNum;
+            pm->parm.capture.timeperframe.denominator = tpfDen;
+            return 0;
+        }
+        case VIDIOC_REQBUFS:
+        {
+            auto *r = (v4l2_requestbuffers *)arg;
+            if (streaming || r->memory != V4L2_MEMORY_MMAP)
+            {
+                errno = streaming ? EBUSY : EINVAL;
+                return -1;
+            }
+            queued.clear();
+            if (r->count == 0)
+            {
+                bufs.clear();
+                return 0;
+            }
+            r->count = r->count < 3 ? 3 : r->count; // driver minimum
+            bufs.assign(r->count, std::vector<uint8_t>(size_image()));
+            return 0;
+        }
+        case VIDIOC_QUERYBUF:
+        {
+            auto *b = (v4l2_buffer *)arg;
+            if (b->index >= bufs.size())
+                break;
+            b->length = (uint32_t)bufs[b->index].size();
+            b->m.offset = b->index << 16;
+            return 0;
+        }
+        case VIDIOC_QBUF:
+        {
+            auto *b = (v4l2_buffer *)arg;
+            if (unplugged)
+            {
+                errno = ENODEV;
+                return -1;
+            }
+            if (b->index >= bufs.size())
+                break;
+            for (uint32_t q : queued)
+                if (q == b->index)
+                {
+                    errno = EINVAL;
+                    return -1;
+                }
+            queued.push_back(b->index);
+            return 0;
+        }
+        case VIDIOC_DQBUF:
+        {
+            auto *b = (v4l2_buffer *)arg;
+            if (unplugged)
+            {
+                errno = ENODEV;
+                return -1;
+            }
+            if (!frame_ready())
+            {
+                ++eagain;
+                errno = EAGAIN;
+                return -1;
+            }
+            b->index = queued.front();
+            queued.pop_front();
+            lastNs = now_ns();
+            if (seq == kSkippedSeq)
+                ++seq;
+            b->sequence = seq++;
+            std::memset(bufs[b->index].data(), (uint8_t)b->sequence, 16);
+            b->bytesused = size_image();
+            b->flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+            b->timestamp.tv_sec = (time_t)(lastNs / 1000000000);
+            b->timestamp.tv_usec = (suseconds_t)(lastNs % 1000000000 / 1000);
+            return 0;
+        }
+        case VIDIOC_STREAMON:
+            streaming = true;
+            seq = 0;
+            return 0;
+        case VIDIOC_STREAMOFF:
+            streaming = false;
+            queued.clear();
+            return 0;
+        default:
+            errno = ENOTTY;
+            return -1;
+        }
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *f_mmap(size_t len, int, int64_t off)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        const size_t i = (size_t)off >> 16;
+        if (i >= bufs.size() || len != bufs[i].size())
+            return MAP_FAILED;
+        ++mapped;
+        return bufs[i].data();
+    }
+
+    int f_munmap(void *, size_t)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        --mapped;
+        return 0;
+    }
+
+    int f_poll(pollfd *p, int timeoutMs)
+    {
+        const uint64_t end = now_ns() + (uint64_t)timeoutMs * 1000000;
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lk(m);
+                if (unplugged)
+                {
+                    p->revents = POLLERR;
+                    return 1;
+                }
+                if (frame_ready() || (spuriousWakeups && streaming))
+                {
+                    p->revents = POLLIN;
+                    return 1;
+                }
+            }
+            if (now_ns() >= end)
+            {
+                p->revents = 0;
+                return 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    const V4l2Io io = {f_open, f_close, f_ioctl, f_mmap, f_munmap, f_poll};
+
+    bool in_driver_buffer(const void *p)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        for (const auto &b : bufs)
+            if (p == b.data())
+                return true;
+        return false;
+    }
+
+    bool is_queued(const void *p)
+    {
+        std::lock_guard<std::mutex> lk(m);
+        for (uint32_t q : queued)
+            if (bufs[q].data() == p)
+                return true;
+        return false;
+    }
+}
+
+namespace
+{
+    struct Sink
+    {
+        gcap_pixfmt_t expect = GCAP_FMT_NV12;
+        std::atomic<int> packets{0}, video{0}, bad{0}, lost{0}, errors{0};
+        std::vector<uint8_t> seqs; // first byte of each packet: the driver's sequence number
+    };
+
+    void on_packet(const gcap_frame_packet_t *p, void *user)
+    {
+        Sink *s = (Sink *)user;
+        ++s->packets;
+        if (p->backend != GCAP_BACKEND_V4L2 || p->source_kind != GCAP_SOURCE_V4L2_MMAP || p->format != s->expect)
+            ++s->bad;
+        // Zero copy: the packet points into a driver buffer the driver does not hold.
+        if (!fake::in_driver_buffer(p->data[0]) || fake::is_queued(p->data[0]))
+            ++s->bad;
+        if (p->stride[0] != (int)fake::bytesPerLine)
+            ++s->bad;
+        if (p->format == GCAP_FMT_NV12 &&
+            (p->plane_count != 2 || (const uint8_t *)p->data[1] != (const uint8_t *)p->data[0] + fake::bytesPerLine * p->height))
+            ++s->bad;
+        s->seqs.push_back(((const uint8_t *)p->data[0])[0]);
+    }
+
+    void on_video(const gcap_frame_t *f, void *user)
+    {
+        Sink *s = (Sink *)user;
+        ++s->video;
+        if (!f->data[0] || f->format != GCAP_FMT_ARGB || f->width <= 0)
+            ++s->bad;
+    }
+
+    void on_error(gcap_status_t st, const char *msg, void *user)
+    {
+        Sink *s = (Sink *)user;
+        if (std::strstr(msg, "device lost"))
+            ++s->lost;
+        if (st != GCAP_OK)
+            ++s->errors;
+    }
+
+    void enumeration()
+    {
+        gcap_device_info_t d[8];
+        int n = 0;
+        CHECK(gcap_enumerate(d, 8, &n) == GCAP_OK);
+        CHECK(n == 1); // the metadata node is skipped
+        CHECK(!std::strcmp(d[0].name, "Fake HDMI") && !std::strcmp(d[0].symbolic_link, "/dev/video0"));
+
+        gcap_video_cap_t caps[32];
+        CHECK(gcap_enum_video_caps(0, nullptr, 0) == 8); // MJPEG is not offered
+        CHECK(gcap_enum_video_caps(0, caps, 32) == 8);
+        gcap_pixfmt_t pf[8];
+        CHECK(gcap_enum_supported_pixel_formats(GCAP_BACKEND_V4L2, 0, pf, 8) == 2);
+        CHECK(pf[0] == GCAP_FMT_YUY2 && pf[1] == GCAP_FMT_NV12);
+    }
+
+    // Negotiates w x h @ 59.94 in `fmt` with `buffers` driver buffers and streams for a while.
+    void stream(gcap_handle h, gcap_pixfmt_t fmt, int w, int hgt, int buffers, size_t expectBuffers)
+    {
+        Sink s;
+        s.expect = fmt;
+        CHECK(gcap_set_callbacks(h, on_video, on_error, &s) == GCAP_OK);
+        CHECK(gcap_set_frame_packet_callback(h, on_packet, &s) == GCAP_OK);
+        gcap_profile_t p{};
+        p.mode = GCAP_PROFILE_CUSTOM;
+        p.width = w;
+        p.height = hgt;
+        p.fps_num = 60000;
+        p.fps_den = 1001;
+        p.format = fmt;
+        CHECK(gcap_set_profile(h, &p) == GCAP_OK);
+        CHECK(gcap_set_buffers(h, buffers, 0) == GCAP_OK);
+        CHECK(gcap_start(h) == GCAP_OK);
+        CHECK(fake::bufs.size() == expectBuffers);
+        CHECK(fake::tpfNum == 1001 && fake::tpfDen == 60000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        gcap_runtime_info_t ri;
+        CHECK(gcap_get_runtime_info(h, &ri) == GCAP_OK);
+        gcap_stats_t st;
+        CHECK(gcap_get_stats(h, &st) == GCAP_OK);
+        CHECK(gcap_stop(h) == GCAP_OK);
+
+        CHECK(s.packets >= 10 && s.video == s.packets && s.bad == 0 && s.errors == 0);
+        CHECK(fake::mapped == 0 && fake::bufs.empty()); // unmapped and freed (REQBUFS 0)
+        CHECK(st.frames_dropped >= 1);                  // kSkippedSeq
+        for (size_t i = 1; i < s.seqs.size(); ++i)
+            CHECK((uint8_t)(s.seqs[i] - s.seqs[i - 1]) == (s.seqs[i - 1] == fake::kSkippedSeq - 1 ? 2 : 1));
+        CHECK(ri.negotiated.width == w && ri.negotiated.height == hgt);
+        CHECK(ri.negotiated.fps_num == 60000 && ri.negotiated.fps_den == 1001);
+        CHECK(ri.signal.range == GCAP_RANGE_FULL && ri.signal.csp == GCAP_CSP_BT709);
+    }
+
+    void spurious_wakeups(gcap_handle h)
+    {
+        Sink s;
+        s.expect = GCAP_FMT_YUY2;
+        CHECK(gcap_set_callbacks(h, on_video, on_error, &s) == GCAP_OK);
+        CHECK(gcap_set_frame_packet_callback(h, on_packet, &s) == GCAP_OK);
+        // Slower than the conversion, so poll() reports POLLIN between frames.
+        fake::frameNs = 40000000;
+        fake::spuriousWakeups = true;
+        fake::eagain = 0;
+        CHECK(gcap_start(h) == GCAP_OK);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CHECK(gcap_stop(h) == GCAP_OK);
+        fake::spuriousWakeups = false;
+        fake::frameNs = 10000000;
+        CHECK(fake::eagain > 0);
+        CHECK(s.packets >= 2 && s.bad == 0 && s.errors == 0);
+    }
+
+    void unplug(gcap_handle h)
+    {
+        Sink s;
+        s.expect = GCAP_FMT_YUY2;
+        CHECK(gcap_set_callbacks(h, on_video, on_error, &s) == GCAP_OK);
+        CHECK(gcap_set_frame_packet_callback(h, on_packet, &s) == GCAP_OK);
+        CHECK(gcap_start(h) == GCAP_OK);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        {
+            std::lock_guard<std::mutex> lk(fake::m);
+            fake::unplugged = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(s.lost == 1);
+        gcap_stop(h);
+        fake::unplugged = false;
+    }
+
+    void unsupported_format(gcap_handle h)
+    {
+        Sink s;
+        CHECK(gcap_set_callbacks(h, on_video, on_error, &s) == GCAP_OK);
+        gcap_profile_t p{};
+        p.mode = GCAP_PROFILE_CUSTOM;
+        p.width = 640;
+        p.height = 480;
+        p.format = GCAP_FMT_P010; // the driver answers with YUYV
+        CHECK(gcap_set_profile(h, &p) == GCAP_OK);
+        CHECK(gcap_start(h) != GCAP_OK);
+    }
+
+    // Green of the frame's centre pixel, whose source bytes are all zero: a value the
+    // forced range changes.
+    std::atomic<int> g_centreGreen{-1};
+
+    void on_centre(const gcap_frame_t *f, void *)
+    {
+        const uint8_t *row = (const uint8_t *)f->data[0] + (size_t)f->stride[0] * (f->height / 2);
+        g_centreGreen = row[(f->width / 2) * 4 + 1];
+    }
+
+    // Reopens h (GCAP_BACKEND_AUTO: the remembered choice) after gcap_set_processing.
+    int reopened_centre_green(gcap_handle h, gcap_range_t range)
+    {
+        gcap_processing_opts_t po{};
+        po.force_range = range;
+        CHECK(gcap_set_processing(h, &po) == GCAP_OK);
+        CHECK(gcap_open2(h, 0) == GCAP_OK);
+        CHECK(gcap_set_callbacks(h, on_centre, nullptr, nullptr) == GCAP_OK);
+        g_centreGreen = -1;
+        CHECK(gcap_start(h) == GCAP_OK);
+        for (int i = 0; i < 100 && g_centreGreen < 0; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(gcap_stop(h) == GCAP_OK);
+        return g_centreGreen;
+    }
+
+    void auto_reopen_keeps_processing()
+    {
+        gcap_auto_calibration_t o{};
+        o.enable = 1;
+        o.warmup_ms = 20;
+        o.measure_ms = 100;
+        CHECK(gcap_set_auto_calibration(&o) == GCAP_OK);
+        gcap_set_backend(GCAP_BACKEND_AUTO);
+
+        gcap_handle h;
+        CHECK(gcap_create(&h) == GCAP_OK);
+        CHECK(gcap_open2(h, 0) == GCAP_OK); // calibrates
+        CHECK(gcap_get_active_backend(h) == GCAP_BACKEND_V4L2);
+        const int limited = reopened_centre_green(h, GCAP_RANGE_LIMITED);
+        const int full = reopened_centre_green(h, GCAP_RANGE_FULL);
+        CHECK(limited >= 0 && full >= 0 && limited != full);
+        gcap_close(h);
+
+        gcap_set_auto_calibration(nullptr);
+        gcap_set_backend(GCAP_BACKEND_V4L2);
+    }
+}
+
+int main()
+{
+    V4L2Provider::setIo(&fake::io);
+    gcap_set_backend(GCAP_BACKEND_V4L2);
+    enumeration();
+
+    gcap_handle h;
+    CHECK(gcap_create(&h) == GCAP_OK);
+    CHECK(gcap_open2(h, 0) == GCAP_OK);
+    stream(h, GCAP_FMT_NV12, 640, 480, 1, 3); // 1 is clamped to 2, the driver asks for 3
+    stream(h, GCAP_FMT_YUY2, 1280, 720, 6, 6);
+    spurious_wakeups(h);
+    unplug(h);
+    unsupported_format(h);
+    gcap_close(h);
+    auto_reopen_keeps_processing();
+
+    // The device watch stops and starts again on the next query.
+    gcap_shutdown();
+    enumeration();
+    gcap_shutdown();
+    return 0;
+}